@@ -18,8 +18,8 @@
 #include "network/AttribUpdateHandler.h"
 #include "network/AuthFailedHandler.h"
 #include "network/EntityRemoveHandler.h"
+#include "network/EntitySnapshotHandler.h"
 #include "network/EntitySpawnHandler.h"
-#include "network/EntityUpdateHandler.h"
 #include "network/UserSpawnHandler.h"
 #include "network/UserInfoHandler.h"
 #include "network/VarUpdateHandler.h"
@@ -158,7 +158,7 @@ core::AppState Client::onInit() {
 	regHandler(network::ServerMsgType::AttribUpdate, AttribUpdateHandler);
 	regHandler(network::ServerMsgType::EntitySpawn, EntitySpawnHandler);
 	regHandler(network::ServerMsgType::EntityRemove, EntityRemoveHandler);
-	regHandler(network::ServerMsgType::EntityUpdate, EntityUpdateHandler);
+	regHandler(network::ServerMsgType::EntitySnapshot, EntitySnapshotHandler);
 	regHandler(network::ServerMsgType::UserSpawn, UserSpawnHandler);
 	regHandler(network::ServerMsgType::AuthFailed, AuthFailedHandler);
 	regHandler(network::ServerMsgType::VarUpdate, VarUpdateHandler);
@@ -300,6 +300,7 @@ void Client::beforeUI() {
 		_action.update(_now, _player);
 		const double speed = _player->attrib().current(attrib::Type::SPEED);
 		_camera.update(_player->position(), _deltaFrameSeconds, _now, (float)speed);
+		_clientPager->prefetch(_worldMgr->volumeData()->chunkPos(glm::ivec3(_player->position())));
 		_worldRenderer.chunkMgr().extractMeshes(camera);
 		_worldRenderer.update(camera, _deltaFrameMillis);
 		_worldRenderer.renderWorld(camera);
@@ -347,6 +348,7 @@ core::AppState Client::onCleanup() {
 	core::AppState state = Super::onCleanup();
 	Log::info("shutting down the world");
 	_worldMgr->shutdown();
+	_clientPager->shutdown();
 	_player = frontend::ClientEntityPtr();
 	Log::info("shutting down the network");
 	_network->shutdown();
@@ -412,6 +414,51 @@ void Client::entitySpawn(frontend::ClientEntityId id, network::EntityType type,
 	_worldRenderer.entityMgr().addEntity(entity);
 }
 
+void Client::entitySnapshot(uint32_t sequence, uint32_t baseline, const uint8_t* data, size_t size) {
+	if (sequence <= _lastEntitySnapshot) {
+		// the unreliable snapshots might arrive out of order
+		return;
+	}
+	const network::EntitySnapshotStates* baselineStates = nullptr;
+	if (baseline != 0u) {
+		baselineStates = _entitySnapshots.get(baseline);
+		if (baselineStates == nullptr) {
+			Log::debug("Baseline %u of entity snapshot %u is not available", baseline, sequence);
+			return;
+		}
+	}
+	network::EntitySnapshotStates states;
+	_changedEntityStates.clear();
+	if (!network::decodeEntitySnapshot(baselineStates, data, size, states, &_changedEntityStates)) {
+		Log::warn("Failed to decode entity snapshot %u", sequence);
+		return;
+	}
+	for (const network::EntitySnapshotState& state : _changedEntityStates) {
+		if (network::findEntitySnapshotState(baselineStates, state.id) != nullptr || getEntity(state.id)) {
+			continue;
+		}
+		// the reliable spawn didn't arrive yet - the snapshot must not become a baseline, otherwise the
+		// unchanged state is never sent again. The server sends the full state until this is acknowledged.
+		Log::debug("Entity snapshot %u contains the unknown entity %li", sequence, (long)state.id);
+		return;
+	}
+	_entitySnapshots.add(sequence) = std::move(states);
+	_lastEntitySnapshot = sequence;
+	for (const network::EntitySnapshotState& state : _changedEntityStates) {
+		const frontend::ClientEntityPtr& entity = getEntity(state.id);
+		if (!entity) {
+			continue;
+		}
+		entity->setPosition(network::dequantizePosition(state.pos));
+		entity->setOrientation(network::dequantizeOrientation(state.orientation));
+		entity->setAnimation(state.animation, true);
+	}
+
+	_snapshotAckFbb.Clear();
+	_messageSender->sendClientMessage(_snapshotAckFbb, network::ClientMsgType::EntitySnapshotAck,
+			network::CreateEntitySnapshotAck(_snapshotAckFbb, sequence).Union(), 0u);
+}
+
 void Client::entityRemove(frontend::ClientEntityId id) {
 	_worldRenderer.entityMgr().removeEntity(id);
 }
@@ -444,6 +491,8 @@ bool Client::connect(uint16_t port, const core::String& hostname) {
 	}
 
 	peer->data = this;
+	_entitySnapshots.clear();
+	_lastEntitySnapshot = 0u;
 	Log::info("Connecting to server %s:%i", hostname.c_str(), port);
 	return true;
 }
@@ -18,6 +18,7 @@
 #include "network/ClientNetwork.h"
 #include "network/ClientMessageSender.h"
 #include "network/NetworkEvents.h"
+#include "network/EntitySnapshot.h"
 #include "ui/nuklear/LUAUIApp.h"
 #include "animation/AnimationCache.h"
 #include "video/Camera.h"
@@ -38,6 +39,10 @@ protected:
 	frontend::PlayerMovement _movement;
 	flatbuffers::FlatBufferBuilder _actionFbb;
 	frontend::PlayerAction _action;
+	flatbuffers::FlatBufferBuilder _snapshotAckFbb;
+	network::EntitySnapshotHistory _entitySnapshots;
+	network::EntitySnapshotStates _changedEntityStates;
+	uint32_t _lastEntitySnapshot = 0u;
 	network::MoveDirection _lastMoveMask = network::MoveDirection::NONE;
 	glm::vec2 _lastMoveAngles {0.0f};
 	core::VarPtr _rotationSpeed;
@@ -98,6 +103,11 @@ public:
 
 	void entitySpawn(frontend::ClientEntityId id, network::EntityType type, float orientation, const glm::vec3& pos, animation::Animation animation);
 	void entityRemove(frontend::ClientEntityId id);
+	/**
+	 * @brief Applies the entity states of the snapshot and acknowledges it to let the server use it as baseline
+	 * @param[in] baseline The sequence number of the snapshot the data is encoded against - @c 0 for full states
+	 */
+	void entitySnapshot(uint32_t sequence, uint32_t baseline, const uint8_t* data, size_t size);
 	frontend::ClientEntityPtr getEntity(frontend::ClientEntityId id) const;
 };
 
@@ -0,0 +1,15 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "IClientProtocolHandler.h"
+
+/**
+ * Applies the delta encoded states of the @c frontend::ClientEntity instances that are part of the snapshot of the server tick
+ */
+CLIENTPROTOHANDLERIMPL(EntitySnapshot) {
+	const auto* data = message->data();
+	client->entitySnapshot(message->sequence(), message->baseline(), data->data(), data->size());
+}
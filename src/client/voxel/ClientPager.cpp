@@ -5,13 +5,24 @@
 #include "ClientPager.h"
 #include "core/App.h"
 #include "core/io/Filesystem.h"
+#include "core/StringUtil.h"
+#include "core/Common.h"
 #include "http/ResponseParser.h"
 #include "http/HttpMimeType.h"
 #include "voxel/Region.h"
+#include "voxelworld/ChunkBatch.h"
 
 namespace client {
 
+ClientPager::~ClientPager() {
+	shutdown();
+}
+
 bool ClientPager::init(const core::String& baseUrl) {
+	if (!_threadPoolStarted) {
+		_threadPool.init();
+		_threadPoolStarted = true;
+	}
 	if (baseUrl.empty()) {
 		return true;
 	}
@@ -20,25 +31,174 @@ bool ClientPager::init(const core::String& baseUrl) {
 	} else {
 		Log::info("Updated client pager url to '%s'", baseUrl.c_str());
 	}
+	_baseUrl = baseUrl;
+	resetPrefetch();
 
 	return true;
 }
 
+void ClientPager::shutdown() {
+	if (_threadPoolStarted) {
+		_threadPool.shutdown();
+		_threadPoolStarted = false;
+	}
+}
+
 void ClientPager::setSeed(unsigned int seed) {
 	_seed = seed;
 	Log::info("set seed: %u", _seed);
+	resetPrefetch();
 }
 
 void ClientPager::setMapId(int mapId) {
 	_mapId = mapId;
 	Log::info("set mapid: %u", _mapId);
+	resetPrefetch();
+}
+
+void ClientPager::resetPrefetch() {
+	std::unique_lock lock(_prefetchMutex);
+	_prefetched.clear();
+	_prefetchCenterValid = false;
+}
+
+void ClientPager::prefetch(const glm::ivec3& chunkPos) {
+	if (!_threadPoolStarted || _baseUrl.empty() || _mapId < 0) {
+		return;
+	}
+	core_trace_scoped(ClientPagerPrefetch);
+	std::vector<glm::ivec3> positions;
+	{
+		std::unique_lock lock(_prefetchMutex);
+		if (_prefetchCenterValid && _prefetchCenter == chunkPos) {
+			return;
+		}
+		_prefetchCenter = chunkPos;
+		_prefetchCenterValid = true;
+		// keep the set bounded while the camera travels through the world
+		for (auto i = _prefetched.begin(); i != _prefetched.end();) {
+			const glm::ivec3& delta = glm::abs(*i - chunkPos);
+			if (delta.x > PrefetchKeepRadius || delta.y > PrefetchKeepRadius || delta.z > PrefetchKeepRadius) {
+				i = _prefetched.erase(i);
+			} else {
+				++i;
+			}
+		}
+		// the pager doesn't page in chunks below the ground
+		const int minY = core_max(0, chunkPos.y - PrefetchRadius);
+		for (int x = chunkPos.x - PrefetchRadius; x <= chunkPos.x + PrefetchRadius; ++x) {
+			for (int y = minY; y <= chunkPos.y + PrefetchRadius; ++y) {
+				for (int z = chunkPos.z - PrefetchRadius; z <= chunkPos.z + PrefetchRadius; ++z) {
+					const glm::ivec3 pos(x, y, z);
+					if (_prefetched.insert(pos).second) {
+						positions.push_back(pos);
+					}
+				}
+			}
+		}
+	}
+	if (positions.empty()) {
+		return;
+	}
+	Log::debug(logid, "Prefetch %i chunks around %i:%i:%i", (int)positions.size(), chunkPos.x, chunkPos.y, chunkPos.z);
+
+	const unsigned int seed = _seed;
+	const int mapId = _mapId;
+	for (size_t i = 0; i < positions.size(); i += voxelworld::MaxChunkBatchSize) {
+		const size_t end = core_min(positions.size(), i + voxelworld::MaxChunkBatchSize);
+		std::vector<glm::ivec3> batch(positions.begin() + i, positions.begin() + end);
+		_threadPool.enqueue([this, baseUrl = _baseUrl, batch = std::move(batch), seed, mapId] () {
+			// the stored chunks are only revalidated with the entity tag of their stored format - the others are downloaded
+			std::vector<glm::ivec3> missing;
+			std::unordered_map<core::String, std::vector<glm::ivec3>, core::StringHash> cached;
+			{
+				std::unique_lock lock(_chunkPersisterMutex);
+				for (const glm::ivec3& pos : batch) {
+					const core::String& etag = _chunkPersister.storedETag(pos, seed);
+					if (etag.empty()) {
+						missing.push_back(pos);
+					} else {
+						cached[etag].push_back(pos);
+					}
+				}
+			}
+			std::vector<glm::ivec3> failed;
+			if (!missing.empty()) {
+				fetch(baseUrl, missing, core::String(), seed, mapId, failed);
+			}
+			for (const auto& e : cached) {
+				fetch(baseUrl, e.second, e.first, seed, mapId, failed);
+			}
+			if (failed.empty()) {
+				return;
+			}
+			// try again the next time the camera enters another chunk
+			std::unique_lock lock(_prefetchMutex);
+			for (const glm::ivec3& pos : failed) {
+				_prefetched.erase(pos);
+			}
+		});
+	}
+}
+
+void ClientPager::fetch(const core::String& baseUrl, const std::vector<glm::ivec3>& chunkPositions, const core::String& etag, unsigned int seed, int mapId,
+		std::vector<glm::ivec3>& failed) {
+	core_trace_scoped(ClientPagerFetch);
+	core::String list;
+	for (const glm::ivec3& pos : chunkPositions) {
+		if (!list.empty()) {
+			list += ";";
+		}
+		list += core::string::format("%i,%i,%i", pos.x, pos.y, pos.z);
+	}
+	http::HeaderMap headers(http::MaxHeaders);
+	if (!etag.empty()) {
+		headers.put(http::header::IF_NONE_MATCH, etag.c_str());
+	}
+	http::HttpClient httpClient(baseUrl);
+	const http::ResponseParser& response = httpClient.get(headers, "?mapid=%i&chunks=%s", mapId, list.c_str());
+	if (response.status == http::HttpStatus::NotModified) {
+		Log::debug(logid, "%i stored chunks are still valid", (int)chunkPositions.size());
+		return;
+	}
+	std::vector<voxelworld::ChunkBatchEntry> entries;
+	entries.reserve(chunkPositions.size());
+	if (response.status != http::HttpStatus::Ok) {
+		Log::warn(logid, "Failed to download %i chunks for seed %u on map %i", (int)chunkPositions.size(), seed, mapId);
+	} else if (!response.isHeaderValue(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNKS)) {
+		Log::error(logid, "Unexpected content type for the chunk batch");
+	} else if (!voxelworld::readChunkBatch((const uint8_t*)response.content, response.contentLength, entries)) {
+		entries.clear();
+	}
+	// the server leaves out the chunks that it didn't generate yet
+	std::unordered_set<glm::ivec3, std::hash<glm::ivec3>> stored;
+	for (const voxelworld::ChunkBatchEntry& entry : entries) {
+		if (storeChunk(entry.chunkPos, seed, entry.data, entry.length)) {
+			stored.insert(entry.chunkPos);
+		}
+	}
+	for (const glm::ivec3& pos : chunkPositions) {
+		if (stored.find(pos) == stored.end()) {
+			failed.push_back(pos);
+		}
+	}
+}
+
+bool ClientPager::storeChunk(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t *data, size_t length) {
+	std::unique_lock lock(_chunkPersisterMutex);
+	return _chunkPersister.write(chunkPos, seed, data, length);
+}
+
+bool ClientPager::loadChunk(voxel::PagedVolume::Chunk* chunk, unsigned int seed) {
+	std::unique_lock lock(_chunkPersisterMutex);
+	return _chunkPersister.load(chunk, seed);
 }
 
 bool ClientPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 	if (pctx.region.getLowerY() < 0) {
 		return false;
 	}
-	if (!_chunkPersister.load(pctx.chunk.get(), _seed)) {
+	if (!loadChunk(pctx.chunk.get(), _seed)) {
 		const int x = pctx.region.getLowerX();
 		const int y = pctx.region.getLowerY();
 		const int z = pctx.region.getLowerZ();
@@ -58,20 +218,17 @@ bool ClientPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 			Log::error("No content type set in response");
 			return false;
 		}
-		if (SDL_strcmp(contentType, "application/chunk")) {
+		if (SDL_strcmp(contentType, http::mimetype::APPLICATION_CHUNK)) {
 			Log::error("Unexpected content type: %s", contentType);
 			return false;
 		}
-		if (!_chunkPersister.loadCompressed(pctx.chunk.get(), (const uint8_t*)data, length)) {
-			Log::error("Failed to uncompress the chunk for position %i:%i:%i and seed %u", x, y, z, _seed);
-			return false;
-		}
-		if (!_chunkPersister.save(pctx.chunk.get(), _seed)) {
+		// the response is already in the format of the stored chunks
+		if (!storeChunk(pctx.chunk->chunkPos(), _seed, (const uint8_t*)data, length)) {
 			Log::error("Failed to save the downloaded chunk");
 			return false;
 		}
 	}
-	if (!_chunkPersister.load(pctx.chunk.get(), _seed)) {
+	if (!loadChunk(pctx.chunk.get(), _seed)) {
 		Log::error("Failed to load the world");
 	}
 	return false;
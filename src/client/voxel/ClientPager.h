@@ -9,17 +9,74 @@
 #include "network/ClientMessageSender.h"
 #include "http/HttpClient.h"
 #include "core/SharedPtr.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/Trace.h"
+#include <glm/gtx/hash.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <mutex>
 
 namespace client {
 
+/**
+ * @brief Pages in the chunks from the local files - the chunks are downloaded from the server if they are missing
+ *
+ * The chunks around the camera are requested ahead in batches on a worker thread (see @c prefetch()). Chunks
+ * that are already stored locally are revalidated with the entity tag of their stored format and generator version
+ * - the server answers with @c http::HttpStatus::NotModified if it would send the same chunks.
+ */
 class ClientPager : public voxel::PagedVolume::Pager {
+public:
+	/**
+	 * @brief The amount of chunks that are requested ahead around the camera chunk in every direction
+	 */
+	static constexpr int PrefetchRadius = 2;
+	/**
+	 * @brief The chunks that are farther away from the camera chunk are forgotten - they are revalidated again
+	 * once the camera comes back
+	 */
+	static constexpr int PrefetchKeepRadius = 2 * PrefetchRadius;
 private:
+	static constexpr auto logid = Log::logid("ClientPager");
 	http::HttpClient _httpClient;
 	unsigned int _seed = 0u;
 	int _mapId = -1;
 	voxelworld::FilePersister _chunkPersister;
+	// the prefetch workers and the pager read and write the same chunk files
+	core_trace_mutex(std::mutex, _chunkPersisterMutex);
+
+	core::ThreadPool _threadPool { 2, "ClientPager" };
+	bool _threadPoolStarted = false;
+	core::String _baseUrl;
+	core_trace_mutex(std::mutex, _prefetchMutex);
+	// the chunks around the camera that were requested or revalidated for the current seed and map
+	std::unordered_set<glm::ivec3, std::hash<glm::ivec3>> _prefetched;
+	glm::ivec3 _prefetchCenter { 0 };
+	bool _prefetchCenterValid = false;
+
+	void resetPrefetch();
+	/**
+	 * @brief Downloads the given chunks with one request and stores them locally
+	 * @param[in] etag The entity tag of the chunks that are already stored locally - they are only downloaded if
+	 * the server has another one. Empty for chunks that are not stored.
+	 * @param[out] failed The chunks that were not stored - e.g. because the server didn't generate them yet
+	 */
+	void fetch(const core::String& baseUrl, const std::vector<glm::ivec3>& chunkPositions, const core::String& etag, unsigned int seed, int mapId,
+			std::vector<glm::ivec3>& failed);
+	bool storeChunk(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t *data, size_t length);
+	bool loadChunk(voxel::PagedVolume::Chunk* chunk, unsigned int seed);
 public:
+	~ClientPager();
+
 	bool init(const core::String& baseUrl);
+	void shutdown();
+
+	/**
+	 * @brief Requests the chunks around the given chunk position asynchronously
+	 * @note Only does something if the chunk position changed since the last call
+	 */
+	void prefetch(const glm::ivec3& chunkPos);
 
 	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override;
 	void pageOut(voxel::PagedVolume::Chunk* chunk) override;
@@ -47,3 +47,71 @@ TEST_F(ZoneTest, testMassAdd1000000) {
 	zone.update(0l);
 	ASSERT_EQ(n, (int)zone.size());
 }
+
+TEST_F(ZoneTest, testExecuteParallel) {
+	ai::Zone zone("test1", 4);
+	ai::TreeNodePtr root = std::make_shared<ai::PrioritySelector>("test", "", ai::True::get());
+	const int n = 1000;
+	std::vector<ai::AIPtr> ais;
+	for (int i = 0; i < n; ++i) {
+		ai::ICharacterPtr character = std::make_shared<TestEntity>(i);
+		ai::AIPtr ai = std::make_shared<ai::AI>(root);
+		ai->setCharacter(character);
+		ais.push_back(ai);
+	}
+	ASSERT_TRUE(zone.addAIs(ais));
+	zone.update(1);
+	ASSERT_EQ(n, (int)zone.size());
+
+	std::vector<core::AtomicInt> visits(n);
+	auto func = [&] (const ai::AIPtr& ai) {
+		visits[ai->getId()].increment(1);
+	};
+	zone.executeParallel(func);
+	for (int i = 0; i < n; ++i) {
+		ASSERT_EQ(1, (int)visits[i]) << "ai " << i << " was not executed exactly once";
+	}
+
+	const ai::Zone::Statistics& stats = zone.statistics();
+	EXPECT_EQ(1u, stats.ticks);
+	EXPECT_GT(stats.batches, 1u);
+	EXPECT_GE((int)(stats.batches * stats.batchSize), n);
+	EXPECT_GE(stats.batchImbalance, 1.0f);
+	EXPECT_GE(stats.maxTickMicros, stats.averageTickMicros);
+}
+
+TEST_F(ZoneTest, testRemoveAndDestroy) {
+	ai::Zone zone("test1", 2);
+	ai::TreeNodePtr root = std::make_shared<ai::PrioritySelector>("test", "", ai::True::get());
+	const int n = 100;
+	std::vector<ai::AIPtr> ais;
+	for (int i = 0; i < n; ++i) {
+		ai::ICharacterPtr character = std::make_shared<TestEntity>(i);
+		ai::AIPtr ai = std::make_shared<ai::AI>(root);
+		ai->setCharacter(character);
+		ais.push_back(ai);
+	}
+	ASSERT_TRUE(zone.addAIs(ais));
+	zone.update(1);
+	for (int i = 0; i < n; i += 2) {
+		ASSERT_TRUE(zone.removeAI(ais[i]));
+	}
+	ASSERT_TRUE(zone.destroyAI(ais[1]->getId()));
+	// keep a reference to the list while it gets modified
+	int executed = 0;
+	zone.execute([&] (const ai::AIPtr& ai) {
+		if (executed++ == 0) {
+			zone.update(1);
+		}
+	});
+	EXPECT_EQ(n, executed);
+	EXPECT_EQ(n / 2 - 1, (int)zone.size());
+
+	core::AtomicInt visited(0);
+	zone.executeParallel([&] (const ai::AIPtr& ai) {
+		EXPECT_EQ(1, ai->getId() % 2) << "removed ai " << ai->getId() << " was executed";
+		EXPECT_NE(1, ai->getId()) << "destroyed ai was executed";
+		visited.increment(1);
+	});
+	EXPECT_EQ(n / 2 - 1, (int)visited);
+}
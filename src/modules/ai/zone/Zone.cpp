@@ -12,10 +12,39 @@ AIPtr Zone::getAI(CharacterId id) const {
 	if (i == _ais.end()) {
 		return AIPtr();
 	}
-	const AIPtr& ai = i->second;
+	const AIPtr& ai = (*_aiList)[i->second];
 	return ai;
 }
 
+Zone::AIListPtr Zone::aiList() const {
+	ScopedReadLock scopedLock(_lock);
+	return _aiList;
+}
+
+int Zone::batchSize(int amount) const {
+	const int batches = (int)_threadPool.size() * BatchesPerWorker;
+	return core_max(MinBatchSize, (amount + batches - 1) / batches);
+}
+
+Zone::AIList& Zone::writableAIList() {
+	// readers that still iterate the current list keep their reference - they get a copy only if needed
+	if (_aiList.use_count() != 1) {
+		_aiList = std::make_shared<AIList>(*_aiList);
+	}
+	return const_cast<AIList&>(*_aiList);
+}
+
+void Zone::removeFromAIList(AIIndexMap::iterator i) {
+	AIList& list = writableAIList();
+	const size_t index = i->second;
+	_ais.erase(i);
+	if (index != list.size() - 1u) {
+		list[index] = std::move(list.back());
+		_ais[list[index]->getId()] = index;
+	}
+	list.pop_back();
+}
+
 std::size_t Zone::size() const {
 	ScopedReadLock scopedLock(_lock);
 	return _ais.size();
@@ -29,7 +58,9 @@ bool Zone::doAddAI(const AIPtr& ai) {
 	if (_ais.find(id) != _ais.end()) {
 		return false;
 	}
-	_ais.insert(std::make_pair(id, ai));
+	AIList& list = writableAIList();
+	_ais.insert(std::make_pair(id, list.size()));
+	list.push_back(ai);
 	ai->setZone(this);
 	return true;
 }
@@ -39,22 +70,23 @@ bool Zone::doRemoveAI(const AIPtr& ai) {
 		return false;
 	}
 	const CharacterId& id = ai->getCharacter()->getId();
-	AIMapIter i = _ais.find(id);
+	AIIndexMap::iterator i = _ais.find(id);
 	if (i == _ais.end()) {
 		return false;
 	}
-	i->second->setZone(nullptr);
-	_groupManager.removeFromAllGroups(i->second);
-	_ais.erase(i);
+	const AIPtr& zoneAI = (*_aiList)[i->second];
+	zoneAI->setZone(nullptr);
+	_groupManager.removeFromAllGroups(zoneAI);
+	removeFromAIList(i);
 	return true;
 }
 
 bool Zone::doDestroyAI(const CharacterId& id) {
-	AIMapIter i = _ais.find(id);
+	AIIndexMap::iterator i = _ais.find(id);
 	if (i == _ais.end()) {
 		return false;
 	}
-	_ais.erase(i);
+	removeFromAIList(i);
 	return true;
 }
 
@@ -83,6 +115,7 @@ bool Zone::removeAI(const AIPtr& ai) {
 }
 
 void Zone::update(int64_t dt) {
+	const uint64_t start = SDL_GetPerformanceCounter();
 	{
 		AIScheduleList scheduledRemove;
 		AIScheduleList scheduledAdd;
@@ -115,8 +148,33 @@ void Zone::update(int64_t dt) {
 		ai->update(dt, _debug);
 		ai->getBehaviour()->execute(ai, dt);
 	};
-	executeParallel(func);
+	const AIListPtr ais = aiList();
+	const int amount = (int)ais->size();
+	const int size = batchSize(amount);
+	_batchMicros.resize((amount + size - 1) / size);
+	const int batches = executeBatches(*ais, func, _batchMicros.data());
 	_groupManager.update(dt);
+
+	_statistics.batches = (uint32_t)batches;
+	_statistics.batchSize = batches > 0 ? (uint32_t)size : 0u;
+	_statistics.batchImbalance = 1.0f;
+	if (batches > 1) {
+		uint64_t sum = 0u;
+		uint64_t max = 0u;
+		for (int i = 0; i < batches; ++i) {
+			sum += _batchMicros[i];
+			max = core_max(max, _batchMicros[i]);
+		}
+		if (sum > 0u) {
+			_statistics.batchImbalance = (float)max * (float)batches / (float)sum;
+		}
+	}
+	const uint64_t tickMicros = (SDL_GetPerformanceCounter() - start) * 1000000u / SDL_GetPerformanceFrequency();
+	++_statistics.ticks;
+	_tickSumMicros += tickMicros;
+	_statistics.lastTickMicros = tickMicros;
+	_statistics.averageTickMicros = _tickSumMicros / _statistics.ticks;
+	_statistics.maxTickMicros = core_max(_statistics.maxTickMicros, tickMicros);
 }
 
 }
@@ -17,10 +17,14 @@
 #include "group/GroupMgr.h"
 #include "common/Thread.h"
 #include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Atomic.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/Common.h"
 #include "common/CharacterId.h"
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <SDL_timer.h>
 
 namespace ai {
 
@@ -38,15 +42,51 @@ typedef std::shared_ptr<AI> AIPtr;
  */
 class Zone {
 public:
-	typedef std::unordered_map<CharacterId, AIPtr> AIMap;
+	typedef std::vector<AIPtr> AIList;
+	typedef std::shared_ptr<const AIList> AIListPtr;
 	typedef std::vector<AIPtr> AIScheduleList;
 	typedef std::vector<CharacterId> CharacterIdList;
-	typedef AIMap::const_iterator AIMapConstIter;
-	typedef AIMap::iterator AIMapIter;
+	/**
+	 * @brief Maps the @c CharacterId to the index in the @c AI list
+	 */
+	typedef std::unordered_map<CharacterId, size_t> AIIndexMap;
+
+	struct Statistics {
+		uint64_t ticks = 0u;
+		uint64_t lastTickMicros = 0u;
+		uint64_t averageTickMicros = 0u;
+		uint64_t maxTickMicros = 0u;
+		// the ai batches of the last tick
+		uint32_t batches = 0u;
+		uint32_t batchSize = 0u;
+		// the slowest batch of the last tick relative to the average batch - 1.0 is perfectly balanced
+		float batchImbalance = 1.0f;
+	};
 
 protected:
+	/**
+	 * @brief The smallest amount of @c AI instances that are ticked in one batch by one worker
+	 */
+	static constexpr int MinBatchSize = 32;
+	/**
+	 * @brief The amount of batches per worker - more batches allow the workers that are done early to take over
+	 * the remaining batches of the slower ones
+	 */
+	static constexpr int BatchesPerWorker = 4;
+
 	const core::String _name;
-	AIMap _ais;
+	AIIndexMap _ais;
+	/**
+	 * @brief The contiguous list of all @c AI instances of the zone.
+	 *
+	 * The list is only modified in @c Zone::update if instances were added or removed. Readers take a reference
+	 * to the list and iterate it without holding the lock - if a reader still holds the list, the next
+	 * modification is done on a copy.
+	 */
+	AIListPtr _aiList;
+	Statistics _statistics;
+	uint64_t _tickSumMicros = 0u;
+	std::vector<uint64_t> _batchMicros;
 	AIScheduleList _scheduledAdd;
 	AIScheduleList _scheduledRemove;
 	CharacterIdList _scheduledDestroy;
@@ -76,9 +116,80 @@ protected:
 	 */
 	bool doDestroyAI(const CharacterId& id);
 
+	/**
+	 * @return The list of @c AI instances that can be iterated without holding the zone lock
+	 */
+	AIListPtr aiList() const;
+
+	/**
+	 * @return The @c AI list that can be modified - a copy if the current list is still in use by a reader
+	 * @note The zone must be locked for writing
+	 */
+	AIList& writableAIList();
+	/**
+	 * @brief Removes the @c AI at the given index - the last @c AI in the list takes its place
+	 * @note The zone must be locked for writing
+	 */
+	void removeFromAIList(AIIndexMap::iterator i);
+
+	/**
+	 * @return The amount of @c AI instances that are ticked in one batch
+	 */
+	int batchSize(int amount) const;
+
+	/**
+	 * @brief Splits the given list into batches and executes them in parallel - the calling thread also takes
+	 * part in the execution. Every worker picks the next unprocessed batch until none is left.
+	 * @param[out] batchMicros Optional array that receives the execution time of each batch
+	 * @return The amount of batches
+	 */
+	template<typename Func>
+	int executeBatches(const AIList& ais, Func& func, uint64_t* batchMicros = nullptr) const {
+		const int amount = (int)ais.size();
+		if (amount == 0) {
+			return 0;
+		}
+		const int size = batchSize(amount);
+		const int batches = (amount + size - 1) / size;
+		core::AtomicInt nextBatch(0);
+		auto worker = [&] () {
+			for (;;) {
+				const int batch = nextBatch.increment(1);
+				if (batch >= batches) {
+					break;
+				}
+				const uint64_t start = batchMicros != nullptr ? SDL_GetPerformanceCounter() : 0u;
+				const int end = core_min(amount, (batch + 1) * size);
+				for (int i = batch * size; i < end; ++i) {
+					func(ais[i]);
+				}
+				if (batchMicros != nullptr) {
+					batchMicros[batch] = (SDL_GetPerformanceCounter() - start) * 1000000u / SDL_GetPerformanceFrequency();
+				}
+			}
+		};
+		const int helpers = core_min((int)_threadPool.size() - 1, batches - 1);
+		std::vector<std::future<void> > results;
+		results.reserve(helpers);
+		for (int i = 0; i < helpers; ++i) {
+			results.emplace_back(_threadPool.enqueue(worker));
+		}
+		worker();
+		for (auto & result: results) {
+			if (result.valid()) {
+				result.wait();
+			}
+		}
+		return batches;
+	}
+
 public:
-	Zone(const core::String& name, int threadCount = (std::min)(1u, std::thread::hardware_concurrency())) :
-			_name(name), _debug(false), _threadPool(threadCount) {
+	/**
+	 * @param threadCount The amount of threads that tick the @c AI instances of the zone - the thread that calls
+	 * @c Zone::update is one of them. Defaults to the amount of cpu cores.
+	 */
+	Zone(const core::String& name, int threadCount = (int)core::cpus()) :
+			_name(name), _aiList(std::make_shared<AIList>()), _debug(false), _threadPool(core_max(1, threadCount), "zone") {
 		_threadPool.init();
 	}
 
@@ -250,17 +361,8 @@ public:
 	 */
 	template<typename Func>
 	void executeParallel(Func& func) {
-		std::vector<std::future<void> > results;
-		_lock.lockRead();
-		AIMap copy(_ais);
-		_lock.unlockRead();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		const AIListPtr ais = aiList();
+		executeBatches(*ais, func);
 	}
 
 	/**
@@ -272,17 +374,8 @@ public:
 	 */
 	template<typename Func>
 	void executeParallel(const Func& func) const {
-		std::vector<std::future<void> > results;
-		_lock.lockRead();
-		AIMap copy(_ais);
-		_lock.unlockRead();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		const AIListPtr ais = aiList();
+		executeBatches(*ais, func);
 	}
 
 	/**
@@ -293,11 +386,8 @@ public:
 	 */
 	template<typename Func>
 	void execute(const Func& func) const {
-		_lock.lockRead();
-		AIMap copy(_ais);
-		_lock.unlockRead();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		const AIListPtr ais = aiList();
+		for (const AIPtr& ai : *ais) {
 			func(ai);
 		}
 	}
@@ -310,18 +400,24 @@ public:
 	 */
 	template<typename Func>
 	void execute(Func& func) {
-		_lock.lockRead();
-		AIMap copy(_ais);
-		_lock.unlockRead();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		const AIListPtr ais = aiList();
+		for (const AIPtr& ai : *ais) {
 			func(ai);
 		}
 	}
 
 	std::size_t size() const;
+
+	/**
+	 * @brief The tick times of the zone and the balance of the ai batches of the last tick
+	 */
+	const Statistics& statistics() const;
 };
 
+inline const Zone::Statistics& Zone::statistics() const {
+	return _statistics;
+}
+
 inline void Zone::setDebug (bool debug) {
 	_debug = debug;
 }
@@ -3,7 +3,6 @@
  */
 
 #include "Entity.h"
-#include "core/collection/Set.h"
 #include "core/ArrayLength.h"
 #include "core/Assert.h"
 #include "core/Log.h"
@@ -15,6 +14,7 @@
 #include "network/ServerMessageSender.h"
 #include "network/ProtocolEnum.h"
 #include "attrib/ContainerProvider.h"
+#include <algorithm>
 
 namespace backend {
 
@@ -31,14 +31,14 @@ Entity::Entity(EntityId id,
 Entity::~Entity() {
 }
 
-void Entity::visibleAdd(const EntitySet& entities) {
+void Entity::visibleAdd(const EntityList& entities) {
 	for (const EntityPtr& e : entities) {
 		Log::trace("entity %i is visible for %i", (int)e->id(), (int)id());
 		sendEntitySpawn(e);
 	}
 }
 
-void Entity::visibleRemove(const EntitySet& entities) {
+void Entity::visibleRemove(const EntityList& entities) {
 	for (const EntityPtr& e : entities) {
 		Log::trace("entity %i is no longer visible for %i", (int)e->id(), (int)id());
 		sendEntityRemove(e);
@@ -59,22 +59,20 @@ bool Entity::attack(EntityId victimId) {
 
 void Entity::sendToVisible(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type,
 		flatbuffers::Offset<void> data, bool sendToSelf, uint32_t flags) const {
-	const EntitySet& visible = visibleCopy();
 	std::vector<ENetPeer*> peers;
-	peers.reserve(visible.size() + 1);
 	if (sendToSelf) {
 		ENetPeer* p = peer();
 		if (p != nullptr) {
 			peers.push_back(p);
 		}
 	}
-	for (const EntityPtr& e : visible) {
+	visitVisible([&] (const EntityPtr& e) {
 		ENetPeer* peer = e->peer();
 		if (peer == nullptr) {
-			continue;
+			return;
 		}
 		peers.push_back(peer);
-	}
+	});
 	if (peers.empty()) {
 		Log::debug("don't send message of type '%s' - no peers found", network::toString(type, network::EnumNamesServerMsgType()));
 		return;
@@ -99,6 +97,7 @@ void Entity::init() {
 			attrib::Type::HEALTH,
 			attrib::Type::SPEED,
 			attrib::Type::VIEWDISTANCE,
+			attrib::Type::FIELDOFVIEW,
 			attrib::Type::ATTACKRANGE,
 			attrib::Type::STRENGTH };
 
@@ -167,35 +166,49 @@ bool Entity::update(long dt) {
 	return true;
 }
 
-void Entity::updateVisible(const EntitySet& set) {
-	_visibleLock.lockWrite();
-	const auto& stillVisible = core::setIntersection(set, _visible);
-	const EntitySet& remove = core::setDifference(stillVisible, _visible);
-	const EntitySet& add = core::setDifference(set, stillVisible);
-	_visible = core::setUnion(stillVisible, add);
-	_visibleLock.unlockWrite();
+void Entity::updateVisible(const EntityList& entities) {
+	_visibleNext = entities;
+	if (!std::is_sorted(_visibleNext.begin(), _visibleNext.end(), visibleLess)) {
+		std::sort(_visibleNext.begin(), _visibleNext.end(), visibleLess);
+	}
 
-	for (const auto& e : _visible) {
-		sendEntityUpdate(e);
+	_visibleLock.lockWrite();
+	// both lists are sorted - one merge pass finds the entities that entered and left the view
+	auto oldIter = _visible.begin();
+	auto newIter = _visibleNext.begin();
+	while (oldIter != _visible.end() || newIter != _visibleNext.end()) {
+		if (newIter == _visibleNext.end() || (oldIter != _visible.end() && visibleLess(*oldIter, *newIter))) {
+			_visibleRemoved.push_back(*oldIter++);
+		} else if (oldIter == _visible.end() || visibleLess(*newIter, *oldIter)) {
+			_visibleAdded.push_back(*newIter++);
+		} else {
+			++oldIter;
+			++newIter;
+		}
 	}
+	_visible.swap(_visibleNext);
+	_visibleLock.unlockWrite();
+	_visibleNext.clear();
 
-	if (!add.empty()) {
-		visibleAdd(add);
+	if (!_visibleAdded.empty()) {
+		visibleAdd(_visibleAdded);
+		_visibleAdded.clear();
 	}
-	if (!remove.empty()) {
-		visibleRemove(remove);
+	if (!_visibleRemoved.empty()) {
+		visibleRemove(_visibleRemoved);
+		_visibleRemoved.clear();
 	}
 }
 
-void Entity::sendEntityUpdate(const EntityPtr& entity) const {
-	if (_peer == nullptr) {
-		return;
+bool Entity::ackSnapshot(uint32_t sequence) {
+	if (sequence <= _ackedSnapshot || sequence > _snapshotSequence) {
+		return false;
 	}
-	const glm::vec3& _pos = entity->pos();
-	const network::Vec3 pos { _pos.x, _pos.y, _pos.z };
-	_entityUpdateFBB.Clear();
-	_messageSender->sendServerMessage(_peer, _entityUpdateFBB, network::ServerMsgType::EntityUpdate,
-			network::CreateEntityUpdate(_entityUpdateFBB, entity->id(), &pos, entity->orientation(), entity->animation()).Union());
+	if (_snapshots.get(sequence) == nullptr) {
+		return false;
+	}
+	_ackedSnapshot = sequence;
+	return true;
 }
 
 void Entity::sendEntitySpawn(const EntityPtr& entity) const {
@@ -204,11 +217,10 @@ void Entity::sendEntitySpawn(const EntityPtr& entity) const {
 	}
 	const glm::vec3& pos = entity->pos();
 	const network::Vec3 vec3 { pos.x, pos.y, pos.z };
-	const EntityId entityId = id();
 	_entitySpawnFBB.Clear();
 	// TODO: User::sendUserSpawn()?
 	_messageSender->sendServerMessage(_peer, _entitySpawnFBB, network::ServerMsgType::EntitySpawn,
-			network::CreateEntitySpawn(_entitySpawnFBB, entity->id(), entity->entityType(), &vec3, entityId, entity->animation()).Union());
+			network::CreateEntitySpawn(_entitySpawnFBB, entity->id(), entity->entityType(), &vec3, entity->orientation(), entity->animation()).Union());
 }
 
 void Entity::sendEntityRemove(const EntityPtr& entity) const {
@@ -12,29 +12,44 @@
 #include "backend/ForwardDecl.h"
 #include "ServerMessages_generated.h"
 #include "network/IProtocolHandler.h"
+#include "network/EntitySnapshot.h"
 
 #include <unordered_set>
 #include <memory>
+#include <vector>
 
 namespace backend {
 
-typedef std::unordered_set<EntityPtr> EntitySet;
+/**
+ * @brief List of entities - the visible entities are sorted by their id
+ */
+typedef std::vector<EntityPtr> EntityList;
 
 /**
  * @brief Every actor in the world is an entity
  *
- * Entities are updated via @c network::ServerMsgType::EntityUpdate
+ * Entities are updated via @c network::ServerMsgType::EntitySnapshot
  * message for the clients that are seeing the entity
  *
- * @sa EntityUpdateHandler
+ * @sa EntityReplicator
+ * @sa EntitySnapshotHandler
  */
 class Entity : public std::enable_shared_from_this<Entity> {
 private:
 	core::ReadWriteLock _visibleLock {"Entity"};
-	EntitySet _visible;
+	// sorted by visibleLess()
+	EntityList _visible;
+	// only used in updateVisible() - they are members to keep their memory between the updates
+	EntityList _visibleNext;
+	EntityList _visibleAdded;
+	EntityList _visibleRemoved;
+
+	// the snapshots that were sent to the peer of this entity - see @c EntityReplicator
+	network::EntitySnapshotHistory _snapshots;
+	uint32_t _snapshotSequence = 0u;
+	uint32_t _ackedSnapshot = 0u;
 	// they are stored as members to reduce memory allocations
 	mutable flatbuffers::FlatBufferBuilder _attribUpdateFBB;
-	mutable flatbuffers::FlatBufferBuilder _entityUpdateFBB;
 	mutable flatbuffers::FlatBufferBuilder _entitySpawnFBB;
 	mutable flatbuffers::FlatBufferBuilder _entityRemoveFBB;
 
@@ -61,14 +76,13 @@ protected:
 	/**
 	 * @brief Called with the set of entities that just get visible for this entity
 	 */
-	void visibleAdd(const EntitySet& entities);
+	void visibleAdd(const EntityList& entities);
 	/**
 	 * @brief Called with the set of entities that just get invisible for this entity
 	 */
-	void visibleRemove(const EntitySet& entities);
+	void visibleRemove(const EntityList& entities);
 
 	void broadcastAttribUpdate();
-	void sendEntityUpdate(const EntityPtr& entity) const;
 	void sendEntitySpawn(const EntityPtr& entity) const;
 	void sendEntityRemove(const EntityPtr& entity) const;
 
@@ -127,11 +141,11 @@ public:
 	int visibleCount() const;
 
 	/**
-	 * @brief Allows to execute a functor/lambda on the visible objects
+	 * @brief Allows to execute a functor/lambda on the visible objects - they are visited in the order of their ids
 	 * @note This is thread safe
 	 */
 	template<typename Func>
-	void visitVisible(Func&& func) {
+	void visitVisible(Func&& func) const {
 		core::ScopedReadLock lock(_visibleLock);
 		for (const EntityPtr& e : _visible) {
 			func(e);
@@ -142,18 +156,52 @@ public:
 	 * @brief Creates a copy of the currently visible objects. If you don't need a copy, use the @c Entity::visibleVisible method.
 	 * @note This is thread safe
 	 */
-	inline EntitySet visibleCopy() const {
+	inline EntityList visibleCopy() const {
 		core::ScopedReadLock lock(_visibleLock);
-		return EntitySet(_visible);
+		return EntityList(_visible);
+	}
+
+	/**
+	 * @brief The order of the visible entities. The ids of the users and the npcs are not unique across both
+	 * types - the entity type is part of the key.
+	 */
+	static inline bool visibleLess(const EntityPtr& lhs, const EntityPtr& rhs) {
+		if (lhs->entityType() != rhs->entityType()) {
+			return lhs->entityType() < rhs->entityType();
+		}
+		return lhs->id() < rhs->id();
 	}
 
 	/**
 	 * @brief This will inform the entity about all the other entities that it can see.
-	 * @param[in] set The entities that are currently visible
+	 * @param[in] entities The entities that are currently visible - if they are sorted by @c visibleLess(), no sorting is needed
 	 * @note All entities have the same view range - see @c Entity::regionRect
-	 * @note This is thread safe
+	 * @note This is thread safe - but must not be called concurrently for the same entity
 	 */
-	void updateVisible(const EntitySet& set);
+	void updateVisible(const EntityList& entities);
+
+	/**
+	 * @brief The snapshots of the visible entity states that were sent to the peer of this entity
+	 */
+	network::EntitySnapshotHistory& snapshots();
+	/**
+	 * @return The sequence number for the next snapshot that is sent to the peer of this entity
+	 */
+	uint32_t nextSnapshotSequence();
+	/**
+	 * @return The sequence number of the last snapshot that was sent to the peer of this entity - or @c 0
+	 */
+	uint32_t lastSnapshot() const;
+	/**
+	 * @return The sequence number of the newest snapshot the peer of this entity acknowledged - or @c 0
+	 */
+	uint32_t ackedSnapshot() const;
+	/**
+	 * @brief The peer received the snapshot with the given sequence number - it can be used as baseline
+	 * for the next snapshots
+	 * @return @c false if the sequence number is unknown or older than the last acknowledged one
+	 */
+	bool ackSnapshot(uint32_t sequence);
 
 	/**
 	 * @brief The tick of the entity
@@ -204,6 +252,22 @@ public:
 			flatbuffers::Offset<void> data, bool sendToSelf = false, uint32_t flags = ENET_PACKET_FLAG_RELIABLE) const;
 };
 
+inline network::EntitySnapshotHistory& Entity::snapshots() {
+	return _snapshots;
+}
+
+inline uint32_t Entity::nextSnapshotSequence() {
+	return ++_snapshotSequence;
+}
+
+inline uint32_t Entity::lastSnapshot() const {
+	return _snapshotSequence;
+}
+
+inline uint32_t Entity::ackedSnapshot() const {
+	return _ackedSnapshot;
+}
+
 inline int Entity::visibleCount() const {
 	return (int)_visible.size();
 }
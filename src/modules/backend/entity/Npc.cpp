@@ -2,9 +2,6 @@
  * @file
  */
 
-#if 0
-#include "voxelutil/AStarPathfinder.h"
-#endif
 #include "Npc.h"
 #include "ai/AICharacter.h"
 #include "ai/AI.h"
@@ -83,16 +80,40 @@ bool Npc::update(long dt) {
 }
 
 bool Npc::route(const glm::ivec3& target) {
-#if 0
-	std::list<glm::ivec3> result;
-	const glm::vec3& pos = _aiChr->getPosition();
-	const glm::ivec3 start(pos);
-	const glm::ivec3 end(target.x, target.y, target.z);
-	if (!_map->findPath(start, end, result)) {
+	const glm::ivec3 start(_aiChr->getPosition());
+	if (start.x == target.x && start.z == target.z) {
+		// already there - no need to know the floor
+		_route.assign(1, target);
+		_routeIndex = 0u;
+		return true;
+	}
+	_routeIndex = 0u;
+	if (!_map->findPath(start, target, _route)) {
+		_route.clear();
 		return false;
 	}
-	// TODO: use the route
-#endif
+	return true;
+}
+
+bool Npc::moveAlongRoute(int64_t deltaMillis) {
+	glm::vec3 pos = _aiChr->getPosition();
+	float distance = current(attrib::Type::SPEED) * static_cast<float>(deltaMillis) / 1000.0f;
+	while (_routeIndex < _route.size()) {
+		const glm::ivec3& waypoint = _route[_routeIndex];
+		const glm::vec3 delta(waypoint.x - pos.x, 0.0f, waypoint.z - pos.z);
+		const float length = glm::length(delta);
+		if (length > distance) {
+			pos += delta * (distance / length);
+			_aiChr->setOrientation(ai::angle(delta));
+			_aiChr->setPosition(pos);
+			return false;
+		}
+		distance -= length;
+		pos.x = (float)waypoint.x;
+		pos.z = (float)waypoint.z;
+		++_routeIndex;
+	}
+	_aiChr->setPosition(pos);
 	return true;
 }
 
@@ -13,6 +13,7 @@
 #include "network/ServerMessageSender.h"
 
 #include <atomic>
+#include <vector>
 
 namespace backend {
 
@@ -27,6 +28,10 @@ private:
 	glm::ivec3 _homePosition;
 	ai::AIPtr _ai;
 	AICharacterPtr _aiChr;
+	// the floor positions of the last route
+	std::vector<glm::ivec3> _route;
+	// the next position of the route that the npc moves to
+	size_t _routeIndex = 0u;
 
 	// cooldowns
 	cooldown::CooldownMgr _cooldowns;
@@ -50,7 +55,22 @@ public:
 
 	void setHomePosition(const glm::ivec3& pos);
 	const glm::ivec3& homePosition() const;
+	/**
+	 * @brief Computes the route from the current position to the given target
+	 * @return @c false if the target isn't reachable on the paged in chunks
+	 */
 	bool route(const glm::ivec3& target);
+	/**
+	 * @brief Moves the npc along the route that was computed by @c route()
+	 * @note Only the x and z components are walked - the npc is put onto the floor by the ai update.
+	 * @return @c true if the end of the route is reached
+	 */
+	bool moveAlongRoute(int64_t deltaMillis);
+	/**
+	 * @return @c true if the current route ends at the given target and the end is not yet reached
+	 */
+	bool hasRoute(const glm::ivec3& target) const;
+	const std::vector<glm::ivec3>& currentRoute() const;
 	const ai::AIPtr& ai();
 
 	cooldown::CooldownMgr& cooldownMgr();
@@ -77,6 +97,14 @@ inline const glm::ivec3& Npc::homePosition() const {
 	return _homePosition;
 }
 
+inline bool Npc::hasRoute(const glm::ivec3& target) const {
+	return _routeIndex < _route.size() && _route.back().x == target.x && _route.back().z == target.z;
+}
+
+inline const std::vector<glm::ivec3>& Npc::currentRoute() const {
+	return _route;
+}
+
 inline const ai::AIPtr& Npc::ai() {
 	return _ai;
 }
@@ -11,10 +11,14 @@ namespace backend {
 
 AI_TASK(GoHome) {
 	backend::Npc& npc = chr.getNpc();
-	if (npc.route(npc.homePosition())) {
+	// the route is only computed once - the following ticks move the npc along it
+	if (!npc.hasRoute(npc.homePosition()) && !npc.route(npc.homePosition())) {
+		return ai::TreeNodeStatus::FAILED;
+	}
+	if (npc.moveAlongRoute(deltaMillis)) {
 		return ai::TreeNodeStatus::FINISHED;
 	}
-	return ai::TreeNodeStatus::FAILED;
+	return ai::TreeNodeStatus::RUNNING;
 }
 
 }
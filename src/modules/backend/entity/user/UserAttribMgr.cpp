@@ -38,9 +38,9 @@ bool UserAttribMgr::init() {
 		Log::warn("Could not load attributes for user " PRIEntId, _userId);
 	}
 
-	// initialize the models
-	_dirtyModels.resize(int(attrib::Type::MAX));
-	for (std::underlying_type<attrib::Type>::type i = 0; i < int(attrib::Type::MAX); ++i) {
+	// initialize the models - the max value of the enum is the last valid attribute type
+	_dirtyModels.resize(int(attrib::Type::MAX) + 1);
+	for (std::underlying_type<attrib::Type>::type i = 0; i <= int(attrib::Type::MAX); ++i) {
 		db::AttribModel& model = _dirtyModels[i];
 		model.setAttribtype(i);
 		model.setUserid(_userId);
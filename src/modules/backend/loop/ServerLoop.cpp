@@ -26,6 +26,7 @@
 #include "backend/network/TriggerActionHandler.h"
 #include "backend/network/VarUpdateHandler.h"
 #include "backend/network/MoveHandler.h"
+#include "backend/network/EntitySnapshotAckHandler.h"
 #include "persistence/PersistenceMgr.h"
 #include "backend/world/World.h"
 #include "core/command/CommandHandler.h"
@@ -52,7 +53,8 @@ ServerLoop::ServerLoop(const core::TimeProviderPtr& timeProvider, const MapProvi
 		_entityStorage(entityStorage), _eventBus(eventBus), _attribContainerProvider(containerProvider),
 		_cooldownProvider(cooldownProvider), _eventMgr(eventMgr), _dbHandler(dbHandler),
 		_stockDataProvider(stockDataProvider), _metricMgr(metricMgr), _filesystem(filesystem),
-		_persistenceMgr(persistenceMgr), _volumeCache(volumeCache), _httpServer(httpServer) {
+		_persistenceMgr(persistenceMgr), _volumeCache(volumeCache), _httpServer(httpServer),
+		_persistenceThreadPool(1, "persistence") {
 	_eventBus->subscribe<network::DisconnectEvent>(*this);
 }
 
@@ -325,6 +327,7 @@ bool ServerLoop::init() {
 	regHandler(network::ClientMsgType::TriggerAction, TriggerActionHandler);
 	regHandler(network::ClientMsgType::Move, MoveHandler);
 	regHandler(network::ClientMsgType::VarUpdate, VarUpdateHandler);
+	regHandler(network::ClientMsgType::EntitySnapshotAck, EntitySnapshotAckHandler);
 
 	Log::info("Init material");
 	if (!voxel::initDefaultMaterialColors()) {
@@ -347,14 +350,15 @@ bool ServerLoop::init() {
 		loop->_world->update(handle->repeat);
 	}, 100);
 
+	_persistenceThreadPool.init();
 	_persistenceMgrTimer = new uv_timer_t;
 	uv_timer_init(_loop, _persistenceMgrTimer);
 	addTimer(_persistenceMgrTimer, [] (uv_timer_t* handle) {
 		core_trace_scoped(PersistenceTimer);
-		const ServerLoop* loop = (const ServerLoop*)handle->data;
+		ServerLoop* loop = (ServerLoop*)handle->data;
 		const long dt = handle->repeat;
 		const persistence::PersistenceMgrPtr& persistenceMgr = loop->_persistenceMgr;
-		core::App::getInstance()->threadPool().enqueue([=] () {
+		loop->_persistenceThreadPool.enqueue([=] () {
 			persistenceMgr->update(dt);
 		});
 	}, 10000);
@@ -393,6 +397,7 @@ bool ServerLoop::init() {
 }
 
 void ServerLoop::shutdown() {
+	_persistenceThreadPool.shutdown();
 	_persistenceMgr->shutdown();
 	_world->shutdown();
 	_dbHandler->shutdown();
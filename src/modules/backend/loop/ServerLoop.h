@@ -8,6 +8,7 @@
 #include "core/Trace.h"
 #include "core/EventBus.h"
 #include "core/IComponent.h"
+#include "core/concurrent/ThreadPool.h"
 #include "network/ServerNetwork.h"
 #include "network/NetworkEvents.h"
 #include "backend/ForwardDecl.h"
@@ -42,6 +43,9 @@ private:
 	persistence::PersistenceMgrPtr _persistenceMgr;
 	voxelformat::VolumeCachePtr _volumeCache;
 	http::HttpServerPtr _httpServer;
+	// the blocking database work must not delay the tasks of the application thread pool - the maps run
+	// their visibility updates there
+	core::ThreadPool _persistenceThreadPool;
 
 	uv_loop_t *_loop = nullptr;
 	uv_timer_t *_worldTimer = nullptr;
@@ -48,6 +48,28 @@ TEST_F(AITest, testFilterSelectVisible) {
 		<< "This npc should not be part of the visible set";
 }
 
+TEST_F(AITest, testUpdateVisible) {
+	const NpcPtr& npc = create();
+	const NpcPtr& npc2 = create();
+	const NpcPtr& npc3 = create();
+	const NpcPtr& npc4 = create();
+	npc->updateVisible({npc4, npc2});
+	EXPECT_EQ(2, npc->visibleCount());
+	npc->updateVisible({npc2, npc3, npc4});
+	EXPECT_EQ(3, npc->visibleCount());
+	npc->updateVisible({npc3});
+	EXPECT_EQ(1, npc->visibleCount());
+	npc->updateVisible({npc4, npc3, npc2});
+	std::vector<EntityId> ids;
+	npc->visitVisible([&] (const EntityPtr& e) {
+		ids.push_back(e->id());
+	});
+	const std::vector<EntityId> expected { npc2->id(), npc3->id(), npc4->id() };
+	EXPECT_EQ(expected, ids) << "The visible entities should be sorted by id";
+	npc->updateVisible({});
+	EXPECT_EQ(0, npc->visibleCount());
+}
+
 TEST_F(AITest, testFilterSelectEntitiesOfTypes) {
 	const NpcPtr& npc = create(network::EntityType::ANIMAL_RABBIT);
 	const NpcPtr& typeOne1 = create(network::EntityType::ANIMAL_RABBIT);
@@ -131,6 +153,38 @@ TEST_F(AITest, testActionGoHome) {
 	EXPECT_EQ(ai::TreeNodeStatus::FINISHED, action->execute(npc->ai(), 0L));
 }
 
+TEST_F(AITest, testActionGoHomeFollowsRoute) {
+	// the grid only knows the top surface - search two connected columns that aren't covered by a tree
+	std::vector<glm::ivec3> path;
+	glm::ivec3 start(0);
+	glm::ivec3 home(0);
+	bool found = false;
+	for (int i = 0; i < 64 && !found; ++i) {
+		start = glm::ivec3((i % 8) * 8, 0, (i / 8) * 8);
+		home = start + glm::ivec3(6, 0, 4);
+		// pages in the chunks of both columns
+		map->findFloor(start);
+		map->findFloor(home);
+		found = map->findPath(start, home, path);
+	}
+	ASSERT_TRUE(found) << "No walkable columns found";
+	const NpcPtr& npc = map->spawnMgr()->spawn(network::EntityType::ANIMAL_RABBIT, &start);
+	ASSERT_TRUE(npc);
+	map->zone()->update(0L);
+	npc->setHomePosition(home);
+	const ai::TreeNodeFactoryContext ctx("foo", "", ai::True::get());
+	const ai::TreeNodePtr& action = GoHome::getFactory().create(&ctx);
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, action->execute(npc->ai(), 100L));
+	EXPECT_FALSE(npc->currentRoute().empty());
+	ai::TreeNodeStatus status = ai::TreeNodeStatus::RUNNING;
+	for (int i = 0; i < 1000 && status == ai::TreeNodeStatus::RUNNING; ++i) {
+		status = action->execute(npc->ai(), 100L);
+	}
+	ASSERT_EQ(ai::TreeNodeStatus::FINISHED, status);
+	EXPECT_FLOAT_EQ((float)home.x, npc->pos().x);
+	EXPECT_FLOAT_EQ((float)home.z, npc->pos().z);
+}
+
 TEST_F(AITest, testActionDie) {
 	const NpcPtr& npc = create();
 	const ai::TreeNodeFactoryContext ctx("foo", "", ai::True::get());
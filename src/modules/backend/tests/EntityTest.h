@@ -39,6 +39,7 @@ rabbit:absolute("FIELDOFVIEW", 360.0)
 rabbit:absolute("HEALTH", 100.0)
 rabbit:absolute("STRENGTH", 1.0)
 rabbit:absolute("VIEWDISTANCE", 10000.0)
+rabbit:absolute("SPEED", 10.0)
 rabbit:register()
 
 local wolf = attrib.createContainer("ANIMAL_WOLF")
@@ -67,6 +68,7 @@ protected:
 	io::FilesystemPtr filesystem;
 	core::TimeProviderPtr timeProvider;
 	persistence::PersistenceMgrPtr persistenceMgr;
+	voxelformat::VolumeCachePtr volumeCache;
 	MapProviderPtr mapProvider;
 	MapPtr map;
 
@@ -89,12 +91,14 @@ protected:
 		cooldownProvider = std::make_shared<cooldown::CooldownProvider>();
 		filesystem = _testApp->filesystem();
 		eventBus = _testApp->eventBus();
-		voxelformat::VolumeCachePtr volumeCache = std::make_shared<voxelformat::VolumeCache>();
+		volumeCache = std::make_shared<voxelformat::VolumeCache>();
 		http::HttpServerPtr httpServer = std::make_shared<http::HttpServer>(_testApp->metric());
 		timeProvider = _testApp->timeProvider();
 		persistenceMgr = persistence::createPersistenceMgrMock();
 		testing::Mock::AllowLeak(persistenceMgr.get());
 		persistence::DBHandlerPtr dbHandler = persistence::createDbHandlerMock();
+		// the map provider and its pagers keep a reference to the handler until the teardown
+		testing::Mock::AllowLeak(dbHandler.get());
 		// TODO: don't use the DBChunkPersister - but a mock
 		core::Factory<backend::DBChunkPersister> chunkPersisterFactory;
 		mapProvider = std::make_shared<MapProvider>(filesystem, eventBus, timeProvider,
@@ -103,6 +107,15 @@ protected:
 		ASSERT_TRUE(mapProvider->init()) << "Failed to initialize the map provider";
 		map = mapProvider->map(1);
 	}
+
+	void TearDown() override {
+		// the spawned entities page in chunks with trees - the volume cache asserts
+		// if it is destroyed with loaded volumes
+		map = MapPtr();
+		mapProvider->shutdown();
+		volumeCache->shutdown();
+		Super::TearDown();
+	}
 };
 
 }
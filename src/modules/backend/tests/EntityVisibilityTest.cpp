@@ -0,0 +1,46 @@
+/**
+ * @file
+ */
+
+#include "UserTest.h"
+#include "backend/entity/Npc.h"
+
+namespace backend {
+
+class EntityVisibilityTest: public UserTest {
+protected:
+	inline NpcPtr createNpc(network::EntityType type = network::EntityType::ANIMAL_RABBIT) {
+		glm::ivec3 pos = glm::zero<glm::ivec3>();
+		const NpcPtr& npc = map->spawnMgr()->spawn(type, &pos);
+		map->zone()->update(0L);
+		return npc;
+	}
+};
+
+TEST_F(EntityVisibilityTest, testUserAndNpcWithSameId) {
+	const NpcPtr& observer = createNpc();
+	ASSERT_TRUE(observer);
+	const NpcPtr& npc = createNpc();
+	ASSERT_TRUE(npc);
+	// the npc ids are not taken from the database - a user might get the same id
+	const UserPtr& user = create(npc->id(), "sameid");
+	ASSERT_EQ(user->id(), npc->id());
+	ASSERT_NE(user->entityType(), npc->entityType());
+	const EntityPtr userEntity = user;
+	const EntityPtr npcEntity = npc;
+	EXPECT_TRUE(Entity::visibleLess(userEntity, npcEntity) || Entity::visibleLess(npcEntity, userEntity))
+		<< "A user and a npc with the same id must not be treated as the same entity";
+
+	observer->updateVisible({npcEntity, userEntity});
+	EXPECT_EQ(2, observer->visibleCount());
+	observer->updateVisible({userEntity});
+	ASSERT_EQ(1, observer->visibleCount());
+	EXPECT_EQ(userEntity, observer->visibleCopy().front());
+	observer->updateVisible(EntityList());
+	EXPECT_EQ(0, observer->visibleCount());
+
+	map->removeUser(user->id());
+	shutdown(user->id());
+}
+
+}
@@ -13,6 +13,7 @@
 #include "backend/entity/ai/AILoader.h"
 #include "backend/entity/EntityStorage.h"
 #include "voxel/MaterialColor.h"
+#include "voxel/Constants.h"
 #include "voxelformat/VolumeCache.h"
 #include "persistence/tests/Mocks.h"
 
@@ -50,6 +51,12 @@ public:
 		_dbHandler = persistence::createDbHandlerMock();
 		testing::Mock::AllowLeak(_persistenceMgr.get());
 	}
+
+	void TearDown() override {
+		// the tree models that were loaded by the pager
+		_volumeCache->shutdown();
+		core::AbstractTest::TearDown();
+	}
 };
 
 #define create(name, id) \
@@ -63,6 +70,16 @@ TEST_F(MapTest, testInitShutdown) {
 	map.shutdown();
 }
 
+TEST_F(MapTest, testShutdownTwice) {
+	create(map, 1);
+	EXPECT_TRUE(map.init()) << "Failed to initialize the map " << map.id();
+	// the map provider shuts the map down - and the destructor does it again
+	persistence::PersistenceMgrMock* persistenceMgr = (persistence::PersistenceMgrMock*)_persistenceMgr.get();
+	EXPECT_CALL(*persistenceMgr, unregisterSavable(testing::_, (persistence::ISavable*)&map)).Times(1).WillOnce(testing::Return(true));
+	map.shutdown();
+	map.shutdown();
+}
+
 TEST_F(MapTest, testUpdate) {
 	create(map, 1);
 	EXPECT_TRUE(map.init()) << "Failed to initialize the map " << map.id();
@@ -70,6 +87,17 @@ TEST_F(MapTest, testUpdate) {
 	map.shutdown();
 }
 
+TEST_F(MapTest, testRandomPos) {
+	create(map, 1);
+	EXPECT_TRUE(map.init()) << "Failed to initialize the map " << map.id();
+	// the floor is searched from the max height downwards - a search upwards leaves the world immediately
+	const glm::ivec3& pos = map.randomPos();
+	EXPECT_NE(voxel::NO_FLOOR_FOUND, pos.y);
+	EXPECT_GE(pos.y, 0);
+	EXPECT_LT(pos.y, voxel::MAX_HEIGHT);
+	map.shutdown();
+}
+
 #undef create
 
 }
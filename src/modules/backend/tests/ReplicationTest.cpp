@@ -0,0 +1,327 @@
+/**
+ * @file
+ */
+
+#include "UserTest.h"
+#include "backend/entity/Npc.h"
+#include "backend/network/EntitySnapshotAckHandler.h"
+#include "core/EventBus.h"
+#include "math/Random.h"
+#include "network/EntitySnapshot.h"
+#include "network/NetworkEvents.h"
+#include "network/ProtocolHandlerRegistry.h"
+#include "poi/PoiProvider.h"
+#include "ClientMessages_generated.h"
+#include "ServerMessages_generated.h"
+#include <SDL_timer.h>
+
+namespace backend {
+
+/**
+ * @brief Load test for the entity replication. Drives a map with users that are connected via
+ * loopback peers and measures the packets and bytes that the peers receive per tick.
+ *
+ * The peers decode and acknowledge the entity snapshots like the client does. Packet loss can be
+ * simulated by dropping received snapshots and acknowledgements.
+ */
+class ReplicationTest: public UserTest, public core::IEventBusHandler<network::NewConnectionEvent> {
+private:
+	using Super = UserTest;
+protected:
+	static constexpr int Users = 32;
+	const core::String _host = "127.0.0.1";
+	uint16_t _port = 0u;
+	struct SimulatedClient {
+		ENetHost* host = nullptr;
+		ENetPeer* peer = nullptr;
+		network::EntitySnapshotHistory snapshots;
+		uint32_t lastSequence = 0u;
+		flatbuffers::FlatBufferBuilder fbb;
+	};
+	std::vector<std::unique_ptr<SimulatedClient>> _clients;
+	std::vector<ENetPeer*> _serverPeers;
+	// same order as the clients
+	std::vector<UserPtr> _users;
+	math::Random _random { 42u };
+	float _snapshotLoss = 0.0f;
+	float _ackLoss = 0.0f;
+
+	struct TickStats {
+		int packets = 0;
+		int bytes = 0;
+		int dropped = 0;
+	};
+
+	void onEvent(const network::NewConnectionEvent& event) override {
+		_serverPeers.push_back(event.get());
+	}
+
+	void SetUp() override {
+		Super::SetUp();
+		eventBus->subscribe<network::NewConnectionEvent>(*this);
+		ASSERT_TRUE(network->init());
+		network->registry()->registerHandler(network::EnumNameClientMsgType(network::ClientMsgType::EntitySnapshotAck),
+				std::make_shared<EntitySnapshotAckHandler>());
+		_port = (uint16_t)((uint32_t)(intptr_t)this) + 1025;
+		ASSERT_TRUE(network->bind(_port, _host, Users));
+
+		ENetAddress address;
+		enet_address_set_host(&address, _host.c_str());
+		address.port = _port;
+		for (int i = 0; i < Users; ++i) {
+			std::unique_ptr<SimulatedClient> client(new SimulatedClient());
+			client->host = enet_host_create(nullptr, 1, 1, 0, 0);
+			ASSERT_NE(nullptr, client->host);
+			// the server compresses the packets
+			enet_host_compress_with_range_coder(client->host);
+			client->peer = enet_host_connect(client->host, &address, 1, 0);
+			ASSERT_NE(nullptr, client->peer);
+			_clients.push_back(std::move(client));
+		}
+		for (int i = 0; i < 1000 && (int)_serverPeers.size() < Users; ++i) {
+			serviceClients();
+			network->update();
+			SDL_Delay(1);
+		}
+		ASSERT_EQ(Users, (int)_serverPeers.size()) << "Not all simulated peers could connect";
+
+		// a spawn point for the users - they are moved to their test positions afterwards
+		map->poiProvider()->add(glm::vec3(0.0f, 64.0f, 0.0f), poi::Type::GENERIC);
+		for (int i = 0; i < Users; ++i) {
+			ENetPeer* serverPeer = findServerPeer(*_clients[i]);
+			ASSERT_NE(nullptr, serverPeer);
+			const UserPtr& u = std::make_shared<User>(serverPeer, i + 1, "loadtest", map, messageSender, timeProvider,
+					containerProvider, cooldownProvider, dbHandler, persistenceMgr, stockDataProvider);
+			u->init();
+			map->addUser(u);
+			// spread the users to get different update rates - and put them on the ground to let them settle
+			const int x = i * 8;
+			const int floor = map->findFloor(glm::ivec3(x, voxel::MAX_HEIGHT, 0));
+			ASSERT_NE(voxel::NO_FLOOR_FOUND, floor);
+			u->setPos(glm::vec3((float)x, (float)floor, 0.0f));
+			_users.push_back(u);
+		}
+	}
+
+	void TearDown() override {
+		for (const UserPtr& u : _users) {
+			// the users see each other - break the reference cycles
+			u->updateVisible(EntityList());
+			map->removeUser(u->id());
+		}
+		_users.clear();
+		eventBus->update();
+		for (const auto& client : _clients) {
+			enet_host_destroy(client->host);
+		}
+		_clients.clear();
+		eventBus->unsubscribe<network::NewConnectionEvent>(*this);
+		network->shutdown();
+		Super::TearDown();
+	}
+
+	/**
+	 * @return The server side peer of the given client
+	 */
+	ENetPeer* findServerPeer(const SimulatedClient& client) const {
+		ENetAddress address;
+		if (enet_socket_get_address(client.host->socket, &address) != 0) {
+			return nullptr;
+		}
+		for (ENetPeer* peer : _serverPeers) {
+			if (peer->address.port == address.port) {
+				return peer;
+			}
+		}
+		return nullptr;
+	}
+
+	/**
+	 * @brief The map spawns some npcs on the first update - they are moving around and would not allow us to
+	 * measure the idle ticks.
+	 */
+	void removeNpcs() {
+		std::vector<NpcPtr> npcs;
+		entityStorage->visitNpcs([&] (const NpcPtr& npc) {
+			npcs.push_back(npc);
+		});
+		for (const NpcPtr& npc : npcs) {
+			npc->updateVisible(EntityList());
+			map->removeNpc(npc->id());
+			entityStorage->removeNpc(npc->id());
+		}
+	}
+
+	/**
+	 * @brief Applies the snapshot and acknowledges it - the same way the client does
+	 */
+	void receive(SimulatedClient& client, const ENetPacket* packet, TickStats& stats) {
+		flatbuffers::Verifier v(packet->data, packet->dataLength);
+		ASSERT_TRUE(network::VerifyServerMessageBuffer(v));
+		const network::ServerMessage* msg = network::GetServerMessage(packet->data);
+		if (msg->data_type() != network::ServerMsgType::EntitySnapshot) {
+			return;
+		}
+		if (_snapshotLoss > 0.0f && _random.randomf() < _snapshotLoss) {
+			++stats.dropped;
+			return;
+		}
+		const network::EntitySnapshot* snapshot = msg->data_as_EntitySnapshot();
+		if (snapshot->sequence() <= client.lastSequence) {
+			return;
+		}
+		const network::EntitySnapshotStates* baseline = nullptr;
+		if (snapshot->baseline() != 0u) {
+			baseline = client.snapshots.get(snapshot->baseline());
+			ASSERT_NE(nullptr, baseline) << "The server used a baseline that was never acknowledged";
+		}
+		network::EntitySnapshotStates states;
+		ASSERT_TRUE(network::decodeEntitySnapshot(baseline, snapshot->data()->data(), snapshot->data()->size(), states));
+		client.snapshots.add(snapshot->sequence()) = std::move(states);
+		client.lastSequence = snapshot->sequence();
+		if (_ackLoss > 0.0f && _random.randomf() < _ackLoss) {
+			++stats.dropped;
+			return;
+		}
+		client.fbb.Clear();
+		auto ack = network::CreateClientMessage(client.fbb, network::ClientMsgType::EntitySnapshotAck,
+				network::CreateEntitySnapshotAck(client.fbb, snapshot->sequence()).Union());
+		network::FinishClientMessageBuffer(client.fbb, ack);
+		enet_peer_send(client.peer, 0, enet_packet_create(client.fbb.GetBufferPointer(), client.fbb.GetSize(), 0));
+	}
+
+	TickStats serviceClients() {
+		TickStats stats;
+		for (const auto& client : _clients) {
+			ENetEvent event;
+			while (enet_host_service(client->host, &event, 0) > 0) {
+				if (event.type == ENET_EVENT_TYPE_RECEIVE) {
+					++stats.packets;
+					stats.bytes += (int)event.packet->dataLength;
+					receive(*client, event.packet, stats);
+					enet_packet_destroy(event.packet);
+				}
+			}
+			// send the acknowledgements
+			enet_host_flush(client->host);
+		}
+		return stats;
+	}
+
+	/**
+	 * @return The amount of ticks until nothing was sent anymore - and no update of a far away entity is pending
+	 */
+	int settle(int maxTicks = 100) {
+		for (int i = 0; i < maxTicks; ++i) {
+			tick(0);
+			const EntityReplicator::Statistics& stats = map->replicator().statistics();
+			if (stats.packets == 0u && stats.deferred == 0u) {
+				return i;
+			}
+		}
+		return maxTicks;
+	}
+
+	/**
+	 * @param[in] moving The amount of users that change their orientation in this tick
+	 */
+	TickStats tick(int moving) {
+		static float yaw = 0.0f;
+		yaw += 0.1f;
+		for (int i = 0; i < moving; ++i) {
+			_users[i]->movementMgr().changeMovement(network::MoveDirection::NONE, 0.0f, yaw);
+		}
+		// process the acknowledgements of the last tick
+		network->update();
+		map->update(50l);
+		network->update();
+		// give the loopback some time to deliver the packets
+		SDL_Delay(5);
+		return serviceClients();
+	}
+};
+
+TEST_F(ReplicationTest, testPacketsPerTick) {
+	tick(0);
+	removeNpcs();
+	// let the users receive and acknowledge the spawns
+	ASSERT_LT(settle(), 100);
+	const EntityReplicator::Statistics& replicatorStats = map->replicator().statistics();
+	const TickStats& idle = tick(0);
+	EXPECT_EQ(0u, replicatorStats.packets) << "Nothing changed - but entity snapshots were sent";
+	EXPECT_EQ(0, idle.packets);
+
+	const int moving = Users / 4;
+	const int ticks = 16;
+	TickStats total;
+	uint32_t maxPacketsPerTick = 0u;
+	uint32_t states = 0u;
+	uint32_t deferred = 0u;
+	for (int i = 0; i < ticks; ++i) {
+		const TickStats& stats = tick(moving);
+		total.packets += stats.packets;
+		total.bytes += stats.bytes;
+		maxPacketsPerTick = core_max(maxPacketsPerTick, replicatorStats.packets);
+		states += replicatorStats.states;
+		deferred += replicatorStats.deferred;
+	}
+	// a late packet might still arrive
+	const TickStats& remaining = tick(0);
+	total.packets += remaining.packets;
+	total.bytes += remaining.bytes;
+
+	Log::info("%i users, %i moving: %.1f packets/tick, %.1f bytes/tick, %.1f states/tick, %.1f deferred/tick (one packet per visible entity: %i packets/tick)",
+			Users, moving, (float)total.packets / (float)ticks, (float)total.bytes / (float)ticks,
+			(float)states / (float)ticks, (float)deferred / (float)ticks, Users * moving);
+	EXPECT_LE(maxPacketsPerTick, (uint32_t)Users) << "There should be at most one entity snapshot per peer and tick";
+	EXPECT_GT(total.packets, 0);
+	EXPECT_GT(deferred, 0u) << "The users that are far away should be updated less often";
+}
+
+TEST_F(ReplicationTest, testPacketLoss) {
+	tick(0);
+	removeNpcs();
+	ASSERT_LT(settle(), 100);
+	const EntityReplicator::Statistics& replicatorStats = map->replicator().statistics();
+	const int moving = Users / 4;
+
+	_snapshotLoss = 0.25f;
+	_ackLoss = 0.25f;
+	TickStats total;
+	for (int i = 0; i < 32; ++i) {
+		const TickStats& stats = tick(moving);
+		total.packets += stats.packets;
+		total.dropped += stats.dropped;
+	}
+	EXPECT_GT(total.dropped, 0);
+
+	// the acknowledged baselines get too old - the server must fall back to full snapshots
+	_snapshotLoss = 0.0f;
+	_ackLoss = 1.0f;
+	uint32_t full = 0u;
+	for (uint32_t i = 0u; i < network::EntitySnapshotHistory::Size + 2u; ++i) {
+		tick(moving);
+		full += replicatorStats.full;
+	}
+	EXPECT_GT(full, 0u);
+
+	_ackLoss = 0.0f;
+	ASSERT_LT(settle(), 100) << "The snapshots should converge after the packet loss stopped";
+	Log::info("%i packets received, %i snapshots or acknowledgements dropped, %u full snapshots", total.packets, total.dropped, full);
+	for (int i = 0; i < Users; ++i) {
+		User& user = *_users[i];
+		const SimulatedClient& client = *_clients[i];
+		ASSERT_EQ(user.lastSnapshot(), client.lastSequence);
+		EXPECT_EQ(user.lastSnapshot(), user.ackedSnapshot());
+		const network::EntitySnapshotStates* clientStates = client.snapshots.get(client.lastSequence);
+		ASSERT_NE(nullptr, clientStates);
+		const network::EntitySnapshotStates* serverStates = user.snapshots().get(user.lastSnapshot());
+		ASSERT_NE(nullptr, serverStates);
+		EXPECT_EQ(*serverStates, *clientStates) << "Client " << i << " has a different view of the world";
+		const network::EntitySnapshotState* own = network::findEntitySnapshotState(clientStates, user.id());
+		ASSERT_NE(nullptr, own);
+		EXPECT_EQ(network::quantizeEntityState(user.id(), user.pos(), user.orientation(), user.animation()), *own);
+	}
+}
+
+}
@@ -0,0 +1,34 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "backend/entity/user/UserAttribMgr.h"
+#include "persistence/tests/Mocks.h"
+#include "attrib/AttributeType.h"
+
+namespace backend {
+
+class UserAttribMgrTest: public core::AbstractTest {
+};
+
+TEST_F(UserAttribMgrTest, testDirtyModelOfLastType) {
+	attrib::Attributes attribs;
+	auto dbHandler = persistence::createDbHandlerMock();
+	auto persistenceMgr = persistence::createPersistenceMgrMock();
+	testing::Mock::AllowLeak(dbHandler.get());
+	testing::Mock::AllowLeak(persistenceMgr.get());
+	UserAttribMgr mgr(EntityId(1), attribs, dbHandler, persistenceMgr);
+	ASSERT_TRUE(mgr.init());
+	// the max value of the type enum is a valid attribute and needs its own model
+	attribs.setCurrent(attrib::Type::MAX, 1.0);
+	std::vector<const persistence::Model*> models;
+	ASSERT_TRUE(mgr.getDirtyModels(models));
+	ASSERT_EQ(1u, models.size());
+	const db::AttribModel* model = (const db::AttribModel*)models[0];
+	EXPECT_EQ((int)attrib::Type::MAX, model->attribtype());
+	EXPECT_DOUBLE_EQ(1.0, model->value());
+	mgr.shutdown();
+}
+
+}
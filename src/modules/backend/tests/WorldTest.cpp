@@ -56,6 +56,7 @@ public:
 		persistence::DBHandlerPtr dbHandler = persistence::createDbHandlerMock();
 		core::Factory<backend::DBChunkPersister> chunkPersisterFactory;
 		testing::Mock::AllowLeak(_persistenceMgr.get());
+		testing::Mock::AllowLeak(dbHandler.get());
 		_mapProvider = std::make_shared<MapProvider>(_testApp->filesystem(), _testApp->eventBus(), _testApp->timeProvider(),
 				_entityStorage, _messageSender, _loader, _containerProvider, _cooldownProvider,
 				_persistenceMgr, _volumeCache, _httpServer, chunkPersisterFactory, dbHandler);
@@ -6,9 +6,27 @@
 #include "BackendModels.h"
 #include "voxel/PagedVolume.h"
 #include "voxel/Region.h"
+#include "core/Common.h"
+#include <string.h>
+#include <algorithm>
+#include <memory>
 
 namespace backend {
 
+namespace {
+
+/**
+ * @brief The chunks of another world generator don't fit to the chunks that are generated now - they are
+ * treated as if they were not persisted and are thus generated again.
+ */
+void releaseOutdated(persistence::Blob& blob) {
+	if (blob.length > 0 && voxelworld::ChunkPersister::generatorVersion(blob.data, blob.length) != voxelworld::ChunkPersister::GeneratorVersion) {
+		blob.release();
+	}
+}
+
+}
+
 DBChunkPersister::DBChunkPersister(const persistence::DBHandlerPtr &dbHandler, MapId mapId) :
 		_dbHandler(dbHandler), _mapId(mapId) {
 }
@@ -27,14 +45,20 @@ void DBChunkPersister::erase(const voxel::Region& region, unsigned int seed) {
 	model.setY(region.getLowerY());
 	model.setZ(region.getLowerZ());
 	model.setSeed(seed);
-	_dbHandler->deleteModel(model);
+	// queued behind the saves of the chunk - a save that is still pending must not restore the chunk
+	_dbHandler->executor().deleteModels({&model}, [region] (bool success) {
+		if (!success) {
+			Log::error("Failed to erase the chunk at %i:%i:%i", region.getLowerX(), region.getLowerY(), region.getLowerZ());
+		}
+	});
 }
 
 bool DBChunkPersister::truncate(unsigned int seed) {
 	db::ChunkModel model;
 	model.setMapid(_mapId);
 	model.setSeed(seed);
-	return _dbHandler->truncate(model);
+	// executed after the pending saves - they would insert their chunks again otherwise
+	return _dbHandler->executor().truncate(model).get();
 }
 
 persistence::Blob DBChunkPersister::load(int x, int y, int z, MapId mapId, unsigned int seed) const {
@@ -44,10 +68,43 @@ persistence::Blob DBChunkPersister::load(int x, int y, int z, MapId mapId, unsig
 	model.setY(y);
 	model.setZ(z);
 	model.setSeed(seed);
-	if (!_dbHandler->select(model, persistence::DBConditionOne())) {
+	// executed by the same worker as the saves of the chunks - a chunk that was just saved is found
+	persistence::Blob blob;
+	std::future<bool> future = _dbHandler->executor().select(model, [&blob] (db::ChunkModel&& selected) {
+		blob = selected.data();
+	});
+	if (!future.get()) {
 		Log::warn("Failed to load the model");
 	}
-	return model.data();
+	releaseOutdated(blob);
+	return blob;
+}
+
+void DBChunkPersister::load(const std::vector<glm::ivec3>& chunkPositions, MapId mapId, unsigned int seed, const LoadCallback& callback) const {
+	core_trace_scoped(DBChunkPersisterLoadBatch);
+	std::vector<db::ChunkModel> models(chunkPositions.size());
+	for (size_t i = 0; i < chunkPositions.size(); ++i) {
+		const glm::ivec3& chunkPos = chunkPositions[i];
+		db::ChunkModel& model = models[i];
+		model.setMapid(mapId);
+		model.setX(chunkPos.x);
+		model.setY(chunkPos.y);
+		model.setZ(chunkPos.z);
+		model.setSeed(seed);
+	}
+	// filled by the worker thread - handed over to the callback once all selects are done
+	const std::shared_ptr<std::vector<persistence::Blob>> blobs = std::make_shared<std::vector<persistence::Blob>>(chunkPositions.size());
+	_dbHandler->executor().select(models, [blobs] (size_t index, db::ChunkModel&& selected) {
+		(*blobs)[index] = selected.data();
+	}, [blobs, callback] (bool success) {
+		if (!success) {
+			Log::warn("Failed to load the models");
+		}
+		for (persistence::Blob& blob : *blobs) {
+			releaseOutdated(blob);
+		}
+		callback(core::move(*blobs));
+	});
 }
 
 bool DBChunkPersister::load(voxel::PagedVolume::Chunk* chunk, unsigned int seed) {
@@ -78,8 +135,98 @@ bool DBChunkPersister::save(voxel::PagedVolume::Chunk* chunk, unsigned int seed)
 	data.data = (uint8_t*)out.getBuffer();
 	data.length = out.getSize();
 	Log::info("Store compressed chunk with size %i", (int)data.length);
+	{
+		std::unique_lock lock(_bulkMutex);
+		if (_bulk) {
+			// the stream buffer is gone after this call
+			data.data = (uint8_t*)core_malloc(data.length > 0 ? data.length : 1);
+			memcpy(data.data, out.getBuffer(), data.length);
+			model.setData(data);
+			// the upsert of the copy can't update a row twice - a chunk that is saved again replaces the collected one
+			auto i = std::find_if(_bulkChunks.begin(), _bulkChunks.end(), [&] (const db::ChunkModel& collected) {
+				return collected.x() == chunkPos.x && collected.y() == chunkPos.y && collected.z() == chunkPos.z
+						&& collected.seed() == (int)seed;
+			});
+			if (i != _bulkChunks.end()) {
+				persistence::Blob collectedData = i->data();
+				collectedData.release();
+				*i = model;
+				return true;
+			}
+			_bulkChunks.push_back(model);
+			if (_bulkChunks.size() >= BulkSize) {
+				_bulkBatches.emplace_back();
+				_bulkBatches.back().swap(_bulkChunks);
+			}
+			return true;
+		}
+	}
 	model.setData(data);
-	return _dbHandler->insert(model);
+	// the chunk data is copied - the pager doesn't have to wait for the database
+	_dbHandler->executor().insert(model, [chunkPos] (bool success) {
+		if (!success) {
+			Log::error("Failed to store the chunk at %i:%i:%i", chunkPos.x, chunkPos.y, chunkPos.z);
+		}
+	});
+	return true;
+}
+
+void DBChunkPersister::beginBulk() {
+	std::unique_lock lock(_bulkMutex);
+	_bulk = true;
+	_bulkWritten = 0;
+}
+
+void DBChunkPersister::flushBulk() {
+	std::vector<std::vector<db::ChunkModel>> batches;
+	{
+		std::unique_lock lock(_bulkMutex);
+		batches.swap(_bulkBatches);
+	}
+	for (std::vector<db::ChunkModel>& chunks : batches) {
+		copyIn(chunks);
+	}
+}
+
+int DBChunkPersister::endBulk() {
+	std::vector<db::ChunkModel> chunks;
+	{
+		std::unique_lock lock(_bulkMutex);
+		_bulk = false;
+		chunks.swap(_bulkChunks);
+	}
+	flushBulk();
+	copyIn(chunks);
+	std::unique_lock lock(_bulkMutex);
+	return _bulkWritten;
+}
+
+bool DBChunkPersister::copyIn(std::vector<db::ChunkModel>& chunks) {
+	if (chunks.empty()) {
+		return true;
+	}
+	core_trace_scoped(DBChunkPersisterCopyIn);
+	// chunks that are already persisted are updated - a plain copy would fail for the whole batch
+	const bool success = _dbHandler->copyIn(chunks, true);
+	if (success) {
+		std::unique_lock lock(_bulkMutex);
+		_bulkWritten += (int)chunks.size();
+	} else {
+		Log::error("Failed to copy %i chunks into the database", (int)chunks.size());
+	}
+	for (db::ChunkModel& chunk : chunks) {
+		persistence::Blob data = chunk.data();
+		data.release();
+	}
+	return success;
+}
+
+bool DBChunkPersister::copyOut(unsigned int seed, const std::function<void(db::ChunkModel&& chunk)>& func) const {
+	core_trace_scoped(DBChunkPersisterCopyOut);
+	db::ChunkModel model;
+	model.setMapid(_mapId);
+	model.setSeed(seed);
+	return _dbHandler->copyOut(model, func);
 }
 
 }
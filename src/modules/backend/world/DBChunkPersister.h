@@ -10,13 +10,43 @@
 #include "voxel/PagedVolume.h"
 #include "voxel/Region.h"
 #include "MapId.h"
+#include "BackendModels.h"
+#include "core/Trace.h"
+#include <mutex>
+#include <vector>
+#include <functional>
 
 namespace backend {
 
+/**
+ * @brief Persists the chunks of a map in the database
+ *
+ * The chunks are saved asynchronously by the @c persistence::DBExecutor. For pregenerating big areas the
+ * persister can be switched into the bulk mode - the chunks are collected and written with binary copies.
+ * The copies go through a staging table, so chunks that are already persisted are updated.
+ */
 class DBChunkPersister : public voxelworld::ChunkPersister {
+public:
+	/**
+	 * @brief The amount of chunks that are written with one copy in the bulk mode
+	 */
+	static constexpr size_t BulkSize = 64u;
 protected:
 	persistence::DBHandlerPtr _dbHandler;
 	const MapId _mapId;
+
+	core_trace_mutex(std::mutex, _bulkMutex);
+	bool _bulk = false;
+	// the chunks that were collected in the bulk mode - the blob data is owned by the persister
+	std::vector<db::ChunkModel> _bulkChunks;
+	// the full batches of the bulk mode that are not yet written
+	std::vector<std::vector<db::ChunkModel>> _bulkBatches;
+	int _bulkWritten = 0;
+
+	/**
+	 * @brief Writes the given chunks with one copy and frees their data
+	 */
+	bool copyIn(std::vector<db::ChunkModel>& chunks);
 public:
 	DBChunkPersister(const persistence::DBHandlerPtr& dbHandler, MapId mapId);
 	virtual ~DBChunkPersister() {}
@@ -24,12 +54,51 @@ public:
 	bool init() override;
 
 	persistence::Blob load(int x, int y, int z, MapId mapId, unsigned int seed) const;
+	/**
+	 * @brief Receives the chunks in the order of the requested positions - the length is @c 0 for chunks that
+	 * are not persisted or were created by another generator version. The blob data is owned by the receiver.
+	 */
+	using LoadCallback = std::function<void(std::vector<persistence::Blob>&& blobs)>;
+	/**
+	 * @brief Loads the chunks at the given chunk positions without waiting for them - the selects are submitted
+	 * at once and are executed in one batch by the @c persistence::DBExecutor
+	 * @param[in] callback Called on the worker thread of the executor once all chunks were selected
+	 */
+	void load(const std::vector<glm::ivec3>& chunkPositions, MapId mapId, unsigned int seed, const LoadCallback& callback) const;
 	/**
 	 * @brief Removes all persisted chunks from the database for the given parameters
+	 * @note Blocks until the saves that were queued before are executed, too
 	 */
 	bool truncate(unsigned int seed);
 
+	/**
+	 * @brief Collect the saved chunks and write them in batches of @c BulkSize with a binary copy
+	 * @sa endBulk()
+	 */
+	void beginBulk();
+	/**
+	 * @brief Writes the full batches that were collected in the bulk mode
+	 * @note The pager saves the chunks while it holds its lock - the batches are not written in @c save() to
+	 * not block the paging for the duration of the copy.
+	 */
+	void flushBulk();
+	/**
+	 * @brief Writes the remaining collected chunks and switches back to the asynchronous single inserts
+	 * @return The amount of chunks that were written since @c beginBulk()
+	 */
+	int endBulk();
+
+	/**
+	 * @brief Streams all persisted chunks of the map for the given seed with a binary copy
+	 * @param[in] func Receives the chunks - the blob data is owned by the receiver
+	 */
+	bool copyOut(unsigned int seed, const std::function<void(db::ChunkModel&& chunk)>& func) const;
+
 	bool load(voxel::PagedVolume::Chunk* chunk, unsigned int seed) override;
+	/**
+	 * @return @c true if the chunk was queued for the database - the pager doesn't wait for the insert, a
+	 * failed insert is only logged
+	 */
 	bool save(voxel::PagedVolume::Chunk* chunk, unsigned int seed) override;
 	void erase(const voxel::Region& region, unsigned int seed) override;
 };
@@ -0,0 +1,125 @@
+/**
+ * @file
+ */
+
+#include "EntityReplicator.h"
+#include "backend/entity/Entity.h"
+#include "network/ServerMessageSender.h"
+#include "core/GameConfig.h"
+#include "core/Trace.h"
+#include "core/Log.h"
+#include <glm/geometric.hpp>
+#include <algorithm>
+
+namespace backend {
+
+EntityReplicator::EntityReplicator(const network::ServerMessageSenderPtr& messageSender) :
+		_messageSender(messageSender) {
+}
+
+bool EntityReplicator::init() {
+	_distance = core::Var::get(cfg::ServerReplicationDistance, "32");
+	_maxInterval = core::Var::get(cfg::ServerReplicationMaxInterval, "8");
+	return true;
+}
+
+void EntityReplicator::shutdown() {
+	_states.clear();
+	_data.clear();
+	_fbb.Clear();
+}
+
+uint32_t EntityReplicator::updateInterval(float distance) const {
+	const float fullRateDistance = _distance->floatVal();
+	const uint32_t maxInterval = (uint32_t)_maxInterval->intVal();
+	uint32_t interval = 1u;
+	for (float d = fullRateDistance; distance > d && interval < maxInterval; d *= 2.0f) {
+		interval *= 2u;
+	}
+	return interval;
+}
+
+network::EntitySnapshotState EntityReplicator::quantize(const Entity& entity) const {
+	return network::quantizeEntityState(entity.id(), entity.pos(), entity.orientation(), entity.animation());
+}
+
+void EntityReplicator::beginTick() {
+	++_tick;
+	_statistics = Statistics();
+}
+
+bool EntityReplicator::replicate(Entity& observer) {
+	ENetPeer* peer = observer.peer();
+	if (peer == nullptr) {
+		return false;
+	}
+	core_trace_scoped(EntityReplicate);
+	network::EntitySnapshotHistory& history = observer.snapshots();
+	const uint32_t ackedSequence = observer.ackedSnapshot();
+	const uint32_t lastSequence = observer.lastSnapshot();
+	const network::EntitySnapshotStates* baseline = history.get(ackedSequence);
+	const network::EntitySnapshotStates* last = history.get(lastSequence);
+
+	_states.clear();
+	_states.push_back(quantize(observer));
+	const glm::vec3& observerPos = observer.pos();
+	observer.visitVisible([&] (const EntityPtr& e) {
+		const network::EntitySnapshotState& state = quantize(*e);
+		const network::EntitySnapshotState* baseState = network::findEntitySnapshotState(baseline, state.id);
+		if (baseState != nullptr && *baseState == state) {
+			++_statistics.unchanged;
+			_states.push_back(state);
+			return;
+		}
+		// spread the updates of the entities with the same interval over the ticks
+		const uint32_t interval = updateInterval(glm::distance(observerPos, e->pos()));
+		if (((_tick + (uint32_t)e->id()) % interval) != 0u) {
+			// repeat the newest state the peer might already know about
+			const network::EntitySnapshotState* lastState = network::findEntitySnapshotState(last, state.id);
+			if (lastState == nullptr) {
+				lastState = baseState;
+			}
+			if (lastState != nullptr) {
+				++_statistics.deferred;
+				_states.push_back(*lastState);
+				return;
+			}
+		}
+		_states.push_back(state);
+	});
+	std::sort(_states.begin(), _states.end(), [] (const network::EntitySnapshotState& a, const network::EntitySnapshotState& b) {
+		return a.id < b.id;
+	});
+
+	if (baseline != nullptr && ackedSequence == lastSequence && *baseline == _states) {
+		// the peer already knows about these states
+		return false;
+	}
+
+	_data.clear();
+	const int states = network::encodeEntitySnapshot(baseline, _states, _data);
+	const uint32_t sequence = observer.nextSnapshotSequence();
+	history.add(sequence) = _states;
+
+	_fbb.Clear();
+	auto data = _fbb.CreateVector(_data);
+	const uint32_t baselineSequence = baseline == nullptr ? 0u : ackedSequence;
+	auto msg = network::CreateServerMessage(_fbb, network::ServerMsgType::EntitySnapshot,
+			network::CreateEntitySnapshot(_fbb, sequence, baselineSequence, data).Union());
+	network::FinishServerMessageBuffer(_fbb, msg);
+	// lost snapshots are not resent - the next one is encoded against the acknowledged baseline anyway
+	ENetPacket* packet = _messageSender->createServerPacket(network::ServerMsgType::EntitySnapshot, _fbb.GetBufferPointer(), _fbb.GetSize(), 0);
+	++_statistics.packets;
+	_statistics.bytes += (uint32_t)packet->dataLength;
+	_statistics.states += (uint32_t)states;
+	if (baseline == nullptr) {
+		++_statistics.full;
+	}
+	if (!_messageSender->sendServerPacket(&peer, 1, packet, network::ServerMsgType::EntitySnapshot)) {
+		Log::debug("Could not send the entity snapshot to entity " PRIEntId, observer.id());
+		return false;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,86 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "backend/ForwardDecl.h"
+#include "core/IComponent.h"
+#include "core/Var.h"
+#include "network/EntitySnapshot.h"
+#include "ServerMessages_generated.h"
+#include <vector>
+
+namespace backend {
+
+class Entity;
+
+/**
+ * @brief Sends the states of the entities in the visible area of a user in one unreliable
+ * @c network::EntitySnapshot message per tick.
+ *
+ * The states are quantized and delta encoded against the newest snapshot that the user acknowledged
+ * (see @c network::encodeEntitySnapshot()). If there is no such snapshot in the history of the user, the
+ * full states are sent. Nothing is sent if the user already acknowledged the current states.
+ * Entities that are further away than @c cfg::ServerReplicationDistance are updated less often - the
+ * update interval doubles with every doubling of the distance up to @c cfg::ServerReplicationMaxInterval
+ * ticks. Until then the last sent state of these entities is repeated.
+ */
+class EntityReplicator : public core::IComponent {
+public:
+	/**
+	 * @brief The replication numbers of the last tick
+	 */
+	struct Statistics {
+		uint32_t packets = 0u;
+		uint32_t bytes = 0u;
+		// entity states that were written to the snapshots
+		uint32_t states = 0u;
+		// visible entities that didn't change since the acknowledged snapshot
+		uint32_t unchanged = 0u;
+		// changed entities that were not sent because they are too far away for an update in this tick
+		uint32_t deferred = 0u;
+		// snapshots that were sent without baseline
+		uint32_t full = 0u;
+	};
+
+private:
+	network::ServerMessageSenderPtr _messageSender;
+	core::VarPtr _distance;
+	core::VarPtr _maxInterval;
+	flatbuffers::FlatBufferBuilder _fbb;
+	network::EntitySnapshotStates _states;
+	std::vector<uint8_t> _data;
+	Statistics _statistics;
+	uint32_t _tick = 0u;
+
+	/**
+	 * @return The amount of ticks between two updates of an entity in the given distance
+	 */
+	uint32_t updateInterval(float distance) const;
+	network::EntitySnapshotState quantize(const Entity& entity) const;
+
+public:
+	EntityReplicator(const network::ServerMessageSenderPtr& messageSender);
+
+	bool init() override;
+	void shutdown() override;
+
+	/**
+	 * @brief Starts a new replication tick
+	 */
+	void beginTick();
+	/**
+	 * @brief Sends the snapshot of the visible entity states to the peer of the given entity
+	 * @return @c true if a message was sent
+	 */
+	bool replicate(Entity& observer);
+
+	const Statistics& statistics() const;
+};
+
+inline const EntityReplicator::Statistics& EntityReplicator::statistics() const {
+	return _statistics;
+}
+
+}
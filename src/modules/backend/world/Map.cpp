@@ -8,7 +8,8 @@
 #include "core/StringUtil.h"
 #include "core/EventBus.h"
 #include "core/App.h"
-#include "math/QuadTree.h"
+#include "core/concurrent/Atomic.h"
+#include "core/Common.h"
 #include "core/io/Filesystem.h"
 #include "backend/entity/Npc.h"
 #include "backend/entity/User.h"
@@ -19,17 +20,22 @@
 #include "backend/spawn/SpawnMgr.h"
 #include "persistence/PersistenceMgr.h"
 #include "attrib/ContainerProvider.h"
+#include <algorithm>
 
 namespace backend {
 
-math::RectFloat Map::QuadTreeNode::getRect() const {
+math::RectFloat Map::GridNode::getRect() const {
 	return entity->rect();
 }
 
-bool Map::QuadTreeNode::operator==(const QuadTreeNode& rhs) const {
+bool Map::GridNode::operator==(const GridNode& rhs) const {
 	return rhs.entity == entity;
 }
 
+size_t Map::GridNodeHash::operator()(const GridNode& node) const {
+	return std::hash<EntityPtr>()(node.entity);
+}
+
 Map::Map(MapId mapId,
 		const core::EventBusPtr& eventBus,
 		const core::TimeProviderPtr& timeProvider,
@@ -44,8 +50,8 @@ Map::Map(MapId mapId,
 		const DBChunkPersisterPtr& chunkPersister) :
 		_mapId(mapId), _mapIdStr(core::string::toString(mapId)),
 		_eventBus(eventBus), _filesystem(filesystem), _persistenceMgr(persistenceMgr),
-		_volumeCache(volumeCache), _attackMgr(this),
-		_quadTree(math::RectFloat::getMaxRect(), 100.0f), _chunkPersister(chunkPersister) {
+		_volumeCache(volumeCache), _attackMgr(this), _replicator(messageSender),
+		_grid(GridCellSize), _chunkPersister(chunkPersister) {
 	_poiProvider = std::make_shared<poi::PoiProvider>(timeProvider);
 	_spawnMgr = std::make_shared<backend::SpawnMgr>(this, filesystem, entityStorage, messageSender,
 			timeProvider, loader, containerProvider, cooldownProvider);
@@ -63,21 +69,79 @@ bool Map::updateEntity(const EntityPtr& entity, long dt) {
 	if (!entity->update(dt)) {
 		return false;
 	}
-	const math::RectFloat& rect = entity->viewRect();
-	// TODO: maybe move into the entity instance to reduce memory allocations.
-	math::QuadTree<QuadTreeNode, float>::Contents contents;
-	_quadTree.query(rect, contents);
-	EntitySet set;
-	set.reserve(contents.size());
-	for (const QuadTreeNode& node : contents) {
-		// TODO: check the distance - the rect might contain more than the circle would...
-		if (entity->inFrustum(node.entity)) {
-			set.insert(node.entity);
+	_grid.update(GridNode { entity });
+	return true;
+}
+
+void Map::updateVisibility() {
+	core_trace_scoped(MapUpdateVisibility);
+	_visibilityEntities.clear();
+	for (const auto& i : _users) {
+		_visibilityEntities.push_back(i.second);
+	}
+	for (const auto& i : _npcs) {
+		_visibilityEntities.push_back(i.second);
+	}
+	const int amount = (int)_visibilityEntities.size();
+	if (amount == 0) {
+		return;
+	}
+	if ((int)_visibilitySets.size() < amount) {
+		_visibilitySets.resize(amount);
+	}
+
+	// the map thread is one of the workers - the helpers run in the thread pool of the application
+	// that is shared by all maps. No blocking work (like the database updates) may be queued there.
+	core::ThreadPool& threadPool = core::App::getInstance()->threadPool();
+	const int workers = (int)threadPool.size() + 1;
+	const int batchSize = core_max(MinVisibilityBatchSize, (amount + workers - 1) / workers);
+	const int batches = (amount + batchSize - 1) / batchSize;
+	const int helpers = core_min(workers - 1, batches - 1);
+	if ((int)_visibilityScratch.size() < helpers + 1) {
+		_visibilityScratch.resize(helpers + 1);
+	}
+	core::AtomicInt nextBatch(0);
+	auto worker = [&] (int workerIndex) {
+		Grid::Contents& contents = _visibilityScratch[workerIndex];
+		for (;;) {
+			const int batch = nextBatch.increment(1);
+			if (batch >= batches) {
+				break;
+			}
+			const int end = core_min(amount, (batch + 1) * batchSize);
+			for (int i = batch * batchSize; i < end; ++i) {
+				const EntityPtr& entity = _visibilityEntities[i];
+				contents.clear();
+				_grid.query(entity->viewRect(), contents);
+				EntityList& visible = _visibilitySets[i];
+				visible.clear();
+				for (const GridNode& node : contents) {
+					// TODO: check the distance - the rect might contain more than the circle would...
+					if (node.entity != entity && entity->inFrustum(node.entity)) {
+						visible.push_back(node.entity);
+					}
+				}
+				// Entity::updateVisible() merges sorted lists
+				std::sort(visible.begin(), visible.end(), Entity::visibleLess);
+			}
 		}
+	};
+	std::vector<std::future<void> > results;
+	results.reserve(helpers);
+	for (int i = 0; i < helpers; ++i) {
+		results.emplace_back(threadPool.enqueue(worker, i + 1));
 	}
-	set.erase(entity);
-	entity->updateVisible(set);
-	return true;
+	worker(0);
+	for (auto& result : results) {
+		result.wait();
+	}
+
+	// this sends the spawn and remove messages - so it's done in the map thread
+	for (int i = 0; i < amount; ++i) {
+		_visibilityEntities[i]->updateVisible(_visibilitySets[i]);
+		_visibilitySets[i].clear();
+	}
+	_visibilityEntities.clear();
 }
 
 void Map::update(long dt) {
@@ -86,16 +150,29 @@ void Map::update(long dt) {
 	_zone->update(dt);
 	_attackMgr.update(dt);
 
+	std::vector<glm::ivec3> missingChunks;
+	{
+		std::unique_lock lock(_missingChunksMutex);
+		missingChunks.swap(_missingChunks);
+	}
+	voxel::PagedVolume* volume = _voxelWorldMgr->volumeData();
+	for (const glm::ivec3& chunkPos : missingChunks) {
+		(void)volume->chunkAsync(chunkPos * (int)volume->chunkSideLength());
+	}
+
+	// page in the surrounding chunks of the users before they are touched by movement or the ai
+	const int prefetchRadius = volume->chunkSideLength();
 	for (auto i = _users.begin(); i != _users.end();) {
 		UserPtr user = i->second;
 		if (updateEntity(user, dt)) {
+			_voxelWorldMgr->prefetch(glm::ivec3(user->pos()), prefetchRadius);
 			++i;
 			continue;
 		}
 		Log::debug("remove user " PRIEntId, user->id());
-		_quadTree.remove(QuadTreeNode { user });
+		_grid.remove(GridNode { user });
 		i = _users.erase(i);
-		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(user->id(), user->entityType()));
+		_eventBus->enqueue<EntityDeleteEvent>(user->id(), user->entityType());
 	}
 	for (auto i = _npcs.begin(); i != _npcs.end();) {
 		NpcPtr npc = i->second;
@@ -104,25 +181,47 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove npc " PRIEntId, npc->id());
-		_quadTree.remove(QuadTreeNode { npc });
+		_grid.remove(GridNode { npc });
 		i = _npcs.erase(i);
 		_zone->removeAI(npc->ai());
-		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(npc->id(), npc->entityType()));
+		_eventBus->enqueue<EntityDeleteEvent>(npc->id(), npc->entityType());
 	}
+
+	// all entities are at their new positions now
+	updateVisibility();
+
+	// send the changed states to the users
+	_replicator.beginTick();
+	for (const auto& i : _users) {
+		_replicator.replicate(*i.second);
+	}
+}
+
+void Map::generateChunks(const std::vector<glm::ivec3>& chunkPositions) {
+	std::unique_lock lock(_missingChunksMutex);
+	_missingChunks.insert(_missingChunks.end(), chunkPositions.begin(), chunkPositions.end());
 }
 
 bool Map::init() {
+	// a partially initialized map must be cleaned up, too
+	_initialized = true;
 	if (!_attackMgr.init()) {
 		Log::error("Failed to init attack mgr");
 		return false;
 	}
 
+	if (!_replicator.init()) {
+		Log::error("Failed to init the entity replicator");
+		return false;
+	}
+
 	if (!_chunkPersister->init()) {
 		Log::error("could not initialize the chunk persister");
 		return false;
 	}
 
 	_pager = core::make_shared<voxelworld::WorldPager>(_volumeCache, _chunkPersister);
+	_pager->setNavigationGrid(&_navigationGrid);
 	_voxelWorldMgr = new voxelworld::WorldMgr(_pager);
 	if (!_voxelWorldMgr->init()) {
 		Log::error("Failed to init map with id %i", _mapId);
@@ -147,12 +246,19 @@ bool Map::init() {
 }
 
 void Map::shutdown() {
+	if (!_initialized) {
+		return;
+	}
+	_initialized = false;
 	_attackMgr.shutdown();
+	_replicator.shutdown();
+	_grid.clear();
 	_spawnMgr->shutdown();
 	if (_pager != nullptr) {
 		_pager->shutdown();
 		_pager = voxelworld::WorldPagerPtr();
 	}
+	_navigationGrid.clear();
 	if (_voxelWorldMgr != nullptr) {
 		_voxelWorldMgr->shutdown();
 		delete _voxelWorldMgr;
@@ -178,8 +284,8 @@ void Map::addUser(const UserPtr& user) {
 	}
 	const glm::vec3& pos = findStartPosition(user);
 	user->setMap(ptr(), pos);
-	_quadTree.insert(QuadTreeNode { user });
-	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(user));
+	_grid.insert(GridNode { user });
+	_eventBus->enqueue<EntityAddToMapEvent>(user);
 	_poiProvider->add(pos, poi::Type::SPAWN);
 }
 
@@ -189,9 +295,9 @@ bool Map::removeUser(EntityId id) {
 		return false;
 	}
 	UserPtr user = i->second;
-	_quadTree.remove(QuadTreeNode { user });
+	_grid.remove(GridNode { user });
 	_users.erase(i);
-	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(user));
+	_eventBus->enqueue<EntityRemoveFromMapEvent>(user);
 	return true;
 }
 
@@ -212,8 +318,8 @@ bool Map::addNpc(const NpcPtr& npc) {
 	const glm::vec3& pos = findStartPosition(npc);
 	npc->setMap(ptr(), pos);
 	_zone->addAI(npc->ai());
-	_quadTree.insert(QuadTreeNode { npc });
-	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(npc));
+	_grid.insert(GridNode { npc });
+	_eventBus->enqueue<EntityAddToMapEvent>(npc);
 	_poiProvider->add(pos, poi::Type::SPAWN);
 	return true;
 }
@@ -224,10 +330,10 @@ bool Map::removeNpc(EntityId id) {
 		return false;
 	}
 	NpcPtr npc = i->second;
-	_quadTree.remove(QuadTreeNode { npc });
+	_grid.remove(GridNode { npc });
 	_npcs.erase(i);
 	_zone->removeAI(npc->ai());
-	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(npc));
+	_eventBus->enqueue<EntityRemoveFromMapEvent>(npc);
 	return true;
 }
 
@@ -244,6 +350,46 @@ int Map::findFloor(const glm::ivec3& pos, int maxDistanceY) const {
 	return _voxelWorldMgr->findWalkableFloor(pos, maxDistanceY);
 }
 
+bool Map::findPath(const glm::ivec3& start, const glm::ivec3& end, std::vector<glm::ivec3>& path) {
+	return _navigationGrid.findPath(start, end, path);
+}
+
+int Map::pregenerate(const voxel::Region& region, core::ThreadPool& threadPool) {
+	core_trace_scoped(MapPregenerate);
+	voxel::PagedVolume* volume = _voxelWorldMgr->volumeData();
+	const int size = volume->chunkSideLength();
+	const glm::ivec3& mins = glm::floor(glm::vec3(region.getLowerCorner()) / (float)size);
+	const glm::ivec3& maxs = glm::floor(glm::vec3(region.getUpperCorner()) / (float)size);
+	std::vector<glm::ivec3> positions;
+	for (int x = mins.x; x <= maxs.x; ++x) {
+		for (int z = mins.z; z <= maxs.z; ++z) {
+			for (int y = mins.y; y <= maxs.y; ++y) {
+				positions.emplace_back(x * size, y * size, z * size);
+			}
+		}
+	}
+	// the pager generates one chunk at a time - but the batches of the previous wave are written to the
+	// database while the chunks of the next wave are generated in the thread pool
+	std::vector<std::future<void>> futures;
+	for (size_t begin = 0u; begin < positions.size(); begin += DBChunkPersister::BulkSize) {
+		const size_t end = core_min(begin + DBChunkPersister::BulkSize, positions.size());
+		futures.clear();
+		for (size_t i = begin; i < end; ++i) {
+			const glm::ivec3& pos = positions[i];
+			futures.emplace_back(threadPool.enqueue([volume, pos] () {
+				volume->chunk(pos);
+			}));
+		}
+		_chunkPersister->flushBulk();
+		for (auto& future : futures) {
+			future.get();
+		}
+	}
+	_chunkPersister->flushBulk();
+	Log::debug("Paged in %i chunks on map %i", (int)positions.size(), _mapId);
+	return (int)positions.size();
+}
+
 glm::ivec3 Map::randomPos() const {
 	return _voxelWorldMgr->randomPos();
 }
@@ -5,19 +5,26 @@
 #pragma once
 
 #include "backend/ForwardDecl.h"
-#include "math/QuadTree.h"
+#include "math/SpatialHashGrid.h"
 #include "math/Rect.h"
 #include "core/Common.h"
 #include "ai/common/CharacterId.h"
 #include "core/IComponent.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/Trace.h"
 #include "backend/attack/AttackMgr.h"
 #include "persistence/ISavable.h"
 #include "persistence/ForwardDecl.h"
 #include "voxel/Constants.h"
+#include "voxelworld/NavigationGrid.h"
 #include "DBChunkPersister.h"
+#include "backend/entity/Entity.h"
+#include "EntityReplicator.h"
 #include "MapId.h"
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #include <glm/fwd.hpp>
 #include <glm/vec3.hpp>
 
@@ -33,6 +40,8 @@ private:
 	core::String _mapIdStr;
 	voxelworld::WorldMgr* _voxelWorldMgr = nullptr;
 	voxelworld::WorldPagerPtr _pager;
+	// the walkable floors of the paged in chunks for the npc pathfinding
+	voxelworld::NavigationGrid _navigationGrid;
 
 	core::EventBusPtr _eventBus;
 	SpawnMgrPtr _spawnMgr;
@@ -42,6 +51,8 @@ private:
 	voxelformat::VolumeCachePtr _volumeCache;
 
 	ai::Zone* _zone = nullptr;
+	// the map provider and the destructor both shut the map down
+	bool _initialized = false;
 
 	typedef std::unordered_map<ai::CharacterId, NpcPtr> Npcs;
 	typedef Npcs::iterator NpcsIter;
@@ -52,20 +63,50 @@ private:
 	Users _users;
 
 	AttackMgr _attackMgr;
+	EntityReplicator _replicator;
 
-	struct QuadTreeNode {
+	struct GridNode {
 		EntityPtr entity;
 
 		math::RectFloat getRect() const;
-		bool operator==(const QuadTreeNode& rhs) const;
+		bool operator==(const GridNode& rhs) const;
 	};
 
-	math::QuadTree<QuadTreeNode, float> _quadTree;
+	struct GridNodeHash {
+		size_t operator()(const GridNode& node) const;
+	};
+
+	/**
+	 * @brief The size of the grid cells - in the range of the view distance of the entities
+	 */
+	static constexpr float GridCellSize = 64.0f;
+	/**
+	 * @brief The smallest amount of entities whose visibility is computed in one batch by one worker
+	 */
+	static constexpr int MinVisibilityBatchSize = 64;
+
+	typedef math::SpatialHashGrid<GridNode, float, GridNodeHash> Grid;
+	Grid _grid;
 	DBChunkPersisterPtr _chunkPersister;
+
+	// the entities and their visible entities of the current visibility pass - reused between the ticks
+	std::vector<EntityPtr> _visibilityEntities;
+	std::vector<EntityList> _visibilitySets;
+	// one query buffer per worker
+	std::vector<Grid::Contents> _visibilityScratch;
+
+	// the chunks that the clients requested but that are not persisted yet - see generateChunks()
+	core_trace_mutex(std::mutex, _missingChunksMutex);
+	std::vector<glm::ivec3> _missingChunks;
+
 	/**
 	 * @return @c false if the entity should be removed from the server.
 	 */
 	bool updateEntity(const EntityPtr& entity, long dt);
+	/**
+	 * @brief Computes the visible entities of all entities of the map in parallel and hands them over to the entities
+	 */
+	void updateVisibility();
 
 	glm::vec3 findStartPosition(const EntityPtr& entity) const;
 
@@ -86,6 +127,13 @@ public:
 
 	void update(long dt);
 
+	/**
+	 * @brief Schedules the generation of the chunks at the given chunk positions on the paging thread of the volume
+	 * @note Can be called from any thread - the chunks are scheduled with the next @c update(), the volume must
+	 * not be paged while it's shut down
+	 */
+	void generateChunks(const std::vector<glm::ivec3>& chunkPositions);
+
 	bool init() override;
 	void shutdown() override;
 
@@ -128,6 +176,21 @@ public:
 	int userCount() const;
 
 	int findFloor(const glm::ivec3& pos, int maxDistanceY = voxel::MAX_HEIGHT) const;
+	/**
+	 * @brief Searches a walkable path on the already paged in chunks - no voxels are touched
+	 * @param[out] path The floor positions from the start to the end position
+	 * @sa voxelworld::NavigationGrid::findPath()
+	 */
+	bool findPath(const glm::ivec3& start, const glm::ivec3& end, std::vector<glm::ivec3>& path);
+	/**
+	 * @brief Pages in all chunks that intersect the given region - the chunks that are not yet persisted are generated
+	 * @note Blocks until all chunks are paged in. Combine this with the bulk mode of the @c DBChunkPersister to write
+	 * the new chunks in batches.
+	 * @note The page-ins are serialized by the pager - the thread pool only lets the generation of the chunks overlap
+	 * with the database writes of the previous batch. One thread is enough.
+	 * @return The amount of chunks that were paged in
+	 */
+	int pregenerate(const voxel::Region& region, core::ThreadPool& threadPool);
 	glm::ivec3 randomPos() const;
 
 	const DBChunkPersisterPtr& chunkPersister();
@@ -135,6 +198,8 @@ public:
 	const AttackMgr& attackMgr() const;
 	AttackMgr& attackMgr();
 
+	const EntityReplicator& replicator() const;
+
 	const SpawnMgrPtr& spawnMgr() const;
 	SpawnMgrPtr& spawnMgr();
 
@@ -162,6 +227,10 @@ inline AttackMgr& Map::attackMgr() {
 	return _attackMgr;
 }
 
+inline const EntityReplicator& Map::replicator() const {
+	return _replicator;
+}
+
 inline MapId Map::id() const {
 	return _mapId;
 }
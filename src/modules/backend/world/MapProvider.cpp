@@ -13,10 +13,81 @@
 #include "attrib/ContainerProvider.h"
 #include "voxel/PagedVolume.h"
 #include "voxelworld/WorldMgr.h"
+#include "voxelworld/ChunkBatch.h"
+#include "core/StringUtil.h"
+#include "core/ArrayLength.h"
+#include "core/Trace.h"
+#include <glm/vector_relational.hpp>
 #include <glm/vec3.hpp>
 
 namespace backend {
 
+namespace {
+
+bool parseInts(const char *str, int *values, int amount, char separator, const char **end) {
+	for (int i = 0; i < amount; ++i) {
+		char *next;
+		values[i] = (int)SDL_strtol(str, &next, 10);
+		if (next == str) {
+			return false;
+		}
+		str = next;
+		if (i < amount - 1) {
+			if (*str != separator) {
+				return false;
+			}
+			++str;
+		}
+	}
+	*end = str;
+	return true;
+}
+
+bool parseChunkList(const char *str, std::vector<glm::ivec3>& chunkPositions) {
+	while (*str != '\0') {
+		if (chunkPositions.size() >= voxelworld::MaxChunkBatchSize) {
+			return false;
+		}
+		glm::ivec3 chunkPos;
+		if (!parseInts(str, &chunkPos.x, 3, ',', &str)) {
+			return false;
+		}
+		chunkPositions.push_back(chunkPos);
+		if (*str == ';') {
+			++str;
+		} else if (*str != '\0') {
+			return false;
+		}
+	}
+	return !chunkPositions.empty();
+}
+
+bool parseChunkBox(const char *str, std::vector<glm::ivec3>& chunkPositions) {
+	int values[6];
+	if (!parseInts(str, values, lengthof(values), ',', &str) || *str != '\0') {
+		return false;
+	}
+	const glm::ivec3 mins(values[0], values[1], values[2]);
+	const glm::ivec3 maxs(values[3], values[4], values[5]);
+	if (glm::any(glm::lessThan(maxs, mins))) {
+		return false;
+	}
+	const glm::ivec3 size = maxs - mins + 1;
+	if ((int64_t)size.x * size.y * size.z > (int64_t)voxelworld::MaxChunkBatchSize) {
+		return false;
+	}
+	for (int x = mins.x; x <= maxs.x; ++x) {
+		for (int y = mins.y; y <= maxs.y; ++y) {
+			for (int z = mins.z; z <= maxs.z; ++z) {
+				chunkPositions.emplace_back(x, y, z);
+			}
+		}
+	}
+	return true;
+}
+
+}
+
 MapProvider::MapProvider(
 		const io::FilesystemPtr& filesystem,
 		const core::EventBusPtr& eventBus,
@@ -73,10 +144,9 @@ bool MapProvider::init() {
 		return false;
 	}
 
+	// single chunks are requested with the world position x, y and z - many chunks at once with a list of
+	// chunk positions (chunks=x,y,z;x,y,z) or with a box of chunk positions (box=minx,miny,minz,maxx,maxy,maxz)
 	_httpServer->registerRoute(http::HttpMethod::GET, "/chunk", [&] (const http::RequestParser& request, http::HttpResponse* response) {
-		HTTP_QUERY_GET_INT(x);
-		HTTP_QUERY_GET_INT(y);
-		HTTP_QUERY_GET_INT(z);
 		HTTP_QUERY_GET_INT(mapid);
 		const MapPtr& m = map(mapid);
 		if (!m) {
@@ -84,28 +154,43 @@ bool MapProvider::init() {
 			response->setText("Map with given id not found");
 			return;
 		}
-		const DBChunkPersisterPtr& persister = m->chunkPersister();
-		voxelworld::WorldMgr* worldMgr = m->worldMgr();
-		voxel::PagedVolume* volume = worldMgr->volumeData();
-		const glm::ivec3& chunkPos = volume->chunkPos(x, y, z);
-		const core::VarPtr& seed = core::Var::getSafe(cfg::ServerSeed);
-		persistence::Blob blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal());
-		if (blob.length <= 0) {
-			(void)volume->voxel(x, y, z);
-			blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal());
-			if (blob.length <= 0) {
-				response->status = http::HttpStatus::NotFound;
-				response->setText(core::string::format("Chunk not found at %i:%i:%i on map %i with seed %u",
-						chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal()));
+		const unsigned int seed = core::Var::getSafe(cfg::ServerSeed)->uintVal();
+		const core::String& etag = voxelworld::ChunkPersister::etag(seed);
+		if (_chunkETag != etag) {
+			_chunkETag = etag;
+		}
+		response->headers.put(http::header::ETAG, _chunkETag.c_str());
+		// the chunks only depend on the seed and the chunk format - cached chunks stay valid
+		const char *ifNoneMatch;
+		if (request.headers.get(http::header::IF_NONE_MATCH, ifNoneMatch)
+				&& (_chunkETag == ifNoneMatch || !SDL_strcmp(ifNoneMatch, "*"))) {
+			response->status = http::HttpStatus::NotModified;
+			return;
+		}
+
+		std::vector<glm::ivec3> chunkPositions;
+		const char *chunksValue;
+		const char *boxValue;
+		if (request.query.get("chunks", chunksValue)) {
+			if (!parseChunkList(chunksValue, chunkPositions)) {
+				response->status = http::HttpStatus::BadRequest;
+				response->setText("Invalid chunk list");
+				return;
+			}
+		} else if (request.query.get("box", boxValue)) {
+			if (!parseChunkBox(boxValue, chunkPositions)) {
+				response->status = http::HttpStatus::BadRequest;
+				response->setText("Invalid chunk box");
 				return;
 			}
+		} else {
+			HTTP_QUERY_GET_INT(x);
+			HTTP_QUERY_GET_INT(y);
+			HTTP_QUERY_GET_INT(z);
+			chunk(m, glm::ivec3(x, y, z), seed, response);
+			return;
 		}
-		response->body = (char*)core_malloc(blob.length);
-		::memcpy((void*)response->body, blob.data, blob.length);
-		response->freeBody = true;
-		response->contentLength(blob.length);
-		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNK);
-		blob.release();
+		chunks(m, chunkPositions, seed, response);
 	});
 
 	const MapId mapId = 1;
@@ -122,8 +207,87 @@ bool MapProvider::init() {
 	return true;
 }
 
+void MapProvider::chunk(const MapPtr& m, const glm::ivec3& pos, unsigned int seed, http::HttpResponse* response) const {
+	const DBChunkPersisterPtr& persister = m->chunkPersister();
+	voxel::PagedVolume* volume = m->worldMgr()->volumeData();
+	const glm::ivec3& chunkPos = volume->chunkPos(pos.x, pos.y, pos.z);
+	const MapId mapId = m->id();
+	persistence::Blob blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapId, seed);
+	if (blob.length <= 0) {
+		(void)volume->voxel(pos.x, pos.y, pos.z);
+		blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapId, seed);
+		if (blob.length <= 0) {
+			response->status = http::HttpStatus::NotFound;
+			response->setText(core::string::format("Chunk not found at %i:%i:%i on map %i with seed %u",
+					chunkPos.x, chunkPos.y, chunkPos.z, mapId, seed));
+			return;
+		}
+	}
+	// the blob is allocated with core_malloc - the server takes the ownership of the data
+	response->body = (const char*)blob.data;
+	response->freeBody = true;
+	response->contentLength(blob.length);
+	response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNK);
+}
+
+void MapProvider::chunks(const MapPtr& m, const std::vector<glm::ivec3>& chunkPositions, unsigned int seed, http::HttpResponse* response) const {
+	core_trace_scoped(MapProviderChunks);
+	const MapId mapId = m->id();
+	// the server loop doesn't wait for the database - the response is sent once all chunks were selected
+	response->defer();
+	const http::HttpResponse deferred = *response;
+	const http::HttpServerPtr httpServer = _httpServer;
+	m->chunkPersister()->load(chunkPositions, mapId, seed, [m, httpServer, deferred, chunkPositions] (std::vector<persistence::Blob>&& blobs) {
+		core_trace_scoped(MapProviderChunksSelected);
+		std::vector<glm::ivec3> missing;
+		for (size_t i = 0; i < blobs.size(); ++i) {
+			if (blobs[i].length <= 0) {
+				missing.push_back(chunkPositions[i]);
+			}
+		}
+		if (!missing.empty()) {
+			// the chunks are generated and saved by the paging thread of the volume - the generation of a whole
+			// batch would block the executor. The client requests the chunks again.
+			Log::debug("Generate %i missing chunks of the batch on map %i", (int)missing.size(), m->id());
+			m->generateChunks(missing);
+		}
+
+		std::vector<voxelworld::ChunkBatchEntry> entries;
+		entries.reserve(blobs.size());
+		for (size_t i = 0; i < blobs.size(); ++i) {
+			if (blobs[i].length <= 0) {
+				continue;
+			}
+			voxelworld::ChunkBatchEntry entry;
+			entry.chunkPos = chunkPositions[i];
+			entry.data = blobs[i].data;
+			entry.length = (uint32_t)blobs[i].length;
+			entries.push_back(entry);
+		}
+		const size_t size = voxelworld::chunkBatchSize(entries);
+		uint8_t *body = (uint8_t*)core_malloc(size > 0u ? size : 1u);
+		voxelworld::writeChunkBatch(entries, body, size);
+		for (persistence::Blob& blob : blobs) {
+			blob.release();
+		}
+		http::HttpResponse completed = deferred;
+		completed.body = (const char*)body;
+		completed.freeBody = true;
+		completed.contentLength(size);
+		completed.headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNKS);
+		httpServer->complete(completed);
+	});
+}
+
 void MapProvider::shutdown() {
 	_httpServer->unregisterRoute(http::HttpMethod::GET, "/chunk");
+	// the chunk batches that are still selected hold a reference to their map
+	_dbHandler->executor().flush();
+	// entities might still hold a reference to their map - make sure the pager and
+	// the worker threads are stopped before the shared resources go away
+	for (auto& e : _maps) {
+		e.second->shutdown();
+	}
 	_maps.clear();
 }
 
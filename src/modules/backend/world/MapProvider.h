@@ -10,8 +10,11 @@
 #include "http/HttpServer.h"
 #include "DBChunkPersister.h"
 #include "core/Factory.h"
+#include "core/String.h"
+#include <glm/vec3.hpp>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace backend {
 
@@ -37,6 +40,21 @@ private:
 	persistence::DBHandlerPtr _dbHandler;
 
 	std::unordered_map<MapId, MapPtr> _maps;
+	// the header values of the response must stay valid until the response was sent - this includes the
+	// deferred responses of the chunk batches
+	core::String _chunkETag;
+
+	/**
+	 * @brief Answers the request for one chunk at the given world position
+	 */
+	void chunk(const MapPtr& map, const glm::ivec3& pos, unsigned int seed, http::HttpResponse* response) const;
+	/**
+	 * @brief Answers the request for the chunks at the given chunk positions with a @c voxelworld::ChunkBatch
+	 * stream - chunks that are not yet persisted are left out. They are generated by the paging thread of the
+	 * map volume and are part of a later response.
+	 * @note The response is deferred until the database selected the chunks - see @c http::HttpResponse::defer()
+	 */
+	void chunks(const MapPtr& map, const std::vector<glm::ivec3>& chunkPositions, unsigned int seed, http::HttpResponse* response) const;
 public:
 	MapProvider(
 			const io::FilesystemPtr& filesystem,
@@ -10,6 +10,9 @@
 #include "backend/world/Map.h"
 #include "backend/entity/ai/AIRegistry.h"
 #include "core/io/Filesystem.h"
+#include "core/TimeProvider.h"
+#include "core/concurrent/ThreadPool.h"
+#include "voxelworld/FilePersister.h"
 #include "core/Log.h"
 #include "core/StringUtil.h"
 #include "core/Common.h"
@@ -82,6 +85,61 @@ void World::construct() {
 		}
 	}).setHelp("Truncate chunks for all maps");
 
+	core::Command::registerCommand("sv_chunkspregenerate", [this] (const core::CmdArgs& args) {
+		if (args.size() < 5) {
+			Log::info("Usage: sv_chunkspregenerate <mapid> <minx> <minz> <maxx> <maxz>");
+			return;
+		}
+		const MapId id = core::string::toInt(args[0]);
+		const MapPtr& map = this->map(id);
+		if (!map) {
+			Log::info("Could not find the specified map");
+			return;
+		}
+		const voxel::Region region(core::string::toInt(args[1]), 0, core::string::toInt(args[2]),
+				core::string::toInt(args[3]), voxel::MAX_HEIGHT, core::string::toInt(args[4]));
+		// the pager serializes the page-ins - more threads wouldn't generate the chunks faster
+		core::ThreadPool threadPool(1, "pregenerate");
+		threadPool.init();
+		const DBChunkPersisterPtr& persister = map->chunkPersister();
+		const uint64_t start = core::TimeProvider::systemMillis();
+		persister->beginBulk();
+		const int chunks = map->pregenerate(region, threadPool);
+		const int written = persister->endBulk();
+		const double seconds = core_max(1.0, (double)(core::TimeProvider::systemMillis() - start)) / 1000.0;
+		Log::info("Paged in %i chunks on map %i - generated and wrote %i chunks in %.2fs (%.1f chunks/s)",
+				chunks, id, written, seconds, (double)written / seconds);
+	}).setHelp("Generates the chunks of an area of a map and writes them in bulk to the database");
+
+	core::Command::registerCommand("sv_chunksexport", [this] (const core::CmdArgs& args) {
+		if (args.empty()) {
+			Log::info("Usage: sv_chunksexport <mapid>");
+			return;
+		}
+		const MapId id = core::string::toInt(args[0]);
+		const MapPtr& map = this->map(id);
+		if (!map) {
+			Log::info("Could not find the specified map");
+			return;
+		}
+		const unsigned int seed = core::Var::getSafe(cfg::ServerSeed)->uintVal();
+		const uint64_t start = core::TimeProvider::systemMillis();
+		int exported = 0;
+		const bool success = map->chunkPersister()->copyOut(seed, [&] (db::ChunkModel&& chunk) {
+			persistence::Blob data = chunk.data();
+			const glm::ivec3 chunkPos(chunk.x(), chunk.y(), chunk.z());
+			if (_filesystem->write(voxelworld::FilePersister::chunkFilename(chunkPos, seed), data.data, data.length)) {
+				++exported;
+			}
+			data.release();
+		});
+		const double seconds = core_max(1.0, (double)(core::TimeProvider::systemMillis() - start)) / 1000.0;
+		if (!success) {
+			Log::error("Failed to export the chunks of map %i", id);
+		}
+		Log::info("Exported %i chunks of map %i for seed %u in %.2fs (%.1f chunks/s)", exported, id, seed, seconds, (double)exported / seconds);
+	}).setHelp("Writes the persisted chunks of a map into files that can be loaded by the file persister");
+
 	_mapProvider->construct();
 }
 
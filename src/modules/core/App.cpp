@@ -47,8 +47,8 @@ App::App(const metric::MetricPtr& metric, const io::FilesystemPtr& filesystem, c
 
 App::~App() {
 	core_trace_set(nullptr);
-	_metricSender->shutdown();
 	_metric->shutdown();
+	_metricSender->shutdown();
 	Log::shutdown();
 	_threadPool = core::ThreadPoolPtr();
 }
@@ -244,6 +244,7 @@ AppState App::onConstruct() {
 	}
 
 	core::Var::get(cfg::MetricFlavor, "telegraf");
+	core::Var::get(cfg::MetricFlushInterval, "1000");
 	const core::String& host = core::Var::get(cfg::MetricHost, "127.0.0.1")->strVal();
 	const int port = core::Var::get(cfg::MetricPort, "8125")->intVal();
 	_metricSender = std::make_shared<metric::UDPMetricSender>(host, port);
@@ -501,6 +502,8 @@ AppState App::onRunning() {
 
 	_filesystem->update();
 
+	_metric->update(_now);
+
 	return AppState::Cleanup;
 }
 
@@ -618,12 +621,13 @@ AppState App::onCleanup() {
 
 	core_trace_shutdown();
 
-	if (_metricSender) {
-		_metricSender->shutdown();
-	}
+	// the metric sends the aggregated metrics that weren't flushed yet
 	if (_metric) {
 		_metric->shutdown();
 	}
+	if (_metricSender) {
+		_metricSender->shutdown();
+	}
 
 #if defined(HAVE_SYS_RESOURCE_H)
 #if defined(HAVE_SYS_TIME_H)
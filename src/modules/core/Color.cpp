@@ -47,11 +47,19 @@ const glm::vec4 Color::DarkBrown    = glm::vec4( 82.f,  43,  26, 255) / glm::vec
  * @param color The color to find the closest match to in the given @c colors array
  * @return index in the colors vector or the first entry if non was found
  */
-int Color::getClosestMatch(const glm::vec4& color, const std::vector<glm::vec4>& colors) {
+static inline float colorDistance(float hue, float saturation, float brightness, float chue, float csaturation, float cbrightness) {
 	const float weightHue = 0.8f;
 	const float weightSaturation = 0.1f;
 	const float weightValue = 0.1f;
+	const float dH = chue - hue;
+	const float dS = csaturation - saturation;
+	const float dV = cbrightness - brightness;
+	return weightHue * glm::pow(dH, 2) +
+			weightValue * glm::pow(dV, 2) +
+			weightSaturation * glm::pow(dS, 2);
+}
 
+int Color::getClosestMatch(const glm::vec4& color, const std::vector<glm::vec4>& colors) {
 	float minDistance = FLT_MAX;
 
 	int minIndex = 0;
@@ -67,12 +75,28 @@ int Color::getClosestMatch(const glm::vec4& color, const std::vector<glm::vec4>&
 		float cbrightness;
 		core::Color::getHSB(colors[i], chue, csaturation, cbrightness);
 
-		const float dH = chue - hue;
-		const float dS = csaturation - saturation;
-		const float dV = cbrightness - brightness;
-		const float val = weightHue * glm::pow(dH, 2) +
-				weightValue * glm::pow(dV, 2) +
-				weightSaturation * glm::pow(dS, 2);
+		const float val = colorDistance(hue, saturation, brightness, chue, csaturation, cbrightness);
+		if (val < minDistance) {
+			minDistance = val;
+			minIndex = (int)i;
+		}
+	}
+	return minIndex;
+}
+
+int Color::getClosestMatchHSB(const glm::vec4& color, const std::vector<glm::vec3>& hsbColors) {
+	float minDistance = FLT_MAX;
+
+	int minIndex = 0;
+
+	float hue;
+	float saturation;
+	float brightness;
+	core::Color::getHSB(color, hue, saturation, brightness);
+
+	for (size_t i = 0; i < hsbColors.size(); ++i) {
+		const glm::vec3& hsb = hsbColors[i];
+		const float val = colorDistance(hue, saturation, brightness, hsb.x, hsb.y, hsb.z);
 		if (val < minDistance) {
 			minDistance = val;
 			minIndex = (int)i;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <glm/fwd.hpp>
+#include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <vector>
 
@@ -52,6 +53,11 @@ public:
 		DarkBrown;
 
 	static int getClosestMatch(const glm::vec4& color, const std::vector<glm::vec4>& colors);
+	/**
+	 * @brief Same as @c getClosestMatch() but with the already converted hue, saturation and brightness values
+	 * of the colors (see @c getHSB()) - this saves the conversion of every candidate
+	 */
+	static int getClosestMatchHSB(const glm::vec4& color, const std::vector<glm::vec3>& hsbColors);
 	static glm::vec4 fromRGB(const unsigned int rgbInt, const float a = 1.0f);
 	static glm::vec4 fromRGBA(const unsigned int rgbaInt);
 	static glm::vec4 fromARGB(const unsigned int argbInt);
@@ -11,7 +11,8 @@
 #include "core/Log.h"
 #include "core/Common.h"
 #include "core/concurrent/ReadWriteLock.h"
-#include "core/collection/ConcurrentQueue.h"
+#include "core/concurrent/ConcurrentPool.h"
+#include "core/collection/MPSCQueue.h"
 
 namespace core {
 
@@ -124,6 +125,57 @@ public: \
 	} \
 }
 
+/**
+ * @brief Allocator for the events that are created by EventBus::enqueue() - the memory of every type
+ * is recycled from its own lock-free pool. The heap is only used if the pool is exhausted.
+ */
+template<class T>
+class EventBusEventAllocator {
+private:
+	static constexpr int PoolSize = 1024;
+	using Pool = ConcurrentPool<sizeof(T), PoolSize, alignof(T)>;
+
+	static Pool& pool() {
+		static Pool _pool;
+		return _pool;
+	}
+public:
+	using value_type = T;
+
+	EventBusEventAllocator() = default;
+
+	template<class U>
+	EventBusEventAllocator(const EventBusEventAllocator<U>&) {
+	}
+
+	T* allocate(size_t n) {
+		if (n == 1u) {
+			if (void* ptr = pool().alloc()) {
+				return (T*)ptr;
+			}
+		}
+		return (T*)::operator new(n * sizeof(T));
+	}
+
+	void deallocate(T* ptr, size_t) {
+		if (pool().owns(ptr)) {
+			pool().free(ptr);
+		} else {
+			::operator delete(ptr);
+		}
+	}
+
+	template<class U>
+	inline bool operator==(const EventBusEventAllocator<U>&) const {
+		return true;
+	}
+
+	template<class U>
+	inline bool operator!=(const EventBusEventAllocator<U>&) const {
+		return false;
+	}
+};
+
 /**
  * @brief EventBus with topic (IEventBusTopic) support
  *
@@ -136,7 +188,8 @@ private:
 	typedef std::unordered_map<ClassTypeId, EventBusHandlerReferences> EventBusHandlerReferenceMap;
 	core::ReadWriteLock _lock;
 
-	core::ConcurrentQueue<IEventBusEventPtr, std::less<IEventBusEventPtr> > _queue;
+	// the queued events are delivered in the order they were enqueued (per producer thread)
+	core::MPSCQueue<IEventBusEventPtr> _queue;
 
 	class EventBusHandlerReference {
 	private:
@@ -208,10 +261,11 @@ public:
 	int publish(const IEventBusEvent& e);
 
 	/**
-	 * @brief Execute all queued events
+	 * @brief Execute all queued events in the order they were enqueued
 	 * @param[in] limit Limit the amount of executed events - if there are too many. If -1 is given here,
 	 * all events are handled.
 	 * @return the amount of events that are still in the queue (due to the limit)
+	 * @note Must only be called from one thread
 	 */
 	int update(int limit = -1);
 
@@ -219,8 +273,19 @@ public:
 
 	/**
 	 * @brief Execute in the main thread in the next tick
+	 * @note Can be called from any thread
 	 */
 	void enqueue(const IEventBusEventPtr& e);
+
+	/**
+	 * @brief Creates the event from the memory pool of its type and executes it in the main thread in the next tick
+	 * @note Can be called from any thread
+	 */
+	template<class T, class ... Args>
+	void enqueue(Args&&... args) {
+		static_assert(std::is_base_of<IEventBusEvent, T>::value, "Wrong type given, must extend IEventBusEvent");
+		_queue.push(std::allocate_shared<T>(EventBusEventAllocator<T>(), std::forward<Args>(args)...));
+	}
 };
 
 typedef std::shared_ptr<EventBus> EventBusPtr;
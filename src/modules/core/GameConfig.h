@@ -52,6 +52,10 @@ constexpr const char *ServerPostgresLib = "sv_postgreslib";
 constexpr const char *ServerHttpPort = "sv_httpport";
 // the download urls for the chunks
 constexpr const char *ServerChunkBaseUrl = "sv_httpchunkurl";
+// entities that are further away from a user are replicated less often
+constexpr const char *ServerReplicationDistance = "sv_replicationdistance";
+// the max amount of ticks between two replications of the same entity
+constexpr const char *ServerReplicationMaxInterval = "sv_replicationmaxinterval";
 
 constexpr const char *ConsoleCurses = "con_curses";
 
@@ -62,6 +66,8 @@ constexpr const char *CorePath = "core_path";
 
 // The size of the chunk that is extracted with each step
 constexpr const char *VoxelMeshSize = "voxel_meshsize";
+// The amount of threads that are extracting the meshes of the world
+constexpr const char *VoxelMeshExtractorThreads = "voxel_meshextractorthreads";
 
 constexpr const char *DatabaseName = "db_name";
 constexpr const char *DatabaseHost = "db_host";
@@ -69,6 +75,10 @@ constexpr const char *DatabasePassword = "db_pw";
 constexpr const char *DatabaseUser = "db_user";
 constexpr const char *DatabaseMinConnections = "db_minconnections";
 constexpr const char *DatabaseMaxConnections = "db_maxconnections";
+// Execute the model statements as cached prepared statements with binary results
+constexpr const char *DatabasePreparedStatements = "db_preparedstatements";
+// The amount of threads that execute the asynchronous database statements
+constexpr const char *DatabaseExecutorWorkers = "db_executorworkers";
 
 constexpr const char *AppHomePath = "app_homepath";
 constexpr const char *AppBasePath = "app_basepath";
@@ -76,5 +86,7 @@ constexpr const char *AppBasePath = "app_basepath";
 constexpr const char *MetricPort = "metric_port";
 constexpr const char *MetricHost = "metric_host";
 constexpr const char *MetricFlavor = "metric_flavor";
+// The interval in millis the aggregated metrics are sent with
+constexpr const char *MetricFlushInterval = "metric_flushinterval";
 
 }
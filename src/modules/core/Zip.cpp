@@ -47,11 +47,11 @@ uint32_t compressBound(uint32_t in) {
 }
 
 bool compress(const uint8_t *inputBuf, size_t inputBufSize,
-		uint8_t* outputBuf, size_t outputBufSize, size_t* finalBufSize) {
+		uint8_t* outputBuf, size_t outputBufSize, size_t* finalBufSize, int level) {
 	core_assert_msg(outputBufSize > 0, "Expected to get a outputBufSize > 0 - but got %i", (int)outputBufSize);
 	core_assert_msg(inputBufSize > 0, "Expected to get a inputBufSize > 0 - but got %i", (int)inputBufSize);
 	mz_ulong destLen = outputBufSize;
-	int ret = ::mz_compress((unsigned char*)outputBuf, &destLen, (const unsigned char*) inputBuf, (mz_ulong)inputBufSize);
+	int ret = ::mz_compress2((unsigned char*)outputBuf, &destLen, (const unsigned char*) inputBuf, (mz_ulong)inputBufSize, level);
 	if (ret == MZ_OK) {
 		if (finalBufSize != nullptr) {
 			*finalBufSize = (size_t)destLen;
@@ -10,9 +10,15 @@
 namespace core {
 namespace zip {
 
+/**
+ * @brief The compression levels are 0 (no compression) to 9 (best compression)
+ */
+constexpr int DefaultCompressionLevel = 6;
+constexpr int FastCompressionLevel = 1;
+
 extern uint32_t compressBound(uint32_t in);
 extern bool compress(const uint8_t *inputBuf, size_t inputBufSize,
-		uint8_t* outputBuf, size_t outputBufSize, size_t* finalBufSize = nullptr);
+		uint8_t* outputBuf, size_t outputBufSize, size_t* finalBufSize = nullptr, int level = DefaultCompressionLevel);
 extern bool uncompress(const uint8_t *inputBuf, size_t inputBufSize,
 		uint8_t* outputBuf, size_t outputBufSize, size_t* finalBufSize = nullptr);
 
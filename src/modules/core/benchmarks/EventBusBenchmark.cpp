@@ -0,0 +1,87 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/EventBus.h"
+#include <thread>
+#include <vector>
+
+namespace {
+
+class BenchmarkEvent: public core::IEventBusEvent {
+private:
+	int _value;
+public:
+	EVENTBUSTYPEID(BenchmarkEvent)
+
+	BenchmarkEvent(int value = 0) : _value(value) {
+	}
+
+	inline int value() const {
+		return _value;
+	}
+};
+
+class BenchmarkHandler: public core::IEventBusHandler<BenchmarkEvent> {
+public:
+	int count = 0;
+
+	void onEvent(const BenchmarkEvent&) override {
+		++count;
+	}
+};
+
+}
+
+class EventBusBenchmark: public core::AbstractBenchmark {
+protected:
+	static constexpr int Events = 10000;
+
+	/**
+	 * @brief The producer threads enqueue the events while the benchmark thread consumes them
+	 */
+	template<class Enqueue>
+	void run(benchmark::State& state, Enqueue enqueue) {
+		const int producers = (int)state.range(0);
+		const int eventsPerProducer = Events / producers;
+		for (auto _ : state) {
+			core::EventBus eventBus;
+			BenchmarkHandler handler;
+			eventBus.subscribe(handler);
+			std::vector<std::thread> threads;
+			threads.reserve(producers);
+			for (int p = 0; p < producers; ++p) {
+				threads.emplace_back([&eventBus, &enqueue, eventsPerProducer] () {
+					for (int i = 0; i < eventsPerProducer; ++i) {
+						enqueue(eventBus, i);
+					}
+				});
+			}
+			while (handler.count < eventsPerProducer * producers) {
+				if (eventBus.update() == 0) {
+					std::this_thread::yield();
+				}
+			}
+			for (std::thread& thread : threads) {
+				thread.join();
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * eventsPerProducer * producers);
+	}
+};
+
+BENCHMARK_DEFINE_F(EventBusBenchmark, enqueuePooled) (benchmark::State& state) {
+	run(state, [] (core::EventBus& eventBus, int i) {
+		eventBus.enqueue<BenchmarkEvent>(i);
+	});
+}
+
+BENCHMARK_DEFINE_F(EventBusBenchmark, enqueueShared) (benchmark::State& state) {
+	run(state, [] (core::EventBus& eventBus, int i) {
+		eventBus.enqueue(std::make_shared<BenchmarkEvent>(i));
+	});
+}
+
+BENCHMARK_REGISTER_F(EventBusBenchmark, enqueuePooled)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK_REGISTER_F(EventBusBenchmark, enqueueShared)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
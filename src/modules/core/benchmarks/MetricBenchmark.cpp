@@ -0,0 +1,80 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/metric/Metric.h"
+#include "core/metric/UDPMetricSender.h"
+#include "core/StringUtil.h"
+
+/**
+ * @brief Compares the immediately sent metrics with the aggregated ones
+ *
+ * The metrics are sent to a local port that nobody listens on - the cost of the syscalls is still
+ * included in the measurement.
+ */
+class MetricBenchmark: public core::AbstractBenchmark {
+protected:
+	static constexpr int Keys = 16;
+	// the network metrics are recorded for every packet - this is the amount of samples between two flushes
+	static constexpr int SamplesPerFlush = 4096;
+	metric::IMetricSenderPtr _sender;
+	metric::MetricPtr _metric;
+	metric::MetricHandle _handles[Keys];
+
+public:
+	void SetUp(benchmark::State& st) override {
+		core::AbstractBenchmark::SetUp(st);
+		_sender = std::make_shared<metric::UDPMetricSender>("127.0.0.1", 18125);
+		_sender->init();
+		_metric = std::make_shared<metric::Metric>();
+		for (int i = 0; i < Keys; ++i) {
+			_handles[i] = _metric->registerMetric("network_packet_count", metric::MetricType::Count,
+					{{"direction", "out"}, {"type", core::string::format("type%i", i)}});
+		}
+		_metric->init("benchmark", _sender);
+	}
+
+	void TearDown(benchmark::State& st) override {
+		_metric->shutdown();
+		_metric = metric::MetricPtr();
+		_sender->shutdown();
+		_sender = metric::IMetricSenderPtr();
+		core::AbstractBenchmark::TearDown(st);
+	}
+};
+
+BENCHMARK_DEFINE_F(MetricBenchmark, immediate) (benchmark::State& state) {
+	const metric::TagMap tags {{"direction", "out"}, {"type", "type0"}};
+	for (auto _ : state) {
+		if (!_metric->count("network_packet_count", 1, tags)) {
+			state.SkipWithError("Failed to send the metric");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(MetricBenchmark, aggregated) (benchmark::State& state) {
+	int samples = 0;
+	for (auto _ : state) {
+		_metric->record(_handles[samples % Keys], 1);
+		if (++samples == SamplesPerFlush) {
+			_metric->flush();
+			samples = 0;
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(MetricBenchmark, aggregatedRecordOnly) (benchmark::State& state) {
+	int samples = 0;
+	for (auto _ : state) {
+		_metric->record(_handles[samples++ % Keys], 1);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(MetricBenchmark, immediate);
+BENCHMARK_REGISTER_F(MetricBenchmark, aggregated);
+BENCHMARK_REGISTER_F(MetricBenchmark, aggregatedRecordOnly);
@@ -115,7 +115,8 @@ public:
 
 	bool waitAndPop(Data& poppedValue) {
 		core::ScopedLock lock(_mutex);
-		if (_data.empty()) {
+		// several consumers might wait - only one of them gets the pushed element
+		while (_data.empty() && !_abort) {
 			_conditionVariable.wait(_mutex);
 		}
 		if (_abort) {
@@ -0,0 +1,138 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/concurrent/ConcurrentPool.h"
+#include "core/NonCopyable.h"
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace core {
+
+/**
+ * @brief Unbounded lock-free multi producer single consumer fifo queue
+ *
+ * The producers only need one atomic exchange to link a new node (see Dmitry Vyukov's intrusive mpsc
+ * node based queue). The values of one producer are popped in the order they were pushed. The nodes are
+ * recycled from a lock-free pool - the heap is only used if more than @c NodePoolSize values are queued.
+ *
+ * @note @c pop() must only be called by one thread at a time - @c push() can be called from any thread.
+ * @note @c pop() might return @c false while a producer is still linking its node - the value is returned
+ * with the next call.
+ */
+template<class T, int NodePoolSize = 4096>
+class MPSCQueue : public core::NonCopyable {
+private:
+	struct Node {
+		std::atomic<Node*> next { nullptr };
+		T value;
+	};
+	ConcurrentPool<sizeof(Node), NodePoolSize, alignof(Node)> _pool;
+	std::atomic<Node*> _head;
+	std::atomic<int> _size { 0 };
+	Node* _tail;
+	Node _stub;
+
+	Node* allocNode(T&& value) {
+		void* mem = _pool.alloc();
+		if (mem == nullptr) {
+			mem = ::operator new(sizeof(Node));
+		}
+		Node* node = new (mem) Node();
+		node->value = std::move(value);
+		return node;
+	}
+
+	void freeNode(Node* node) {
+		node->~Node();
+		if (_pool.owns(node)) {
+			_pool.free(node);
+		} else {
+			::operator delete(node);
+		}
+	}
+
+	void pushNode(Node* node) {
+		node->next.store(nullptr, std::memory_order_relaxed);
+		Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+		// between the exchange and this store the consumer can't see the node yet
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	inline bool popNode(Node* tail, Node* next, T& out) {
+		_tail = next;
+		out = std::move(tail->value);
+		freeNode(tail);
+		_size.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+public:
+	MPSCQueue() : _head(&_stub), _tail(&_stub) {
+	}
+
+	~MPSCQueue() {
+		clear();
+	}
+
+	void push(T value) {
+		// counted before the node is visible - otherwise the size could get negative
+		_size.fetch_add(1, std::memory_order_relaxed);
+		pushNode(allocNode(std::move(value)));
+	}
+
+	/**
+	 * @note Only one thread may pop at a time
+	 */
+	bool pop(T& out) {
+		Node* tail = _tail;
+		Node* next = tail->next.load(std::memory_order_acquire);
+		if (tail == &_stub) {
+			if (next == nullptr) {
+				return false;
+			}
+			_tail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+		if (next != nullptr) {
+			return popNode(tail, next, out);
+		}
+		if (tail != _head.load(std::memory_order_acquire)) {
+			// a producer didn't link its node yet
+			return false;
+		}
+		// the last node can only be removed if another node follows - that's what the stub is for
+		pushNode(&_stub);
+		next = tail->next.load(std::memory_order_acquire);
+		if (next != nullptr) {
+			return popNode(tail, next, out);
+		}
+		return false;
+	}
+
+	/**
+	 * @note Only one thread may clear the queue at a time - and not while another thread pops
+	 */
+	void clear() {
+		T value;
+		while (pop(value)) {
+		}
+	}
+
+	/**
+	 * @note The value is only a snapshot if there are producers
+	 */
+	inline int size() const {
+		return _size.load(std::memory_order_relaxed);
+	}
+
+	inline bool empty() const {
+		return size() == 0;
+	}
+};
+
+}
@@ -0,0 +1,94 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace core {
+
+/**
+ * @brief Lock-free pool of a fixed amount of memory slots that can be allocated and freed from any thread
+ *
+ * The free slots are linked by their index. The head of the free list contains a counter that is increased
+ * with every change - so a slot that was allocated and freed again in between doesn't break the list (ABA).
+ *
+ * @note The pool doesn't call any constructors or destructors. If it is exhausted, @c alloc() returns
+ * @c nullptr and the caller is expected to fall back to the heap - @c owns() tells where the memory
+ * came from.
+ * @note The pool has a trivial destructor - it can be used as function local static without any issues
+ * for slots that are freed during the shutdown.
+ */
+template<size_t SlotSize, int Capacity, size_t Alignment = alignof(max_align_t)>
+class ConcurrentPool {
+private:
+	static_assert(Capacity > 0, "The capacity must be greater than 0");
+	static constexpr size_t Stride = (SlotSize + Alignment - 1) / Alignment * Alignment;
+	static constexpr int32_t End = -1;
+
+	alignas(Alignment) uint8_t _storage[Stride * Capacity];
+	std::atomic<int32_t> _next[Capacity];
+	// the upper 32 bits are the change counter, the lower 32 bits the index of the first free slot
+	std::atomic<uint64_t> _head;
+
+	static inline uint64_t pack(uint64_t head, int32_t index) {
+		return (((head >> 32) + 1u) << 32) | (uint32_t)index;
+	}
+
+	static inline int32_t index(uint64_t head) {
+		return (int32_t)(uint32_t)(head & 0xFFFFFFFFu);
+	}
+
+public:
+	ConcurrentPool() {
+		for (int32_t i = 0; i < Capacity - 1; ++i) {
+			_next[i].store(i + 1, std::memory_order_relaxed);
+		}
+		_next[Capacity - 1].store(End, std::memory_order_relaxed);
+		_head.store(0u, std::memory_order_release);
+	}
+
+	/**
+	 * @return @c nullptr if all slots are in use
+	 */
+	void* alloc() {
+		uint64_t head = _head.load(std::memory_order_acquire);
+		for (;;) {
+			const int32_t i = index(head);
+			if (i == End) {
+				return nullptr;
+			}
+			const int32_t next = _next[i].load(std::memory_order_relaxed);
+			if (_head.compare_exchange_weak(head, pack(head, next), std::memory_order_acq_rel, std::memory_order_acquire)) {
+				return &_storage[(size_t)i * Stride];
+			}
+		}
+	}
+
+	/**
+	 * @param[in] ptr Must be a slot of this pool - see @c owns()
+	 */
+	void free(void* ptr) {
+		const int32_t i = (int32_t)(((uint8_t*)ptr - _storage) / Stride);
+		uint64_t head = _head.load(std::memory_order_acquire);
+		for (;;) {
+			_next[i].store(index(head), std::memory_order_relaxed);
+			if (_head.compare_exchange_weak(head, pack(head, i), std::memory_order_acq_rel, std::memory_order_acquire)) {
+				return;
+			}
+		}
+	}
+
+	inline bool owns(const void* ptr) const {
+		return (const uint8_t*)ptr >= _storage && (const uint8_t*)ptr < _storage + sizeof(_storage);
+	}
+
+	static constexpr int capacity() {
+		return Capacity;
+	}
+};
+
+}
@@ -70,8 +70,15 @@ void ThreadPool::shutdown(bool wait) {
 	if (_stop) {
 		return;
 	}
-	_force = !wait;
-	_stop = true;
+	{
+		std::unique_lock lock(_queueMutex);
+		_force = !wait;
+		_stop = true;
+		if (_force) {
+			// don't execute the discarded tasks if the pool is initialized again
+			_tasks = decltype(_tasks)();
+		}
+	}
 	_queueCondition.notify_all();
 	for (std::thread &worker : _workers) {
 		worker.join();
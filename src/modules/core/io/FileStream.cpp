@@ -23,6 +23,48 @@ FileStream::FileStream(SDL_RWops* rwops) :
 FileStream::~FileStream() {
 }
 
+const uint8_t* FileStream::fillWindow(int64_t pos, int64_t size) const {
+	if (pos < 0 || size < 0 || pos + size > _size) {
+		return nullptr;
+	}
+	if (_rwops->type == SDL_RWOPS_MEMORY || _rwops->type == SDL_RWOPS_MEMORY_RO) {
+		// the rwops memory is the stream content - there is nothing to copy
+		_window = _rwops->hidden.mem.base;
+		_windowPos = 0;
+		_windowSize = _size;
+		return _window + pos;
+	}
+	int64_t windowPos = pos;
+	int64_t windowSize = core_max(size, BufferSize);
+	if (_size <= MaxInMemorySize) {
+		windowPos = 0;
+		windowSize = _size;
+	} else if (windowPos + windowSize > _size) {
+		windowSize = _size - windowPos;
+	}
+	_buffer.resize(windowSize);
+	if (SDL_RWseek(_rwops, windowPos, RW_SEEK_SET) < 0) {
+		invalidateWindow();
+		return nullptr;
+	}
+	uint8_t *b = _buffer.data();
+	int64_t completeBytesRead = 0;
+	size_t bytesRead = 1;
+	while (completeBytesRead < windowSize && bytesRead != 0) {
+		bytesRead = SDL_RWread(_rwops, b, 1, (size_t)(windowSize - completeBytesRead));
+		b += bytesRead;
+		completeBytesRead += bytesRead;
+	}
+	if (completeBytesRead < (pos - windowPos) + size) {
+		invalidateWindow();
+		return nullptr;
+	}
+	_window = _buffer.data();
+	_windowPos = windowPos;
+	_windowSize = completeBytesRead;
+	return _window + (pos - windowPos);
+}
+
 int FileStream::peekInt(uint32_t& val) const {
 	const int retVal = peek(val);
 	if (retVal == 0) {
@@ -219,10 +261,35 @@ int FileStream::readInt(uint32_t& val) {
 }
 
 int FileStream::readBuf(uint8_t *buf, size_t bufSize) {
-	for (size_t i = 0; i < bufSize; ++i) {
-		if (readByte(buf[i]) != 0) {
-			return -1;
-		}
+	return readArray(buf, bufSize);
+}
+
+int FileStream::readShorts(uint16_t *buf, size_t amount) {
+	if (readArray(buf, amount) != 0) {
+		return -1;
+	}
+	for (size_t i = 0; i < amount; ++i) {
+		buf[i] = SDL_SwapLE16(buf[i]);
+	}
+	return 0;
+}
+
+int FileStream::readInts(uint32_t *buf, size_t amount) {
+	if (readArray(buf, amount) != 0) {
+		return -1;
+	}
+	for (size_t i = 0; i < amount; ++i) {
+		buf[i] = SDL_SwapLE32(buf[i]);
+	}
+	return 0;
+}
+
+int FileStream::readFloats(float *buf, size_t amount) {
+	if (readArray(buf, amount) != 0) {
+		return -1;
+	}
+	for (size_t i = 0; i < amount; ++i) {
+		buf[i] = SDL_SwapFloatLE(buf[i]);
 	}
 	return 0;
 }
@@ -238,6 +305,7 @@ int FileStream::readLong(uint64_t& val) {
 }
 
 bool FileStream::addByte(uint8_t val) {
+	invalidateWindow();
 	SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
 	if (SDL_RWwrite(_rwops, &val, 1, 1) != 1) {
 		return false;
@@ -250,6 +318,7 @@ bool FileStream::addByte(uint8_t val) {
 }
 
 bool FileStream::append(const uint8_t *buf, size_t size) {
+	invalidateWindow();
 	SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
 	size_t completeBytesWritten = 0;
 	int32_t bytesWritten = 1;
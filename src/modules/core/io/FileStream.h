@@ -11,8 +11,10 @@
 #include <SDL_stdinc.h>
 #include <SDL_rwops.h>
 #include "core/Common.h"
+#include "core/NonCopyable.h"
 #include <limits.h>
 #include <memory>
+#include <vector>
 
 namespace io {
 
@@ -21,13 +23,82 @@ typedef std::shared_ptr<File> FilePtr;
 
 /**
  * @brief Little endian file stream
+ *
+ * The reads are served from a window of the stream content. Memory backed rwops are used directly as window
+ * (zero-copy), for all other rwops the window is filled with one bulk read - small files are read completely.
+ * Writing to the stream drops the window.
  */
-class FileStream {
+class FileStream : public core::NonCopyable {
 private:
+	/**
+	 * @brief Streams up to this size are completely read into memory with the first read
+	 */
+	static constexpr int64_t MaxInMemorySize = 64 * 1024 * 1024;
+	/**
+	 * @brief The window size for larger streams
+	 */
+	static constexpr int64_t BufferSize = 64 * 1024;
+
 	int64_t _pos = 0;
 	int64_t _size = 0;
 	mutable SDL_RWops *_rwops;
 
+	// the part of the stream content that is currently readable without the rwops
+	mutable const uint8_t* _window = nullptr;
+	mutable int64_t _windowPos = 0;
+	mutable int64_t _windowSize = 0;
+	mutable std::vector<uint8_t> _buffer;
+
+	/**
+	 * @return @c nullptr if the requested range can't be read
+	 */
+	const uint8_t* fillWindow(int64_t pos, int64_t size) const;
+
+	/**
+	 * @brief Bounds checked access to the stream content
+	 * @return Pointer to @c size bytes at the given stream position - only valid until the next read or write.
+	 * @c nullptr if there are not enough bytes.
+	 */
+	inline const uint8_t* data(int64_t pos, int64_t size) const {
+		if (pos + size > _size) {
+			return nullptr;
+		}
+		if (pos >= _windowPos && pos + size <= _windowPos + _windowSize) {
+			return _window + (pos - _windowPos);
+		}
+		return fillWindow(pos, size);
+	}
+
+	inline void invalidateWindow() const {
+		_window = nullptr;
+		_windowPos = 0;
+		_windowSize = 0;
+	}
+
+	/**
+	 * @brief Bulk read of values - the caller has to convert the byte order
+	 */
+	template<class Type>
+	int readArray(Type* buf, size_t amount) {
+		if (amount == 0u) {
+			// there is no window to point into if nothing was read yet
+			return 0;
+		}
+		// the amount usually comes from the stream itself - don't let the multiplication overflow
+		const int64_t left = remaining();
+		if (left <= 0 || amount > (size_t)left / sizeof(Type)) {
+			return -1;
+		}
+		const int64_t bytes = (int64_t)(amount * sizeof(Type));
+		const uint8_t* src = data(_pos, bytes);
+		if (src == nullptr) {
+			return -1;
+		}
+		core_memcpy(buf, src, bytes);
+		_pos += bytes;
+		return 0;
+	}
+
 public:
 	FileStream(File* file);
 	FileStream(const FilePtr& file) : FileStream(file.get()) {}
@@ -54,32 +125,18 @@ public:
 	 * @return A value of @c 0 indicates no error
 	 */
 	template<class Ret>
-	int peek(Ret& val) const {
-		const size_t bufSize = sizeof(Ret);
-		if (remaining() < (int64_t)bufSize) {
+	inline int peek(Ret& val) const {
+		const uint8_t* src = data(_pos, sizeof(Ret));
+		if (src == nullptr) {
 			return -1;
 		}
-		uint8_t buf[bufSize];
-		SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
-		uint8_t *b = buf;
-
-		size_t completeBytesRead = 0;
-		size_t bytesRead = 1;
-		while (completeBytesRead < bufSize && bytesRead != 0) {
-			bytesRead = SDL_RWread(_rwops, b, 1, (bufSize - completeBytesRead));
-			b += bytesRead;
-			completeBytesRead += bytesRead;
-		}
-		if (completeBytesRead != bufSize) {
-			return -1;
-		}
-		const Ret *word = (const Ret*) (void*) buf;
-		val = *word;
+		core_memcpy(&val, src, sizeof(Ret));
 		return 0;
 	}
 
 	template<class Type>
 	inline bool write(Type val) {
+		invalidateWindow();
 		SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
 		const size_t bufSize = sizeof(Type);
 		uint8_t buf[bufSize];
@@ -114,7 +171,17 @@ public:
 		return retVal;
 	}
 
+	/**
+	 * @return A value of @c 0 indicates no error - on error, the stream position isn't changed
+	 */
 	int readBuf(uint8_t *buf, size_t bufSize);
+	/**
+	 * @brief Reads @c amount little endian values in one go
+	 * @return A value of @c 0 indicates no error - on error, the stream position isn't changed
+	 */
+	int readShorts(uint16_t *buf, size_t amount);
+	int readInts(uint32_t *buf, size_t amount);
+	int readFloats(float *buf, size_t amount);
 
 	bool readBool();
 	int readByte(uint8_t& val);
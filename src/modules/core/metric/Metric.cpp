@@ -6,12 +6,42 @@
 #include "core/Log.h"
 #include "core/Var.h"
 #include "core/Assert.h"
+#include "core/Common.h"
+#include "core/StringUtil.h"
 #include <stdio.h>
 #include <string.h>
 #include <SDL_stdinc.h>
 
 namespace metric {
 
+namespace {
+
+// every thread records into its own shard - the threads only share a shard if there are more threads than shards
+int shardIndex(int shards) {
+	static std::atomic_int nextShard { 0 };
+	thread_local const int shard = nextShard++;
+	return shard % shards;
+}
+
+const char* typeName(MetricType type) {
+	switch (type) {
+	case MetricType::Gauge:
+		return "g";
+	case MetricType::Timing:
+		return "ms";
+	case MetricType::Histogram:
+		return "h";
+	case MetricType::Meter:
+		return "m";
+	case MetricType::Count:
+	default:
+		break;
+	}
+	return "c";
+}
+
+}
+
 Metric::~Metric() {
 	shutdown();
 }
@@ -35,13 +65,189 @@ bool Metric::init(const char *prefix, const IMetricSenderPtr& messageSender) {
 		Log::warn("Invalid %s given - using telegraf", cfg::MetricFlavor);
 	}
 	_messageSender = messageSender;
+	_flushIntervalMillis = (uint32_t)core::Var::getSafe(cfg::MetricFlushInterval)->intVal();
+
+	std::unique_lock lock(_aggregationMutex);
+	for (AggregatedMetric& metric : _aggregated) {
+		formatAggregated(metric);
+	}
 	return true;
 }
 
 void Metric::shutdown() {
+	if (_messageSender) {
+		flush();
+	}
 	_messageSender = IMetricSenderPtr();
 }
 
+MetricHandle Metric::registerMetric(const char* key, MetricType type, const TagMap& tags) {
+	std::unique_lock lock(_aggregationMutex);
+	if ((int)_aggregated.size() >= MaxAggregatedMetrics) {
+		Log::warn("Can't register metric %s - max of %i metrics reached", key, MaxAggregatedMetrics);
+		return InvalidMetricHandle;
+	}
+	if (!_slots) {
+		_slots = std::unique_ptr<Slot[]>(new Slot[AggregationShards * MaxAggregatedMetrics]);
+		// record() reads the registered metrics without locking - they must never be moved
+		_aggregated.reserve(MaxAggregatedMetrics);
+	}
+	// don't keep the default pool size of the given tags for every registered metric
+	AggregatedMetric metric { key, type, TagMap(core_max(2, (int)tags.size())) };
+	for (const auto& e : tags) {
+		metric.tags.put(e->key, e->value);
+	}
+	formatAggregated(metric);
+	_aggregated.push_back(metric);
+	return (MetricHandle)_aggregated.size() - 1;
+}
+
+void Metric::record(MetricHandle handle, int value) const {
+	if (handle < 0 || handle >= MaxAggregatedMetrics || !_slots) {
+		return;
+	}
+	// a gauge only keeps the last value - which is only defined if all threads share the slot
+	const int shard = _aggregated[handle].type == MetricType::Gauge ? 0 : shardIndex(AggregationShards);
+	Slot& slot = _slots[shard * MaxAggregatedMetrics + handle];
+	switch (_aggregated[handle].type) {
+	case MetricType::Gauge:
+		slot.sum.store(value, std::memory_order_relaxed);
+		slot.count.store(1, std::memory_order_relaxed);
+		break;
+	case MetricType::Timing:
+	case MetricType::Histogram: {
+		slot.sum.fetch_add(value, std::memory_order_relaxed);
+		slot.count.fetch_add(1, std::memory_order_relaxed);
+		int32_t min = slot.min.load(std::memory_order_relaxed);
+		while (value < min && !slot.min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {
+		}
+		int32_t max = slot.max.load(std::memory_order_relaxed);
+		while (value > max && !slot.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+		}
+		break;
+	}
+	case MetricType::Count:
+	case MetricType::Meter:
+	default:
+		slot.sum.fetch_add(value, std::memory_order_relaxed);
+		slot.count.fetch_add(1, std::memory_order_relaxed);
+		break;
+	}
+}
+
+void Metric::update(uint64_t nowMillis) {
+	if (nowMillis - _lastFlushMillis < _flushIntervalMillis) {
+		return;
+	}
+	_lastFlushMillis = nowMillis;
+	flush();
+}
+
+void Metric::formatAggregated(AggregatedMetric& metric) const {
+	constexpr int tagsSize = 256;
+	char tagsBuffer[tagsSize] = "";
+	const char *type = typeName(metric.type);
+	metric.tail = "";
+	switch (_flavor) {
+	case Flavor::Etsy:
+		metric.head = core::string::format("%s.%s", _prefix.c_str(), metric.key.c_str());
+		break;
+	case Flavor::Datadog:
+		if (!createTags(tagsBuffer, sizeof(tagsBuffer), metric.tags, ":", "|#", ",")) {
+			Log::warn("Failed to create the tags for metric %s", metric.key.c_str());
+		}
+		metric.head = core::string::format("%s.%s", _prefix.c_str(), metric.key.c_str());
+		metric.tail = tagsBuffer;
+		break;
+	case Flavor::Influx:
+		if (!createTags(tagsBuffer, sizeof(tagsBuffer), metric.tags, "=", ",", ",")) {
+			Log::warn("Failed to create the tags for metric %s", metric.key.c_str());
+		}
+		metric.head = core::string::format("%s_%s,type=%s%s", _prefix.c_str(), metric.key.c_str(), type, tagsBuffer);
+		break;
+	case Flavor::Telegraf:
+	default:
+		if (!createTags(tagsBuffer, sizeof(tagsBuffer), metric.tags, "=", ",", ",")) {
+			Log::warn("Failed to create the tags for metric %s", metric.key.c_str());
+		}
+		metric.head = core::string::format("%s.%s%s", _prefix.c_str(), metric.key.c_str(), tagsBuffer);
+		break;
+	}
+}
+
+int Metric::formatAggregatedLine(char *buffer, size_t len, const AggregatedMetric& metric, int64_t sum, int32_t count, int32_t min, int32_t max) const {
+	const bool sampled = metric.type == MetricType::Timing || metric.type == MetricType::Histogram;
+	const int64_t value = sampled ? sum / count : sum;
+	if (_flavor == Flavor::Influx) {
+		if (sampled) {
+			return SDL_snprintf(buffer, len, "%s value=%lli,count=%i,min=%i,max=%i", metric.head.c_str(), (long long)value, count, min, max);
+		}
+		return SDL_snprintf(buffer, len, "%s value=%lli", metric.head.c_str(), (long long)value);
+	}
+	const char *type = typeName(metric.type);
+	if (sampled && count > 1) {
+		return SDL_snprintf(buffer, len, "%s:%lli|%s|@%g%s", metric.head.c_str(), (long long)value, type, 1.0 / (double)count, metric.tail.c_str());
+	}
+	return SDL_snprintf(buffer, len, "%s:%lli|%s%s", metric.head.c_str(), (long long)value, type, metric.tail.c_str());
+}
+
+bool Metric::flush() {
+	if (!_messageSender) {
+		return false;
+	}
+	core_trace_scoped(MetricFlush);
+	std::unique_lock lock(_aggregationMutex);
+	char datagram[MaxDatagramSize + 1];
+	size_t datagramLength = 0u;
+	bool success = true;
+	const int registered = (int)_aggregated.size();
+	for (int handle = 0; handle < registered; ++handle) {
+		const AggregatedMetric& metric = _aggregated[handle];
+		int64_t sum = 0;
+		int32_t count = 0;
+		int32_t min = INT32_MAX;
+		int32_t max = INT32_MIN;
+		for (int shard = 0; shard < AggregationShards; ++shard) {
+			Slot& slot = _slots[shard * MaxAggregatedMetrics + handle];
+			if (slot.count.load(std::memory_order_relaxed) == 0) {
+				continue;
+			}
+			count += slot.count.exchange(0, std::memory_order_relaxed);
+			sum += slot.sum.exchange(0, std::memory_order_relaxed);
+			const int32_t slotMin = slot.min.exchange(INT32_MAX, std::memory_order_relaxed);
+			const int32_t slotMax = slot.max.exchange(INT32_MIN, std::memory_order_relaxed);
+			min = core_min(min, slotMin);
+			max = core_max(max, slotMax);
+		}
+		if (count <= 0) {
+			continue;
+		}
+		char line[512];
+		const int written = formatAggregatedLine(line, sizeof(line), metric, sum, count, min, max);
+		if (written < 0 || written >= (int)sizeof(line) || written > (int)MaxDatagramSize) {
+			Log::warn("Failed to format metric %s", metric.key.c_str());
+			success = false;
+			continue;
+		}
+		// the lines are separated by newlines - send the datagram if the line doesn't fit anymore
+		const size_t needed = (datagramLength > 0u ? 1u : 0u) + (size_t)written;
+		if (datagramLength + needed > MaxDatagramSize) {
+			success &= _messageSender->send(datagram);
+			datagramLength = 0u;
+		}
+		if (datagramLength > 0u) {
+			datagram[datagramLength++] = '\n';
+		}
+		SDL_memcpy(&datagram[datagramLength], line, written);
+		datagramLength += written;
+		datagram[datagramLength] = '\0';
+	}
+	if (datagramLength > 0u) {
+		success &= _messageSender->send(datagram);
+	}
+	return success;
+}
+
 bool Metric::createTags(char* buffer, size_t len, const TagMap& tags, const char* sep, const char* preamble, const char *split) {
 	if (tags.empty()) {
 		return true;
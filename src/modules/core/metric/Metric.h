@@ -13,7 +13,11 @@
 #include "IMetricSender.h"
 #include "core/NonCopyable.h"
 #include "core/collection/StringMap.h"
+#include "core/Trace.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <stdint.h>
 
 namespace metric {
@@ -33,15 +37,69 @@ enum class Flavor {
  */
 using TagMap = core::StringMap<core::String, 4>;
 
+/**
+ * @brief The metric types
+ */
+enum class MetricType {
+	Count,
+	Gauge,
+	Timing,
+	Histogram,
+	Meter
+};
+
+/**
+ * @brief Handle of a metric that was registered with @c Metric::registerMetric()
+ */
+using MetricHandle = int32_t;
+constexpr MetricHandle InvalidMetricHandle = -1;
+
 /**
  * @brief The Metric class generates and publishes metrics
+ *
+ * The metrics that are recorded with @c count(), @c gauge() and the other methods are formatted and sent
+ * immediately - one datagram per call. Metrics that are recorded at a high frequency should be registered
+ * once with @c registerMetric() and recorded with @c record(). Those are aggregated in lock-free per thread
+ * slots and sent with @c flush() as multi line datagrams.
  */
 class Metric : public core::NonCopyable {
+public:
+	/**
+	 * @brief The max size of a datagram that is sent by @c flush() - fits into one ethernet frame
+	 */
+	static constexpr size_t MaxDatagramSize = 1432u;
+	static constexpr int MaxAggregatedMetrics = 256;
 private:
 	core::String _prefix;
 	Flavor _flavor = Flavor::Telegraf;
 	IMetricSenderPtr _messageSender;
 
+	static constexpr int AggregationShards = 4;
+	struct AggregatedMetric {
+		core::String key;
+		MetricType type;
+		TagMap tags;
+		// the part of the line in front of the value - formatted for the configured flavor
+		core::String head {};
+		// the part of the line after the type - the datadog tags
+		core::String tail {};
+	};
+	// the values that were recorded since the last flush - the slots of one shard are next to each other
+	struct Slot {
+		std::atomic<int64_t> sum { 0 };
+		std::atomic<int32_t> count { 0 };
+		std::atomic<int32_t> min { INT32_MAX };
+		std::atomic<int32_t> max { INT32_MIN };
+	};
+	core_trace_mutex(std::mutex, _aggregationMutex);
+	std::vector<AggregatedMetric> _aggregated;
+	std::unique_ptr<Slot[]> _slots;
+	uint32_t _flushIntervalMillis = 1000u;
+	uint64_t _lastFlushMillis = 0u;
+
+	void formatAggregated(AggregatedMetric& metric) const;
+	int formatAggregatedLine(char *buffer, size_t len, const AggregatedMetric& metric, int64_t sum, int32_t count, int32_t min, int32_t max) const;
+
 	/**
 	 * @brief Create the needed tag list if it is supported by the specified flavor
 	 * @param[out] buffer The buffer to write the tag list into
@@ -61,8 +119,37 @@ public:
 	 * @note Reads the @c metric_flavor cvar to configure the flavor.
 	 */
 	bool init(const char *prefix, const IMetricSenderPtr& messageSender);
+	/**
+	 * @brief Sends the aggregated metrics that weren't flushed yet
+	 */
 	void shutdown();
 
+	/**
+	 * @brief Registers a metric for the aggregation - the key and the tags are only formatted once
+	 * @note Can be called before @c init()
+	 * @return @c InvalidMetricHandle if there are already @c MaxAggregatedMetrics registered
+	 */
+	MetricHandle registerMetric(const char* key, MetricType type, const TagMap& tags = {});
+
+	/**
+	 * @brief Records a value for a registered metric without sending anything - thread safe and lock-free
+	 *
+	 * Counts and meters are summed up, gauges keep the last value. Timings and histograms are sent as
+	 * the mean value with a sample rate of @c 1/count - so the server still counts every sample.
+	 */
+	void record(MetricHandle handle, int value) const;
+
+	/**
+	 * @brief Sends all aggregated metrics that were recorded since the last flush
+	 * @note The lines are packed into datagrams of max @c MaxDatagramSize bytes
+	 */
+	bool flush();
+
+	/**
+	 * @brief Flushes the aggregated metrics if the flush interval (cvar @c metric_flushinterval) passed
+	 */
+	void update(uint64_t nowMillis);
+
 	/**
 	 * @brief Increments the key
 	 */
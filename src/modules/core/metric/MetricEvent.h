@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "Metric.h"
 #include "core/EventBus.h"
 #include "core/collection/Map.h"
 #include <stdint.h>
@@ -13,15 +14,7 @@
 
 namespace metric {
 
-enum class MetricEventType {
-	Count,
-	Gauge,
-	Timing,
-	Histogram,
-	Meter
-};
-
-using TagMap = core::StringMap<core::String, 4>;
+using MetricEventType = MetricType;
 
 class MetricEvent: public core::IEventBusEvent {
 private:
@@ -43,4 +43,20 @@ TEST_F(ColorTest, testHex) {
 	EXPECT_EQ(glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), core::Color::fromHex("#ff0000ff"));
 }
 
+TEST_F(ColorTest, testClosestMatchHSB) {
+	const std::vector<glm::vec4> colors = { core::Color::Black, core::Color::Red, core::Color::Green,
+			core::Color::Blue, core::Color::Yellow, core::Color::White, core::Color::Brown };
+	std::vector<glm::vec3> hsbColors;
+	for (const glm::vec4& c : colors) {
+		glm::vec3 hsb;
+		core::Color::getHSB(c, hsb.x, hsb.y, hsb.z);
+		hsbColors.push_back(hsb);
+	}
+	for (uint32_t rgba = 0u; rgba <= 0xffffffu; rgba += 0x0f0d0bu) {
+		const glm::vec4& color = core::Color::fromRGBA(rgba | 0xff000000u);
+		EXPECT_EQ(core::Color::getClosestMatch(color, colors), core::Color::getClosestMatchHSB(color, hsbColors));
+	}
+	EXPECT_EQ(1, core::Color::getClosestMatchHSB(core::Color::Red, hsbColors));
+}
+
 }
@@ -4,10 +4,13 @@
 
 #include "core/tests/AbstractTest.h"
 #include "core/EventBus.h"
+#include <thread>
+#include <vector>
 
 namespace core {
 
 EVENTBUSEVENT(TestEvent);
+EVENTBUSPAYLOADEVENT(TestPayloadEvent, int);
 
 template<class T>
 class CountHandlerTest: public IEventBusHandler<T> {
@@ -28,6 +31,15 @@ public:
 class HandlerTest: public CountHandlerTest<TestEvent> {
 };
 
+class PayloadHandlerTest: public IEventBusHandler<TestPayloadEvent> {
+public:
+	std::vector<int> values;
+
+	void onEvent(const TestPayloadEvent& event) override {
+		values.push_back(event.get());
+	}
+};
+
 class EventBusTest : public core::AbstractTest {
 };
 
@@ -155,4 +167,58 @@ TEST_F(EventBusTest, testMultipleTopics_1) {
 	ASSERT_EQ(3, handler.getCount()) << "Unexpected handler notification amount";
 }
 
+TEST_F(EventBusTest, testQueueOrder) {
+	EventBus eventBus;
+	PayloadHandlerTest handler;
+	eventBus.subscribe(handler);
+
+	// more events than the pools can hold
+	const int n = 5000;
+	for (int i = 0; i < n; ++i) {
+		if (i % 2) {
+			eventBus.enqueue<TestPayloadEvent>(i);
+		} else {
+			eventBus.enqueue(std::make_shared<TestPayloadEvent>(i));
+		}
+	}
+	ASSERT_EQ(n, eventBus.size());
+	ASSERT_EQ(0, eventBus.update());
+	ASSERT_EQ(n, (int)handler.values.size());
+	for (int i = 0; i < n; ++i) {
+		ASSERT_EQ(i, handler.values[i]) << "Expected the events in the order they were enqueued";
+	}
+}
+
+TEST_F(EventBusTest, testQueueMultipleProducers) {
+	EventBus eventBus;
+	PayloadHandlerTest handler;
+	eventBus.subscribe(handler);
+
+	const int producers = 4;
+	const int n = 10000;
+	std::vector<std::thread> threads;
+	for (int p = 0; p < producers; ++p) {
+		threads.emplace_back([&eventBus, p] () {
+			for (int i = 0; i < n; ++i) {
+				eventBus.enqueue<TestPayloadEvent>(p * n + i);
+			}
+		});
+	}
+	while ((int)handler.values.size() < producers * n) {
+		eventBus.update();
+		std::this_thread::yield();
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	ASSERT_EQ(0, eventBus.update());
+	ASSERT_EQ(producers * n, (int)handler.values.size());
+	std::vector<int> last(producers, -1);
+	for (int value : handler.values) {
+		const int p = value / n;
+		ASSERT_LT(last[p], value) << "Expected the events of one producer in the order they were enqueued";
+		last[p] = value;
+	}
+}
+
 }
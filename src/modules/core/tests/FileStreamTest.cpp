@@ -57,4 +57,89 @@ TEST_F(FileStreamTest, testFileStreamWrite) {
 	EXPECT_EQ(8l, file->length());
 }
 
+TEST_F(FileStreamTest, testFileStreamBulkRead) {
+	const FilePtr& file = _testApp->filesystem()->open("iotest.txt");
+	ASSERT_TRUE(file->exists());
+	FileStream stream(file.get());
+	uint32_t magic[2];
+	ASSERT_EQ(0, stream.readInts(magic, 2));
+	EXPECT_EQ(FourCC('W', 'i', 'n', 'd'), magic[0]);
+	EXPECT_EQ(FourCC('o', 'w', 'I', 'n'), magic[1]);
+	EXPECT_EQ(8, stream.pos());
+	uint8_t buf[2];
+	ASSERT_EQ(0, stream.readBuf(buf, sizeof(buf)));
+	EXPECT_EQ('f', buf[0]);
+	EXPECT_EQ('o', buf[1]);
+}
+
+TEST_F(FileStreamTest, testFileStreamReadZeroBytes) {
+	const FilePtr& file = _testApp->filesystem()->open("iotest.txt");
+	ASSERT_TRUE(file->exists());
+	FileStream stream(file.get());
+	uint8_t buf[1];
+	EXPECT_EQ(0, stream.readBuf(buf, 0));
+	EXPECT_EQ(0, stream.pos());
+	uint32_t magic;
+	ASSERT_EQ(0, stream.readInt(magic));
+	EXPECT_EQ(FourCC('W', 'i', 'n', 'd'), magic);
+	stream.seek(stream.size());
+	EXPECT_EQ(0, stream.readBuf(buf, 0)) << "A zero length read at the end must not fail";
+}
+
+TEST_F(FileStreamTest, testFileStreamReadArrayOverflow) {
+	const uint8_t data[] = { 1, 0, 2, 0, 3, 0, 0, 0 };
+	SDL_RWops* rwops = SDL_RWFromConstMem(data, sizeof(data));
+	ASSERT_NE(nullptr, rwops);
+	FileStream stream(rwops);
+	uint32_t value;
+	// the amount times the size of the type wraps around to 4
+	EXPECT_EQ(-1, stream.readInts(&value, (SIZE_MAX / sizeof(uint32_t)) + 2));
+	EXPECT_EQ(-1, stream.readInts(&value, 3));
+	EXPECT_EQ(0, stream.pos());
+	ASSERT_EQ(0, stream.readInts(&value, 1));
+	EXPECT_EQ(131073u, value);
+}
+
+TEST_F(FileStreamTest, testFileStreamMemory) {
+	const uint8_t data[] = { 1, 0, 2, 0, 3, 0, 0, 0, 0, 0, 128, 63 };
+	SDL_RWops* rwops = SDL_RWFromConstMem(data, sizeof(data));
+	ASSERT_NE(nullptr, rwops);
+	FileStream stream(rwops);
+	uint16_t shorts[2];
+	ASSERT_EQ(0, stream.readShorts(shorts, 2));
+	EXPECT_EQ(1, shorts[0]);
+	EXPECT_EQ(2, shorts[1]);
+	uint32_t value;
+	ASSERT_EQ(0, stream.readInts(&value, 1));
+	EXPECT_EQ(3u, value);
+	uint32_t tooMany[3];
+	EXPECT_EQ(-1, stream.readInts(tooMany, 3)) << "Reading beyond the end must fail";
+	EXPECT_EQ(8, stream.pos()) << "A failed read must not change the position";
+	float f[1];
+	ASSERT_EQ(0, stream.readFloats(f, 1));
+	EXPECT_FLOAT_EQ(1.0f, f[0]);
+	EXPECT_EQ(0, stream.remaining());
+	uint8_t chr;
+	EXPECT_EQ(-1, stream.readByte(chr));
+	SDL_RWclose(rwops);
+}
+
+TEST_F(FileStreamTest, testFileStreamReadAfterWrite) {
+	uint8_t data[8] {};
+	SDL_RWops* rwops = SDL_RWFromMem(data, sizeof(data));
+	ASSERT_NE(nullptr, rwops);
+	FileStream stream(rwops);
+	EXPECT_TRUE(stream.addInt(42));
+	ASSERT_EQ(0, stream.seek(0));
+	uint32_t value;
+	ASSERT_EQ(0, stream.readInt(value));
+	EXPECT_EQ(42u, value);
+	ASSERT_EQ(0, stream.seek(0));
+	EXPECT_TRUE(stream.addInt(43));
+	ASSERT_EQ(0, stream.seek(0));
+	ASSERT_EQ(0, stream.readInt(value));
+	EXPECT_EQ(43u, value);
+	SDL_RWclose(rwops);
+}
+
 }
@@ -6,22 +6,31 @@
 #include "core/metric/Metric.h"
 #include "core/metric/IMetricSender.h"
 #include "core/Var.h"
+#include "core/StringUtil.h"
+#include <thread>
+#include <vector>
 
 namespace metric {
 
 class BufferSender : public IMetricSender {
 private:
 	mutable core::String _lastBuffer;
+	mutable std::vector<core::String> _buffers;
 public:
 
 	bool send(const char* buffer) const override {
 		_lastBuffer = buffer;
+		_buffers.push_back(_lastBuffer);
 		return true;
 	}
 
 	inline const core::String& metricLine() const {
 		return _lastBuffer;
 	}
+
+	inline const std::vector<core::String>& buffers() const {
+		return _buffers;
+	}
 };
 
 #define PREFIX "test"
@@ -126,4 +135,87 @@ TEST_F(MetricTest, DISABLED_testTimingMultipleTags) {
 		<< "Expected to get tags after type in datadog flavor";
 }
 
+TEST_F(MetricTest, testAggregatedCount) {
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	const MetricHandle handle = m.registerMetric("test1", MetricType::Count);
+	ASSERT_NE(InvalidMetricHandle, handle);
+	m.init(PREFIX, sender);
+	m.record(handle, 1);
+	m.record(handle, 2);
+	EXPECT_TRUE(sender->buffers().empty()) << "Expected to get nothing sent before the flush";
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(sender->metricLine(), PREFIX ".test1:3|c");
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(1u, sender->buffers().size()) << "Expected to get nothing sent without new values";
+}
+
+TEST_F(MetricTest, testAggregatedTiming) {
+	const TagMap map {{"key1", "value1"}};
+	setFlavor(Flavor::Telegraf);
+	{
+		Metric m;
+		m.init(PREFIX, sender);
+		const MetricHandle handle = m.registerMetric("test", MetricType::Timing, map);
+		m.record(handle, 10);
+		m.record(handle, 20);
+		EXPECT_TRUE(m.flush());
+		EXPECT_EQ(sender->metricLine(), PREFIX ".test,key1=value1:15|ms|@0.5");
+	}
+	setFlavor(Flavor::Influx);
+	{
+		Metric m;
+		m.init(PREFIX, sender);
+		const MetricHandle handle = m.registerMetric("test", MetricType::Timing, map);
+		m.record(handle, 10);
+		m.record(handle, 20);
+		EXPECT_TRUE(m.flush());
+		EXPECT_EQ(sender->metricLine(), PREFIX "_test,type=ms,key1=value1 value=15,count=2,min=10,max=20");
+	}
+}
+
+TEST_F(MetricTest, testAggregatedDatagrams) {
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	m.init(PREFIX, sender);
+	constexpr int n = 200;
+	for (int i = 0; i < n; ++i) {
+		const MetricHandle handle = m.registerMetric(core::string::format("counter%i", i).c_str(), MetricType::Count);
+		ASSERT_NE(InvalidMetricHandle, handle);
+		m.record(handle, i);
+	}
+	EXPECT_TRUE(m.flush());
+	ASSERT_GT(sender->buffers().size(), 1u);
+	int lines = 0;
+	for (const core::String& buffer : sender->buffers()) {
+		EXPECT_LE(buffer.size(), Metric::MaxDatagramSize);
+		std::vector<core::String> tokens;
+		core::string::splitString(buffer, tokens, "\n");
+		lines += (int)tokens.size();
+	}
+	EXPECT_EQ(n, lines);
+}
+
+TEST_F(MetricTest, testAggregatedThreads) {
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	m.init(PREFIX, sender);
+	const MetricHandle handle = m.registerMetric("test", MetricType::Count);
+	constexpr int threads = 4;
+	constexpr int samples = 10000;
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; ++i) {
+		workers.emplace_back([&] () {
+			for (int j = 0; j < samples; ++j) {
+				m.record(handle, 1);
+			}
+		});
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(sender->metricLine(), core::string::format(PREFIX ".test:%i|c", threads * samples));
+}
+
 }
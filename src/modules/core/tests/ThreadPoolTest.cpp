@@ -5,6 +5,8 @@
 #include "AbstractTest.h"
 #include "core/concurrent/ThreadPool.h"
 #include "core/concurrent/Atomic.h"
+#include <SDL_timer.h>
+#include <thread>
 
 namespace core {
 
@@ -43,4 +45,36 @@ TEST_F(ThreadPoolTest, testMultiplePush) {
 	ASSERT_EQ(x, _count) << "Not all threads were executed";
 }
 
+TEST_F(ThreadPoolTest, testShutdownDiscardsTasks) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::AtomicBool release { false };
+	pool.enqueue([&release] () {
+		while (!release) {
+			SDL_Delay(1);
+		}
+	});
+	for (int i = 0; i < 10; ++i) {
+		pool.enqueue([this] () {
+			++_count;
+		});
+	}
+	// release the running task while the pool is already shutting down
+	std::thread releaser([&release] () {
+		SDL_Delay(50);
+		release = true;
+	});
+	pool.shutdown();
+	releaser.join();
+	const int executed = _count;
+	EXPECT_EQ(0, executed) << "The queued tasks should have been discarded";
+	pool.init();
+	auto future = pool.enqueue([this] () {
+		_executed = true;
+	});
+	future.get();
+	EXPECT_TRUE(_executed);
+	EXPECT_EQ(executed, _count) << "The discarded tasks must not run after the pool was initialized again";
+}
+
 }
@@ -19,14 +19,27 @@ bool HttpClient::setBaseUrl(const core::String &baseUrl) {
 
 ResponseParser HttpClient::get(const char *msg, ...) {
 	va_list ap;
+	va_start(ap, msg);
+	ResponseParser response = execute(nullptr, msg, ap);
+	va_end(ap);
+	return response;
+}
+
+ResponseParser HttpClient::get(const HeaderMap& headers, const char *msg, ...) {
+	va_list ap;
+	va_start(ap, msg);
+	ResponseParser response = execute(&headers, msg, ap);
+	va_end(ap);
+	return response;
+}
+
+ResponseParser HttpClient::execute(const HeaderMap* headers, const char *msg, va_list ap) {
 	constexpr std::size_t bufSize = 2048;
 	char text[bufSize];
 
-	va_start(ap, msg);
 	SDL_snprintf(text, bufSize, "%s", _baseUrl.c_str());
 	SDL_vsnprintf(text + _baseUrl.size(), bufSize - _baseUrl.size(), msg, ap);
 	text[sizeof(text) - 1] = '\0';
-	va_end(ap);
 
 	Url u(text);
 	if (!u.valid()) {
@@ -34,6 +47,11 @@ ResponseParser HttpClient::get(const char *msg, ...) {
 		return ResponseParser(nullptr, 0u);
 	}
 	Request request(u, HttpMethod::GET);
+	if (headers != nullptr) {
+		for (const auto& h : *headers) {
+			request.header(h->key, h->value);
+		}
+	}
 	return request.execute();
 }
 
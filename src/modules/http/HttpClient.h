@@ -5,6 +5,7 @@
 #pragma once
 
 #include "ResponseParser.h"
+#include "HttpHeader.h"
 #include <SDL_stdinc.h>
 #include "core/String.h"
 
@@ -13,6 +14,8 @@ namespace http {
 class HttpClient {
 private:
 	core::String _baseUrl;
+
+	ResponseParser execute(const HeaderMap* headers, const char *msg, va_list ap);
 public:
 	HttpClient(const core::String &baseUrl = "");
 
@@ -23,6 +26,10 @@ public:
 	bool setBaseUrl(const core::String &baseUrl);
 
 	ResponseParser get(SDL_PRINTF_FORMAT_STRING const char *msg, ...) SDL_PRINTF_VARARG_FUNC(2);
+	/**
+	 * @brief Sends the given headers in addition to the default headers of the @c Request
+	 */
+	ResponseParser get(const HeaderMap& headers, SDL_PRINTF_FORMAT_STRING const char *msg, ...) SDL_PRINTF_VARARG_FUNC(3);
 };
 
 }
\ No newline at end of file
@@ -9,6 +9,10 @@
 namespace http {
 
 using HeaderMap = core::CharPointerMap;
+/**
+ * @brief The max amount of headers of a message - the maps are preallocated with this size
+ */
+constexpr int MaxHeaders = 64;
 
 namespace header {
 
@@ -22,6 +26,8 @@ static constexpr const char *ACCEPT = "Accept";
 static constexpr const char *SERVER = "Server";
 static constexpr const char *HOST = "Host";
 static constexpr const char *CONTENT_LENGTH = "Content-length";
+static constexpr const char *ETAG = "ETag";
+static constexpr const char *IF_NONE_MATCH = "If-None-Match";
 }
 
 extern bool buildHeaderBuffer(char *buf, size_t len, const HeaderMap& headers);
@@ -10,6 +10,7 @@ namespace mimetype {
 static constexpr const char *TEXT_PLAIN = "text/plain";
 static constexpr const char *TEXT_HTML = "text/html";
 static constexpr const char *APPLICATION_CHUNK = "application/chunk";
+static constexpr const char *APPLICATION_CHUNKS = "application/chunks";
 static constexpr const char *APPLICATION_JSON = "application/json";
 
 }
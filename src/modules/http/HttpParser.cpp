@@ -7,14 +7,21 @@
 
 namespace http {
 
-HttpParser::HttpParser(uint8_t* buffer, const size_t bufferSize) :
-		buf(buffer), bufSize(bufferSize) {
+HttpParser::HttpParser(uint8_t* buffer, const size_t bufferSize, bool ownsBuffer) :
+		buf(buffer), bufSize(bufferSize), _ownsBuffer(ownsBuffer) {
 }
 
 HttpParser& HttpParser::operator=(HttpParser&& other) {
+	if (&other == this) {
+		return *this;
+	}
+	if (_ownsBuffer) {
+		SDL_free(buf);
+	}
 	buf = other.buf;
 	bufSize = other.bufSize;
 	_valid = other._valid;
+	_ownsBuffer = other._ownsBuffer;
 	protocolVersion = other.protocolVersion;
 	headers = HTTP_PARSER_NEW_BASE_CHARPTR_MAP(other.headers);
 	content = other.content;
@@ -34,6 +41,7 @@ HttpParser::HttpParser(HttpParser&& other) {
 	buf = other.buf;
 	bufSize = other.bufSize;
 	_valid = other._valid;
+	_ownsBuffer = other._ownsBuffer;
 	protocolVersion = other.protocolVersion;
 	headers = HTTP_PARSER_NEW_BASE_CHARPTR_MAP(other.headers);
 	content = other.content;
@@ -48,6 +56,13 @@ HttpParser::HttpParser(HttpParser&& other) {
 }
 
 HttpParser& HttpParser::operator=(const HttpParser& other) {
+	if (&other == this) {
+		return *this;
+	}
+	if (_ownsBuffer) {
+		SDL_free(buf);
+	}
+	_ownsBuffer = true;
 	buf = (uint8_t*)SDL_malloc(other.bufSize);
 	SDL_memcpy(buf, other.buf, other.bufSize);
 	bufSize = other.bufSize;
@@ -79,7 +94,9 @@ HttpParser::HttpParser(const HttpParser& other) {
 }
 
 HttpParser::~HttpParser() {
-	SDL_free(buf);
+	if (_ownsBuffer) {
+		SDL_free(buf);
+	}
 	buf = nullptr;
 	bufSize = 0;
 }
@@ -120,6 +137,9 @@ bool HttpParser::parseHeaders(char **bufPos) {
 		}
 		const char *var = core::string::getBeforeToken(&headerEntry, ": ", remainingBufSize(headerEntry));
 		const char *value = headerEntry;
+		if (headers.size() >= headers.capacity()) {
+			return false;
+		}
 		headers.put(var, value);
 	}
 	return true;
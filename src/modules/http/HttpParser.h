@@ -40,6 +40,7 @@ protected:
 	uint8_t *buf = nullptr;
 	size_t bufSize = 0u;
 	bool _valid = false;
+	bool _ownsBuffer = true;
 
 	size_t remainingBufSize(const char *bufPos) const;
 	char* getHeaderLine(char **buffer);
@@ -50,8 +51,10 @@ public:
 	 * @brief Parses a http response/request buffer
 	 * @note The given memory is owned by this class. You may not
 	 * release it on your own.
+	 * @param[in] ownsBuffer If this is @c false the buffer is parsed in place and must outlive the
+	 * parser - it is not released. Copies of the parser always own their buffer.
 	 */
-	HttpParser(uint8_t* buffer, const size_t bufferSize);
+	HttpParser(uint8_t* buffer, const size_t bufferSize, bool ownsBuffer = true);
 
 	/**
 	 * @brief Pointer to that part of the protocol header that stores
@@ -63,7 +66,7 @@ public:
 	 * protocol header buffer. It's safe to copy this structure, but
 	 * don't manually modify the @c headers map
 	 */
-	HeaderMap headers;
+	HeaderMap headers { MaxHeaders };
 	/**
 	 * @brief The pointer to the data after the protocol header
 	 */
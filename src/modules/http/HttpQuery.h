@@ -11,6 +11,10 @@
 namespace http {
 
 using HttpQuery = core::CharPointerMap;
+/**
+ * @brief The max amount of query parameters of a request - further parameters are ignored
+ */
+constexpr int MaxQueryParameters = 64;
 
 #define HTTP_QUERY_GET_INT(name) \
 	const char *name##value; \
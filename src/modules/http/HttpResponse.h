@@ -9,11 +9,12 @@
 #include "HttpHeader.h"
 #include "HttpMimeType.h"
 #include <SDL_stdinc.h>
+#include <stdint.h>
 
 namespace http {
 
 struct HttpResponse {
-	HeaderMap headers;
+	HeaderMap headers { MaxHeaders };
 	HttpStatus status = HttpStatus::Ok;
 	// the memory is managed by the server and freed after the response was sent.
 	const char *body = nullptr;
@@ -21,6 +22,19 @@ struct HttpResponse {
 	// if the route handler sets this to false, the memory is not freed. Can be useful for static content
 	// like error pages.
 	bool freeBody = true;
+	// assigned by the server before the route is called - see defer()
+	uint32_t id = 0u;
+	bool deferred = false;
+
+	/**
+	 * @brief The route doesn't answer the request right away - e.g. because it waits for the database.
+	 * The response is sent once it was given to @c HttpServer::complete() with the returned id.
+	 * @note The request is gone after the route returned - copy what's needed for the response
+	 */
+	uint32_t defer() {
+		deferred = true;
+		return id;
+	}
 
 	void contentLength(size_t len) {
 		bodySize = len;
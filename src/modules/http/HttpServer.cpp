@@ -7,17 +7,89 @@
 #include "core/Assert.h"
 #include "core/ArrayLength.h"
 #include "core/Log.h"
+#include "core/Trace.h"
+#include "core/TimeProvider.h"
 #include "Network.cpp.h"
 #include "core/App.h"
 #include <string.h>
+#include <errno.h>
 #include <SDL_stdinc.h>
+#ifdef HTTP_SERVER_EPOLL
+#include <sys/epoll.h>
+#endif
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
 
 namespace http {
 
+namespace {
+
+// the free space that is at least available for every recv call
+constexpr size_t MinReadSize = 2048u;
+constexpr uint64_t TimeoutCheckMillis = 1000u;
+
+inline bool networkWouldBlock() {
+#ifdef WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/**
+ * @brief HTTP/1.1 connections are kept alive if not requested otherwise - HTTP/1.0 connections only on request
+ */
+bool isKeepAlive(const RequestParser& request) {
+	const char *connection = request.headerValue(header::CONNECTION);
+	if (connection != nullptr) {
+		if (!SDL_strcasecmp(connection, "close")) {
+			return false;
+		}
+		if (!SDL_strcasecmp(connection, "keep-alive")) {
+			return true;
+		}
+	}
+	return request.protocolVersion != nullptr && !SDL_strcmp(request.protocolVersion, "HTTP/1.1");
+}
+
+/**
+ * @return The value of the content length header in the given header block or @c 0 if there is none. If the
+ * value exceeds the given max length, @c maxLength + 1 is returned - the parsing stops before the value can overflow.
+ */
+size_t parseContentLength(const uint8_t *header, size_t headerLength, size_t maxLength) {
+	static const char *key = "Content-Length:";
+	const size_t keyLength = SDL_strlen(key);
+	size_t lineStart = 0u;
+	for (size_t i = 0u; i + 1u < headerLength; ++i) {
+		if (header[i] != '\r' || header[i + 1u] != '\n') {
+			continue;
+		}
+		const size_t lineLength = i - lineStart;
+		if (lineLength > keyLength && !SDL_strncasecmp((const char*)header + lineStart, key, keyLength)) {
+			size_t length = 0u;
+			for (size_t j = lineStart + keyLength; j < i; ++j) {
+				const uint8_t c = header[j];
+				if (c >= '0' && c <= '9') {
+					length = length * 10u + (c - '0');
+					if (length > maxLength) {
+						return maxLength + 1u;
+					}
+				} else if (c != ' ') {
+					break;
+				}
+			}
+			return length;
+		}
+		lineStart = i + 2u;
+	}
+	return 0u;
+}
+
+}
+
 HttpServer::HttpServer(const metric::MetricPtr& metric) :
 		_socketFD(INVALID_SOCKET), _metric(metric) {
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
 }
 
 HttpServer::~HttpServer() {
@@ -53,6 +125,9 @@ bool HttpServer::unregisterRoute(HttpMethod method, const char *path) {
 }
 
 bool HttpServer::init(int16_t port) {
+	if (!networkInit()) {
+		return false;
+	}
 	_socketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
 	if (_socketFD == INVALID_SOCKET) {
 		network_cleanup();
@@ -64,9 +139,6 @@ bool HttpServer::init(int16_t port) {
 	sin.sin_addr.s_addr = INADDR_ANY;
 	sin.sin_port = htons(port);
 
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-
 	int t = 1;
 #ifdef _WIN32
 	if (setsockopt(_socketFD, SOL_SOCKET, SO_REUSEADDR, (char*) &t, sizeof(t)) != 0) {
@@ -86,7 +158,7 @@ bool HttpServer::init(int16_t port) {
 		return false;
 	}
 
-	if (listen(_socketFD, 5) < 0) {
+	if (listen(_socketFD, SOMAXCONN) < 0) {
 		network_cleanup();
 		closesocket(_socketFD);
 		_socketFD = INVALID_SOCKET;
@@ -95,169 +167,420 @@ bool HttpServer::init(int16_t port) {
 
 	networkNonBlocking(_socketFD);
 
-	FD_SET(_socketFD, &_readFDSet);
+#ifdef HTTP_SERVER_EPOLL
+	_epollFD = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event;
+	SDL_memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = _socketFD;
+	if (_epollFD == -1 || epoll_ctl(_epollFD, EPOLL_CTL_ADD, _socketFD, &event) != 0) {
+		Log::error("Failed to initialize epoll: %s", strerror(errno));
+		if (_epollFD != -1) {
+			close(_epollFD);
+			_epollFD = -1;
+		}
+		closesocket(_socketFD);
+		_socketFD = INVALID_SOCKET;
+		return false;
+	}
+#endif
 
 	return true;
 }
 
-HttpServer::ClientSocketsIter HttpServer::closeClient(ClientSocketsIter& iter) {
-	Client& client = *iter;
-	const SOCKET clientSocket = client.socket;
-	FD_CLR(clientSocket, &_readFDSet);
-	FD_CLR(clientSocket, &_writeFDSet);
-	closesocket(clientSocket);
-	client.socket = INVALID_SOCKET;
-	SDL_free(client.request);
-	SDL_free(client.response);
-	return _clientSockets.erase(iter);
+void HttpServer::accept() {
+	for (;;) {
+		const SOCKET clientSocket = ::accept(_socketFD, nullptr, nullptr);
+		if (clientSocket == INVALID_SOCKET) {
+			return;
+		}
+#if !defined(HTTP_SERVER_EPOLL) && !defined(WIN32)
+		if (clientSocket >= FD_SETSIZE) {
+			Log::warn("Too many http connections");
+			closesocket(clientSocket);
+			continue;
+		}
+#endif
+		if (_clients.size() >= _clients.capacity()) {
+			Log::warn("Too many http connections");
+			closesocket(clientSocket);
+			continue;
+		}
+		networkNonBlocking(clientSocket);
+		int t = 1;
+		setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, (const char*)&t, sizeof(t));
+#ifdef HTTP_SERVER_EPOLL
+		struct epoll_event event;
+		SDL_memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.fd = clientSocket;
+		if (epoll_ctl(_epollFD, EPOLL_CTL_ADD, clientSocket, &event) != 0) {
+			Log::warn("Failed to watch the http connection: %s", strerror(errno));
+			closesocket(clientSocket);
+			continue;
+		}
+#endif
+		Client* client = new Client();
+		client->socket = clientSocket;
+		client->lastActivity = core::TimeProvider::systemMillis();
+		_clients.put(clientSocket, client);
+	}
 }
 
-bool HttpServer::update() {
-	fd_set readFDsOut;
-	fd_set writeFDsOut;
+void HttpServer::closeClient(SOCKET socket) {
+	Client* client = nullptr;
+	if (!_clients.get(socket, client)) {
+		return;
+	}
+#ifdef HTTP_SERVER_EPOLL
+	epoll_ctl(_epollFD, EPOLL_CTL_DEL, socket, nullptr);
+#endif
+	closesocket(socket);
+	_clients.remove(socket);
+	delete client;
+}
+
+void HttpServer::watchWrite(Client& client, bool write) {
+	if (client.writeWatched == write) {
+		return;
+	}
+	client.writeWatched = write;
+#ifdef HTTP_SERVER_EPOLL
+	struct epoll_event event;
+	SDL_memset(&event, 0, sizeof(event));
+	event.events = write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+	event.data.fd = client.socket;
+	epoll_ctl(_epollFD, EPOLL_CTL_MOD, client.socket, &event);
+#endif
+}
 
-	SDL_memcpy(&readFDsOut, &_readFDSet, sizeof(readFDsOut));
-	SDL_memcpy(&writeFDsOut, &_writeFDSet, sizeof(writeFDsOut));
+bool HttpServer::update(int timeoutMillis) {
+	core_trace_scoped(HttpServerUpdate);
+	if (_socketFD == INVALID_SOCKET) {
+		return false;
+	}
+	sendCompleted();
+#ifdef HTTP_SERVER_EPOLL
+	constexpr int MaxEvents = 64;
+	struct epoll_event events[MaxEvents];
+	const int ready = epoll_wait(_epollFD, events, MaxEvents, timeoutMillis);
+	if (ready < 0) {
+		return errno == EINTR;
+	}
+	for (int i = 0; i < ready; ++i) {
+		const SOCKET socket = events[i].data.fd;
+		if (socket == _socketFD) {
+			accept();
+			continue;
+		}
+		Client* client = nullptr;
+		if (!_clients.get(socket, client)) {
+			continue;
+		}
+		const uint32_t e = events[i].events;
+		bool keep = (e & EPOLLERR) == 0;
+		if (keep && (e & (EPOLLIN | EPOLLHUP))) {
+			keep = onReadable(*client);
+		}
+		if (keep && (e & EPOLLOUT)) {
+			keep = onWritable(*client);
+		}
+		if (!keep) {
+			closeClient(socket);
+		}
+	}
+#else
+	fd_set readFDs;
+	fd_set writeFDs;
+	FD_ZERO(&readFDs);
+	FD_ZERO(&writeFDs);
+	FD_SET(_socketFD, &readFDs);
+	SOCKET maxSocket = _socketFD;
+	for (auto i : _clients) {
+		FD_SET(i->key, &readFDs);
+		if (i->value->responsePending && i->value->deferredId == 0u) {
+			FD_SET(i->key, &writeFDs);
+		}
+		maxSocket = core_max(maxSocket, i->key);
+	}
 
 	struct timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
-	const int ready = select(FD_SETSIZE, &readFDsOut, &writeFDsOut, nullptr, &tv);
+	tv.tv_sec = timeoutMillis / 1000;
+	tv.tv_usec = (timeoutMillis % 1000) * 1000;
+	const int ready = select((int)maxSocket + 1, &readFDs, &writeFDs, nullptr, &tv);
 	if (ready < 0) {
 		return false;
 	}
-	if (_socketFD != INVALID_SOCKET && FD_ISSET(_socketFD, &readFDsOut)) {
-		const SOCKET clientSocket = accept(_socketFD, nullptr, nullptr);
-		if (clientSocket != INVALID_SOCKET) {
-			FD_SET(clientSocket, &_readFDSet);
-			Client c;
-			c.socket = clientSocket;
-			_clientSockets.insert(c);
-			networkNonBlocking(clientSocket);
+	std::vector<SOCKET> closed;
+	for (auto i : _clients) {
+		Client* client = i->value;
+		bool keep = true;
+		if (FD_ISSET(i->key, &readFDs)) {
+			keep = onReadable(*client);
+		}
+		if (keep && FD_ISSET(i->key, &writeFDs)) {
+			keep = onWritable(*client);
+		}
+		if (!keep) {
+			closed.push_back(i->key);
 		}
 	}
+	for (SOCKET socket : closed) {
+		closeClient(socket);
+	}
+	if (FD_ISSET(_socketFD, &readFDs)) {
+		accept();
+	}
+#endif
+	closeIdleClients();
+	return true;
+}
 
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		Client& client = *i;
-		const SOCKET clientSocket = client.socket;
-		if (clientSocket == INVALID_SOCKET) {
-			i = closeClient(i);
-			continue;
+void HttpServer::closeIdleClients() {
+	const uint64_t now = core::TimeProvider::systemMillis();
+	if (now - _lastTimeoutCheck < TimeoutCheckMillis) {
+		return;
+	}
+	_lastTimeoutCheck = now;
+	std::vector<SOCKET> idle;
+	for (auto i : _clients) {
+		if (now - i->value->lastActivity > _keepAliveTimeoutMillis) {
+			idle.push_back(i->key);
 		}
+	}
+	for (SOCKET socket : idle) {
+		Log::debug("Close idle http connection");
+		closeClient(socket);
+	}
+}
 
-		if (FD_ISSET(clientSocket, &writeFDsOut)) {
-			if (!sendMessage(client) || client.finished()) {
-				i = closeClient(i);
-			} else {
-				++i;
+void HttpServer::complete(const HttpResponse& response) {
+	core_assert(response.deferred);
+	std::unique_lock lock(_completedMutex);
+	_completed.push_back(response);
+}
+
+void HttpServer::sendCompleted() {
+	std::vector<HttpResponse> completed;
+	{
+		std::unique_lock lock(_completedMutex);
+		if (_completed.empty()) {
+			return;
+		}
+		completed.swap(_completed);
+	}
+	for (HttpResponse& response : completed) {
+		Client* client = nullptr;
+		for (auto i : _clients) {
+			if (i->value->deferredId == response.id) {
+				client = i->value;
+				break;
 			}
-			continue;
 		}
-
-		if (!FD_ISSET(clientSocket, &readFDsOut)) {
-			++i;
+		if (client == nullptr) {
+			Log::debug("Drop the deferred response - the connection was closed");
+			if (response.freeBody) {
+				SDL_free((char*)response.body);
+			}
 			continue;
 		}
+		client->deferredId = 0u;
+		assembleResponse(*client, response);
+		// sent like a response that waited for the socket to become writable
+		watchWrite(*client, true);
+		if (!onWritable(*client)) {
+			closeClient(client->socket);
+		}
+	}
+}
 
-		constexpr const int BUFFERSIZE = 2048;
-		uint8_t recvBuf[BUFFERSIZE];
-		const network_return len = recv(clientSocket, (char*)recvBuf, BUFFERSIZE - 1, 0);
+bool HttpServer::onReadable(Client& client) {
+	bool peerClosed = false;
+	for (;;) {
+		if (client.requestCapacity - client.requestLength < MinReadSize) {
+			const size_t capacity = core_max(client.requestCapacity * 2u, MinReadSize * 2u);
+			client.request = (uint8_t*)SDL_realloc(client.request, capacity);
+			client.requestCapacity = capacity;
+		}
+		const size_t space = client.requestCapacity - client.requestLength;
+		const network_return len = recv(client.socket, (char*)client.request + client.requestLength, space, 0);
 		if (len < 0) {
-			i = closeClient(i);
-			continue;
+			if (networkWouldBlock()) {
+				break;
+			}
+			return false;
 		}
 		if (len == 0) {
-			++i;
-			continue;
+			peerClosed = true;
+			break;
 		}
-
-		client.request = (uint8_t*)SDL_realloc(client.request, client.requestLength + len);
-		SDL_memcpy(client.request + client.requestLength, recvBuf, len);
 		client.requestLength += len;
-
-		if (client.requestLength == 0) {
-			++i;
-			continue;
+		client.lastActivity = core::TimeProvider::systemMillis();
+		if ((size_t)len < space || client.requestLength > _maxRequestBytes) {
+			break;
 		}
+	}
+	if (!processRequests(client)) {
+		return false;
+	}
+	if (client.responsePending && client.requestLength > _maxRequestBytes) {
+		// the pipelined requests are only answered after the pending response was sent - a client that
+		// doesn't read the response must not fill the buffer without limits
+		Log::debug("Close http connection with %i bytes of pipelined requests", (int)client.requestLength);
+		return false;
+	}
+	if (peerClosed) {
+		// the pending response is still sent - but the connection is closed afterwards
+		client.keepAlive = false;
+		return client.responsePending;
+	}
+	return true;
+}
 
-		// GET / HTTP/1.1\r\n\r\n
-		if (client.requestLength < 18) {
-			++i;
-			continue;
-		}
+bool HttpServer::onWritable(Client& client) {
+	if (!client.responsePending) {
+		watchWrite(client, false);
+		return true;
+	}
+	if (client.deferredId != 0u) {
+		return true;
+	}
+	if (!sendMessage(client)) {
+		return false;
+	}
+	if (!client.finished()) {
+		return true;
+	}
+	if (!client.keepAlive) {
+		return false;
+	}
+	client.resetResponse();
+	watchWrite(client, false);
+	// answer the requests that were pipelined in the meantime
+	return processRequests(client);
+}
 
-		if (SDL_memcmp(client.request, "GET", 3) != 0 && SDL_memcmp(client.request, "POST", 4) != 0) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::NotImplemented);
-			++i;
-			continue;
+size_t HttpServer::requestSize(Client& client) const {
+	if (client.expectedLength == 0u) {
+		// continue the search for the end of the header where the last one stopped
+		size_t i = client.scanned >= 3u ? client.scanned - 3u : 0u;
+		const uint8_t *r = client.request;
+		for (; i + 3u < client.requestLength; ++i) {
+			if (r[i] == '\r' && r[i + 1u] == '\n' && r[i + 2u] == '\r' && r[i + 3u] == '\n') {
+				break;
+			}
 		}
-
-		if (client.requestLength > _maxRequestBytes) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::InternalServerError);
-			++i;
-			continue;
+		if (i + 3u >= client.requestLength) {
+			client.scanned = client.requestLength;
+			return 0u;
 		}
+		const size_t headerLength = i + 4u;
+		client.expectedLength = headerLength + parseContentLength(r, headerLength, _maxRequestBytes);
+	}
+	if (client.requestLength < client.expectedLength) {
+		return 0u;
+	}
+	return client.expectedLength;
+}
 
-		uint8_t *mem = (uint8_t *)SDL_malloc(client.requestLength);
-		SDL_memcpy(mem, client.request, client.requestLength);
-		const RequestParser request(mem, client.requestLength);
-		if (!request.valid()) {
-			++i;
-			continue;
+bool HttpServer::processRequests(Client& client) {
+	core_trace_scoped(HttpServerProcessRequests);
+	while (!client.responsePending) {
+		const size_t size = requestSize(client);
+		if (size == 0u) {
+			if (client.requestLength <= _maxRequestBytes && client.expectedLength <= _maxRequestBytes) {
+				break;
+			}
+			// the error response closes the connection - the rest of the request is never read
+			assembleError(client, HttpStatus::PayloadTooLarge);
+			client.requestLength = 0u;
+		} else {
+			uint8_t *data = client.request;
+			const bool get = size >= 4u && SDL_memcmp(data, "GET ", 4) == 0;
+			const bool post = size >= 5u && SDL_memcmp(data, "POST ", 5) == 0;
+			if (!get && !post) {
+				assembleError(client, HttpStatus::NotImplemented);
+			} else {
+				// parsed in place - the request is removed from the buffer after it was answered
+				const RequestParser request(data, size, false);
+				if (!request.valid()) {
+					assembleError(client, HttpStatus::BadRequest);
+				} else {
+					client.keepAlive = isKeepAlive(request);
+					HttpResponse response;
+					if (++_nextResponseId == 0u) {
+						++_nextResponseId;
+					}
+					response.id = _nextResponseId;
+					if (!route(request, response)) {
+						assembleError(client, HttpStatus::NotFound);
+					} else if (response.deferred) {
+						client.deferredId = response.id;
+						client.responsePending = true;
+					} else {
+						assembleResponse(client, response);
+					}
+				}
+			}
+			const size_t remaining = client.requestLength - size;
+			if (remaining > 0u) {
+				SDL_memmove(client.request, client.request + size, remaining);
+			}
+			client.requestLength = remaining;
+		}
+		client.scanned = 0u;
+		client.expectedLength = 0u;
+		if (client.deferredId != 0u) {
+			// the route answers later - see sendCompleted()
+			break;
 		}
 
-		FD_CLR(clientSocket, &_readFDSet);
-		FD_CLR(clientSocket, &readFDsOut);
-
-		HttpResponse response;
-		if (!route(request, response)) {
-			assembleError(client, HttpStatus::NotFound);
-			++i;
-			continue;
+		if (!sendMessage(client)) {
+			return false;
 		}
-		assembleResponse(client, response);
-		if (response.freeBody) {
-			SDL_free((char*)response.body);
+		if (!client.finished()) {
+			watchWrite(client, true);
+			break;
 		}
+		if (!client.keepAlive) {
+			return false;
+		}
+		client.resetResponse();
 	}
 	return true;
 }
 
 void HttpServer::assembleError(Client& client, HttpStatus status) {
-	char buf[512];
-	SDL_snprintf(buf, sizeof(buf),
+	const char *errorPage = "";
+	_errorPages.get((int)status, errorPage);
+	const size_t errorPageLength = SDL_strlen(errorPage);
+
+	client.headerLength = SDL_snprintf(client.header, sizeof(client.header),
 			"HTTP/1.1 %i %s\r\n"
 			"Connection: close\r\n"
 			"Server: %s\r\n"
+			"Content-length: %u\r\n"
 			"\r\n",
 			(int)status,
 			toStatusString(status),
-			core::App::getInstance()->appname().c_str());
-
-	const char *errorPage = "";
-	_errorPages.get((int)status, errorPage);
-
-	const size_t responseSize = SDL_strlen(errorPage) + SDL_strlen(buf);
-	char *responseBuf = (char*)SDL_malloc(responseSize + 1);
-	SDL_snprintf(responseBuf, responseSize + 1, "%s%s", buf, errorPage);
-	client.setResponse(responseBuf, responseSize);
+			core::App::getInstance()->appname().c_str(),
+			(unsigned int)errorPageLength);
+	client.headerLength = core_min(client.headerLength, sizeof(client.header) - 1u);
+	// the error pages are owned by the server
+	client.body = errorPage;
+	client.bodyLength = errorPageLength;
+	client.freeBody = false;
+	client.alreadySent = 0u;
+	client.responsePending = true;
+	client.keepAlive = false;
 	metric(status);
-	FD_SET(client.socket, &_writeFDSet);
 }
 
-void HttpServer::assembleResponse(Client& client, const HttpResponse& response) {
+void HttpServer::assembleResponse(Client& client, HttpResponse& response) {
+	response.headers.put(header::CONNECTION, client.keepAlive ? "keep-alive" : "close");
 	char headers[2048];
-	if (!buildHeaderBuffer(headers, lengthof(headers), response.headers)) {
-		assembleError(client, HttpStatus::InternalServerError);
-		return;
-	}
-
-	char buf[4096];
-	const int headerSize = SDL_snprintf(buf, sizeof(buf),
+	const bool headersValid = buildHeaderBuffer(headers, lengthof(headers), response.headers);
+	const int headerSize = headersValid ? SDL_snprintf(client.header, sizeof(client.header),
 			"HTTP/1.1 %i %s\r\n"
 			"Content-length: %u\r\n"
 			"%s"
@@ -265,46 +588,89 @@ void HttpServer::assembleResponse(Client& client, const HttpResponse& response)
 			(int)response.status,
 			toStatusString(response.status),
 			(unsigned int)response.bodySize,
-			headers);
-	if (headerSize >= lengthof(buf)) {
+			headers) : -1;
+	if (headerSize < 0 || headerSize >= lengthof(client.header)) {
+		if (response.freeBody) {
+			SDL_free((char*)response.body);
+		}
 		assembleError(client, HttpStatus::InternalServerError);
 		return;
 	}
 
-	const size_t responseSize = response.bodySize + SDL_strlen(buf);
-	char *responseBuf = (char*)SDL_malloc(responseSize);
-	SDL_memcpy(responseBuf, buf, headerSize);
-	SDL_memcpy(responseBuf + headerSize, response.body, response.bodySize);
-	client.setResponse(responseBuf, responseSize);
-	Log::trace("Response buffer of size %i", (int)responseSize);
+	client.headerLength = headerSize;
+	// the body is sent as it is - the server takes the ownership
+	client.body = response.body;
+	client.bodyLength = response.bodySize;
+	client.freeBody = response.freeBody;
+	client.alreadySent = 0u;
+	client.responsePending = true;
+	Log::trace("Response of size %i", (int)(client.headerLength + client.bodyLength));
 	metric(response.status);
-	FD_SET(client.socket, &_writeFDSet);
-}
-
-void HttpServer::metric(HttpStatus status) const {
-	char buf[8];
-	SDL_snprintf(buf, sizeof(buf), "%u", (uint32_t)status);
-	_metric->count("http.request", 1, {{"status", buf}});
 }
 
 bool HttpServer::sendMessage(Client& client) {
-	core_assert(client.response != nullptr);
-	int remaining = (int)client.responseLength - (int)client.alreadySent;
-	if (remaining <= 0) {
-		return false;
+	core_assert(client.responsePending);
+	const size_t bodyOffset = client.alreadySent > client.headerLength ? client.alreadySent - client.headerLength : 0u;
+	const char *parts[2];
+	size_t lengths[2];
+	int n = 0;
+	if (client.alreadySent < client.headerLength) {
+		parts[n] = client.header + client.alreadySent;
+		lengths[n] = client.headerLength - client.alreadySent;
+		++n;
+	}
+	if (bodyOffset < client.bodyLength) {
+		parts[n] = client.body + bodyOffset;
+		lengths[n] = client.bodyLength - bodyOffset;
+		++n;
 	}
-	const char* p = client.response + client.alreadySent;
-	const network_return sent = ::send(client.socket, p, remaining, 0);
+	if (n == 0) {
+		return true;
+	}
+#ifdef WIN32
+	const network_return sent = ::send(client.socket, parts[0], (int)lengths[0], 0);
+#else
+	struct iovec iov[2];
+	for (int i = 0; i < n; ++i) {
+		iov[i].iov_base = (void*)parts[i];
+		iov[i].iov_len = lengths[i];
+	}
+	struct msghdr msg;
+	SDL_memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = n;
+#ifdef MSG_NOSIGNAL
+	const network_return sent = ::sendmsg(client.socket, &msg, MSG_NOSIGNAL);
+#else
+	const network_return sent = ::sendmsg(client.socket, &msg, 0);
+#endif
+#endif
 	if (sent < 0) {
+		if (networkWouldBlock()) {
+			return true;
+		}
 		Log::debug("Failed to send to the client");
 		return false;
 	}
-	if (sent == 0) {
-		return true;
-	}
-	remaining -= sent;
 	client.alreadySent += sent;
-	return remaining > 0;
+	client.lastActivity = core::TimeProvider::systemMillis();
+	return true;
+}
+
+void HttpServer::metric(HttpStatus status) {
+	metric::MetricHandle handle;
+	if (!_statusMetrics.get((int)status, handle)) {
+		if (_statusMetrics.size() >= _statusMetrics.capacity()) {
+			return;
+		}
+		char buf[8];
+		SDL_snprintf(buf, sizeof(buf), "%u", (uint32_t)status);
+		metric::TagMap tags(2);
+		tags.put("status", buf);
+		handle = _metric->registerMetric("http.request", metric::MetricType::Count, tags);
+		_statusMetrics.put((int)status, handle);
+	}
+	_metric->record(handle, 1);
 }
 
 bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
@@ -339,7 +705,6 @@ bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 		return false;
 	}
 	response.headers.put(header::CONTENT_TYPE, http::mimetype::TEXT_PLAIN);
-	response.headers.put(header::CONNECTION, "close");
 	response.headers.put(header::SERVER, core::App::getInstance()->appname().c_str());
 	// TODO urldecode of request data
 	//core::string::urlDecode(request.query);
@@ -352,19 +717,32 @@ void HttpServer::shutdown() {
 	for (size_t i = 0; i < l; ++i) {
 		_routes[i].clear();
 	}
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		i = closeClient(i);
+	std::vector<SOCKET> sockets;
+	sockets.reserve(_clients.size());
+	for (auto i : _clients) {
+		sockets.push_back(i->key);
 	}
+	for (SOCKET socket : sockets) {
+		closeClient(socket);
+	}
+	// the routes might still complete their deferred responses - nobody is waiting for them anymore
+	sendCompleted();
 
 	for (auto i : _errorPages) {
 		SDL_free((char*)i->second);
 	}
 	_errorPages.clear();
 
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-	closesocket(_socketFD);
-	_socketFD = INVALID_SOCKET;
+#ifdef HTTP_SERVER_EPOLL
+	if (_epollFD != -1) {
+		close(_epollFD);
+		_epollFD = -1;
+	}
+#endif
+	if (_socketFD != INVALID_SOCKET) {
+		closesocket(_socketFD);
+		_socketFD = INVALID_SOCKET;
+	}
 	network_cleanup();
 }
 
@@ -372,18 +750,29 @@ HttpServer::Client::Client() :
 		socket(INVALID_SOCKET) {
 }
 
-void HttpServer::Client::setResponse(char* responseBuf, size_t responseBufLength) {
-	core_assert(response == nullptr);
-	response = responseBuf;
-	responseLength = responseBufLength;
+HttpServer::Client::~Client() {
+	resetResponse();
+	SDL_free(request);
+}
+
+void HttpServer::Client::resetResponse() {
+	if (freeBody) {
+		SDL_free((char*)body);
+	}
+	body = nullptr;
+	bodyLength = 0u;
+	freeBody = false;
+	headerLength = 0u;
 	alreadySent = 0u;
+	deferredId = 0u;
+	responsePending = false;
 }
 
 bool HttpServer::Client::finished() const {
-	if (response == nullptr) {
+	if (!responsePending || deferredId != 0u) {
 		return false;
 	}
-	return responseLength == alreadySent;
+	return alreadySent == headerLength + bodyLength;
 }
 
 }
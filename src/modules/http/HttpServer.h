@@ -12,54 +12,123 @@
 #include "HttpHeader.h"
 #include "HttpQuery.h"
 #include "core/collection/Map.h"
-#include "core/collection/List.h"
 #include "core/metric/Metric.h"
+#include "core/Trace.h"
 #include <stdint.h>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__linux__)
+#define HTTP_SERVER_EPOLL 1
+#endif
 
 namespace http {
 
 class RequestParser;
 
+/**
+ * @brief Non-blocking http server that is updated from the main loop
+ *
+ * The connections are kept alive (HTTP/1.1) until the client closes them, asks for it or is idle for
+ * longer than the keep alive timeout. The requests are parsed in place in one reusable buffer per
+ * connection - pipelined requests are answered in the order they were received. The response header
+ * and the body of the route are sent with one scatter write - the body is not copied.
+ *
+ * On linux the sockets are watched with epoll, on the other platforms with select.
+ *
+ * A route can defer its response (see @c HttpResponse::defer()) and finish it later from any thread with
+ * @c complete() - the response is sent in the next @c update(). The pipelined requests of the connection
+ * wait for it.
+ */
 class HttpServer {
 public:
 	using RouteCallback = std::function<void(const RequestParser& query, HttpResponse* response)>;
 private:
 	SOCKET _socketFD;
-	fd_set _readFDSet;
-	fd_set _writeFDSet;
+#ifdef HTTP_SERVER_EPOLL
+	int _epollFD = -1;
+#endif
 	using Routes = core::Map<const char*, RouteCallback, 8, core::hashCharPtr, core::hashCharCompare>;
 	core::Map<int, const char*, 8, std::hash<int>> _errorPages;
 	Routes _routes[2];
 	size_t _maxRequestBytes = 1 * 1024 * 1024;
+	uint32_t _keepAliveTimeoutMillis = 15000u;
+	uint64_t _lastTimeoutCheck = 0u;
 	metric::MetricPtr _metric;
+	// the request metric is registered once per status code
+	core::Map<int, metric::MetricHandle, 8, std::hash<int>> _statusMetrics { 32 };
+	uint32_t _nextResponseId = 0u;
+	// the deferred responses that were completed - they are sent by the server thread
+	core_trace_mutex(std::mutex, _completedMutex);
+	std::vector<HttpResponse> _completed;
 
 	struct Client {
-		Client();
 		SOCKET socket;
+		uint64_t lastActivity = 0u;
 
+		// the received data - might contain more than one request
 		uint8_t *request = nullptr;
 		size_t requestLength = 0u;
-
-		char* response = nullptr;
-		size_t responseLength = 0u;
+		size_t requestCapacity = 0u;
+		// the amount of bytes that were already searched for the end of the header
+		size_t scanned = 0u;
+		// the size of the current request - known once the header is complete
+		size_t expectedLength = 0u;
+
+		// the response - the header is assembled here, the body is owned by the route
+		char header[4096];
+		size_t headerLength = 0u;
+		const char *body = nullptr;
+		size_t bodyLength = 0u;
+		bool freeBody = false;
 		size_t alreadySent = 0u;
+		// the id of the response that the route deferred - 0 if there is none
+		uint32_t deferredId = 0u;
+		bool responsePending = false;
+		bool keepAlive = true;
+		bool writeWatched = false;
 
-		void setResponse(char* responseBuf, size_t responseBufLength);
+		Client();
+		~Client();
+		void resetResponse();
 		bool finished() const;
 	};
 
-	using ClientSockets = core::List<Client>;
-	using ClientSocketsIter = ClientSockets::iterator;
-	ClientSockets _clientSockets { 1024 };
+	using Clients = core::Map<SOCKET, Client*, 64, std::hash<SOCKET>>;
+	Clients _clients;
 
-	ClientSocketsIter closeClient (ClientSocketsIter& i);
+	void accept();
+	void closeClient(SOCKET socket);
+	/**
+	 * @return @c false if the connection should be closed
+	 */
+	bool onReadable(Client& client);
+	/**
+	 * @return @c false if the connection should be closed
+	 */
+	bool onWritable(Client& client);
+	/**
+	 * @brief Answers the complete requests that were received - one at a time in the order they arrived
+	 * @return @c false if the connection should be closed
+	 */
+	bool processRequests(Client& client);
+	/**
+	 * @return The size of the first request in the buffer or @c 0 if it is not yet complete
+	 */
+	size_t requestSize(Client& client) const;
+	void watchWrite(Client& client, bool write);
+	void closeIdleClients();
+	/**
+	 * @brief Sends the deferred responses that were completed since the last call
+	 */
+	void sendCompleted();
 
-	void metric(HttpStatus status) const;
+	void metric(HttpStatus status);
 
 	bool route(const RequestParser& request, HttpResponse& response);
-	void assembleResponse(Client& client, const HttpResponse& response);
+	void assembleResponse(Client& client, HttpResponse& response);
 	void assembleError(Client& client, HttpStatus status);
 	bool sendMessage(Client& client);
 
@@ -70,6 +139,10 @@ public:
 	~HttpServer();
 
 	void setMaxRequestSize(size_t maxBytes);
+	/**
+	 * @brief Idle connections are closed after the given amount of milliseconds
+	 */
+	void setKeepAliveTimeout(uint32_t millis);
 
 	/**
 	 * @param[in] body The status code body. The pointer is copied and then released by the server.
@@ -77,9 +150,21 @@ public:
 	void setErrorText(HttpStatus status, const char *body);
 
 	bool init(int16_t port = 8080);
-	bool update();
+	/**
+	 * @param[in] timeoutMillis The time to wait for network events - the default is to only handle the
+	 * events that are already pending
+	 */
+	bool update(int timeoutMillis = 0);
 	void shutdown();
 
+	/**
+	 * @brief Finishes a deferred response - can be called from any thread
+	 * @note The header values must stay valid until the response was sent. If the connection was closed in
+	 * the meantime, the response is dropped.
+	 * @sa HttpResponse::defer()
+	 */
+	void complete(const HttpResponse& response);
+
 	void registerRoute(HttpMethod method, const char *path, const RouteCallback& callback);
 	bool unregisterRoute(HttpMethod method, const char *path);
 };
@@ -88,6 +173,9 @@ inline void HttpServer::setMaxRequestSize(size_t maxBytes) {
 	_maxRequestBytes = maxBytes;
 }
 
+inline void HttpServer::setKeepAliveTimeout(uint32_t millis) {
+	_keepAliveTimeoutMillis = millis;
+}
 
 typedef std::shared_ptr<HttpServer> HttpServerPtr;
 
@@ -11,8 +11,14 @@ const char* toStatusString(HttpStatus status) {
 		return "Internal Server Error";
 	} else if (status == HttpStatus::Ok) {
 		return "OK";
+	} else if (status == HttpStatus::NotModified) {
+		return "Not Modified";
+	} else if (status == HttpStatus::BadRequest) {
+		return "Bad Request";
 	} else if (status == HttpStatus::NotFound) {
 		return "Not Found";
+	} else if (status == HttpStatus::PayloadTooLarge) {
+		return "Payload Too Large";
 	} else if (status == HttpStatus::NotImplemented) {
 		return "Not Implemented";
 	}
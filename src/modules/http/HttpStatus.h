@@ -13,10 +13,12 @@ enum class HttpStatus : uint16_t {
 	Ok = 200,
 	Created = 201,
 	Accepted = 202,
+	NotModified = 304,
 	BadRequest = 400,
 	Unauthorized = 401,
 	Forbidden = 403,
 	NotFound = 404,
+	PayloadTooLarge = 413,
 	RequestUriTooLong = 414,
 	InternalServerError = 500,
 	NotImplemented = 501,
@@ -21,7 +21,7 @@ private:
 	const Url _url;
 	SOCKET _socketFD;
 	HttpMethod _method;
-	HeaderMap _headers;
+	HeaderMap _headers { MaxHeaders };
 	const char *_body = "";
 	ResponseParser failed();
 public:
@@ -44,8 +44,8 @@ RequestParser::RequestParser(const RequestParser &other) :
 	path = HTTP_PARSER_NEW_BASE(other.path);
 }
 
-RequestParser::RequestParser(uint8_t* requestBuffer, size_t requestBufferSize)
-		: Super(requestBuffer, requestBufferSize) {
+RequestParser::RequestParser(uint8_t* requestBuffer, size_t requestBufferSize, bool ownsBuffer)
+		: Super(requestBuffer, requestBufferSize, ownsBuffer) {
 	if (buf == nullptr || bufSize == 0) {
 		return;
 	}
@@ -97,7 +97,9 @@ RequestParser::RequestParser(uint8_t* requestBuffer, size_t requestBufferSize)
 				static const char *EMPTY = "";
 				value = (char*)EMPTY;
 			}
-			query.put(key, value);
+			if (query.size() < query.capacity()) {
+				query.put(key, value);
+			}
 
 			if (last) {
 				break;
@@ -14,11 +14,14 @@ class RequestParser : public HttpParser {
 private:
 	using Super = HttpParser;
 public:
-	RequestParser(uint8_t* requestBuffer, size_t requestBufferSize);
+	/**
+	 * @param[in] ownsBuffer See @c HttpParser::HttpParser()
+	 */
+	RequestParser(uint8_t* requestBuffer, size_t requestBufferSize, bool ownsBuffer = true);
 
 	// arrays are not supported as query parameters - but
 	// that's fine for our use case
-	HttpQuery query;
+	HttpQuery query { MaxQueryParameters };
 	HttpMethod method = HttpMethod::NOT_SUPPORTED;
 	const char* path = nullptr;
 
@@ -0,0 +1,201 @@
+/**
+ * @file
+ *
+ * Load test of the http server over the loopback device. The server is updated on its own thread, the
+ * clients request a body of 8k from their own threads. The first argument is the amount of client
+ * threads, the second one toggles the keep alive connections (1) against a new connection for every
+ * request (0).
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/Common.h"
+#include "core/concurrent/Atomic.h"
+#include "http/HttpServer.h"
+#include "http/Network.cpp.h"
+#include <SDL_stdinc.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int16_t Port = 10180;
+constexpr int RequestsPerClient = 500;
+constexpr size_t BodySize = 8192u;
+
+SOCKET connectClient() {
+	const SOCKET clientSocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (clientSocket == INVALID_SOCKET) {
+		return INVALID_SOCKET;
+	}
+	struct sockaddr_in sin;
+	SDL_memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(Port);
+	if (connect(clientSocket, (struct sockaddr *) &sin, sizeof(sin)) != 0) {
+		closesocket(clientSocket);
+		return INVALID_SOCKET;
+	}
+	int t = 1;
+	setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, (const char*)&t, sizeof(t));
+	return clientSocket;
+}
+
+/**
+ * @brief Sends one request and reads the whole response
+ */
+bool request(SOCKET clientSocket, const char *req, size_t reqLength, std::vector<char>& buf) {
+	if (send(clientSocket, req, reqLength, 0) != (network_return)reqLength) {
+		return false;
+	}
+	size_t received = 0u;
+	size_t expected = 0u;
+	for (;;) {
+		const network_return len = recv(clientSocket, buf.data() + received, buf.size() - received, 0);
+		if (len <= 0) {
+			return false;
+		}
+		received += len;
+		if (expected == 0u) {
+			const char *headerEnd = SDL_strstr(buf.data(), "\r\n\r\n");
+			if (headerEnd == nullptr) {
+				continue;
+			}
+			const char *contentLength = SDL_strstr(buf.data(), "Content-length: ");
+			if (contentLength == nullptr || contentLength > headerEnd) {
+				return false;
+			}
+			expected = (size_t)(headerEnd + 4 - buf.data()) + SDL_atoi(contentLength + 16);
+		}
+		if (received >= expected) {
+			return received == expected;
+		}
+	}
+}
+
+}
+
+class HttpServerBenchmark : public core::AbstractBenchmark {
+private:
+	using Super = core::AbstractBenchmark;
+protected:
+	http::HttpServerPtr _server;
+	std::thread _serverThread;
+	core::AtomicBool _running { false };
+	std::vector<uint8_t> _body;
+	bool _initialized = false;
+
+public:
+	void SetUp(benchmark::State& state) override {
+		Super::SetUp(state);
+		_body.resize(BodySize);
+		for (size_t i = 0u; i < _body.size(); ++i) {
+			_body[i] = (uint8_t)(i * 31u);
+		}
+		_server = std::make_shared<http::HttpServer>(_benchmarkApp->metric());
+		_initialized = _server->init(Port);
+		if (!_initialized) {
+			return;
+		}
+		_server->registerRoute(http::HttpMethod::GET, "/chunk", [this] (const http::RequestParser& request, http::HttpResponse* response) {
+			response->body = (const char*)_body.data();
+			response->contentLength(_body.size());
+			response->freeBody = false;
+			response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNK);
+		});
+		_running = true;
+		_serverThread = std::thread([this] () {
+			while (_running) {
+				_server->update(1);
+			}
+		});
+	}
+
+	void TearDown(benchmark::State& state) override {
+		_running = false;
+		if (_serverThread.joinable()) {
+			_serverThread.join();
+		}
+		if (_initialized) {
+			_server->shutdown();
+		}
+		_server = http::HttpServerPtr();
+		Super::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(HttpServerBenchmark, load) (benchmark::State& state) {
+	const int clients = (int)state.range(0);
+	const bool keepAlive = state.range(1) != 0;
+	const char *req = keepAlive ? "GET /chunk HTTP/1.1\r\nHost: localhost\r\n\r\n"
+			: "GET /chunk HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+	const size_t reqLength = SDL_strlen(req);
+	std::vector<uint64_t> latencies;
+	Clock::duration total { 0 };
+	int64_t totalRequests = 0;
+	for (auto _ : state) {
+		if (!_initialized) {
+			state.SkipWithError("Failed to start the http server");
+			break;
+		}
+		std::vector<std::vector<uint64_t>> clientLatencies(clients);
+		core::AtomicInt failed { 0 };
+		const Clock::time_point start = Clock::now();
+		std::vector<std::thread> threads;
+		for (int c = 0; c < clients; ++c) {
+			threads.emplace_back([&, c] () {
+				std::vector<char> buf(BodySize + 1024u);
+				std::vector<uint64_t>& l = clientLatencies[c];
+				l.reserve(RequestsPerClient);
+				SOCKET clientSocket = INVALID_SOCKET;
+				for (int i = 0; i < RequestsPerClient; ++i) {
+					const Clock::time_point requestStart = Clock::now();
+					if (clientSocket == INVALID_SOCKET) {
+						clientSocket = connectClient();
+					}
+					if (clientSocket == INVALID_SOCKET || !request(clientSocket, req, reqLength, buf)) {
+						++failed;
+						break;
+					}
+					if (!keepAlive) {
+						closesocket(clientSocket);
+						clientSocket = INVALID_SOCKET;
+					}
+					l.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - requestStart).count());
+				}
+				if (clientSocket != INVALID_SOCKET) {
+					closesocket(clientSocket);
+				}
+			});
+		}
+		for (std::thread& t : threads) {
+			t.join();
+		}
+		total += Clock::now() - start;
+		if (failed > 0) {
+			state.SkipWithError("Request failed");
+			break;
+		}
+		for (const std::vector<uint64_t>& l : clientLatencies) {
+			latencies.insert(latencies.end(), l.begin(), l.end());
+			totalRequests += (int64_t)l.size();
+		}
+	}
+	const double totalNanos = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(total).count();
+	if (latencies.empty() || totalNanos <= 0.0) {
+		return;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	const size_t p99 = core_min(latencies.size() - 1u, latencies.size() * 99u / 100u);
+	state.counters["req/s"] = (double)totalRequests * 1000000000.0 / totalNanos;
+	state.counters["p99_us"] = (double)latencies[p99] / 1000.0;
+	state.SetItemsProcessed(totalRequests);
+}
+
+BENCHMARK_REGISTER_F(HttpServerBenchmark, load)->Args({1, 1})->Args({8, 1})->Args({1, 0})->Args({8, 0})->UseRealTime();
+
+BENCHMARK_MAIN();
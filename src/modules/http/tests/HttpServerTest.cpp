@@ -3,7 +3,11 @@
  */
 
 #include "core/tests/AbstractTest.h"
+#include "core/TimeProvider.h"
 #include "http/HttpServer.h"
+#include "http/Network.cpp.h"
+#include <errno.h>
+#include <thread>
 
 namespace http {
 
@@ -19,4 +23,202 @@ TEST_F(HttpServerTest, testSimple) {
 	server.shutdown();
 }
 
+TEST_F(HttpServerTest, testKeepAlivePipelined) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10102));
+	int calls = 0;
+	server.registerRoute(HttpMethod::GET, "/", [&] (const http::RequestParser& request, HttpResponse* response) {
+		++calls;
+		response->setText("Success");
+	});
+
+	const SOCKET clientSocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	ASSERT_NE(INVALID_SOCKET, clientSocket);
+	struct sockaddr_in sin;
+	SDL_memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(10102);
+	ASSERT_EQ(0, connect(clientSocket, (struct sockaddr *) &sin, sizeof(sin)));
+	networkNonBlocking(clientSocket);
+
+	// two requests on one connection - the first one arrives in two pieces
+	const char *requests = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\nGET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	const size_t length = SDL_strlen(requests);
+	ASSERT_EQ(10, (int)send(clientSocket, requests, 10, 0));
+	server.update();
+	ASSERT_EQ((int)length - 10, (int)send(clientSocket, requests + 10, length - 10, 0));
+
+	core::String received;
+	const uint64_t end = core::TimeProvider::systemMillis() + 5000u;
+	while (core::TimeProvider::systemMillis() < end) {
+		server.update();
+		char buf[1024];
+		const network_return len = recv(clientSocket, buf, sizeof(buf), 0);
+		if (len > 0) {
+			received += core::String(buf, len);
+		}
+		if (received.find("Success") != received.rfind("Success")) {
+			break;
+		}
+	}
+	EXPECT_EQ(2, calls);
+	const size_t first = received.find("HTTP/1.1 200 OK");
+	ASSERT_NE(core::String::npos, first) << received.c_str();
+	EXPECT_NE(core::String::npos, received.find("HTTP/1.1 200 OK", first + 1)) << received.c_str();
+	EXPECT_NE(core::String::npos, received.find("Connection: keep-alive")) << received.c_str();
+
+	closesocket(clientSocket);
+	server.shutdown();
+}
+
+TEST_F(HttpServerTest, testPipelinedRequestsAreBounded) {
+	HttpServer server(_testApp->metric());
+	server.setMaxRequestSize(4096);
+	ASSERT_TRUE(server.init(10103));
+	// bigger than the socket buffers - the response stays pending as long as the client doesn't read
+	std::vector<char> body(32 * 1024 * 1024, 'x');
+	server.registerRoute(HttpMethod::GET, "/", [&] (const http::RequestParser& request, HttpResponse* response) {
+		response->body = body.data();
+		response->contentLength(body.size());
+		response->freeBody = false;
+	});
+
+	const SOCKET clientSocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	ASSERT_NE(INVALID_SOCKET, clientSocket);
+	struct sockaddr_in sin;
+	SDL_memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(10103);
+	ASSERT_EQ(0, connect(clientSocket, (struct sockaddr *) &sin, sizeof(sin)));
+	networkNonBlocking(clientSocket);
+
+	const char *request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	const size_t length = SDL_strlen(request);
+	bool closed = false;
+	const uint64_t end = core::TimeProvider::systemMillis() + 5000u;
+	while (!closed && core::TimeProvider::systemMillis() < end) {
+		// the client never reads - the first request blocks the answers of all the following ones
+#ifdef MSG_NOSIGNAL
+		const network_return len = send(clientSocket, request, length, MSG_NOSIGNAL);
+#else
+		const network_return len = send(clientSocket, request, length, 0);
+#endif
+		if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			closed = true;
+		}
+		server.update();
+	}
+	EXPECT_TRUE(closed) << "The server should close the connection once the pipelined requests exceed the max request size";
+
+	closesocket(clientSocket);
+	server.shutdown();
+}
+
+TEST_F(HttpServerTest, testContentLengthOverflow) {
+	HttpServer server(_testApp->metric());
+	server.setMaxRequestSize(4096);
+	ASSERT_TRUE(server.init(10104));
+	int calls = 0;
+	server.registerRoute(HttpMethod::POST, "/", [&] (const http::RequestParser& request, HttpResponse* response) {
+		++calls;
+		response->setText("Success");
+	});
+
+	const SOCKET clientSocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	ASSERT_NE(INVALID_SOCKET, clientSocket);
+	struct sockaddr_in sin;
+	SDL_memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(10104);
+	ASSERT_EQ(0, connect(clientSocket, (struct sockaddr *) &sin, sizeof(sin)));
+	networkNonBlocking(clientSocket);
+
+	// 2^64 + 100 - without the overflow check the server would wait for a body of 100 bytes
+	const char *request = "POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: 18446744073709551716\r\n\r\nx";
+	const size_t length = SDL_strlen(request);
+	ASSERT_EQ((int)length, (int)send(clientSocket, request, length, 0));
+
+	core::String received;
+	const uint64_t end = core::TimeProvider::systemMillis() + 5000u;
+	while (core::TimeProvider::systemMillis() < end) {
+		server.update();
+		char buf[1024];
+		const network_return len = recv(clientSocket, buf, sizeof(buf), 0);
+		if (len > 0) {
+			received += core::String(buf, len);
+		}
+		if (received.find("\r\n\r\n") != core::String::npos) {
+			break;
+		}
+	}
+	EXPECT_EQ(0, calls) << "The request with the oversized body must not be handled";
+	EXPECT_NE(core::String::npos, received.find("HTTP/1.1 413")) << received.c_str();
+	EXPECT_NE(core::String::npos, received.find("Connection: close")) << received.c_str();
+
+	closesocket(clientSocket);
+	server.shutdown();
+}
+
+TEST_F(HttpServerTest, testDeferredResponse) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10105));
+	std::thread worker;
+	int calls = 0;
+	server.registerRoute(HttpMethod::GET, "/", [&] (const http::RequestParser& request, HttpResponse* response) {
+		++calls;
+		if (calls > 1) {
+			response->setText("Second");
+			return;
+		}
+		response->defer();
+		const HttpResponse deferred = *response;
+		// answered by another thread - the pipelined request must wait for it
+		worker = std::thread([&server, deferred] () mutable {
+			deferred.setText("First");
+			server.complete(deferred);
+		});
+	});
+
+	const SOCKET clientSocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	ASSERT_NE(INVALID_SOCKET, clientSocket);
+	struct sockaddr_in sin;
+	SDL_memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(10105);
+	ASSERT_EQ(0, connect(clientSocket, (struct sockaddr *) &sin, sizeof(sin)));
+	networkNonBlocking(clientSocket);
+
+	const char *requests = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\nGET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	const size_t length = SDL_strlen(requests);
+	ASSERT_EQ((int)length, (int)send(clientSocket, requests, length, 0));
+
+	core::String received;
+	const uint64_t end = core::TimeProvider::systemMillis() + 5000u;
+	while (core::TimeProvider::systemMillis() < end) {
+		server.update();
+		char buf[1024];
+		const network_return len = recv(clientSocket, buf, sizeof(buf), 0);
+		if (len > 0) {
+			received += core::String(buf, len);
+		}
+		if (received.find("Second") != core::String::npos) {
+			break;
+		}
+	}
+	if (worker.joinable()) {
+		worker.join();
+	}
+	EXPECT_EQ(2, calls);
+	const size_t first = received.find("First");
+	ASSERT_NE(core::String::npos, first) << received.c_str();
+	EXPECT_NE(core::String::npos, received.find("Second", first)) << received.c_str();
+
+	closesocket(clientSocket);
+	server.shutdown();
+}
+
 }
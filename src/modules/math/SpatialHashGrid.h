@@ -0,0 +1,187 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "Rect.h"
+#include "core/Trace.h"
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <stdint.h>
+#include <glm/common.hpp>
+
+namespace math {
+
+/**
+ * @brief Uniform grid of hashed cells for spatial queries on moving items
+ *
+ * Every item is stored in the cell that contains the center of its rect. Moving items don't have to be
+ * removed and inserted again - @c update() only touches the cells if the item crossed a cell border.
+ * The queries don't allocate memory but append to a caller owned list - this allows concurrent queries
+ * as long as the grid isn't modified.
+ *
+ * @note The cell size should be in the range of the usual query size - too small cells increase the
+ * amount of cell lookups per query, too big cells increase the amount of items that must be checked.
+ */
+template<class NODE, typename TYPE = float, class HASH = std::hash<NODE> >
+class SpatialHashGrid {
+public:
+	typedef std::vector<NODE> Contents;
+private:
+	typedef uint64_t CellKey;
+	struct Slot {
+		CellKey cell;
+		uint32_t index;
+	};
+	std::unordered_map<CellKey, Contents> _cells;
+	std::unordered_map<NODE, Slot, HASH> _slots;
+	const TYPE _cellSize;
+	// the biggest half extent of all the items that were added - the queries must look that far into the neighbour cells
+	TYPE _maxHalfExtent = (TYPE)0;
+
+	static inline Rect<TYPE> rect(const typename std::remove_pointer<NODE>::type* item) {
+		return item->getRect();
+	}
+
+	static inline Rect<TYPE> rect(const typename std::remove_pointer<NODE>::type& item) {
+		return item.getRect();
+	}
+
+	inline int32_t cellCoord(TYPE value) const {
+		return (int32_t)glm::floor((double)value / (double)_cellSize);
+	}
+
+	static inline CellKey cellKey(int32_t x, int32_t z) {
+		return ((CellKey)(uint32_t)x << 32) | (CellKey)(uint32_t)z;
+	}
+
+	CellKey cellKey(const Rect<TYPE>& area) {
+		const TYPE halfExtent = glm::max(area.getMaxX() - area.getMinX(), area.getMaxZ() - area.getMinZ()) / (TYPE)2;
+		_maxHalfExtent = glm::max(_maxHalfExtent, halfExtent);
+		const glm::tvec2<TYPE>& center = area.center();
+		return cellKey(cellCoord(center.x), cellCoord(center.y));
+	}
+
+	/**
+	 * @brief Removes the item from its cell - the last item of the cell takes its place
+	 * @note Empty cells are erased - otherwise every cell an item ever passed would stay in the map
+	 */
+	void removeFromCell(const Slot& slot) {
+		auto i = _cells.find(slot.cell);
+		Contents& contents = i->second;
+		if (slot.index + 1u != (uint32_t)contents.size()) {
+			NODE& last = contents.back();
+			_slots[last].index = slot.index;
+			contents[slot.index] = std::move(last);
+		}
+		contents.pop_back();
+		if (contents.empty()) {
+			_cells.erase(i);
+		}
+	}
+
+	uint32_t addToCell(CellKey cell, const NODE& item) {
+		Contents& contents = _cells[cell];
+		contents.push_back(item);
+		return (uint32_t)contents.size() - 1u;
+	}
+
+public:
+	SpatialHashGrid(TYPE cellSize) :
+			_cellSize(cellSize) {
+	}
+
+	inline int count() const {
+		return (int)_slots.size();
+	}
+
+	/**
+	 * @return The amount of cells that contain at least one item
+	 */
+	inline int cells() const {
+		return (int)_cells.size();
+	}
+
+	inline TYPE cellSize() const {
+		return _cellSize;
+	}
+
+	/**
+	 * @return @c false if the item is already part of the grid
+	 */
+	bool insert(const NODE& item) {
+		auto i = _slots.find(item);
+		if (i != _slots.end()) {
+			return false;
+		}
+		const CellKey cell = cellKey(rect(item));
+		_slots.emplace(item, Slot { cell, addToCell(cell, item) });
+		return true;
+	}
+
+	bool remove(const NODE& item) {
+		auto i = _slots.find(item);
+		if (i == _slots.end()) {
+			return false;
+		}
+		const Slot slot = i->second;
+		_slots.erase(i);
+		removeFromCell(slot);
+		return true;
+	}
+
+	/**
+	 * @brief Moves the item into the cell of its current rect
+	 * @return @c true if the item was moved into another cell, @c false if it stays in its cell or isn't part of the grid
+	 */
+	bool update(const NODE& item) {
+		auto i = _slots.find(item);
+		if (i == _slots.end()) {
+			return false;
+		}
+		const CellKey cell = cellKey(rect(item));
+		if (cell == i->second.cell) {
+			return false;
+		}
+		removeFromCell(i->second);
+		i->second.cell = cell;
+		i->second.index = addToCell(cell, item);
+		return true;
+	}
+
+	/**
+	 * @brief Appends all items whose rect intersects the given area
+	 * @note The results are not cleared - and don't have a particular order
+	 * @note Every cell in the area is looked up - don't use this for unbounded areas
+	 */
+	void query(const Rect<TYPE>& area, Contents& results) const {
+		core_trace_scoped(SpatialHashGridQuery);
+		const int32_t minX = cellCoord(area.getMinX() - _maxHalfExtent);
+		const int32_t minZ = cellCoord(area.getMinZ() - _maxHalfExtent);
+		const int32_t maxX = cellCoord(area.getMaxX() + _maxHalfExtent);
+		const int32_t maxZ = cellCoord(area.getMaxZ() + _maxHalfExtent);
+		for (int32_t x = minX; x <= maxX; ++x) {
+			for (int32_t z = minZ; z <= maxZ; ++z) {
+				auto i = _cells.find(cellKey(x, z));
+				if (i == _cells.end()) {
+					continue;
+				}
+				for (const NODE& item : i->second) {
+					if (area.intersectsWith(rect(item))) {
+						results.push_back(item);
+					}
+				}
+			}
+		}
+	}
+
+	void clear() {
+		_cells.clear();
+		_slots.clear();
+		_maxHalfExtent = (TYPE)0;
+	}
+};
+
+}
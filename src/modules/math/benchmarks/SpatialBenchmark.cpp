@@ -0,0 +1,173 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/concurrent/Atomic.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/concurrent/ThreadPool.h"
+#include "math/QuadTree.h"
+#include "math/Random.h"
+#include "math/SpatialHashGrid.h"
+#include <glm/common.hpp>
+#include <glm/exponential.hpp>
+#include <future>
+
+/**
+ * @brief Simulates the visibility pass of a map: all entities move a little bit, the spatial index is updated
+ * and every entity queries the entities in its view rect.
+ *
+ * The density of the entities is the same for every entity count - one entity per 20x20 units - so the
+ * amount of visible entities per query stays the same while the map grows.
+ */
+class SpatialBenchmark: public core::AbstractBenchmark {
+protected:
+	struct Entity {
+		glm::vec2 pos;
+		glm::vec2 velocity;
+
+		math::RectFloat getRect() const {
+			return math::RectFloat(pos.x - 0.5f, pos.y - 0.5f, pos.x + 0.5f, pos.y + 0.5f);
+		}
+
+		math::RectFloat viewRect() const {
+			return math::RectFloat(pos.x - ViewDistance, pos.y - ViewDistance, pos.x + ViewDistance, pos.y + ViewDistance);
+		}
+	};
+
+	static constexpr float ViewDistance = 50.0f;
+	static constexpr float CellSize = 64.0f;
+	std::vector<Entity> _entities;
+	float _mapSize = 0.0f;
+
+	void createEntities(int amount) {
+		const math::Random random(1);
+		_mapSize = glm::sqrt((float)amount) * 20.0f;
+		_entities.resize(amount);
+		for (Entity& e : _entities) {
+			e.pos = glm::vec2(random.randomf(0.0f, _mapSize), random.randomf(0.0f, _mapSize));
+			e.velocity = glm::vec2(random.randomf(-1.0f, 1.0f), random.randomf(-1.0f, 1.0f));
+		}
+	}
+
+	void move() {
+		for (Entity& e : _entities) {
+			e.pos += e.velocity;
+			if (e.pos.x < 0.0f || e.pos.x > _mapSize) {
+				e.velocity.x = -e.velocity.x;
+			}
+			if (e.pos.y < 0.0f || e.pos.y > _mapSize) {
+				e.velocity.y = -e.velocity.y;
+			}
+		}
+	}
+};
+
+BENCHMARK_DEFINE_F(SpatialBenchmark, quadTree) (benchmark::State& state) {
+	createEntities((int)state.range(0));
+	math::QuadTree<Entity*, float> quadTree(math::RectFloat::getMaxRect(), 100);
+	for (Entity& e : _entities) {
+		quadTree.insert(&e);
+	}
+	math::QuadTree<Entity*, float>::Contents contents;
+	size_t visible = 0u;
+	while (state.KeepRunning()) {
+		// the quad tree has no support for moving items - they have to be removed at their old position
+		for (Entity& e : _entities) {
+			quadTree.remove(&e);
+		}
+		move();
+		for (Entity& e : _entities) {
+			quadTree.insert(&e);
+		}
+		for (const Entity& e : _entities) {
+			contents.clear();
+			quadTree.query(e.viewRect(), contents);
+			visible += contents.size();
+		}
+	}
+	benchmark::DoNotOptimize(visible);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(SpatialBenchmark, spatialHashGrid) (benchmark::State& state) {
+	createEntities((int)state.range(0));
+	math::SpatialHashGrid<Entity*, float> grid(CellSize);
+	for (Entity& e : _entities) {
+		grid.insert(&e);
+	}
+	math::SpatialHashGrid<Entity*, float>::Contents contents;
+	size_t visible = 0u;
+	while (state.KeepRunning()) {
+		move();
+		for (Entity& e : _entities) {
+			grid.update(&e);
+		}
+		for (const Entity& e : _entities) {
+			contents.clear();
+			grid.query(e.viewRect(), contents);
+			visible += contents.size();
+		}
+	}
+	benchmark::DoNotOptimize(visible);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief The queries are split into batches that are executed by all cores - like the visibility pass of the map
+ */
+BENCHMARK_DEFINE_F(SpatialBenchmark, spatialHashGridParallel) (benchmark::State& state) {
+	createEntities((int)state.range(0));
+	math::SpatialHashGrid<Entity*, float> grid(CellSize);
+	for (Entity& e : _entities) {
+		grid.insert(&e);
+	}
+	core::ThreadPool threadPool(core_max(1u, core::cpus()), "benchmark");
+	threadPool.init();
+	const int workers = (int)threadPool.size();
+	std::vector<math::SpatialHashGrid<Entity*, float>::Contents> contents(workers);
+	const int amount = (int)_entities.size();
+	const int batchSize = core_max(64, (amount + workers - 1) / workers);
+	const int batches = (amount + batchSize - 1) / batchSize;
+	const int helpers = core_min(workers - 1, batches - 1);
+	core::AtomicInt visible(0);
+	while (state.KeepRunning()) {
+		move();
+		for (Entity& e : _entities) {
+			grid.update(&e);
+		}
+		core::AtomicInt nextBatch(0);
+		auto worker = [&] (int workerIndex) {
+			math::SpatialHashGrid<Entity*, float>::Contents& scratch = contents[workerIndex];
+			for (;;) {
+				const int batch = nextBatch.increment(1);
+				if (batch >= batches) {
+					break;
+				}
+				const int end = core_min(amount, (batch + 1) * batchSize);
+				for (int i = batch * batchSize; i < end; ++i) {
+					scratch.clear();
+					grid.query(_entities[i].viewRect(), scratch);
+					visible.increment((int)scratch.size());
+				}
+			}
+		};
+		std::vector<std::future<void> > results;
+		for (int i = 0; i < helpers; ++i) {
+			results.emplace_back(threadPool.enqueue(worker, i + 1));
+		}
+		worker(0);
+		for (auto& result : results) {
+			result.wait();
+		}
+	}
+	threadPool.shutdown();
+	benchmark::DoNotOptimize(visible);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(SpatialBenchmark, quadTree)->RangeMultiplier(4)->Range(100, 20000);
+BENCHMARK_REGISTER_F(SpatialBenchmark, spatialHashGrid)->RangeMultiplier(4)->Range(100, 20000);
+BENCHMARK_REGISTER_F(SpatialBenchmark, spatialHashGridParallel)->RangeMultiplier(4)->Range(100, 20000)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,137 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "math/SpatialHashGrid.h"
+#include "math/QuadTree.h"
+#include "math/Random.h"
+#include <algorithm>
+
+namespace math {
+
+namespace grid {
+struct Item {
+	RectFloat bounds;
+	int id;
+
+	RectFloat getRect() const {
+		return bounds;
+	}
+
+	bool operator==(const Item& rhs) const {
+		return rhs.id == id;
+	}
+};
+
+struct ItemHash {
+	size_t operator()(const Item& item) const {
+		return std::hash<int>()(item.id);
+	}
+};
+
+typedef SpatialHashGrid<Item*, float, std::hash<Item*> > Grid;
+}
+
+TEST(SpatialHashGridTest, testInsertRemove) {
+	SpatialHashGrid<grid::Item, float, grid::ItemHash> grid(16.0f);
+	const grid::Item item1 { RectFloat(51.0f, 51.0f, 53.0f, 53.0f), 1 };
+	const grid::Item item2 { RectFloat(-15.0f, -15.0f, -13.0f, -13.0f), 2 };
+	EXPECT_TRUE(grid.insert(item1));
+	EXPECT_FALSE(grid.insert(item1)) << "The item is already part of the grid";
+	EXPECT_TRUE(grid.insert(item2));
+	EXPECT_EQ(2, grid.count());
+	EXPECT_TRUE(grid.remove(item1));
+	EXPECT_FALSE(grid.remove(item1));
+	EXPECT_EQ(1, grid.count());
+
+	SpatialHashGrid<grid::Item, float, grid::ItemHash>::Contents contents;
+	grid.query(RectFloat(-20.0f, -20.0f, 60.0f, 60.0f), contents);
+	ASSERT_EQ(1u, contents.size());
+	EXPECT_EQ(2, contents[0].id);
+}
+
+TEST(SpatialHashGridTest, testUpdate) {
+	grid::Item items[3] {
+		{ RectFloat(1.0f, 1.0f, 2.0f, 2.0f), 1 },
+		{ RectFloat(3.0f, 3.0f, 4.0f, 4.0f), 2 },
+		{ RectFloat(5.0f, 5.0f, 6.0f, 6.0f), 3 }
+	};
+	grid::Grid grid(16.0f);
+	for (grid::Item& item : items) {
+		EXPECT_TRUE(grid.insert(&item));
+	}
+	items[1].bounds = RectFloat(5.0f, 1.0f, 6.0f, 2.0f);
+	EXPECT_FALSE(grid.update(&items[1])) << "The item is still in the same cell";
+	// moves the first item of the cell - the last one takes its place
+	items[0].bounds = RectFloat(101.0f, 101.0f, 102.0f, 102.0f);
+	EXPECT_TRUE(grid.update(&items[0]));
+	items[2].bounds = RectFloat(105.0f, 105.0f, 106.0f, 106.0f);
+	EXPECT_TRUE(grid.update(&items[2]));
+
+	grid::Grid::Contents contents;
+	grid.query(RectFloat(0.0f, 0.0f, 10.0f, 10.0f), contents);
+	ASSERT_EQ(1u, contents.size());
+	EXPECT_EQ(&items[1], contents[0]);
+	contents.clear();
+	grid.query(RectFloat(100.0f, 100.0f, 110.0f, 110.0f), contents);
+	EXPECT_EQ(2u, contents.size());
+	EXPECT_TRUE(grid.remove(&items[0]));
+	EXPECT_TRUE(grid.remove(&items[2]));
+	EXPECT_TRUE(grid.remove(&items[1]));
+	EXPECT_EQ(0, grid.count());
+}
+
+TEST(SpatialHashGridTest, testEmptyCellsAreErased) {
+	grid::Item item { RectFloat(1.0f, 1.0f, 2.0f, 2.0f), 1 };
+	grid::Grid grid(16.0f);
+	EXPECT_TRUE(grid.insert(&item));
+	EXPECT_EQ(1, grid.cells());
+	for (int i = 1; i <= 10; ++i) {
+		const float pos = (float)i * 32.0f;
+		item.bounds = RectFloat(pos, pos, pos + 1.0f, pos + 1.0f);
+		EXPECT_TRUE(grid.update(&item));
+		EXPECT_EQ(1, grid.cells()) << "The cell the item left must be erased";
+	}
+	EXPECT_TRUE(grid.remove(&item));
+	EXPECT_EQ(0, grid.cells());
+}
+
+TEST(SpatialHashGridTest, testBigItems) {
+	grid::Grid grid(4.0f);
+	grid::Item big { RectFloat(-50.0f, -50.0f, 50.0f, 50.0f), 1 };
+	EXPECT_TRUE(grid.insert(&big));
+	grid::Grid::Contents contents;
+	grid.query(RectFloat(40.0f, 40.0f, 41.0f, 41.0f), contents);
+	EXPECT_EQ(1u, contents.size()) << "The item intersects the area - but its center is far away";
+}
+
+TEST(SpatialHashGridTest, testSameResultsAsQuadTree) {
+	const Random random(1);
+	std::vector<grid::Item> items(500);
+	grid::Grid grid(32.0f);
+	QuadTree<grid::Item*, float> quadTree(RectFloat::getMaxRect(), 100);
+	for (int i = 0; i < (int)items.size(); ++i) {
+		const float x = random.randomf(-500.0f, 500.0f);
+		const float z = random.randomf(-500.0f, 500.0f);
+		items[i] = grid::Item { RectFloat(x - 0.5f, z - 0.5f, x + 0.5f, z + 0.5f), i };
+		ASSERT_TRUE(grid.insert(&items[i]));
+		ASSERT_TRUE(quadTree.insert(&items[i]));
+	}
+	for (int i = 0; i < 50; ++i) {
+		const float x = random.randomf(-500.0f, 500.0f);
+		const float z = random.randomf(-500.0f, 500.0f);
+		const float size = random.randomf(1.0f, 200.0f);
+		const RectFloat area(x - size, z - size, x + size, z + size);
+		grid::Grid::Contents gridContents;
+		grid.query(area, gridContents);
+		QuadTree<grid::Item*, float>::Contents quadTreeContents;
+		quadTree.query(area, quadTreeContents);
+		std::vector<grid::Item*> expected(quadTreeContents.begin(), quadTreeContents.end());
+		std::sort(gridContents.begin(), gridContents.end());
+		std::sort(expected.begin(), expected.end());
+		EXPECT_EQ(expected, gridContents);
+	}
+}
+
+}
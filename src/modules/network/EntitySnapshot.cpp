@@ -0,0 +1,317 @@
+/**
+ * @file
+ */
+
+#include "EntitySnapshot.h"
+#include "core/Common.h"
+#include <glm/common.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+
+namespace network {
+
+namespace {
+
+enum SnapshotFlags : uint8_t {
+	PosX = 1 << 0,
+	PosY = 1 << 1,
+	PosZ = 1 << 2,
+	Orientation = 1 << 3,
+	AnimationChanged = 1 << 4,
+	All = PosX | PosY | PosZ | Orientation | AnimationChanged
+};
+
+inline uint64_t zigzag(int64_t value) {
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1u);
+}
+
+void writeVarUInt(std::vector<uint8_t>& out, uint64_t value) {
+	while (value >= 0x80u) {
+		out.push_back((uint8_t)(value | 0x80u));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+inline void writeVarInt(std::vector<uint8_t>& out, int64_t value) {
+	writeVarUInt(out, zigzag(value));
+}
+
+class Reader {
+private:
+	const uint8_t* _data;
+	size_t _size;
+	size_t _pos = 0u;
+public:
+	Reader(const uint8_t* data, size_t size) : _data(data), _size(size) {
+	}
+
+	bool readByte(uint8_t& value) {
+		if (_pos >= _size) {
+			return false;
+		}
+		value = _data[_pos++];
+		return true;
+	}
+
+	bool readVarUInt(uint64_t& value) {
+		value = 0u;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t byte;
+			if (!readByte(byte)) {
+				return false;
+			}
+			value |= (uint64_t)(byte & 0x7fu) << shift;
+			if ((byte & 0x80u) == 0u) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool readVarInt(int64_t& value) {
+		uint64_t v;
+		if (!readVarUInt(v)) {
+			return false;
+		}
+		value = unzigzag(v);
+		return true;
+	}
+
+	bool eof() const {
+		return _pos == _size;
+	}
+};
+
+}
+
+const EntitySnapshotState* findEntitySnapshotState(const EntitySnapshotStates* states, int64_t id) {
+	if (states == nullptr) {
+		return nullptr;
+	}
+	auto i = std::lower_bound(states->begin(), states->end(), id, [] (const EntitySnapshotState& state, int64_t id) {
+		return state.id < id;
+	});
+	if (i == states->end() || i->id != id) {
+		return nullptr;
+	}
+	return &*i;
+}
+
+EntitySnapshotState quantizeEntityState(int64_t id, const glm::vec3& pos, float orientation, Animation animation) {
+	EntitySnapshotState state;
+	state.id = id;
+	state.pos = glm::ivec3(glm::round(pos * EntitySnapshotPositionScale));
+	const float turn = glm::two_pi<float>();
+	float normalized = glm::mod(orientation, turn);
+	if (normalized < 0.0f) {
+		normalized += turn;
+	}
+	state.orientation = (uint16_t)((uint32_t)(normalized / turn * 65536.0f + 0.5f) & 0xffffu);
+	state.animation = animation;
+	return state;
+}
+
+glm::vec3 dequantizePosition(const glm::ivec3& pos) {
+	return glm::vec3(pos) / EntitySnapshotPositionScale;
+}
+
+float dequantizeOrientation(uint16_t orientation) {
+	return (float)orientation / 65536.0f * glm::two_pi<float>();
+}
+
+int encodeEntitySnapshot(const EntitySnapshotStates* baseline, const EntitySnapshotStates& target, std::vector<uint8_t>& out) {
+	// the entities that the receiver should forget about
+	std::vector<int64_t> removed;
+	if (baseline != nullptr) {
+		for (const EntitySnapshotState& state : *baseline) {
+			if (findEntitySnapshotState(&target, state.id) == nullptr) {
+				removed.push_back(state.id);
+			}
+		}
+	}
+	writeVarUInt(out, removed.size());
+	int64_t lastId = 0;
+	for (int64_t id : removed) {
+		writeVarInt(out, id - lastId);
+		lastId = id;
+	}
+
+	std::vector<const EntitySnapshotState*> changed;
+	changed.reserve(target.size());
+	for (const EntitySnapshotState& state : target) {
+		const EntitySnapshotState* base = findEntitySnapshotState(baseline, state.id);
+		if (base == nullptr || *base != state) {
+			changed.push_back(&state);
+		}
+	}
+	writeVarUInt(out, changed.size());
+	lastId = 0;
+	for (const EntitySnapshotState* state : changed) {
+		const EntitySnapshotState* base = findEntitySnapshotState(baseline, state->id);
+		const EntitySnapshotState zero;
+		const EntitySnapshotState& from = base == nullptr ? zero : *base;
+		uint8_t flags = 0u;
+		if (base == nullptr) {
+			flags = SnapshotFlags::All;
+		} else {
+			if (state->pos.x != from.pos.x) {
+				flags |= SnapshotFlags::PosX;
+			}
+			if (state->pos.y != from.pos.y) {
+				flags |= SnapshotFlags::PosY;
+			}
+			if (state->pos.z != from.pos.z) {
+				flags |= SnapshotFlags::PosZ;
+			}
+			if (state->orientation != from.orientation) {
+				flags |= SnapshotFlags::Orientation;
+			}
+			if (state->animation != from.animation) {
+				flags |= SnapshotFlags::AnimationChanged;
+			}
+		}
+		writeVarInt(out, state->id - lastId);
+		lastId = state->id;
+		out.push_back(flags);
+		if (flags & SnapshotFlags::PosX) {
+			writeVarInt(out, (int64_t)state->pos.x - from.pos.x);
+		}
+		if (flags & SnapshotFlags::PosY) {
+			writeVarInt(out, (int64_t)state->pos.y - from.pos.y);
+		}
+		if (flags & SnapshotFlags::PosZ) {
+			writeVarInt(out, (int64_t)state->pos.z - from.pos.z);
+		}
+		if (flags & SnapshotFlags::Orientation) {
+			// take the shorter way around the circle
+			writeVarInt(out, (int16_t)(uint16_t)(state->orientation - from.orientation));
+		}
+		if (flags & SnapshotFlags::AnimationChanged) {
+			out.push_back((uint8_t)state->animation);
+		}
+	}
+	return (int)changed.size();
+}
+
+bool decodeEntitySnapshot(const EntitySnapshotStates* baseline, const uint8_t* data, size_t size, EntitySnapshotStates& target, EntitySnapshotStates* changed) {
+	Reader reader(data, size);
+	target.clear();
+	if (baseline != nullptr) {
+		target = *baseline;
+	}
+
+	uint64_t removedCount;
+	if (!reader.readVarUInt(removedCount) || removedCount > target.size()) {
+		return false;
+	}
+	int64_t id = 0;
+	for (uint64_t i = 0u; i < removedCount; ++i) {
+		int64_t delta;
+		if (!reader.readVarInt(delta)) {
+			return false;
+		}
+		id += delta;
+		auto iter = std::lower_bound(target.begin(), target.end(), id, [] (const EntitySnapshotState& state, int64_t id) {
+			return state.id < id;
+		});
+		if (iter == target.end() || iter->id != id) {
+			return false;
+		}
+		target.erase(iter);
+	}
+
+	uint64_t changedCount;
+	if (!reader.readVarUInt(changedCount) || changedCount > size) {
+		return false;
+	}
+	id = 0;
+	for (uint64_t i = 0u; i < changedCount; ++i) {
+		int64_t delta;
+		uint8_t flags;
+		if (!reader.readVarInt(delta) || !reader.readByte(flags)) {
+			return false;
+		}
+		id += delta;
+		auto iter = std::lower_bound(target.begin(), target.end(), id, [] (const EntitySnapshotState& state, int64_t id) {
+			return state.id < id;
+		});
+		if (iter == target.end() || iter->id != id) {
+			if (flags != SnapshotFlags::All) {
+				// the baseline doesn't know this entity - the full state is needed
+				return false;
+			}
+			EntitySnapshotState state;
+			state.id = id;
+			iter = target.insert(iter, state);
+		}
+		EntitySnapshotState& state = *iter;
+		int64_t value;
+		if (flags & SnapshotFlags::PosX) {
+			if (!reader.readVarInt(value)) {
+				return false;
+			}
+			state.pos.x += (int32_t)value;
+		}
+		if (flags & SnapshotFlags::PosY) {
+			if (!reader.readVarInt(value)) {
+				return false;
+			}
+			state.pos.y += (int32_t)value;
+		}
+		if (flags & SnapshotFlags::PosZ) {
+			if (!reader.readVarInt(value)) {
+				return false;
+			}
+			state.pos.z += (int32_t)value;
+		}
+		if (flags & SnapshotFlags::Orientation) {
+			if (!reader.readVarInt(value)) {
+				return false;
+			}
+			state.orientation = (uint16_t)(state.orientation + (int16_t)value);
+		}
+		if (flags & SnapshotFlags::AnimationChanged) {
+			uint8_t animation;
+			if (!reader.readByte(animation) || animation > (uint8_t)Animation::MAX) {
+				return false;
+			}
+			state.animation = (Animation)animation;
+		}
+		if (changed != nullptr) {
+			changed->push_back(state);
+		}
+	}
+	return reader.eof();
+}
+
+EntitySnapshotStates& EntitySnapshotHistory::add(uint32_t sequence) {
+	Snapshot& snapshot = _snapshots[sequence % Size];
+	snapshot.sequence = sequence;
+	snapshot.states.clear();
+	return snapshot.states;
+}
+
+const EntitySnapshotStates* EntitySnapshotHistory::get(uint32_t sequence) const {
+	if (sequence == 0u) {
+		return nullptr;
+	}
+	const Snapshot& snapshot = _snapshots[sequence % Size];
+	if (snapshot.sequence != sequence) {
+		return nullptr;
+	}
+	return &snapshot.states;
+}
+
+void EntitySnapshotHistory::clear() {
+	for (uint32_t i = 0u; i < Size; ++i) {
+		_snapshots[i].sequence = 0u;
+		_snapshots[i].states.clear();
+	}
+}
+
+}
@@ -0,0 +1,101 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "Shared_generated.h"
+#include <glm/vec3.hpp>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace network {
+
+/**
+ * @brief The quantized state of an entity as it is known by the client
+ *
+ * The position is stored in fixed point with @c EntitySnapshotPositionScale steps per voxel, the
+ * orientation uses the full 16 bit range for one turn.
+ */
+struct EntitySnapshotState {
+	int64_t id = 0;
+	glm::ivec3 pos { 0 };
+	uint16_t orientation = 0u;
+	Animation animation = Animation::IDLE;
+
+	inline bool operator==(const EntitySnapshotState& other) const {
+		return id == other.id && pos == other.pos && orientation == other.orientation && animation == other.animation;
+	}
+
+	inline bool operator!=(const EntitySnapshotState& other) const {
+		return !(*this == other);
+	}
+};
+
+/**
+ * @brief The states of all entities of a snapshot - sorted by id
+ */
+using EntitySnapshotStates = std::vector<EntitySnapshotState>;
+
+constexpr float EntitySnapshotPositionScale = 16.0f;
+
+EntitySnapshotState quantizeEntityState(int64_t id, const glm::vec3& pos, float orientation, Animation animation);
+glm::vec3 dequantizePosition(const glm::ivec3& pos);
+float dequantizeOrientation(uint16_t orientation);
+
+/**
+ * @return The state with the given id - or @c nullptr if the states are @c nullptr or don't contain the id
+ */
+const EntitySnapshotState* findEntitySnapshotState(const EntitySnapshotStates* states, int64_t id);
+
+/**
+ * @brief Encodes the difference between the baseline and the target states
+ *
+ * Only the entities that are not part of the baseline or whose state differs from the baseline are
+ * written - and only the changed components of them. The ids of the entities that are part of the
+ * baseline but not of the target are written as removed.
+ *
+ * @param[in] baseline The states the receiver already acknowledged - or @c nullptr to encode the full target
+ * @param[in] target The states the receiver should know after decoding the data
+ * @param[out] out The encoded data is appended here
+ * @return The amount of entities that were written (not counting the removed ones)
+ */
+int encodeEntitySnapshot(const EntitySnapshotStates* baseline, const EntitySnapshotStates& target, std::vector<uint8_t>& out);
+
+/**
+ * @brief Applies the data that was encoded by @c encodeEntitySnapshot() to the given baseline
+ * @param[in] baseline Must be the same baseline that was used to encode the data
+ * @param[out] target The states of the snapshot
+ * @param[out] changed Optional list of the states that were part of the data
+ * @return @c false if the data is invalid
+ */
+bool decodeEntitySnapshot(const EntitySnapshotStates* baseline, const uint8_t* data, size_t size, EntitySnapshotStates& target, EntitySnapshotStates* changed = nullptr);
+
+/**
+ * @brief Ring buffer of the last snapshots that were sent or received - they can be used as baseline
+ * as soon as the receiver acknowledged them.
+ */
+class EntitySnapshotHistory {
+public:
+	static constexpr uint32_t Size = 32u;
+private:
+	struct Snapshot {
+		// 0 is never used as sequence number
+		uint32_t sequence = 0u;
+		EntitySnapshotStates states;
+	};
+	Snapshot _snapshots[Size];
+public:
+	/**
+	 * @return The states for the given sequence number - this overrides the oldest snapshot
+	 */
+	EntitySnapshotStates& add(uint32_t sequence);
+	/**
+	 * @return @c nullptr if the snapshot is no longer (or was never) part of the history
+	 */
+	const EntitySnapshotStates* get(uint32_t sequence) const;
+	void clear();
+};
+
+}
@@ -14,9 +14,9 @@ ENetPacket* ServerMessageSender::createServerPacket(ServerMsgType type, const vo
 	ENetPacket* packet = enet_packet_create(data, dataLength, flags);
 	const char *msgType = EnumNameServerMsgType(type);
 	Log::trace(logid, "Create server package: %s - size %u", msgType, (unsigned int)dataLength);
-	const metric::TagMap& tags {{"direction", "out"}, {"type", msgType}};
-	_metric->count("network_packet_count", 1, tags);
-	_metric->count("network_packet_size", (int)dataLength, tags);
+	const PacketMetrics& metrics = _packetMetrics[(int)type];
+	_metric->record(metrics.count, 1);
+	_metric->record(metrics.size, (int)dataLength);
 	return packet;
 }
 
@@ -28,6 +28,16 @@ ENetPacket* ServerMessageSender::createServerPacket(FlatBufferBuilder& fbb, Serv
 
 ServerMessageSender::ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric) :
 		_network(network), _metric(metric) {
+	for (ServerMsgType type : EnumValuesServerMsgType()) {
+		const char *msgType = EnumNameServerMsgType(type);
+		const metric::TagMap& tags {{"direction", "out"}, {"type", msgType}};
+		PacketMetrics& metrics = _packetMetrics[(int)type];
+		metrics.count = _metric->registerMetric("network_packet_count", metric::MetricType::Count, tags);
+		metrics.size = _metric->registerMetric("network_packet_size", metric::MetricType::Count, tags);
+		metrics.sent = _metric->registerMetric("network_sent", metric::MetricType::Count, tags);
+		metrics.notSent = _metric->registerMetric("network_not_sent", metric::MetricType::Count, tags);
+		metrics.broadcast = _metric->registerMetric("network_sent", metric::MetricType::Count, {{"direction", "broadcast"}, {"type", msgType}});
+	}
 }
 
 bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
@@ -36,25 +46,30 @@ bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& f
 }
 
 bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
+	auto packet = createServerPacket(fbb, type, data, flags);
+	const bool success = sendServerPacket(peers, numPeers, packet, type);
+	fbb.Clear();
+	return success;
+}
+
+bool ServerMessageSender::sendServerPacket(ENetPeer** peers, int numPeers, ENetPacket* packet, ServerMsgType type) {
 	const char *msgType = network::EnumNameServerMsgType(type);
 	Log::debug(logid, "Send %s to %i peers", msgType, numPeers);
 	core_assert(numPeers > 0);
 	int sent = 0;
-	auto packet = createServerPacket(fbb, type, data, flags);
-	const metric::TagMap& tags {{"direction", "out"}, {"type", msgType}};
+	const PacketMetrics& metrics = _packetMetrics[(int)type];
 	{
 		// TODO: lock
 		for (int i = 0; i < numPeers; ++i) {
 			if (!_network->sendMessage(peers[i], packet)) {
-				_metric->count("network_not_sent", 1, tags);
+				_metric->record(metrics.notSent, 1);
 				Log::trace(logid, "Could not send message of type %s to peer %i", msgType, i);
 			} else {
-				_metric->count("network_sent", 1, tags);
+				_metric->record(metrics.sent, 1);
 				++sent;
 			}
 		}
 	}
-	fbb.Clear();
 	return sent == numPeers;
 }
 
@@ -65,8 +80,7 @@ bool ServerMessageSender::broadcastServerMessage(FlatBufferBuilder& fbb, ServerM
 	{
 		// TODO: lock
 		success = _network->broadcast(createServerPacket(fbb, type, data, flags), channel);
-		const metric::TagMap& tags {{"direction", "broadcast"}, {"type", msgType}};
-		_metric->count("network_sent", 1, tags);
+		_metric->record(_packetMetrics[(int)type].broadcast, 1);
 	}
 	fbb.Clear();
 	return success;
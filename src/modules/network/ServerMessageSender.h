@@ -22,12 +22,25 @@ private:
 	static constexpr auto logid = Log::logid("ServerMessageSender");
 	ServerNetworkPtr _network;
 	metric::MetricPtr _metric;
+	struct PacketMetrics {
+		metric::MetricHandle count = metric::InvalidMetricHandle;
+		metric::MetricHandle size = metric::InvalidMetricHandle;
+		metric::MetricHandle sent = metric::InvalidMetricHandle;
+		metric::MetricHandle notSent = metric::InvalidMetricHandle;
+		metric::MetricHandle broadcast = metric::InvalidMetricHandle;
+	};
+	// the metrics are registered once per message type - they are recorded for every packet and peer
+	PacketMetrics _packetMetrics[(int)ServerMsgType::MAX + 1];
 
 public:
 	ENetPacket* createServerPacket(ServerMsgType type, const void * data, size_t dataLength, uint32_t flags);
 	ENetPacket* createServerPacket(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags);
 	ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric);
 
+	/**
+	 * @brief Sends a packet that was created by @c createServerPacket() to the given peers
+	 */
+	bool sendServerPacket(ENetPeer** peers, int numPeers, ENetPacket* packet, ServerMsgType type);
 	bool sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
 	bool sendServerMessage(std::vector<ENetPeer*> peers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
 	bool sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
@@ -12,6 +12,12 @@ namespace network {
 ServerNetwork::ServerNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRegistry,
 		const core::EventBusPtr& eventBus, const metric::MetricPtr& metric) :
 		Super(protocolHandlerRegistry, eventBus), _metric(metric) {
+	for (ClientMsgType type : EnumValuesClientMsgType()) {
+		const metric::TagMap& tags {{"direction", "in"}, {"type", EnumNameClientMsgType(type)}};
+		PacketMetrics& metrics = _packetMetrics[(int)type];
+		metrics.count = _metric->registerMetric("network_packet_count", metric::MetricType::Count, tags);
+		metrics.size = _metric->registerMetric("network_packet_size", metric::MetricType::Count, tags);
+	}
 }
 
 bool ServerNetwork::packetReceived(ENetEvent& event) {
@@ -29,9 +35,9 @@ bool ServerNetwork::packetReceived(ENetEvent& event) {
 		Log::error("No handler for client msg type %s", clientMsgType);
 		return false;
 	}
-	const metric::TagMap& tags  {{"direction", "in"}, {"type", clientMsgType}};
-	_metric->count("network_packet_count", 1, tags);
-	_metric->count("network_packet_size", (int)event.packet->dataLength, tags);
+	const PacketMetrics& metrics = _packetMetrics[(int)type];
+	_metric->record(metrics.count, 1);
+	_metric->record(metrics.size, (int)event.packet->dataLength);
 
 	Log::debug("Received %s", clientMsgType);
 	handler->execute(event.peer, reinterpret_cast<const flatbuffers::Table*>(req->data()));
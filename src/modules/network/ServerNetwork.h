@@ -5,6 +5,7 @@
 #pragma once
 
 #include "Network.h"
+#include "ClientMessages_generated.h"
 #include "core/metric/Metric.h"
 
 namespace network {
@@ -13,6 +14,12 @@ class ServerNetwork : public Network {
 private:
 	ENetHost* _server = nullptr;
 	metric::MetricPtr _metric;
+	struct PacketMetrics {
+		metric::MetricHandle count = metric::InvalidMetricHandle;
+		metric::MetricHandle size = metric::InvalidMetricHandle;
+	};
+	// the metrics are registered once per message type - they are recorded for every packet
+	PacketMetrics _packetMetrics[(int)ClientMsgType::MAX + 1];
 	using Super = Network;
 public:
 	ServerNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRegistry,
@@ -0,0 +1,117 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "network/EntitySnapshot.h"
+#include <glm/gtc/constants.hpp>
+
+namespace network {
+
+class EntitySnapshotTest: public core::AbstractTest {
+protected:
+	EntitySnapshotStates createStates(int amount) const {
+		EntitySnapshotStates states;
+		for (int i = 0; i < amount; ++i) {
+			states.push_back(quantizeEntityState(i * 3 + 1, glm::vec3((float)i, 64.0f, (float)-i), 0.0f, Animation::IDLE));
+		}
+		return states;
+	}
+};
+
+TEST_F(EntitySnapshotTest, testFull) {
+	const EntitySnapshotStates& states = createStates(10);
+	std::vector<uint8_t> data;
+	EXPECT_EQ(10, encodeEntitySnapshot(nullptr, states, data));
+	EntitySnapshotStates decoded;
+	ASSERT_TRUE(decodeEntitySnapshot(nullptr, data.data(), data.size(), decoded));
+	EXPECT_EQ(states, decoded);
+}
+
+TEST_F(EntitySnapshotTest, testDelta) {
+	const EntitySnapshotStates& baseline = createStates(10);
+	EntitySnapshotStates target = baseline;
+	target[2].pos.x += 3;
+	target[5].orientation = 65535u;
+	target[7].animation = Animation::TOOL;
+
+	std::vector<uint8_t> full;
+	encodeEntitySnapshot(nullptr, target, full);
+	std::vector<uint8_t> data;
+	EXPECT_EQ(3, encodeEntitySnapshot(&baseline, target, data));
+	EXPECT_LT(data.size(), full.size() / 4);
+
+	EntitySnapshotStates decoded;
+	EntitySnapshotStates changed;
+	ASSERT_TRUE(decodeEntitySnapshot(&baseline, data.data(), data.size(), decoded, &changed));
+	EXPECT_EQ(target, decoded);
+	ASSERT_EQ(3u, changed.size());
+	EXPECT_EQ(target[2], changed[0]);
+	EXPECT_EQ(target[5], changed[1]);
+	EXPECT_EQ(target[7], changed[2]);
+}
+
+TEST_F(EntitySnapshotTest, testAddAndRemove) {
+	const EntitySnapshotStates& baseline = createStates(10);
+	EntitySnapshotStates target = baseline;
+	target.erase(target.begin() + 4);
+	target.erase(target.begin());
+	target.push_back(quantizeEntityState(1000, glm::vec3(1.0f), 1.0f, Animation::SWIM));
+
+	std::vector<uint8_t> data;
+	EXPECT_EQ(1, encodeEntitySnapshot(&baseline, target, data));
+	EntitySnapshotStates decoded;
+	ASSERT_TRUE(decodeEntitySnapshot(&baseline, data.data(), data.size(), decoded));
+	EXPECT_EQ(target, decoded);
+
+	EXPECT_FALSE(decodeEntitySnapshot(nullptr, data.data(), data.size(), decoded)) << "The removed entities are not part of the baseline";
+	EXPECT_FALSE(decodeEntitySnapshot(&baseline, data.data(), data.size() - 1, decoded)) << "The data is truncated";
+}
+
+TEST_F(EntitySnapshotTest, testUnchanged) {
+	const EntitySnapshotStates& baseline = createStates(10);
+	std::vector<uint8_t> data;
+	EXPECT_EQ(0, encodeEntitySnapshot(&baseline, baseline, data));
+	EXPECT_EQ(2u, data.size());
+}
+
+TEST_F(EntitySnapshotTest, testQuantize) {
+	const glm::vec3 pos(10.3f, -64.0f, 1024.77f);
+	const EntitySnapshotState& state = quantizeEntityState(1, pos, glm::pi<float>(), Animation::IDLE);
+	const glm::vec3& dequantized = dequantizePosition(state.pos);
+	EXPECT_NEAR(pos.x, dequantized.x, 0.5f / EntitySnapshotPositionScale);
+	EXPECT_NEAR(pos.y, dequantized.y, 0.5f / EntitySnapshotPositionScale);
+	EXPECT_NEAR(pos.z, dequantized.z, 0.5f / EntitySnapshotPositionScale);
+	EXPECT_EQ(32768u, state.orientation);
+	EXPECT_NEAR(glm::pi<float>(), dequantizeOrientation(state.orientation), 0.001f);
+	EXPECT_EQ(quantizeEntityState(1, pos, -glm::pi<float>(), Animation::IDLE).orientation, state.orientation);
+	EXPECT_EQ(0u, quantizeEntityState(1, pos, glm::two_pi<float>(), Animation::IDLE).orientation);
+}
+
+TEST_F(EntitySnapshotTest, testOrientationWrap) {
+	EntitySnapshotStates baseline { quantizeEntityState(1, glm::vec3(0.0f), -0.001f, Animation::IDLE) };
+	EntitySnapshotStates target { quantizeEntityState(1, glm::vec3(0.0f), 0.001f, Animation::IDLE) };
+	std::vector<uint8_t> data;
+	encodeEntitySnapshot(&baseline, target, data);
+	// count, count, id, flags and a one byte orientation delta
+	EXPECT_EQ(5u, data.size()) << "The orientation delta should take the short way over the wrap";
+	EntitySnapshotStates decoded;
+	ASSERT_TRUE(decodeEntitySnapshot(&baseline, data.data(), data.size(), decoded));
+	EXPECT_EQ(target, decoded);
+}
+
+TEST_F(EntitySnapshotTest, testHistory) {
+	EntitySnapshotHistory history;
+	EXPECT_EQ(nullptr, history.get(0u));
+	EXPECT_EQ(nullptr, history.get(1u));
+	history.add(1u) = createStates(1);
+	ASSERT_NE(nullptr, history.get(1u));
+	EXPECT_EQ(1u, history.get(1u)->size());
+	history.add(1u + EntitySnapshotHistory::Size);
+	EXPECT_EQ(nullptr, history.get(1u)) << "The oldest snapshot should have been replaced";
+	EXPECT_NE(nullptr, history.get(1u + EntitySnapshotHistory::Size));
+	history.clear();
+	EXPECT_EQ(nullptr, history.get(1u + EntitySnapshotHistory::Size));
+}
+
+}
@@ -14,6 +14,8 @@
 #include <glm/gtc/noise.hpp>
 #include <limits>
 #include "Simplex.h"
+#include "SimplexBatch.h"
+#include <SDL_cpuinfo.h>
 
 #define GLM_NOISE 0
 #define CINDER_NOISE 1
@@ -21,7 +23,7 @@
 namespace noise {
 
 Noise::Noise() :
-		_shader(compute::NoiseShader::getInstance()) {
+		_shader(compute::NoiseShader::getInstance()), _batchKernel(bestBatchKernel()) {
 }
 
 Noise::~Noise() {
@@ -52,6 +54,84 @@ bool Noise::useShader(bool enableShader) {
 	return true;
 }
 
+static bool isBatchKernelSupported(BatchKernel kernel) {
+	// a row without any positions is only checking whether the kernel was compiled in
+	const FBmRow empty {};
+	switch (kernel) {
+	case BatchKernel::AVX2:
+		return SDL_HasAVX2() && fBmRow2AVX2(empty);
+	case BatchKernel::SSE41:
+		return SDL_HasSSE41() && fBmRow2SSE41(empty);
+	case BatchKernel::Scalar:
+		return true;
+	default:
+		return false;
+	}
+}
+
+BatchKernel Noise::bestBatchKernel() {
+	static const BatchKernel kernel = [] () {
+		if (isBatchKernelSupported(BatchKernel::AVX2)) {
+			return BatchKernel::AVX2;
+		}
+		if (isBatchKernelSupported(BatchKernel::SSE41)) {
+			return BatchKernel::SSE41;
+		}
+		return BatchKernel::Scalar;
+	}();
+	return kernel;
+}
+
+bool Noise::setBatchKernel(BatchKernel kernel) {
+	if (!isBatchKernelSupported(kernel)) {
+		return false;
+	}
+	_batchKernel = kernel;
+	return true;
+}
+
+/**
+ * @brief The permutation table of the simplex noise widened to 32 bit values for the vector gathers
+ */
+static const int32_t* batchPermutationTable() {
+	static const struct Table {
+		int32_t perm[512];
+		Table() {
+			for (int i = 0; i < 512; ++i) {
+				perm[i] = details::perm[i];
+			}
+		}
+	} table;
+	return table.perm;
+}
+
+template<int DIMENSIONS>
+static void fBmRowKernel(BatchKernel kernel, const FBmRow& row) {
+	if constexpr (DIMENSIONS == 2) {
+		if ((kernel == BatchKernel::AVX2 && fBmRow2AVX2(row)) || (kernel == BatchKernel::SSE41 && fBmRow2SSE41(row))) {
+			return;
+		}
+		fBmRow2Scalar(row);
+	} else {
+		if ((kernel == BatchKernel::AVX2 && fBmRow3AVX2(row)) || (kernel == BatchKernel::SSE41 && fBmRow3SSE41(row))) {
+			return;
+		}
+		fBmRow3Scalar(row);
+	}
+}
+
+void Noise::fBmRow(float* out, int amount, const glm::vec2& offset, const glm::vec2& start, const glm::vec2& step, float frequency, uint8_t octaves, float lacunarity, float gain) const {
+	core_trace_scoped(NoiseFBmRow2);
+	const FBmRow row { batchPermutationTable(), {offset.x, offset.y, 0.0f}, {start.x, start.y, 0.0f}, {step.x, step.y, 0.0f}, frequency, amount, out, octaves, lacunarity, gain };
+	fBmRowKernel<2>(_batchKernel, row);
+}
+
+void Noise::fBmRow(float* out, int amount, const glm::vec3& offset, const glm::vec3& start, const glm::vec3& step, float frequency, uint8_t octaves, float lacunarity, float gain) const {
+	core_trace_scoped(NoiseFBmRow3);
+	const FBmRow row { batchPermutationTable(), {offset.x, offset.y, offset.z}, {start.x, start.y, start.z}, {step.x, step.y, step.z}, frequency, amount, out, octaves, lacunarity, gain };
+	fBmRowKernel<3>(_batchKernel, row);
+}
+
 int32_t Noise::intValueNoise(const glm::ivec3& pos, int32_t seed) const {
 	constexpr int32_t xgen = 1619;
 	constexpr int32_t ygen = 31337;
@@ -14,6 +14,18 @@ class NoiseShader;
 
 namespace noise {
 
+/**
+ * @brief The instruction set that is used for the batched noise functions
+ * @sa Noise::fBmRow()
+ */
+enum class BatchKernel : uint8_t {
+	Scalar,
+	SSE41,
+	AVX2,
+
+	Max
+};
+
 /**
  * @brief Normalizes a noise value in the range [-1,-1] to [0,1]
  */
@@ -39,6 +51,7 @@ private:
 	compute::NoiseShader& _shader;
 	bool _useShader = false;
 	bool _enableShader = true;
+	BatchKernel _batchKernel;
 public:
 	Noise();
 	~Noise();
@@ -53,6 +66,33 @@ public:
 	bool init() override;
 	void shutdown() override;
 
+	/**
+	 * @return The best kernel for the batched noise functions that the cpu supports
+	 */
+	static BatchKernel bestBatchKernel();
+	/**
+	 * @return @c false if the given kernel is not supported by the cpu - the current kernel is kept in this case
+	 */
+	bool setBatchKernel(BatchKernel kernel);
+	BatchKernel batchKernel() const;
+
+	/**
+	 * @brief Batched version of noise::fBm() for @c amount 2d positions that start at @c start and are advancing
+	 * by @c step - e.g. a row of columns of a chunk. The offset is added to every position - the positions are
+	 * @code (offset + (start + step * i)) * frequency @endcode
+	 * @param[out] out Must be able to hold @c amount values
+	 * @note The results are bit-identical to noise::fBm() for those positions on every instruction set. Keep the
+	 * integral world coordinates in @c start and @c step and the float seed offset in @c offset - adding the
+	 * offset to @c start first would round differently.
+	 */
+	void fBmRow(float* out, int amount, const glm::vec2& offset, const glm::vec2& start, const glm::vec2& step, float frequency = 1.0f, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f) const;
+	/**
+	 * @brief Batched version of noise::fBm() for @c amount 3d positions that start at @c start and are advancing
+	 * by @c step - e.g. all voxels of a column.
+	 * @sa fBmRow()
+	 */
+	void fBmRow(float* out, int amount, const glm::vec3& offset, const glm::vec3& start, const glm::vec3& step, float frequency = 1.0f, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f) const;
+
 	/**
 	 * @brief Fills the given target buffer with RGB values for the noise.
 	 * @param[in] buffer pointer to the target buffer - must be of size @c width * height * 3
@@ -104,4 +144,8 @@ inline bool Noise::canUseShader() const {
 	return _useShader && _enableShader;
 }
 
+inline BatchKernel Noise::batchKernel() const {
+	return _batchKernel;
+}
+
 }
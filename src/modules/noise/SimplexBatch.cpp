@@ -0,0 +1,64 @@
+/**
+ * @file
+ */
+
+#include "SimplexBatch.h"
+
+namespace noise {
+
+namespace {
+
+/**
+ * @brief Single lane traits for the batched simplex noise kernels - this is the fallback for cpus without
+ * the supported vector extensions.
+ */
+struct Scalar {
+	static constexpr int Width = 1;
+	using F = float;
+	using I = int32_t;
+	using M = bool;
+
+	static inline F set1(float v) { return v; }
+	static inline I seti(int32_t v) { return v; }
+	static inline F iota() { return 0.0f; }
+	static inline void store(float* out, F v) { *out = v; }
+
+	static inline F add(F a, F b) { return a + b; }
+	static inline F sub(F a, F b) { return a - b; }
+	static inline F mul(F a, F b) { return a * b; }
+	static inline F mulD(F a, double b) { return (float)((double)a * b); }
+	static inline F addD(F a, double b) { return (float)((double)a + b); }
+	static inline I addi(I a, I b) { return a + b; }
+	static inline I subi(I a, I b) { return a - b; }
+	static inline I andi(I a, I b) { return a & b; }
+	static inline F cvt(I v) { return (float)v; }
+	static inline I cvtt(F v) { return (int32_t)v; }
+
+	static inline M cmpgt(F a, F b) { return a > b; }
+	static inline M cmpge(F a, F b) { return a >= b; }
+	static inline M cmplt(F a, F b) { return a < b; }
+	static inline M cmple(F a, F b) { return a <= b; }
+	static inline M icmplt(I a, I b) { return a < b; }
+	static inline M icmpeq(I a, I b) { return a == b; }
+	static inline M mand(M a, M b) { return a && b; }
+	static inline M mor(M a, M b) { return a || b; }
+	static inline M mnot(M a) { return !a; }
+	static inline I maskToInt(M m) { return m ? -1 : 0; }
+	static inline I maskToOne(M m) { return m ? 1 : 0; }
+
+	static inline F select(M m, F a, F b) { return m ? a : b; }
+	static inline F negateIf(F v, M m) { return m ? -v : v; }
+	static inline I gather(const int32_t* table, I idx) { return table[idx]; }
+};
+
+}
+
+void fBmRow2Scalar(const FBmRow& row) {
+	batch::fBmRow<Scalar, 2>(row);
+}
+
+void fBmRow3Scalar(const FBmRow& row) {
+	batch::fBmRow<Scalar, 3>(row);
+}
+
+}
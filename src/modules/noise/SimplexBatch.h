@@ -0,0 +1,238 @@
+/**
+ * @file
+ *
+ * Batched fBm simplex noise kernels. The kernels are written once against a small set of vector
+ * operations (see the traits in SimplexBatch.cpp, SimplexBatchSSE41.cpp and SimplexBatchAVX2.cpp) and are
+ * compiled for the different instruction sets in their own translation units.
+ *
+ * @note This header must stay free of other includes - it's compiled with instruction set specific
+ * compiler flags and any inline function of other headers might end up in the final binary with those
+ * instructions.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace noise {
+
+/**
+ * @brief The kernels are evaluating the fBm for @c amount positions that start at @c start and are
+ * advancing by @c step. The offset is added after the step was applied - @code offset + (start + step * i) @endcode
+ * - this gives the same float positions as adding the offset to the integral world coordinates. The positions are
+ * scaled by the frequency. All kernels give the same results as the scalar noise::fBm() for those positions - the
+ * lanes are computed independently from each other.
+ */
+struct FBmRow {
+	/** the simplex permutation table widened to 32 bit - 512 entries */
+	const int32_t* perm;
+	float offset[3];
+	float start[3];
+	float step[3];
+	float frequency;
+	int amount;
+	float* out;
+	int octaves;
+	float lacunarity;
+	float gain;
+};
+
+void fBmRow2Scalar(const FBmRow& row);
+void fBmRow3Scalar(const FBmRow& row);
+/**
+ * @return @c false if the kernel wasn't compiled in
+ */
+bool fBmRow2SSE41(const FBmRow& row);
+bool fBmRow3SSE41(const FBmRow& row);
+bool fBmRow2AVX2(const FBmRow& row);
+bool fBmRow3AVX2(const FBmRow& row);
+
+namespace batch {
+
+/**
+ * @brief Skewing factors - they must match the ones of the scalar simplex noise in Simplex.h
+ * @note The skewing and the corner offsets are computed in double precision like in the scalar noise,
+ * where the macros are promoting the float expressions - otherwise the results would differ in the last bits.
+ */
+constexpr double F2 = 0.366025403;
+constexpr double G2 = 0.211324865;
+constexpr double F3 = 0.333333333;
+constexpr double G3 = 0.166666667;
+
+/**
+ * @brief Mirrors the FASTFLOOR macro of Simplex.h - that is also subtracting one for negative integral values
+ */
+template<class V>
+inline typename V::I fastFloor(typename V::F v) {
+	return V::addi(V::cvtt(v), V::maskToInt(V::cmple(v, V::set1(0.0f))));
+}
+
+template<class V>
+inline typename V::F grad2(typename V::I hash, typename V::F x, typename V::F y) {
+	const typename V::I h = V::andi(hash, V::seti(7));
+	const typename V::M low = V::icmplt(h, V::seti(4));
+	const typename V::F u = V::select(low, x, y);
+	const typename V::F v = V::select(low, y, x);
+	const typename V::F su = V::negateIf(u, V::icmpeq(V::andi(h, V::seti(1)), V::seti(1)));
+	const typename V::F v2 = V::mul(V::set1(2.0f), v);
+	const typename V::F sv = V::negateIf(v2, V::icmpeq(V::andi(h, V::seti(2)), V::seti(2)));
+	return V::add(su, sv);
+}
+
+template<class V>
+inline typename V::F grad3(typename V::I hash, typename V::F x, typename V::F y, typename V::F z) {
+	const typename V::I h = V::andi(hash, V::seti(15));
+	const typename V::F u = V::select(V::icmplt(h, V::seti(8)), x, y);
+	const typename V::M xForV = V::mor(V::icmpeq(h, V::seti(12)), V::icmpeq(h, V::seti(14)));
+	const typename V::F v = V::select(V::icmplt(h, V::seti(4)), y, V::select(xForV, x, z));
+	const typename V::F su = V::negateIf(u, V::icmpeq(V::andi(h, V::seti(1)), V::seti(1)));
+	const typename V::F sv = V::negateIf(v, V::icmpeq(V::andi(h, V::seti(2)), V::seti(2)));
+	return V::add(su, sv);
+}
+
+/**
+ * @brief The contribution of one simplex corner
+ */
+template<class V>
+inline typename V::F corner(typename V::F t, typename V::F grad) {
+	const typename V::F tt = V::mul(t, t);
+	const typename V::F n = V::mul(V::mul(tt, tt), grad);
+	return V::select(V::cmplt(t, V::set1(0.0f)), V::set1(0.0f), n);
+}
+
+template<class V>
+inline typename V::I perm(const int32_t* table, typename V::I idx) {
+	return V::gather(table, idx);
+}
+
+template<class V>
+typename V::F simplex2(const int32_t* table, typename V::F x, typename V::F y) {
+	using F = typename V::F;
+	using I = typename V::I;
+	const F s = V::mulD(V::add(x, y), F2);
+	const I i = fastFloor<V>(V::add(x, s));
+	const I j = fastFloor<V>(V::add(y, s));
+	const F t = V::mulD(V::cvt(V::addi(i, j)), G2);
+	const F x0 = V::sub(x, V::sub(V::cvt(i), t));
+	const F y0 = V::sub(y, V::sub(V::cvt(j), t));
+
+	const typename V::M lower = V::cmpgt(x0, y0);
+	const I i1 = V::maskToOne(lower);
+	const I j1 = V::subi(V::seti(1), i1);
+
+	const F x1 = V::addD(V::sub(x0, V::cvt(i1)), G2);
+	const F y1 = V::addD(V::sub(y0, V::cvt(j1)), G2);
+	const F x2 = V::addD(V::sub(x0, V::set1(1.0f)), 2.0 * G2);
+	const F y2 = V::addD(V::sub(y0, V::set1(1.0f)), 2.0 * G2);
+
+	const I ii = V::andi(i, V::seti(0xff));
+	const I jj = V::andi(j, V::seti(0xff));
+	const I one = V::seti(1);
+	const I gi0 = perm<V>(table, V::addi(ii, perm<V>(table, jj)));
+	const I gi1 = perm<V>(table, V::addi(V::addi(ii, i1), perm<V>(table, V::addi(jj, j1))));
+	const I gi2 = perm<V>(table, V::addi(V::addi(ii, one), perm<V>(table, V::addi(jj, one))));
+
+	const F half = V::set1(0.5f);
+	const F n0 = corner<V>(V::sub(V::sub(half, V::mul(x0, x0)), V::mul(y0, y0)), grad2<V>(gi0, x0, y0));
+	const F n1 = corner<V>(V::sub(V::sub(half, V::mul(x1, x1)), V::mul(y1, y1)), grad2<V>(gi1, x1, y1));
+	const F n2 = corner<V>(V::sub(V::sub(half, V::mul(x2, x2)), V::mul(y2, y2)), grad2<V>(gi2, x2, y2));
+	return V::mul(V::set1(40.0f), V::add(V::add(n0, n1), n2));
+}
+
+template<class V>
+typename V::F simplex3(const int32_t* table, typename V::F x, typename V::F y, typename V::F z) {
+	using F = typename V::F;
+	using I = typename V::I;
+	using M = typename V::M;
+	const F s = V::mulD(V::add(V::add(x, y), z), F3);
+	const I i = fastFloor<V>(V::add(x, s));
+	const I j = fastFloor<V>(V::add(y, s));
+	const I k = fastFloor<V>(V::add(z, s));
+	const F t = V::mulD(V::cvt(V::addi(V::addi(i, j), k)), G3);
+	const F x0 = V::sub(x, V::sub(V::cvt(i), t));
+	const F y0 = V::sub(y, V::sub(V::cvt(j), t));
+	const F z0 = V::sub(z, V::sub(V::cvt(k), t));
+
+	// branchless version of the simplex corner ordering of the scalar noise
+	const M xy = V::cmpge(x0, y0);
+	const M yz = V::cmpge(y0, z0);
+	const M xz = V::cmpge(x0, z0);
+	const I i1 = V::maskToOne(V::mand(xy, V::mor(yz, xz)));
+	const I j1 = V::maskToOne(V::mand(V::mnot(xy), yz));
+	const I k1 = V::maskToOne(V::mand(V::mnot(yz), V::mor(V::mnot(xy), V::mnot(xz))));
+	const I i2 = V::maskToOne(V::mor(xy, V::mand(yz, xz)));
+	const I j2 = V::maskToOne(V::mor(V::mnot(xy), yz));
+	const I k2 = V::maskToOne(V::mor(V::mnot(yz), V::mand(V::mnot(xy), V::mnot(xz))));
+
+	const F x1 = V::addD(V::sub(x0, V::cvt(i1)), G3);
+	const F y1 = V::addD(V::sub(y0, V::cvt(j1)), G3);
+	const F z1 = V::addD(V::sub(z0, V::cvt(k1)), G3);
+	const F x2 = V::addD(V::sub(x0, V::cvt(i2)), 2.0 * G3);
+	const F y2 = V::addD(V::sub(y0, V::cvt(j2)), 2.0 * G3);
+	const F z2 = V::addD(V::sub(z0, V::cvt(k2)), 2.0 * G3);
+	const F x3 = V::addD(V::sub(x0, V::set1(1.0f)), 3.0 * G3);
+	const F y3 = V::addD(V::sub(y0, V::set1(1.0f)), 3.0 * G3);
+	const F z3 = V::addD(V::sub(z0, V::set1(1.0f)), 3.0 * G3);
+
+	const I ii = V::andi(i, V::seti(0xff));
+	const I jj = V::andi(j, V::seti(0xff));
+	const I kk = V::andi(k, V::seti(0xff));
+	const I one = V::seti(1);
+	const I gi0 = perm<V>(table, V::addi(ii, perm<V>(table, V::addi(jj, perm<V>(table, kk)))));
+	const I gi1 = perm<V>(table, V::addi(V::addi(ii, i1), perm<V>(table, V::addi(V::addi(jj, j1), perm<V>(table, V::addi(kk, k1))))));
+	const I gi2 = perm<V>(table, V::addi(V::addi(ii, i2), perm<V>(table, V::addi(V::addi(jj, j2), perm<V>(table, V::addi(kk, k2))))));
+	const I gi3 = perm<V>(table, V::addi(V::addi(ii, one), perm<V>(table, V::addi(V::addi(jj, one), perm<V>(table, V::addi(kk, one))))));
+
+	const F r = V::set1(0.6f);
+	const F n0 = corner<V>(V::sub(V::sub(V::sub(r, V::mul(x0, x0)), V::mul(y0, y0)), V::mul(z0, z0)), grad3<V>(gi0, x0, y0, z0));
+	const F n1 = corner<V>(V::sub(V::sub(V::sub(r, V::mul(x1, x1)), V::mul(y1, y1)), V::mul(z1, z1)), grad3<V>(gi1, x1, y1, z1));
+	const F n2 = corner<V>(V::sub(V::sub(V::sub(r, V::mul(x2, x2)), V::mul(y2, y2)), V::mul(z2, z2)), grad3<V>(gi2, x2, y2, z2));
+	const F n3 = corner<V>(V::sub(V::sub(V::sub(r, V::mul(x3, x3)), V::mul(y3, y3)), V::mul(z3, z3)), grad3<V>(gi3, x3, y3, z3));
+	return V::mul(V::set1(32.0f), V::add(V::add(V::add(n0, n1), n2), n3));
+}
+
+/**
+ * @brief Evaluates the fBm for the given row - the last lanes of the last vector are computed in
+ * full width and only the requested values are copied.
+ */
+template<class V, int DIMENSIONS>
+void fBmRow(const FBmRow& row) {
+	using F = typename V::F;
+	for (int n = 0; n < row.amount; n += V::Width) {
+		const F index = V::add(V::iota(), V::set1((float)n));
+		F pos[DIMENSIONS];
+		for (int d = 0; d < DIMENSIONS; ++d) {
+			const F p = V::add(V::set1(row.start[d]), V::mul(V::set1(row.step[d]), index));
+			pos[d] = V::mul(V::add(V::set1(row.offset[d]), p), V::set1(row.frequency));
+		}
+		F sum = V::set1(0.0f);
+		float freq = 1.0f;
+		float amp = 0.5f;
+		for (int o = 0; o < row.octaves; ++o) {
+			const F f = V::set1(freq);
+			F noise;
+			if constexpr (DIMENSIONS == 2) {
+				noise = simplex2<V>(row.perm, V::mul(pos[0], f), V::mul(pos[1], f));
+			} else {
+				noise = simplex3<V>(row.perm, V::mul(pos[0], f), V::mul(pos[1], f), V::mul(pos[2], f));
+			}
+			sum = V::add(sum, V::mul(noise, V::set1(amp)));
+			freq *= row.lacunarity;
+			amp *= row.gain;
+		}
+		const int remaining = row.amount - n;
+		if (remaining >= V::Width) {
+			V::store(row.out + n, sum);
+		} else {
+			float buf[V::Width];
+			V::store(buf, sum);
+			for (int i = 0; i < remaining; ++i) {
+				row.out[n + i] = buf[i];
+			}
+		}
+	}
+}
+
+}
+
+}
@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @note This file is compiled with AVX2 enabled - keep the includes to a minimum
+ */
+
+#include "SimplexBatch.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace noise {
+
+namespace {
+
+struct AVX2 {
+	static constexpr int Width = 8;
+	using F = __m256;
+	using I = __m256i;
+	using M = __m256;
+
+	static inline F set1(float v) { return _mm256_set1_ps(v); }
+	static inline I seti(int32_t v) { return _mm256_set1_epi32(v); }
+	static inline F iota() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+	static inline void store(float* out, F v) { _mm256_storeu_ps(out, v); }
+
+	static inline F add(F a, F b) { return _mm256_add_ps(a, b); }
+	static inline F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static inline F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static inline F mulD(F a, double b) {
+		const __m256d bd = _mm256_set1_pd(b);
+		const __m256d lo = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), bd);
+		const __m256d hi = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), bd);
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+	}
+	static inline F addD(F a, double b) {
+		const __m256d bd = _mm256_set1_pd(b);
+		const __m256d lo = _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), bd);
+		const __m256d hi = _mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), bd);
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+	}
+	static inline I addi(I a, I b) { return _mm256_add_epi32(a, b); }
+	static inline I subi(I a, I b) { return _mm256_sub_epi32(a, b); }
+	static inline I andi(I a, I b) { return _mm256_and_si256(a, b); }
+	static inline F cvt(I v) { return _mm256_cvtepi32_ps(v); }
+	static inline I cvtt(F v) { return _mm256_cvttps_epi32(v); }
+
+	static inline M cmpgt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static inline M cmpge(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static inline M cmplt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static inline M cmple(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static inline M icmplt(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+	static inline M icmpeq(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+	static inline M mand(M a, M b) { return _mm256_and_ps(a, b); }
+	static inline M mor(M a, M b) { return _mm256_or_ps(a, b); }
+	static inline M mnot(M a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+	static inline I maskToInt(M m) { return _mm256_castps_si256(m); }
+	static inline I maskToOne(M m) { return _mm256_srli_epi32(_mm256_castps_si256(m), 31); }
+
+	static inline F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+	static inline F negateIf(F v, M m) { return _mm256_xor_ps(v, _mm256_and_ps(m, _mm256_set1_ps(-0.0f))); }
+	static inline I gather(const int32_t* table, I idx) { return _mm256_i32gather_epi32((const int*)table, idx, 4); }
+};
+
+}
+
+bool fBmRow2AVX2(const FBmRow& row) {
+	batch::fBmRow<AVX2, 2>(row);
+	return true;
+}
+
+bool fBmRow3AVX2(const FBmRow& row) {
+	batch::fBmRow<AVX2, 3>(row);
+	return true;
+}
+
+}
+
+#else
+
+namespace noise {
+
+bool fBmRow2AVX2(const FBmRow&) {
+	return false;
+}
+
+bool fBmRow3AVX2(const FBmRow&) {
+	return false;
+}
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @note This file is compiled with SSE4.1 enabled - keep the includes to a minimum
+ */
+
+#include "SimplexBatch.h"
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+
+namespace noise {
+
+namespace {
+
+struct SSE41 {
+	static constexpr int Width = 4;
+	using F = __m128;
+	using I = __m128i;
+	using M = __m128;
+
+	static inline F set1(float v) { return _mm_set1_ps(v); }
+	static inline I seti(int32_t v) { return _mm_set1_epi32(v); }
+	static inline F iota() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+	static inline void store(float* out, F v) { _mm_storeu_ps(out, v); }
+
+	static inline F add(F a, F b) { return _mm_add_ps(a, b); }
+	static inline F sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static inline F mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static inline F mulD(F a, double b) {
+		const __m128d bd = _mm_set1_pd(b);
+		const __m128d lo = _mm_mul_pd(_mm_cvtps_pd(a), bd);
+		const __m128d hi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), bd);
+		return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+	}
+	static inline F addD(F a, double b) {
+		const __m128d bd = _mm_set1_pd(b);
+		const __m128d lo = _mm_add_pd(_mm_cvtps_pd(a), bd);
+		const __m128d hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), bd);
+		return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+	}
+	static inline I addi(I a, I b) { return _mm_add_epi32(a, b); }
+	static inline I subi(I a, I b) { return _mm_sub_epi32(a, b); }
+	static inline I andi(I a, I b) { return _mm_and_si128(a, b); }
+	static inline F cvt(I v) { return _mm_cvtepi32_ps(v); }
+	static inline I cvtt(F v) { return _mm_cvttps_epi32(v); }
+
+	static inline M cmpgt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+	static inline M cmpge(F a, F b) { return _mm_cmpge_ps(a, b); }
+	static inline M cmplt(F a, F b) { return _mm_cmplt_ps(a, b); }
+	static inline M cmple(F a, F b) { return _mm_cmple_ps(a, b); }
+	static inline M icmplt(I a, I b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+	static inline M icmpeq(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+	static inline M mand(M a, M b) { return _mm_and_ps(a, b); }
+	static inline M mor(M a, M b) { return _mm_or_ps(a, b); }
+	static inline M mnot(M a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	static inline I maskToInt(M m) { return _mm_castps_si128(m); }
+	static inline I maskToOne(M m) { return _mm_srli_epi32(_mm_castps_si128(m), 31); }
+
+	static inline F select(M m, F a, F b) { return _mm_blendv_ps(b, a, m); }
+	static inline F negateIf(F v, M m) { return _mm_xor_ps(v, _mm_and_ps(m, _mm_set1_ps(-0.0f))); }
+	static inline I gather(const int32_t* table, I idx) {
+		alignas(16) int32_t indices[Width];
+		_mm_store_si128((__m128i*)indices, idx);
+		return _mm_setr_epi32(table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]]);
+	}
+};
+
+}
+
+bool fBmRow2SSE41(const FBmRow& row) {
+	batch::fBmRow<SSE41, 2>(row);
+	return true;
+}
+
+bool fBmRow3SSE41(const FBmRow& row) {
+	batch::fBmRow<SSE41, 3>(row);
+	return true;
+}
+
+}
+
+#else
+
+namespace noise {
+
+bool fBmRow2SSE41(const FBmRow&) {
+	return false;
+}
+
+bool fBmRow3SSE41(const FBmRow&) {
+	return false;
+}
+
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "core/tests/AbstractTest.h"
 #include "compute/Compute.h"
 #include "noise/Noise.h"
+#include "noise/Simplex.h"
 #include "image/Image.h"
 #include "core/GLM.h"
 #include "core/StringUtil.h"
@@ -52,4 +53,63 @@ TEST_F(NoiseTest, testSeamlessNoiseCPU) {
 	seamlessNoise(false);
 }
 
+TEST_F(NoiseTest, testFBmRowMatchesScalarNoise) {
+	noise::Noise noise;
+	const int amount = 37;
+	const glm::vec2 offset2d(-1337.4242f, 815.0133f);
+	const glm::vec2 start2d(-13.0f, 4.0f);
+	const glm::vec2 step2d(2.0f, 0.0f);
+	const glm::vec3 offset3d(52.1234f, 0.0f, -9.87f);
+	const glm::vec3 start3d(-3.0f, 1.0f, 17.0f);
+	const glm::vec3 step3d(0.0f, 1.0f, 0.0f);
+	const float frequency = 0.0123f;
+	for (int i = 0; i < (int)noise::BatchKernel::Max; ++i) {
+		if (!noise.setBatchKernel((noise::BatchKernel)i)) {
+			continue;
+		}
+		float row2d[amount];
+		float row3d[amount];
+		noise.fBmRow(row2d, amount, offset2d, start2d, step2d, frequency, 5, 2.1f, 0.45f);
+		noise.fBmRow(row3d, amount, offset3d, start3d, step3d, frequency, 3, 2.0f, 0.5f);
+		for (int n = 0; n < amount; ++n) {
+			// the world generation was switched to the batched noise - the generated chunks must not change
+			const glm::vec2 pos2d(offset2d.x + (float)(-13 + n * 2), offset2d.y + 4.0f);
+			const glm::vec3 pos3d(offset3d.x - 3.0f, (float)(1 + n), offset3d.z + 17.0f);
+			ASSERT_EQ(noise::fBm(pos2d * frequency, 5, 2.1f, 0.45f), row2d[n]) << "kernel " << i << ", 2d position " << n;
+			ASSERT_EQ(noise::fBm(pos3d * frequency, 3, 2.0f, 0.5f), row3d[n]) << "kernel " << i << ", 3d position " << n;
+		}
+	}
+}
+
+TEST_F(NoiseTest, testFBmRowKernels) {
+	noise::Noise noise;
+	ASSERT_TRUE(noise.setBatchKernel(noise::BatchKernel::Scalar));
+	const int amount = 100;
+	float expected2d[amount];
+	float expected3d[amount];
+	const glm::vec2 start2d(-100.0f, 50.0f);
+	const glm::vec2 step2d(0.7f, 0.3f);
+	const glm::vec3 start3d(30.0f, -20.0f, 0.5f);
+	const glm::vec3 step3d(0.11f, 0.9f, -0.4f);
+	noise.fBmRow(expected2d, amount, glm::vec2(0.0f), start2d, step2d);
+	noise.fBmRow(expected3d, amount, glm::vec3(0.0f), start3d, step3d);
+
+	for (int i = 0; i < (int)noise::BatchKernel::Max; ++i) {
+		const noise::BatchKernel kernel = (noise::BatchKernel)i;
+		if (!noise.setBatchKernel(kernel)) {
+			continue;
+		}
+		float row2d[amount];
+		float row3d[amount];
+		noise.fBmRow(row2d, amount, glm::vec2(0.0f), start2d, step2d);
+		noise.fBmRow(row3d, amount, glm::vec3(0.0f), start3d, step3d);
+		for (int n = 0; n < amount; ++n) {
+			// the kernels must produce the same world on every cpu
+			ASSERT_EQ(expected2d[n], row2d[n]) << "kernel " << i << ", 2d position " << n;
+			ASSERT_EQ(expected3d[n], row3d[n]) << "kernel " << i << ", 3d position " << n;
+		}
+	}
+	EXPECT_EQ(noise::Noise::bestBatchKernel(), noise.batchKernel());
+}
+
 }
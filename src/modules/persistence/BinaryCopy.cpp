@@ -0,0 +1,225 @@
+/**
+ * @file
+ */
+
+#include "BinaryCopy.h"
+#include "Model.h"
+#include "Field.h"
+#include "Blob.h"
+#include "Timestamp.h"
+#include "core/Log.h"
+#include <SDL_endian.h>
+#include <string.h>
+
+namespace persistence {
+
+namespace {
+
+const uint8_t CopySignature[] = { 'P', 'G', 'C', 'O', 'P', 'Y', '\n', 0xff, '\r', '\n', '\0' };
+// signature, flags and the length of the header extension area
+constexpr size_t CopyHeaderSize = sizeof(CopySignature) + 4u + 4u;
+// seconds between the unix epoch and the postgres epoch 2000-01-01
+constexpr int64_t PostgresEpochOffset = 946684800;
+
+inline int16_t readInt16(const uint8_t *buf) {
+	int16_t v;
+	memcpy(&v, buf, sizeof(v));
+	return (int16_t)SDL_SwapBE16(v);
+}
+
+inline int32_t readInt32(const uint8_t *buf) {
+	int32_t v;
+	memcpy(&v, buf, sizeof(v));
+	return (int32_t)SDL_SwapBE32(v);
+}
+
+}
+
+BinaryCopyWriter::BinaryCopyWriter() {
+	_buffer.insert(_buffer.end(), CopySignature, CopySignature + sizeof(CopySignature));
+	// flags
+	addInt32(0);
+	// header extension length
+	addInt32(0);
+}
+
+void BinaryCopyWriter::addInt16(int16_t value) {
+	const int16_t v = SDL_SwapBE16(value);
+	addData(&v, sizeof(v));
+}
+
+void BinaryCopyWriter::addInt32(int32_t value) {
+	const int32_t v = SDL_SwapBE32(value);
+	addData(&v, sizeof(v));
+}
+
+void BinaryCopyWriter::addInt64(int64_t value) {
+	const int64_t v = SDL_SwapBE64(value);
+	addData(&v, sizeof(v));
+}
+
+void BinaryCopyWriter::addData(const void *data, int length) {
+	const uint8_t *bytes = (const uint8_t*)data;
+	_buffer.insert(_buffer.end(), bytes, bytes + length);
+}
+
+bool BinaryCopyWriter::addRow(const Model& model, const std::vector<const Field*>& columns) {
+	const size_t rowStart = _buffer.size();
+	addInt16((int16_t)columns.size());
+	for (const Field* field : columns) {
+		const Field& f = *field;
+		if (model.isNull(f)) {
+			addInt32(-1);
+			continue;
+		}
+		const bool notNull = f.nulloffset == -1;
+		switch (f.type) {
+		case FieldType::SHORT:
+			addInt32(2);
+			addInt16(notNull ? model.getValue<int16_t>(f) : *model.getValuePointer<int16_t>(f));
+			break;
+		case FieldType::BYTE:
+			// stored as smallint
+			addInt32(2);
+			addInt16(notNull ? model.getValue<uint8_t>(f) : *model.getValuePointer<uint8_t>(f));
+			break;
+		case FieldType::INT:
+			addInt32(4);
+			addInt32(notNull ? model.getValue<int32_t>(f) : *model.getValuePointer<int32_t>(f));
+			break;
+		case FieldType::LONG:
+			addInt32(8);
+			addInt64(notNull ? model.getValue<int64_t>(f) : *model.getValuePointer<int64_t>(f));
+			break;
+		case FieldType::DOUBLE: {
+			const double value = notNull ? model.getValue<double>(f) : *model.getValuePointer<double>(f);
+			int64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			addInt32(8);
+			addInt64(bits);
+			break;
+		}
+		case FieldType::BOOLEAN: {
+			const uint8_t value = (notNull ? model.getValue<bool>(f) : *model.getValuePointer<bool>(f)) ? 1u : 0u;
+			addInt32(1);
+			addData(&value, 1);
+			break;
+		}
+		case FieldType::TIMESTAMP: {
+			const Timestamp& value = notNull ? model.getValue<Timestamp>(f) : *model.getValuePointer<Timestamp>(f);
+			const int64_t seconds = (int64_t)(value.isNow() ? Timestamp::now() : value).seconds();
+			// microseconds since the postgres epoch
+			addInt32(8);
+			addInt64((seconds - PostgresEpochOffset) * (int64_t)1000000);
+			break;
+		}
+		case FieldType::BLOB: {
+			const Blob& value = notNull ? model.getValue<Blob>(f) : *model.getValuePointer<Blob>(f);
+			addInt32((int32_t)value.length);
+			addData(value.data, (int)value.length);
+			break;
+		}
+		case FieldType::STRING:
+		case FieldType::TEXT: {
+			const core::String& value = notNull ? model.getValue<core::String>(f) : *model.getValuePointer<core::String>(f);
+			addInt32((int32_t)value.size());
+			addData(value.c_str(), (int)value.size());
+			break;
+		}
+		case FieldType::PASSWORD:
+		case FieldType::MAX:
+			Log::error("Field '%s' of type %s can't be copied", f.name.c_str(), toFieldType(f.type));
+			_buffer.resize(rowStart);
+			return false;
+		}
+	}
+	return true;
+}
+
+void BinaryCopyWriter::finish() {
+	addInt16(-1);
+}
+
+void BinaryCopyReader::append(const uint8_t *data, size_t length) {
+	if (_pos > 0u) {
+		_buffer.erase(_buffer.begin(), _buffer.begin() + _pos);
+		_pos = 0u;
+	}
+	_buffer.insert(_buffer.end(), data, data + length);
+}
+
+bool BinaryCopyReader::readHeader() {
+	if (_buffer.size() - _pos < CopyHeaderSize) {
+		return false;
+	}
+	if (memcmp(&_buffer[_pos], CopySignature, sizeof(CopySignature)) != 0) {
+		Log::error("Invalid copy signature");
+		_error = true;
+		return false;
+	}
+	const int32_t extensionLength = readInt32(&_buffer[_pos + sizeof(CopySignature) + 4u]);
+	if (_buffer.size() - _pos < CopyHeaderSize + (size_t)extensionLength) {
+		return false;
+	}
+	_pos += CopyHeaderSize + extensionLength;
+	_header = true;
+	return true;
+}
+
+BinaryCopyReader::Result BinaryCopyReader::readRow(std::vector<CopyValue>& row) {
+	if (_error) {
+		return Result::Error;
+	}
+	if (_finished) {
+		return Result::Finished;
+	}
+	if (!_header && !readHeader()) {
+		return _error ? Result::Error : Result::NeedData;
+	}
+	const size_t available = _buffer.size() - _pos;
+	if (available < 2u) {
+		return Result::NeedData;
+	}
+	const int16_t fields = readInt16(&_buffer[_pos]);
+	if (fields == -1) {
+		_pos += 2u;
+		_finished = true;
+		return Result::Finished;
+	}
+	// check that the whole row is available before the values are handed out
+	size_t offset = 2u;
+	for (int16_t i = 0; i < fields; ++i) {
+		if (available < offset + 4u) {
+			return Result::NeedData;
+		}
+		const int32_t length = readInt32(&_buffer[_pos + offset]);
+		offset += 4u;
+		if (length > 0) {
+			offset += length;
+		}
+	}
+	if (available < offset) {
+		return Result::NeedData;
+	}
+	row.resize(fields);
+	offset = 2u;
+	for (int16_t i = 0; i < fields; ++i) {
+		const int32_t length = readInt32(&_buffer[_pos + offset]);
+		offset += 4u;
+		CopyValue& value = row[i];
+		if (length < 0) {
+			value.value = "";
+			value.length = 0;
+			value.isNull = true;
+			continue;
+		}
+		value.value = (const char*)_buffer.data() + _pos + offset;
+		value.length = length;
+		value.isNull = false;
+		offset += length;
+	}
+	_pos += offset;
+	return Result::Row;
+}
+
+}
@@ -0,0 +1,104 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace persistence {
+
+class Model;
+struct Field;
+
+/**
+ * @brief A value of a row in the binary copy format - in network byte order
+ */
+struct CopyValue {
+	const char *value = nullptr;
+	int length = 0;
+	bool isNull = true;
+};
+
+/**
+ * @brief Encodes the rows for a @c COPY ... @c FROM @c STDIN @c (FORMAT @c binary)
+ *
+ * The buffer can be sent to the server and cleared at any time - the rows don't have to be sent in one piece.
+ * @sa createCopyInStatement()
+ */
+class BinaryCopyWriter {
+private:
+	std::vector<uint8_t> _buffer;
+
+	void addInt16(int16_t value);
+	void addInt32(int32_t value);
+	void addInt64(int64_t value);
+	void addData(const void *data, int length);
+public:
+	/**
+	 * @brief Starts the stream with the copy header
+	 */
+	BinaryCopyWriter();
+
+	/**
+	 * @brief Adds the given fields of the model as new row
+	 * @return @c false if one of the fields can't be copied - passwords must be encrypted by the server
+	 */
+	bool addRow(const Model& model, const std::vector<const Field*>& columns);
+	/**
+	 * @brief Adds the trailer - no rows may be added afterwards
+	 */
+	void finish();
+
+	const uint8_t* data() const;
+	size_t size() const;
+	/**
+	 * @brief Clears the buffer after it was sent
+	 */
+	void clear();
+};
+
+/**
+ * @brief Decodes the rows of a @c COPY ... @c TO @c STDOUT @c (FORMAT @c binary)
+ *
+ * The data can be added in arbitrary pieces - a row is only returned once it is complete.
+ * @sa createCopyOutStatement()
+ */
+class BinaryCopyReader {
+private:
+	std::vector<uint8_t> _buffer;
+	size_t _pos = 0u;
+	bool _header = false;
+	bool _finished = false;
+	bool _error = false;
+
+	bool readHeader();
+public:
+	enum class Result {
+		Row, NeedData, Finished, Error
+	};
+
+	void append(const uint8_t *data, size_t length);
+
+	/**
+	 * @param[out] row The values of the row - they point into the buffer of the reader and are only
+	 * valid until the next call of @c append() or @c readRow()
+	 */
+	Result readRow(std::vector<CopyValue>& row);
+};
+
+inline const uint8_t* BinaryCopyWriter::data() const {
+	return _buffer.data();
+}
+
+inline size_t BinaryCopyWriter::size() const {
+	return _buffer.size();
+}
+
+inline void BinaryCopyWriter::clear() {
+	_buffer.clear();
+}
+
+}
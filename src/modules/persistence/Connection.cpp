@@ -117,6 +117,23 @@ bool Connection::connect() {
 	return true;
 }
 
+void Connection::clearPreparedStatements() {
+	if (_preparedStatements.empty()) {
+		return;
+	}
+	_preparedStatements.clear();
+#ifdef HAVE_POSTGRES
+	if (_connection == nullptr) {
+		return;
+	}
+	PGresult *res = PQexec(_connection, "DEALLOCATE ALL;");
+	if (PQresultStatus(res) == PGRES_FATAL_ERROR) {
+		Log::error("Failed to deallocate the prepared statements: %s", PQerrorMessage(_connection));
+	}
+	PQclear(res);
+#endif
+}
+
 void Connection::disconnect() {
 	if (_connection != nullptr) {
 		Log::debug("Disconnect %p", _connection);
@@ -6,7 +6,7 @@
 
 #include "ForwardDecl.h"
 #include "core/String.h"
-#include <unordered_set>
+#include <unordered_map>
 
 namespace persistence {
 
@@ -18,13 +18,39 @@ private:
 	core::String _user;
 	core::String _password;
 	uint16_t _port;
-	std::unordered_set<core::String, core::StringHash> _preparedStatements;
+	int _schemaVersion = 0;
+	// maps the statement text to the name of the prepared statement
+	std::unordered_map<core::String, core::String, core::StringHash> _preparedStatements;
 public:
+	/**
+	 * @brief Statements that are executed after this limit was hit are no longer prepared. This
+	 * protects the server from statements that differ in every execution (e.g. a limit or offset).
+	 */
+	static constexpr size_t MaxPreparedStatements = 256u;
+
 	Connection();
 	~Connection();
 
-	bool hasPreparedStatement(const core::String& name) const;
-	void registerPreparedStatement(const core::String& name);
+	/**
+	 * @return The name of the prepared statement for the given statement text - or @c nullptr if
+	 * the statement wasn't yet prepared on this connection
+	 */
+	const core::String* preparedStatement(const core::String& statement) const;
+	void registerPreparedStatement(const core::String& statement, const core::String& name);
+	size_t preparedStatements() const;
+	/**
+	 * @brief Deallocates all prepared statements of this connection
+	 * @note Must be called after the schema of a table was changed - the result types of the cached
+	 * statements might have changed.
+	 */
+	void clearPreparedStatements();
+
+	/**
+	 * @brief The schema version the prepared statements were created for
+	 * @see clearPreparedStatements()
+	 */
+	int schemaVersion() const;
+	void setSchemaVersion(int schemaVersion);
 
 	bool status() const;
 
@@ -48,12 +74,28 @@ inline ConnectionType* Connection::connection() const {
 	return _connection;
 }
 
-inline bool Connection::hasPreparedStatement(const core::String& name) const {
-	return _preparedStatements.find(name) != _preparedStatements.end();
+inline const core::String* Connection::preparedStatement(const core::String& statement) const {
+	auto i = _preparedStatements.find(statement);
+	if (i == _preparedStatements.end()) {
+		return nullptr;
+	}
+	return &i->second;
+}
+
+inline void Connection::registerPreparedStatement(const core::String& statement, const core::String& name) {
+	_preparedStatements.insert(std::make_pair(statement, name));
+}
+
+inline size_t Connection::preparedStatements() const {
+	return _preparedStatements.size();
+}
+
+inline int Connection::schemaVersion() const {
+	return _schemaVersion;
 }
 
-inline void Connection::registerPreparedStatement(const core::String& name) {
-	_preparedStatements.insert(name);
+inline void Connection::setSchemaVersion(int schemaVersion) {
+	_schemaVersion = schemaVersion;
 }
 
 }
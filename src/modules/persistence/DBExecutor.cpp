@@ -0,0 +1,540 @@
+/**
+ * @file
+ */
+
+#include "DBExecutor.h"
+#include "DBHandler.h"
+#include "BindParam.h"
+#include "Connection.h"
+#include "ScopedConnection.h"
+#include "SQLGenerator.h"
+#include "core/Assert.h"
+#include "core/Common.h"
+#include "core/StringUtil.h"
+#include "postgres/PQSymbol.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <SDL_stdinc.h>
+#include <string.h>
+
+namespace persistence {
+
+namespace {
+
+/**
+ * @brief Appends the given sql and adds the offset to the numbers of all placeholders.
+ * @note This only works because the generated statements don't contain any literal values - every value
+ * is bound as parameter.
+ */
+void appendRenumbered(core::String& out, const core::String& in, int offset) {
+	const size_t size = in.size();
+	for (size_t i = 0; i < size; ++i) {
+		const char c = in[i];
+		out += c;
+		if (c != '$') {
+			continue;
+		}
+		int number = 0;
+		size_t end = i + 1;
+		while (end < size && in[end] >= '0' && in[end] <= '9') {
+			number = number * 10 + (in[end] - '0');
+			++end;
+		}
+		if (end == i + 1) {
+			continue;
+		}
+		out += core::string::toString(number + offset);
+		i = end - 1;
+	}
+}
+
+/**
+ * @brief Appends the name and the value of the field to the key of a row
+ * @return @c false if the field has no value - such a key doesn't identify a row
+ */
+bool appendKeyValue(const Model& model, const Field& field, core::String& key) {
+	if (!model.isValid(field) || model.isNull(field)) {
+		return false;
+	}
+	BindParam param(1);
+	param.push(model, field);
+	if (!key.empty()) {
+		key += ',';
+	}
+	key += field.name;
+	key += '=';
+	if (param.formats[0] == 0) {
+		key += param.values[0];
+	} else {
+		key += core::String(param.values[0], param.lengths[0]);
+	}
+	return true;
+}
+
+/**
+ * @brief Builds the key of a row from all the fields the filter accepts
+ * @return @c false if one of the fields has no value
+ */
+template<class FILTER>
+bool createKey(const Model& model, FILTER&& filter, core::String& key) {
+	for (const Field& field : model.fields()) {
+		if (filter(field) && !appendKeyValue(model, field, key)) {
+			return false;
+		}
+	}
+	return !key.empty();
+}
+
+
+}
+
+void DBExecutor::Submission::done(bool success) {
+	if (!success) {
+		failed = true;
+	}
+	if (pending.decrement(1) == 1) {
+		finish(!failed);
+	}
+}
+
+void DBExecutor::Submission::finish(bool success) {
+	if (completion) {
+		completion(success);
+	}
+	promise.set_value(success);
+}
+
+void DBExecutor::Statement::bind(const BindParam& params) {
+	parameters.reserve(params.position);
+	for (int i = 0; i < params.position; ++i) {
+		Parameter parameter;
+		parameter.offset = (int)data.size();
+		const char *value = params.values[i];
+		if (value == nullptr) {
+			parameter.null = true;
+		} else if (params.formats[i] == 1) {
+			parameter.format = 1;
+			parameter.length = params.lengths[i];
+			data.insert(data.end(), value, value + parameter.length);
+		} else {
+			// text parameters are null terminated
+			parameter.length = (int)strlen(value);
+			data.insert(data.end(), value, value + parameter.length + 1);
+		}
+		parameters.push_back(parameter);
+	}
+}
+
+void DBExecutor::Query::add(Statement* statement, int parameterOffset) {
+	if (statement->coalescable()) {
+		if (statements.empty()) {
+			sql = statement->base;
+			sql += " VALUES ";
+			suffix = &statement->suffix;
+		} else {
+			sql += ", ";
+		}
+		appendRenumbered(sql, statement->values, parameterOffset);
+	} else {
+		core_assert(statements.empty());
+		sql = statement->base;
+	}
+	for (const Parameter& parameter : statement->parameters) {
+		values.push_back(parameter.null ? nullptr : statement->data.data() + parameter.offset);
+		lengths.push_back(parameter.length);
+		formats.push_back(parameter.format);
+	}
+	statements.push_back(statement);
+}
+
+void DBExecutor::Query::finish(bool success) {
+	for (Statement* statement : statements) {
+		statement->submission->done(success);
+	}
+}
+
+DBExecutor::DBExecutor(const DBHandler* dbHandler) :
+		_dbHandler(dbHandler) {
+}
+
+DBExecutor::~DBExecutor() {
+	core_assert_msg(_workers.empty(), "DBExecutor was not properly shut down");
+}
+
+bool DBExecutor::init() {
+	return init(1);
+}
+
+bool DBExecutor::init(int workers) {
+	if (_running) {
+		return true;
+	}
+	_running = true;
+	workers = core_max(1, workers);
+	for (int i = 0; i < workers; ++i) {
+		_workers.emplace_back(new Worker());
+	}
+	for (auto& worker : _workers) {
+		Worker* w = worker.get();
+		w->thread = std::thread([this, w] () {
+			run(*w);
+		});
+	}
+	Log::debug(logid, "Started %i database workers", workers);
+	return true;
+}
+
+void DBExecutor::shutdown() {
+	if (!_running) {
+		return;
+	}
+	_running = false;
+	for (auto& worker : _workers) {
+		{
+			std::unique_lock lock(worker->mutex);
+		}
+		worker->condition.notify_all();
+	}
+	// the workers execute the remaining statements before they quit
+	for (auto& worker : _workers) {
+		worker->thread.join();
+	}
+	_workers.clear();
+}
+
+DBExecutor::Worker& DBExecutor::worker(const char *table) {
+	size_t hash = 0u;
+	for (const char *c = table; *c != '\0'; ++c) {
+		hash = hash * 31u + (size_t)*c;
+	}
+	return *_workers[hash % _workers.size()];
+}
+
+bool DBExecutor::idle() {
+	for (auto& worker : _workers) {
+		std::unique_lock lock(worker->mutex);
+		if (worker->busy || !worker->queue.empty()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void DBExecutor::flush() {
+	core_trace_scoped(DBExecutorFlush);
+	if (!_running) {
+		return;
+	}
+	std::unique_lock lock(_idleMutex);
+	_idleCondition.wait(lock, [this] () {
+		return idle();
+	});
+}
+
+void DBExecutor::run(Worker& worker) {
+	std::vector<Statement> statements;
+	for (;;) {
+		{
+			std::unique_lock lock(worker.mutex);
+			worker.condition.wait(lock, [&] () {
+				return !worker.queue.empty() || !_running;
+			});
+			if (worker.queue.empty()) {
+				return;
+			}
+			statements.swap(worker.queue);
+			worker.busy = true;
+		}
+		execute(statements);
+		statements.clear();
+		{
+			std::unique_lock lock(worker.mutex);
+			worker.busy = false;
+		}
+		{
+			std::unique_lock lock(_idleMutex);
+		}
+		_idleCondition.notify_all();
+	}
+}
+
+std::future<bool> DBExecutor::submit(std::vector<Statement>&& statements, CompletionCallback&& completion) {
+	const SubmissionPtr& submission = std::make_shared<Submission>();
+	submission->completion = core::move(completion);
+	std::future<bool> future = submission->promise.get_future();
+	if (!_running) {
+		Log::debug(logid, "Executor is not running - can't execute %i statements", (int)statements.size());
+		submission->finish(false);
+		return future;
+	}
+	if (statements.empty()) {
+		submission->finish(true);
+		return future;
+	}
+	submission->pending = (int)statements.size();
+	for (Statement& statement : statements) {
+		statement.submission = submission;
+		Worker& w = worker(statement.table);
+		{
+			std::unique_lock lock(w.mutex);
+			// the worker might already have executed its last statements if we raced with the shutdown
+			if (!_running) {
+				lock.unlock();
+				Log::debug(logid, "Executor was shut down - can't execute statement for table %s", statement.table);
+				submission->done(false);
+				continue;
+			}
+			w.queue.emplace_back(core::move(statement));
+		}
+		w.condition.notify_one();
+	}
+	return future;
+}
+
+DBExecutor::Statement DBExecutor::createInsert(const Model& model) {
+	Statement statement;
+	statement.table = model.tableName();
+	bool primaryKeyIncluded = false;
+	statement.base = createInsertBaseStatement(model, primaryKeyIncluded);
+	BindParam params((int)model.fields().size());
+	int insertValueIndex = 1;
+	statement.values = createInsertValuesStatement(model, &params, insertValueIndex);
+	createUpsertStatement(model, statement.suffix, primaryKeyIncluded, insertValueIndex - 1);
+	statement.bind(params);
+	// a row is identified by the whole primary key and by every unique key on its own
+	core::String key;
+	if (createKey(model, [] (const Field& field) { return field.isPrimaryKey(); }, key)) {
+		statement.keys.push_back(key);
+	}
+	for (const Field& uniqueField : model.fields()) {
+		if (!uniqueField.isUnique()) {
+			continue;
+		}
+		key.clear();
+		if (createKey(model, [&] (const Field& field) { return &field == &uniqueField; }, key)) {
+			statement.keys.push_back(key);
+		}
+	}
+	for (const auto& uniqueKey : model.uniqueKeys()) {
+		key.clear();
+		if (createKey(model, [&] (const Field& field) { return uniqueKey.find(field.name) != uniqueKey.end(); }, key)) {
+			statement.keys.push_back(key);
+		}
+	}
+	return statement;
+}
+
+DBExecutor::Statement DBExecutor::createDelete(const Model& model) {
+	Statement statement;
+	statement.table = model.tableName();
+	BindParam params(model.primaryKeyFields());
+	statement.base = createDeleteStatement(model, &params);
+	statement.bind(params);
+	return statement;
+}
+
+std::future<bool> DBExecutor::insert(const std::vector<const Model*>& models, CompletionCallback&& completion) {
+	std::vector<Statement> statements;
+	statements.reserve(models.size());
+	for (const Model* model : models) {
+		statements.emplace_back(createInsert(*model));
+	}
+	return submit(core::move(statements), core::move(completion));
+}
+
+std::future<bool> DBExecutor::insert(const Model& model, CompletionCallback&& completion) {
+	std::vector<Statement> statements;
+	statements.emplace_back(createInsert(model));
+	return submit(core::move(statements), core::move(completion));
+}
+
+std::future<bool> DBExecutor::deleteModels(const std::vector<const Model*>& models, CompletionCallback&& completion) {
+	std::vector<Statement> statements;
+	statements.reserve(models.size());
+	for (const Model* model : models) {
+		statements.emplace_back(createDelete(*model));
+	}
+	return submit(core::move(statements), core::move(completion));
+}
+
+std::future<bool> DBExecutor::truncate(const Model& model) {
+	std::vector<Statement> statements;
+	Statement statement;
+	statement.table = model.tableName();
+	statement.base = createTruncateTableStatement(model);
+	statements.emplace_back(core::move(statement));
+	return submit(core::move(statements));
+}
+
+DBExecutor::Statement DBExecutor::createSelectStatement(const Model& model, ResultCallback&& callback) {
+	Statement statement;
+	statement.table = model.tableName();
+	BindParam params(model.primaryKeyFields());
+	statement.base = createSelect(model, &params);
+	statement.bind(params);
+	statement.callback = core::move(callback);
+	return statement;
+}
+
+std::future<bool> DBExecutor::submitSelect(const Model& model, ResultCallback&& callback) {
+	std::vector<Statement> statements;
+	statements.emplace_back(createSelectStatement(model, core::move(callback)));
+	return submit(core::move(statements));
+}
+
+void DBExecutor::coalesce(std::vector<Statement>& statements, std::vector<Query>& queries) {
+	queries.reserve(statements.size());
+	// the coalesced inserts that still accept rows - by table and columns
+	std::unordered_map<core::String, size_t, core::StringHash> open;
+	// the key values of the rows in the open inserts - by table
+	std::unordered_map<core::String, std::unordered_set<core::String, core::StringHash>, core::StringHash> keys;
+
+	// the rows that were added before must be written before the next statement for the table
+	auto close = [&] (const char *table) {
+		for (auto i = open.begin(); i != open.end();) {
+			if (!SDL_strcmp(queries[i->second].statements.front()->table, table)) {
+				i = open.erase(i);
+			} else {
+				++i;
+			}
+		}
+		keys.erase(table);
+	};
+
+	for (Statement& statement : statements) {
+		if (!statement.coalescable()) {
+			close(statement.table);
+			queries.emplace_back();
+			queries.back().add(&statement, 0);
+			continue;
+		}
+		auto tableKeys = keys.find(statement.table);
+		if (tableKeys != keys.end()) {
+			for (const core::String& key : statement.keys) {
+				if (tableKeys->second.find(key) != tableKeys->second.end()) {
+					// this clears the keys of the table
+					close(statement.table);
+					break;
+				}
+			}
+		}
+		// close() might have erased the keys - look them up again
+		auto& rowKeys = keys[statement.table];
+		rowKeys.insert(statement.keys.begin(), statement.keys.end());
+
+		const core::String& shape = statement.base + statement.suffix;
+		auto i = open.find(shape);
+		if (i != open.end()) {
+			Query& query = queries[i->second];
+			if (query.values.size() + statement.parameters.size() <= (size_t)MaxParameters) {
+				query.add(&statement, (int)query.values.size());
+				continue;
+			}
+		}
+		open[shape] = queries.size();
+		queries.emplace_back();
+		queries.back().add(&statement, 0);
+	}
+	for (Query& query : queries) {
+		if (query.suffix != nullptr) {
+			query.sql += *query.suffix;
+		}
+		query.sql += ";";
+	}
+}
+
+void DBExecutor::handleResult(Query& query, State& state) {
+	if (state.result && query.statements.size() == 1u) {
+		const ResultCallback& callback = query.statements.front()->callback;
+		if (callback) {
+			callback(state);
+		}
+	}
+	query.finish(state.result);
+}
+
+void DBExecutor::execute(std::vector<Statement>& statements) const {
+	core_trace_scoped(DBExecutorExecute);
+	std::vector<Query> queries;
+	coalesce(statements, queries);
+	ScopedConnection scoped(_dbHandler->_connectionPool, _dbHandler->connection());
+	if (!scoped) {
+		Log::error(logid, "Could not execute %i statements - could not acquire connection", (int)statements.size());
+		for (Query& query : queries) {
+			query.finish(false);
+		}
+		return;
+	}
+	Log::debug(logid, "Execute %i statements in %i queries", (int)statements.size(), (int)queries.size());
+	for (size_t begin = 0u; begin < queries.size(); begin += MaxPipelineDepth) {
+		const size_t end = core_min(begin + MaxPipelineDepth, queries.size());
+		if (!executePipelined(scoped.connection(), queries, begin, end)) {
+			executeSequential(scoped.connection(), queries, begin, end);
+		}
+	}
+}
+
+bool DBExecutor::executePipelined(Connection* connection, std::vector<Query>& queries, size_t begin, size_t end) const {
+#if defined(HAVE_POSTGRES) && defined(LIBPQ_HAS_PIPELINING)
+	if (PQenterPipelineMode == nullptr || PQexitPipelineMode == nullptr || PQpipelineSync == nullptr
+			|| PQsendQueryParams == nullptr || PQgetResult == nullptr) {
+		return false;
+	}
+	ConnectionType* c = connection->connection();
+	if (PQenterPipelineMode(c) != 1) {
+		return false;
+	}
+	size_t sent = begin;
+	for (; sent < end; ++sent) {
+		Query& query = queries[sent];
+		if (PQsendQueryParams(c, query.sql.c_str(), (int)query.values.size(), nullptr, query.values.data(),
+				query.lengths.data(), query.formats.data(), 1) != 1) {
+			Log::error(logid, "Failed to send query '%s': %s", query.sql.c_str(), PQerrorMessage(c));
+			break;
+		}
+		// every query gets its own sync point - an error only aborts the failing query
+		if (PQpipelineSync(c) != 1) {
+			Log::error(logid, "Failed to sync the pipeline: %s", PQerrorMessage(c));
+			++sent;
+			break;
+		}
+	}
+	for (size_t i = begin; i < sent; ++i) {
+		State state(connection, true);
+		bool hasResult = false;
+		while (ResultType* res = PQgetResult(c)) {
+			if (hasResult) {
+				PQclear(res);
+				continue;
+			}
+			hasResult = true;
+			state.assign(res);
+		}
+		handleResult(queries[i], state);
+		// consume the sync point of the query
+		if (ResultType* sync = PQgetResult(c)) {
+			PQclear(sync);
+		}
+	}
+	for (size_t i = sent; i < end; ++i) {
+		queries[i].finish(false);
+	}
+	PQexitPipelineMode(c);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void DBExecutor::executeSequential(Connection* connection, std::vector<Query>& queries, size_t begin, size_t end) const {
+	for (size_t i = begin; i < end; ++i) {
+		Query& query = queries[i];
+		State state(connection, true);
+		if (!state.exec(query.sql.c_str(), (int)query.values.size(), query.values.data(), query.lengths.data(), query.formats.data())) {
+			Log::error(logid, "Failed to execute query '%s'", query.sql.c_str());
+		}
+		handleResult(query, state);
+	}
+}
+
+}
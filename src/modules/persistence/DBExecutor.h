@@ -0,0 +1,242 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/IComponent.h"
+#include "core/String.h"
+#include "core/Log.h"
+#include "core/concurrent/Atomic.h"
+#include "core/Trace.h"
+#include "ForwardDecl.h"
+#include "Model.h"
+#include "State.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+
+namespace persistence {
+
+/**
+ * @brief Executes model statements asynchronously on the connections of the @c DBHandler
+ *
+ * The statements are generated and their parameters are copied when they are submitted - the models
+ * can be modified or destroyed right after the call. Every table is handled by one worker thread, so
+ * the statements for a table are executed in the order they were submitted.
+ *
+ * A worker takes all statements that are queued at the time it wakes up. The inserts for the same
+ * table and columns are coalesced into multi-row upserts, and up to @c MaxPipelineDepth statements
+ * are sent to the server in one pipeline (if the loaded libpq supports the pipeline mode) - a batch
+ * only needs one round trip. Without pipeline support the statements are executed one after another.
+ *
+ * @ingroup Persistence
+ */
+class DBExecutor : public core::IComponent {
+	friend class DBExecutorTest;
+public:
+	/**
+	 * @brief The amount of statements that are in flight on one connection
+	 */
+	static constexpr int MaxPipelineDepth = 64;
+	/**
+	 * @brief The max amount of parameters per coalesced statement - postgres allows 65535
+	 */
+	static constexpr int MaxParameters = 32768;
+
+	/**
+	 * @brief Called on the worker thread with the result of a select
+	 */
+	using ResultCallback = std::function<void(State& state)>;
+	/**
+	 * @brief Called with the result of a submission right before its future is fulfilled - for the callers
+	 * that don't wait for the future
+	 */
+	using CompletionCallback = std::function<void(bool success)>;
+
+private:
+	static constexpr auto logid = Log::logid("DBExecutor");
+
+	/**
+	 * @brief Shared by all statements of one submission - the future is fulfilled by the last one
+	 */
+	struct Submission {
+		std::promise<bool> promise;
+		core::AtomicInt pending { 0 };
+		core::AtomicBool failed { false };
+		CompletionCallback completion;
+
+		void done(bool success);
+		void finish(bool success);
+	};
+	using SubmissionPtr = std::shared_ptr<Submission>;
+
+	struct Parameter {
+		int offset = 0;
+		int length = 0;
+		int format = 0;
+		bool null = false;
+	};
+
+	/**
+	 * @brief A statement with copies of all its parameters
+	 */
+	struct Statement {
+		const char *table = nullptr;
+		// the statement text - for inserts this is the part in front of the values
+		core::String base;
+		// inserts only: the values of the row with the placeholders starting at $1
+		core::String values;
+		// inserts only: the conflict clause
+		core::String suffix;
+		// inserts only: one entry per key tuple (primary key, unique keys) with the values of its
+		// columns - a multi-row upsert must not affect a row twice
+		std::vector<core::String> keys;
+		std::vector<char> data;
+		std::vector<Parameter> parameters;
+		ResultCallback callback;
+		SubmissionPtr submission;
+
+		bool coalescable() const;
+		void bind(const BindParam& params);
+	};
+
+	/**
+	 * @brief The sql and the parameters that are sent to the server - maybe made up of several statements
+	 */
+	struct Query {
+		core::String sql;
+		// the conflict clause that is appended after the last row of a coalesced insert
+		const core::String* suffix = nullptr;
+		std::vector<const char*> values;
+		std::vector<int> lengths;
+		std::vector<int> formats;
+		std::vector<Statement*> statements;
+
+		void add(Statement* statement, int parameterOffset);
+		void finish(bool success);
+	};
+
+	struct Worker {
+		std::thread thread;
+		core_trace_mutex(std::mutex, mutex);
+		std::condition_variable_any condition;
+		std::vector<Statement> queue;
+		bool busy = false;
+	};
+
+	const DBHandler* _dbHandler;
+	std::vector<std::unique_ptr<Worker>> _workers;
+	core::AtomicBool _running { false };
+	core_trace_mutex(std::mutex, _idleMutex);
+	std::condition_variable_any _idleCondition;
+
+	Worker& worker(const char *table);
+	void run(Worker& worker);
+	bool idle();
+	void execute(std::vector<Statement>& statements) const;
+	/**
+	 * @brief Groups the statements into the queries - coalesces the inserts
+	 */
+	static void coalesce(std::vector<Statement>& statements, std::vector<Query>& queries);
+	bool executePipelined(Connection* connection, std::vector<Query>& queries, size_t begin, size_t end) const;
+	void executeSequential(Connection* connection, std::vector<Query>& queries, size_t begin, size_t end) const;
+	static void handleResult(Query& query, State& state);
+
+	std::future<bool> submit(std::vector<Statement>&& statements, CompletionCallback&& completion = CompletionCallback());
+	std::future<bool> submitSelect(const Model& model, ResultCallback&& callback);
+	static Statement createSelectStatement(const Model& model, ResultCallback&& callback);
+	static Statement createInsert(const Model& model);
+	static Statement createDelete(const Model& model);
+
+public:
+	DBExecutor(const DBHandler* dbHandler);
+	~DBExecutor();
+
+	/**
+	 * @brief Starts the worker threads
+	 * @param[in] workers The amount of worker threads - every worker uses one connection of the pool while
+	 * it executes a batch
+	 */
+	bool init(int workers);
+	bool init() override;
+	/**
+	 * @brief Executes all submitted statements and stops the worker threads
+	 */
+	void shutdown() override;
+
+	/**
+	 * @brief Blocks until all statements that were submitted so far are executed
+	 */
+	void flush();
+
+	/**
+	 * @brief Inserts or updates the given models - see @c DBHandler::insert()
+	 * @note The auto increment fields are not written back into the models
+	 * @param[in] completion Called on the worker thread (or the calling thread if the statements can't be
+	 * submitted) with the result of the statements
+	 * @return The future is @c false if one of the statements failed
+	 */
+	std::future<bool> insert(const std::vector<const Model*>& models, CompletionCallback&& completion = CompletionCallback());
+	std::future<bool> insert(const Model& model, CompletionCallback&& completion = CompletionCallback());
+
+	/**
+	 * @brief Deletes the given models - identified by their primary keys
+	 * @param[in] completion See @c insert()
+	 */
+	std::future<bool> deleteModels(const std::vector<const Model*>& models, CompletionCallback&& completion = CompletionCallback());
+
+	/**
+	 * @brief Removes all entries from the table of the given model - after the statements that were
+	 * submitted for the table before
+	 */
+	std::future<bool> truncate(const Model& model);
+
+	/**
+	 * @brief Selects the entries that match the primary keys that are set in the given model
+	 * @param[in] func Called on the worker thread for every entry that was found. It accepts a rvalue
+	 * of the given @c MODEL class as parameter.
+	 */
+	template<class MODEL, class FUNC>
+	std::future<bool> select(const MODEL& model, FUNC&& func) {
+		return submitSelect(model, [func] (State& state) mutable {
+			for (int i = 0; i < state.affectedRows; ++i) {
+				MODEL selectedModel;
+				static_cast<Model&>(selectedModel).fillModelValues(state);
+				func(core::move(selectedModel));
+			}
+		});
+	}
+
+	/**
+	 * @brief Selects the entries for all given models with one submission - see @c select()
+	 * @param[in] func Called on the worker thread for every entry that was found. It accepts the index of the
+	 * model and a rvalue of the given @c MODEL class as parameters.
+	 * @param[in] completion Called after all selects were executed - see @c insert()
+	 */
+	template<class MODEL, class FUNC>
+	std::future<bool> select(const std::vector<MODEL>& models, FUNC&& func, CompletionCallback&& completion = CompletionCallback()) {
+		std::vector<Statement> statements;
+		statements.reserve(models.size());
+		for (size_t index = 0; index < models.size(); ++index) {
+			statements.emplace_back(createSelectStatement(models[index], [func, index] (State& state) mutable {
+				for (int i = 0; i < state.affectedRows; ++i) {
+					MODEL selectedModel;
+					static_cast<Model&>(selectedModel).fillModelValues(state);
+					func(index, core::move(selectedModel));
+				}
+			}));
+		}
+		return submit(core::move(statements), core::move(completion));
+	}
+};
+
+inline bool DBExecutor::Statement::coalescable() const {
+	return !values.empty();
+}
+
+}
@@ -5,7 +5,11 @@
 #include "DBHandler.h"
 #include "core/Assert.h"
 #include "core/Log.h"
+#include "core/Var.h"
+#include "core/GameConfig.h"
 #include "postgres/PQSymbol.h"
+#include "core/Common.h"
+#include <string.h>
 
 namespace persistence {
 
@@ -29,16 +33,30 @@ bool DBHandler::init() {
 		Log::error(logid, "Failed to init the connection pool");
 		return false;
 	}
+	_usePreparedStatements = core::Var::get(cfg::DatabasePreparedStatements, "true")->boolVal();
 	_initialized = createOrUpdateTable(db::MetainfoModel());
+	if (!_initialized) {
+		return false;
+	}
+	const int workers = core::Var::get(cfg::DatabaseExecutorWorkers, "2")->intVal();
+	if (!_executor.init(workers)) {
+		Log::error(logid, "Failed to init the database executor");
+		_initialized = false;
+	}
 	return _initialized;
 }
 
 void DBHandler::shutdown() {
 	_initialized = false;
+	_executor.shutdown();
 	_connectionPool.shutdown();
 	postgresShutdown();
 }
 
+DBExecutor& DBHandler::executor() const {
+	return _executor;
+}
+
 Connection* DBHandler::connection() const {
 	return _connectionPool.connection();
 }
@@ -69,6 +87,165 @@ bool DBHandler::insert(std::vector<const Model*>& models) const {
 	return execInternalWithParameters(query, param).result;
 }
 
+bool DBHandler::copyIn(Connection* connection, const core::String& query, const std::vector<const Field*>& columns, const std::vector<const Model*>& models) const {
+	Log::debug(logid, "Execute query '%s' for %i rows", query.c_str(), (int)models.size());
+	State s(connection);
+	if (!s.exec(query.c_str())) {
+		Log::error(logid, "Failed to start the copy '%s'", query.c_str());
+		return false;
+	}
+#ifdef HAVE_POSTGRES
+	// the rows are sent in pieces of this size - the whole copy doesn't have to be in memory
+	constexpr size_t CopyBufferSize = 256 * 1024;
+	ConnectionType* c = connection->connection();
+	BinaryCopyWriter writer;
+	const char *error = nullptr;
+	for (const Model* model : models) {
+		if (!writer.addRow(*model, columns)) {
+			error = "Invalid row";
+			break;
+		}
+		if (writer.size() < CopyBufferSize) {
+			continue;
+		}
+		if (PQputCopyData(c, (const char*)writer.data(), (int)writer.size()) != 1) {
+			error = "Failed to send the rows";
+			break;
+		}
+		writer.clear();
+	}
+	if (error == nullptr) {
+		writer.finish();
+		if (PQputCopyData(c, (const char*)writer.data(), (int)writer.size()) != 1) {
+			error = "Failed to send the rows";
+		}
+	}
+	if (error != nullptr) {
+		Log::error(logid, "Abort the copy: %s", error);
+	}
+	// an error message aborts the copy on the server side
+	if (PQputCopyEnd(c, error) != 1) {
+		Log::error(logid, "Failed to finish the copy: %s", PQerrorMessage(c));
+		return false;
+	}
+	bool success = error == nullptr;
+	while (ResultType* res = PQgetResult(c)) {
+		State result(connection);
+		if (!result.assign(res)) {
+			success = false;
+		}
+	}
+	return success;
+#else
+	return false;
+#endif
+}
+
+bool DBHandler::copyIn(const std::vector<const Model*>& models, bool upsert) const {
+	if (models.empty()) {
+		return true;
+	}
+	const Model& model = *models.front();
+	std::vector<const Field*> columns;
+	ScopedConnection scoped(_connectionPool, connection());
+	if (!scoped) {
+		Log::error(logid, "Could not copy %i rows into '%s' - could not acquire connection", (int)models.size(), model.tableName());
+		return false;
+	}
+	if (!upsert) {
+		return copyIn(scoped.connection(), createCopyInStatement(model, &columns), columns, models);
+	}
+	// the copy itself has no conflict handling - the rows are copied into a temporary table
+	// and inserted or updated from there in one transaction
+	if (!State(scoped.connection()).exec(createTransactionBegin())) {
+		Log::error(logid, "Failed to start the transaction for the copy into '%s'", model.tableName());
+		return false;
+	}
+	bool success = State(scoped.connection()).exec(createCreateStagingTableStatement(model).c_str());
+	if (!success) {
+		Log::error(logid, "Failed to create the staging table for '%s'", model.tableName());
+	}
+	success = success && copyIn(scoped.connection(), createCopyInStagingStatement(model, &columns), columns, models);
+	if (success && !State(scoped.connection()).exec(createInsertFromStagingStatement(model).c_str())) {
+		Log::error(logid, "Failed to insert the staged rows into '%s'", model.tableName());
+		success = false;
+	}
+	if (!State(scoped.connection()).exec(success ? createTransactionCommit() : createTransactionRollback())) {
+		return false;
+	}
+	return success;
+}
+
+bool DBHandler::copyOut(const core::String& query, const std::vector<const Field*>& columns, const std::function<void(const CopyValue* row)>& func) const {
+	Log::debug(logid, "Execute query '%s'", query.c_str());
+	ScopedConnection scoped(_connectionPool, connection());
+	if (!scoped) {
+		Log::error(logid, "Could not execute query '%s' - could not acquire connection", query.c_str());
+		return false;
+	}
+	State s(scoped.connection());
+	if (!s.exec(query.c_str())) {
+		Log::error(logid, "Failed to start the copy '%s'", query.c_str());
+		return false;
+	}
+#ifdef HAVE_POSTGRES
+	ConnectionType* c = scoped.connection()->connection();
+	BinaryCopyReader reader;
+	std::vector<CopyValue> row;
+	bool success = true;
+	for (;;) {
+		char *buf = nullptr;
+		const int length = PQgetCopyData(c, &buf, 0);
+		if (length == -1) {
+			break;
+		}
+		if (length < 0) {
+			Log::error(logid, "Failed to read the copy data: %s", PQerrorMessage(c));
+			success = false;
+			break;
+		}
+		// the remaining data must be consumed even if the rows can't be parsed
+		if (success) {
+			reader.append((const uint8_t*)buf, length);
+		}
+		PQfreemem(buf);
+		while (success) {
+			const BinaryCopyReader::Result result = reader.readRow(row);
+			if (result == BinaryCopyReader::Result::Error) {
+				success = false;
+			}
+			if (result != BinaryCopyReader::Result::Row) {
+				break;
+			}
+			if (row.size() != columns.size()) {
+				Log::error(logid, "Expected %i columns, but got %i", (int)columns.size(), (int)row.size());
+				success = false;
+				break;
+			}
+			for (size_t i = 0u; i < row.size(); ++i) {
+				CopyValue& value = row[i];
+				if (columns[i]->type != FieldType::BLOB || value.isNull) {
+					continue;
+				}
+				uint8_t *copy = (uint8_t*)core_malloc(value.length > 0 ? value.length : 1);
+				memcpy(copy, value.value, value.length);
+				value.value = (const char*)copy;
+			}
+			func(row.data());
+		}
+	}
+	while (ResultType* res = PQgetResult(c)) {
+		State result(scoped.connection());
+		if (!result.assign(res)) {
+			success = false;
+		}
+	}
+	return success;
+#else
+	return false;
+#endif
+}
+
 bool DBHandler::deleteModels(std::vector<const Model*>& models) const {
 	bool state = true;
 	// TODO: prepared statement
@@ -92,6 +269,7 @@ MassQuery DBHandler::massQuery() const {
 
 bool DBHandler::dropTable(const Model& model) const {
 	const State& s = execInternal(createDropTableStatement(model));
+	++_schemaVersion;
 	if (!s.result) {
 		return false;
 	}
@@ -123,11 +301,17 @@ bool DBHandler::createOrUpdateTable(Model&& model) const {
 	std::vector<db::MetainfoModel> schemaModels;
 	if (!tableExists(model) || !loadMetadata(model, schemaModels)) {
 		// doesn't exist yet - just create it
-		if (!exec(createCreateTableStatement(model, _useForeignKeys))) {
+		const bool created = exec(createCreateTableStatement(model, _useForeignKeys));
+		++_schemaVersion;
+		if (!created) {
+			return false;
+		}
+	} else {
+		const bool altered = exec(createAlterTableStatement(schemaModels, model, _useForeignKeys));
+		++_schemaVersion;
+		if (!altered) {
 			return false;
 		}
-	} else if (!exec(createAlterTableStatement(schemaModels, model, _useForeignKeys))) {
-		return false;
 	}
 	return insertMetadata(model);
 }
@@ -167,7 +351,9 @@ bool DBHandler::insertMetadata(const Model& model) const {
 }
 
 bool DBHandler::createTable(Model&& model) const {
-	if (!exec(createCreateTableStatement(model, _useForeignKeys))) {
+	const bool created = exec(createCreateTableStatement(model, _useForeignKeys));
+	++_schemaVersion;
+	if (!created) {
 		Log::error(logid, "Failed to create table");
 		return false;
 	}
@@ -179,6 +365,19 @@ bool DBHandler::exec(const core::String& query) const {
 	return execInternal(query).result;
 }
 
+bool DBHandler::execStatement(State& state, Connection* connection, const core::String& query, int parameterCount,
+		const char *const *paramValues, const int *paramLengths, const int *paramFormats) const {
+	if (!_usePreparedStatements) {
+		return state.exec(query.c_str(), parameterCount, paramValues, paramLengths, paramFormats);
+	}
+	const int schemaVersion = _schemaVersion;
+	if (connection->schemaVersion() != schemaVersion) {
+		connection->clearPreparedStatements();
+		connection->setSchemaVersion(schemaVersion);
+	}
+	return state.execCached(query, parameterCount, paramValues, paramLengths, paramFormats);
+}
+
 State DBHandler::execInternal(const core::String& query) const {
 	ScopedConnection scoped(_connectionPool, connection());
 	if (!scoped) {
@@ -201,7 +400,7 @@ State DBHandler::execInternalWithCondition(const core::String& query, BindParam&
 		Log::error(logid, "Could not execute query '%s' - could not acquire connection", query.c_str());
 		return State();
 	}
-	State s(scoped.connection());
+	State s(scoped.connection(), _usePreparedStatements);
 	if (conditionOffset > 0) {
 		for (int i = 0; i < conditionOffset; ++i) {
 			const int index = params.add();
@@ -209,10 +408,10 @@ State DBHandler::execInternalWithCondition(const core::String& query, BindParam&
 			Log::debug(logid, "Parameter %i: '%s'", index + 1, value);
 			params.values[index] = value;
 		}
-		if (!s.exec(query.c_str(), params.position, &params.values[0], &params.lengths[0], &params.formats[0])) {
+		if (!execStatement(s, scoped.connection(), query, params.position, &params.values[0], &params.lengths[0], &params.formats[0])) {
 			Log::error(logid, "Failed to execute query '%s' with %i parameters", query.c_str(), conditionOffset);
 		}
-	} else if (!s.exec(query.c_str())) {
+	} else if (!execStatement(s, scoped.connection(), query, 0, nullptr, nullptr, nullptr)) {
 		Log::error(logid, "Failed to execute query '%s'", query.c_str());
 	}
 	if (s.affectedRows <= 0) {
@@ -228,9 +427,9 @@ State DBHandler::execInternalWithParameters(const core::String& query, Model& mo
 		Log::error(logid, "Could not execute query '%s' - could not acquire connection", query.c_str());
 		return State();
 	}
-	State s(scoped.connection());
+	State s(scoped.connection(), _usePreparedStatements);
 	Log::debug(logid, "Execute query '%s' with %i parameters", query.c_str(), param.position);
-	if (!s.exec(query.c_str(), param.position, &param.values[0], &param.lengths[0], &param.formats[0])) {
+	if (!execStatement(s, scoped.connection(), query, param.position, &param.values[0], &param.lengths[0], &param.formats[0])) {
 		Log::warn(logid, "Failed to execute query: '%s'", query.c_str());
 	}
 	if (s.affectedRows <= 0) {
@@ -247,9 +446,9 @@ State DBHandler::execInternalWithParameters(const core::String& query, const Bin
 		Log::error(logid, "Could not execute query '%s' - could not acquire connection", query.c_str());
 		return State();
 	}
-	State s(scoped.connection());
+	State s(scoped.connection(), _usePreparedStatements);
 	Log::debug(logid, "Execute query '%s' with %i parameters", query.c_str(), param.position);
-	if (!s.exec(query.c_str(), param.position, &param.values[0], &param.lengths[0], &param.formats[0])) {
+	if (!execStatement(s, scoped.connection(), query, param.position, &param.values[0], &param.lengths[0], &param.formats[0])) {
 		Log::warn(logid, "Failed to execute query: '%s'", query.c_str());
 	}
 	Log::debug(logid, "current row: %i", s.currentRow);
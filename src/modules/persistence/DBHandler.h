@@ -13,9 +13,12 @@
 #include "ConnectionPool.h"
 #include "Model.h"
 #include "MassQuery.h"
+#include "DBExecutor.h"
+#include "BinaryCopy.h"
 #include "core/StringUtil.h"
 #include "core/Log.h"
 #include "core/IComponent.h"
+#include "core/concurrent/Atomic.h"
 #include "ScopedConnection.h"
 #include "BindParam.h"
 #include "SQLGenerator.h"
@@ -23,6 +26,7 @@
 #include "OrderBy.h"
 #include <memory>
 #include <vector>
+#include <functional>
 
 namespace persistence {
 
@@ -36,17 +40,38 @@ namespace persistence {
 class DBHandler : public core::IComponent {
 private:
 	friend class MassQuery;
+	friend class DBExecutor;
 	static constexpr auto logid = Log::logid("DBHandler");
 	State execInternal(const core::String& query) const;
 	State execInternalWithParameters(const core::String& query, Model& model, const BindParam& param) const;
 	State execInternalWithCondition(const core::String& query, BindParam& params, int conditionOffset, const DBCondition& condition) const;
 	State execInternalWithParameters(const core::String& query, const BindParam& param) const;
+	/**
+	 * @brief Executes the statement as cached prepared statement of the connection if this is enabled
+	 * @sa cfg::DatabasePreparedStatements
+	 */
+	bool execStatement(State& state, Connection* connection, const core::String& query, int parameterCount,
+			const char *const *paramValues, const int *paramLengths, const int *paramFormats) const;
 
 	mutable ConnectionPool _connectionPool;
+	// prepared statements and binary results for the model statements
+	bool _usePreparedStatements = true;
+	// increased for every table that was created, changed or dropped - the cached prepared
+	// statements of the connections become invalid
+	mutable core::AtomicInt _schemaVersion { 0 };
 
 	virtual Connection* connection() const;
 
 	bool insertMetadata(const Model& model) const;
+	/**
+	 * @param[in] func Called with the values of every row - in the order of the columns. The blobs are copies
+	 * that are owned by the receiver.
+	 */
+	bool copyOut(const core::String& query, const std::vector<const Field*>& columns, const std::function<void(const CopyValue* row)>& func) const;
+	/**
+	 * @brief Sends the rows of the given copy statement on the given connection
+	 */
+	bool copyIn(Connection* connection, const core::String& query, const std::vector<const Field*>& columns, const std::vector<const Model*>& models) const;
 	bool loadMetadata(const Model& model, std::vector<db::MetainfoModel>& schemaModels) const;
 
 	template<class FUNC, class MODEL>
@@ -57,10 +82,10 @@ private:
 			Log::error(logid, "Could not execute query '%s' - could not acquire connection", query.c_str());
 			return false;
 		}
-		State s(scoped.connection());
+		State s(scoped.connection(), _usePreparedStatements);
 		if (conditionAmount > 0) {
 			if (keyParams.position == conditionAmount) {
-				if (!s.exec(query.c_str(), conditionAmount, &keyParams.values[0], &keyParams.lengths[0], &keyParams.formats[0])) {
+				if (!execStatement(s, scoped.connection(), query, conditionAmount, &keyParams.values[0], &keyParams.lengths[0], &keyParams.formats[0])) {
 					Log::error(logid, "Failed to execute query '%s' with %i parameters", query.c_str(), conditionAmount);
 				}
 			} else {
@@ -71,11 +96,11 @@ private:
 					Log::debug(logid, "Parameter %i: '%s'", index + 1, value);
 					params.values[index] = value;
 				}
-				if (!s.exec(query.c_str(), conditionAmount, &params.values[0], &params.lengths[0], &params.formats[0])) {
+				if (!execStatement(s, scoped.connection(), query, conditionAmount, &params.values[0], &params.lengths[0], &params.formats[0])) {
 					Log::error(logid, "Failed to execute query '%s' with %i parameters", query.c_str(), conditionAmount);
 				}
 			}
-		} else if (!s.exec(query.c_str())) {
+		} else if (!execStatement(s, scoped.connection(), query, 0, nullptr, nullptr, nullptr)) {
 			Log::error(logid, "Failed to execute query '%s'", query.c_str());
 		}
 		for (int i = 0; i < s.affectedRows; ++i) {
@@ -88,6 +113,7 @@ private:
 
 	bool _initialized = false;
 	const bool _useForeignKeys;
+	mutable DBExecutor _executor { this };
 
 public:
 	DBHandler(bool useForeignKeys = true);
@@ -99,6 +125,12 @@ public:
 	 */
 	bool init() override;
 
+	/**
+	 * @brief Executes the model statements asynchronously
+	 * @sa cfg::DatabaseExecutorWorkers
+	 */
+	DBExecutor& executor() const;
+
 	/**
 	 * @brief Not calling @c shutdown() after @c init() was called will lead to memory leaks
 	 */
@@ -235,6 +267,51 @@ public:
 
 	bool deleteModels(std::vector<const Model*>& models) const;
 
+	/**
+	 * @brief Writes the given models with one binary @c COPY - this is much faster than inserts for big amounts of rows
+	 * @note The valid fields of the first model define the columns - all models must have the same fields set.
+	 * @param[in] upsert Without conflict handling an already existing key lets the whole copy fail. With
+	 * @c true the rows are copied into a temporary staging table and inserted or updated from there - the
+	 * given models must not contain the same key twice.
+	 * @return @c true if all models were written, @c false otherwise.
+	 */
+	bool copyIn(const std::vector<const Model*>& models, bool upsert = false) const;
+
+	template<class MODEL>
+	bool copyIn(const std::vector<MODEL>& models, bool upsert = false) const {
+		std::vector<const Model*> converted(models.size());
+		const size_t size = models.size();
+		for (size_t i = 0u; i < size; ++i) {
+			converted[i] = &models[i];
+		}
+		return copyIn(converted, upsert);
+	}
+
+	/**
+	 * @brief Reads the database entries that match the valid fields of the given model with a binary @c COPY
+	 * @note Only number and boolean fields are supported as condition
+	 * @param[in] func The callback that is notified on every entry that was found. It accepts a rvalue of the
+	 * given @c MODEL class as parameter.
+	 * @return @c true if the statement was executed successfully, @c false otherwise.
+	 */
+	template<class MODEL, class FUNC>
+	bool copyOut(const MODEL& model, FUNC&& func) const {
+		std::vector<const Field*> columns;
+		const core::String& query = createCopyOutStatement(model, &columns);
+		if (query.empty()) {
+			return false;
+		}
+		const State state(nullptr, true);
+		return copyOut(query, columns, [&] (const CopyValue* row) {
+			MODEL selectedModel;
+			const size_t size = columns.size();
+			for (size_t i = 0u; i < size; ++i) {
+				selectedModel.fillModelValue(state, *columns[i], row[i].value, row[i].length, row[i].isNull);
+			}
+			func(core::move(selectedModel));
+		});
+	}
+
 	/**
 	 * @brief Truncate the table for the given @c persistence::Model
 	 * @param[in] model The model that identifies the table that should be truncated
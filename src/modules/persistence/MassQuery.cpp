@@ -7,6 +7,7 @@
 #include "DBHandler.h"
 #include "SQLGenerator.h"
 #include "core/Assert.h"
+#include "core/Log.h"
 
 namespace persistence {
 
@@ -17,21 +18,61 @@ MassQuery::MassQuery(const DBHandler* dbHandler, size_t amount) :
 }
 
 MassQuery::~MassQuery() {
-	commit();
+	if (!_insertOrUpdate.empty() || !_delete.empty() || _result) {
+		Log::warn("MassQuery was not committed - the result of the statements is not checked");
+		commit();
+	}
 }
 
-void MassQuery::commit() {
-	// TODO: how to handle the error state here?
+void MassQuery::Result::done(bool success) {
+	if (!success) {
+		failed = true;
+	}
+	if (pending.decrement(1) == 1) {
+		promise.set_value(!failed);
+	}
+}
+
+void MassQuery::submit() {
+	if (_insertOrUpdate.empty() && _delete.empty()) {
+		return;
+	}
+	if (!_result) {
+		_result = std::make_shared<Result>();
+	}
+	// the statements are executed asynchronously - the models are copied and can be changed right away
+	DBExecutor& executor = _dbHandler->executor();
+	const ResultPtr result = _result;
 	if (!_insertOrUpdate.empty()) {
-		_dbHandler->insert(_insertOrUpdate);
+		result->pending.increment(1);
+		executor.insert(_insertOrUpdate, [result] (bool success) {
+			result->done(success);
+		});
 		_insertOrUpdate.clear();
 	}
 	if (!_delete.empty()) {
-		_dbHandler->deleteModels(_delete);
+		result->pending.increment(1);
+		executor.deleteModels(_delete, [result] (bool success) {
+			result->done(success);
+		});
 		_delete.clear();
 	}
 }
 
+std::future<bool> MassQuery::commit() {
+	submit();
+	if (!_result) {
+		std::promise<bool> promise;
+		promise.set_value(true);
+		return promise.get_future();
+	}
+	std::future<bool> future = _result->promise.get_future();
+	// give up the reference of the commit - the promise is fulfilled by the last statement
+	_result->done(true);
+	_result.reset();
+	return future;
+}
+
 void MassQuery::add(ISavable* savable) {
 	core_assert(savable != nullptr);
 	std::vector<const Model*> models;
@@ -46,7 +87,7 @@ void MassQuery::add(ISavable* savable) {
 		}
 	}
 	if (_insertOrUpdate.size() + _delete.size() >= _commitSize) {
-		commit();
+		submit();
 	}
 }
 
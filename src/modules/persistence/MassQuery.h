@@ -5,6 +5,8 @@
 #pragma once
 
 #include "BindParam.h"
+#include "core/concurrent/Atomic.h"
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -15,21 +17,43 @@ class DBHandler;
 
 /**
  * @brief Implements mass updates for @c ISavable instances.
+ * @note The statements are executed asynchronously by the @c DBExecutor of the @c DBHandler
  */
 class MassQuery {
 private:
+	/**
+	 * @brief The combined result of all statements that were submitted since the last @c commit()
+	 */
+	struct Result {
+		std::promise<bool> promise;
+		// the commit holds one reference until all statements are submitted
+		core::AtomicInt pending { 1 };
+		core::AtomicBool failed { false };
+
+		void done(bool success);
+	};
+	using ResultPtr = std::shared_ptr<Result>;
+
 	const DBHandler * const _dbHandler;
 	const size_t _commitSize;
 	std::vector<const Model*> _insertOrUpdate;
 	std::vector<const Model*> _delete;
+	ResultPtr _result;
 	friend class DBHandler;
 	MassQuery(const DBHandler* dbHandler, size_t amount = 1000);
 
+	void submit();
+
 public:
 	~MassQuery();
 
 	void add(ISavable* savable);
-	void commit();
+	/**
+	 * @brief Submits the remaining statements
+	 * @return The future is fulfilled once all statements that were added since the last commit are
+	 * executed - it is @c false if one of them failed
+	 */
+	std::future<bool> commit();
 };
 
 }
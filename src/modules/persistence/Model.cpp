@@ -44,6 +44,57 @@ const Field& Model::getField(const char* name) const {
 	return emptyField;
 }
 
+void Model::fillModelValue(const State& state, const Field& f, const char *value, int length, bool isNull) {
+	if (f.type == FieldType::BLOB || state.isBinary()) {
+		Log::debug("Try to set '%s' to binary value (length: %i)", f.name.c_str(), length);
+	} else {
+		Log::debug("Try to set '%s' to '%s' (length: %i)", f.name.c_str(), value, length);
+	}
+	switch (f.type) {
+	case FieldType::PASSWORD:
+	case FieldType::TEXT:
+		setValue(f, core::String(value, length));
+		break;
+	case FieldType::STRING: {
+		const core::String s(value, length);
+		if (f.isLower()) {
+			setValue(f, s.toLower());
+		} else {
+			setValue(f, s);
+		}
+		break;
+	}
+	case FieldType::BOOLEAN:
+		setValue(f, state.toBool(value, length));
+		break;
+	case FieldType::BLOB:
+		setValue(f, Blob((uint8_t*)value, length));
+		break;
+	case FieldType::INT:
+		setValue(f, (int32_t)state.toLong(value, length));
+		break;
+	case FieldType::SHORT:
+		setValue(f, (int16_t)state.toLong(value, length));
+		break;
+	case FieldType::BYTE:
+		setValue(f, (uint8_t)state.toLong(value, length));
+		break;
+	case FieldType::LONG:
+		setValue(f, state.toLong(value, length));
+		break;
+	case FieldType::DOUBLE:
+		setValue(f, state.toDouble(value, length));
+		break;
+	case FieldType::TIMESTAMP: {
+		setValue(f, Timestamp(state.toLong(value, length)));
+		break;
+	}
+	case FieldType::MAX:
+		break;
+	}
+	setIsNull(f, isNull);
+}
+
 bool Model::fillModelValues(State& state) {
 	const int cols = state.cols;
 	Log::debug("Query has values for %i cols", cols);
@@ -59,50 +110,7 @@ bool Model::fillModelValues(State& state) {
 		int length;
 		bool isNull;
 		state.getResult(i, f.type, &value, &length, &isNull);
-		Log::debug("Try to set '%s' to '%s' (length: %i)", name, value, length);
-		switch (f.type) {
-		case FieldType::PASSWORD:
-		case FieldType::TEXT:
-			setValue(f, core::String(value, length));
-			break;
-		case FieldType::STRING: {
-			const core::String s(value, length);
-			if (f.isLower()) {
-				setValue(f, s.toLower());
-			} else {
-				setValue(f, s);
-			}
-			break;
-		}
-		case FieldType::BOOLEAN:
-			setValue(f, state.isBool(value));
-			break;
-		case FieldType::BLOB:
-			setValue(f, Blob((uint8_t*)value, length));
-			break;
-		case FieldType::INT:
-			setValue(f, (int32_t)core::string::toInt(value));
-			break;
-		case FieldType::SHORT:
-			setValue(f, (int16_t)core::string::toInt(value));
-			break;
-		case FieldType::BYTE:
-			setValue(f, (uint8_t)core::string::toInt(value));
-			break;
-		case FieldType::LONG:
-			setValue(f, core::string::toLong(value));
-			break;
-		case FieldType::DOUBLE:
-			setValue(f, core::string::toDouble(value));
-			break;
-		case FieldType::TIMESTAMP: {
-			setValue(f, Timestamp(core::string::toLong(value)));
-			break;
-		}
-		case FieldType::MAX:
-			break;
-		}
-		setIsNull(f, isNull);
+		fillModelValue(state, f, value, length, isNull);
 	}
 	++state.currentRow;
 	return true;
@@ -53,6 +53,7 @@ protected:
 
 	friend class DBHandler;
 	friend class MassQuery;
+	friend class DBExecutor;
 	bool _flagToDelete = false;
 	uint8_t* _membersPointer;
 	const Meta* _s;
@@ -67,6 +68,12 @@ public:
 	Model(const Meta* s);
 	virtual ~Model();
 
+	/**
+	 * @brief Put a value of a result row into the field
+	 * @param[in] state Converts the value - depending on the result format
+	 */
+	void fillModelValue(const State& state, const Field& f, const char *value, int length, bool isNull);
+
 	/**
 	 * @return The table name without schema
 	 * @see schema()
@@ -36,7 +36,8 @@ bool PersistenceMgr::unregisterSavable(uint32_t fourcc, ISavable *savable) {
 		// make sure to persist the dirty state
 		MassQuery stmt = _dbHandler->massQuery();
 		stmt.add(savable);
-		stmt.commit();
+		// don't wait for the database here - the result is checked in the next update
+		_unregisterCommits.emplace_back(stmt.commit());
 		Log::trace(logid, "Removed savable (fourcc: %u, savable: %p)", fourcc, savable);
 		return true;
 	}
@@ -51,24 +52,46 @@ bool PersistenceMgr::init() {
 void PersistenceMgr::shutdown() {
 	core_trace_scoped(PersistenceMgrShutdown);
 	update(0l);
+	// wait until the dirty states are written
+	_dbHandler->executor().flush();
 	core::ScopedWriteLock lock(_lock);
 	_savables.clear();
 }
 
-void PersistenceMgr::update(long dt) {
+bool PersistenceMgr::update(long dt) {
 	core_trace_scoped(PersistenceMgrUpdate);
-	core::ScopedReadLock lock(_lock);
-	for (auto& collection : _savables) {
-		if (collection.second.empty()) {
-			continue;
+	std::vector<std::future<bool>> commits;
+	int savables = 0;
+	{
+		core::ScopedWriteLock lock(_lock);
+		commits.swap(_unregisterCommits);
+	}
+	{
+		core::ScopedReadLock lock(_lock);
+		for (auto& collection : _savables) {
+			if (collection.second.empty()) {
+				continue;
+			}
+			MassQuery stmt = _dbHandler->massQuery();
+			for (ISavable *savable : collection.second) {
+				stmt.add(savable);
+			}
+			commits.emplace_back(stmt.commit());
+			savables += (int)collection.second.size();
 		}
-		MassQuery stmt = _dbHandler->massQuery();
-		for (ISavable *savable : collection.second) {
-			stmt.add(savable);
+	}
+	int failed = 0;
+	for (std::future<bool>& commit : commits) {
+		if (!commit.get()) {
+			++failed;
 		}
-		stmt.commit();
 	}
-	Log::debug(logid, "Persisted dirty states of %i savables", (int)_savables.size());
+	if (failed > 0) {
+		Log::error(logid, "Failed to persist %i of %i commits", failed, (int)commits.size());
+		return false;
+	}
+	Log::debug(logid, "Persisted dirty states of %i savables", savables);
+	return true;
 }
 
 }
@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
 #include <map>
 #include <unordered_set>
+#include <vector>
 #include "ISavable.h"
 #include "DBHandler.h"
 #include "core/IComponent.h"
@@ -27,6 +29,8 @@ private:
 	Map _savables;
 	core::ReadWriteLock _lock;
 	const DBHandlerPtr _dbHandler;
+	// the commits of the unregistered savables - they are checked in the next update
+	std::vector<std::future<bool>> _unregisterCommits;
 public:
 	PersistenceMgr(const DBHandlerPtr& dbHandler);
 	virtual ~PersistenceMgr() {}
@@ -40,7 +44,12 @@ public:
 	 */
 	void shutdown() override;
 
-	void update(long dt);
+	/**
+	 * @brief Writes the dirty states of all registered savables and waits until they are executed
+	 * @note This blocks on the database - don't call this in the main thread
+	 * @return @c false if the dirty states of one of the savables could not be written
+	 */
+	bool update(long dt);
 };
 
 typedef std::shared_ptr<PersistenceMgr> PersistenceMgrPtr;
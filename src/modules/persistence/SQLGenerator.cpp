@@ -49,6 +49,13 @@ static inline void createTableIdentifier(core::String& stmt, const Model& table)
 	stmt += "\"";
 }
 
+static inline void createStagingTableIdentifier(core::String& stmt, const Model& table) {
+	// temporary tables live in their own schema
+	stmt += "\"";
+	stmt += table.tableName();
+	stmt += "_staging\"";
+}
+
 static inline void createSequenceIdentifier(core::String& stmt, const Model& table, const core::String& field) {
 	createSchemaIdentifier(stmt, table);
 	stmt += ".\"";
@@ -902,10 +909,8 @@ core::String createInsertStatement(const Model& model, BindParam* params, int* p
 
 // https://www.postgresql.org/docs/current/static/functions-formatting.html
 // https://www.postgresql.org/docs/current/static/functions-datetime.html
-core::String createSelect(const Model& model, BindParam* params) {
+static void createSelectColumns(core::String& stmt, const Model& model, std::vector<const Field*>* columns) {
 	const Fields& fields = model.fields();
-	core::String stmt;
-	stmt += "SELECT ";
 	int select = 0;
 	for (auto i = fields.begin(); i != fields.end(); ++i) {
 		const Field& f = *i;
@@ -917,6 +922,9 @@ core::String createSelect(const Model& model, BindParam* params) {
 			stmt += ", ";
 		}
 		++select;
+		if (columns != nullptr) {
+			columns->push_back(&f);
+		}
 		if (f.type == FieldType::TIMESTAMP) {
 			stmt += "CAST(EXTRACT(EPOCH FROM ";
 		}
@@ -929,8 +937,13 @@ core::String createSelect(const Model& model, BindParam* params) {
 			stmt += "\"";
 		}
 	}
-
 	core_assert_always(select > 0);
+}
+
+core::String createSelect(const Model& model, BindParam* params) {
+	core::String stmt;
+	stmt += "SELECT ";
+	createSelectColumns(stmt, model, nullptr);
 	stmt += " FROM ";
 	createTableIdentifier(stmt, model);
 	int index = 1;
@@ -938,6 +951,119 @@ core::String createSelect(const Model& model, BindParam* params) {
 	return stmt;
 }
 
+static void createValidColumns(core::String& stmt, const Model& model, std::vector<const Field*>* columns) {
+	int inserted = 0;
+	for (const persistence::Field& f : model.fields()) {
+		if (!model.isValid(f)) {
+			continue;
+		}
+		if (inserted > 0) {
+			stmt += ", ";
+		}
+		++inserted;
+		if (columns != nullptr) {
+			columns->push_back(&f);
+		}
+		stmt += "\"";
+		stmt += f.name;
+		stmt += "\"";
+	}
+}
+
+core::String createCopyInStatement(const Model& model, std::vector<const Field*>* columns) {
+	core::String stmt;
+	stmt += "COPY ";
+	createTableIdentifier(stmt, model);
+	stmt += " (";
+	createValidColumns(stmt, model, columns);
+	stmt += ") FROM STDIN (FORMAT binary)";
+	return stmt;
+}
+
+core::String createCopyInStagingStatement(const Model& model, std::vector<const Field*>* columns) {
+	core::String stmt;
+	stmt += "COPY ";
+	createStagingTableIdentifier(stmt, model);
+	stmt += " (";
+	createValidColumns(stmt, model, columns);
+	stmt += ") FROM STDIN (FORMAT binary)";
+	return stmt;
+}
+
+core::String createCreateStagingTableStatement(const Model& model) {
+	core::String stmt;
+	stmt += "CREATE TEMPORARY TABLE ";
+	createStagingTableIdentifier(stmt, model);
+	// only the columns - the constraints of the table are checked by the insert
+	stmt += " ON COMMIT DROP AS SELECT ";
+	createValidColumns(stmt, model, nullptr);
+	stmt += " FROM ";
+	createTableIdentifier(stmt, model);
+	stmt += " WITH NO DATA;";
+	return stmt;
+}
+
+core::String createInsertFromStagingStatement(const Model& model) {
+	bool primaryKeyIncluded = false;
+	core::String stmt = createInsertBaseStatement(model, primaryKeyIncluded);
+	stmt += " SELECT ";
+	std::vector<const Field*> columns;
+	createValidColumns(stmt, model, &columns);
+	stmt += " FROM ";
+	createStagingTableIdentifier(stmt, model);
+	createUpsertStatement(model, stmt, primaryKeyIncluded, (int)columns.size());
+	stmt += ";";
+	return stmt;
+}
+
+core::String createCopyOutStatement(const Model& model, std::vector<const Field*>* columns) {
+	core::String stmt;
+	stmt += "COPY (SELECT ";
+	createSelectColumns(stmt, model, columns);
+	stmt += " FROM ";
+	createTableIdentifier(stmt, model);
+	// COPY doesn't support parameters - only numbers are accepted as condition values
+	int where = 0;
+	for (const persistence::Field& f : model.fields()) {
+		if (!model.isValid(f)) {
+			continue;
+		}
+		stmt += where > 0 ? " AND " : " WHERE ";
+		++where;
+		stmt += "\"";
+		stmt += f.name;
+		stmt += "\"";
+		if (model.isNull(f)) {
+			stmt += " IS NULL";
+			continue;
+		}
+		stmt += " = ";
+		const bool notNull = f.nulloffset == -1;
+		switch (f.type) {
+		case FieldType::SHORT:
+			stmt += core::string::toString((int)(notNull ? model.getValue<int16_t>(f) : *model.getValuePointer<int16_t>(f)));
+			break;
+		case FieldType::BYTE:
+			stmt += core::string::toString((int)(notNull ? model.getValue<uint8_t>(f) : *model.getValuePointer<uint8_t>(f)));
+			break;
+		case FieldType::INT:
+			stmt += core::string::toString(notNull ? model.getValue<int32_t>(f) : *model.getValuePointer<int32_t>(f));
+			break;
+		case FieldType::LONG:
+			stmt += core::string::toString((int64_t)(notNull ? model.getValue<int64_t>(f) : *model.getValuePointer<int64_t>(f)));
+			break;
+		case FieldType::BOOLEAN:
+			stmt += (notNull ? model.getValue<bool>(f) : *model.getValuePointer<bool>(f)) ? "TRUE" : "FALSE";
+			break;
+		default:
+			Log::error("Field '%s' of type %s can't be used as copy condition", f.name.c_str(), toFieldType(f.type));
+			return core::String();
+		}
+	}
+	stmt += ") TO STDOUT (FORMAT binary)";
+	return stmt;
+}
+
 /**
  * @param[in] condition The condition to generate the where clause for
  * @param[in,out] parameterCount The amount of already existing where clauses due
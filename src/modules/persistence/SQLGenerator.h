@@ -13,6 +13,7 @@ namespace persistence {
 
 struct BindParam;
 class Model;
+struct Field;
 class DBCondition;
 class OrderBy;
 struct Range;
@@ -26,10 +27,35 @@ extern core::String createUpdateStatement(const Model& model, BindParam* params
 extern core::String createDeleteStatement(const Model& model, BindParam* params = nullptr);
 extern core::String createInsertBaseStatement(const Model& table, bool& primaryKeyIncluded);
 extern core::String createInsertValuesStatement(const Model& table, BindParam* params, int& insertValueIndex);
+extern void createUpsertStatement(const Model& table, core::String& stmt, bool primaryKeyIncluded, int insertValueIndex);
 extern core::String createInsertStatement(const Model& model, BindParam* params = nullptr, int* parameterCount = nullptr);
 extern core::String createInsertStatement(const std::vector<const Model*>& tables, BindParam* params = nullptr, int* parameterCount = nullptr);
 
 extern core::String createSelect(const Model& model, BindParam* params = nullptr);
+/**
+ * @brief Binary copy of the valid fields of the given model into the table
+ * @param[out] columns The fields in the order of the copy columns
+ */
+extern core::String createCopyInStatement(const Model& model, std::vector<const Field*>* columns = nullptr);
+/**
+ * @brief Binary copy of the valid fields of the given model into the staging table of the model
+ * @sa createCreateStagingTableStatement()
+ */
+extern core::String createCopyInStagingStatement(const Model& model, std::vector<const Field*>* columns = nullptr);
+/**
+ * @brief Temporary table with the valid fields of the given model - it is dropped at the end of the transaction
+ */
+extern core::String createCreateStagingTableStatement(const Model& model);
+/**
+ * @brief Inserts or updates the rows of the staging table in the table of the model
+ */
+extern core::String createInsertFromStagingStatement(const Model& model);
+/**
+ * @brief Binary copy of the rows that match the valid fields of the given model
+ * @param[out] columns The fields in the order of the copy columns
+ * @return An empty string if one of the valid fields can't be used as condition - only numbers are supported
+ */
+extern core::String createCopyOutStatement(const Model& model, std::vector<const Field*>* columns = nullptr);
 extern const char* createTransactionBegin();
 extern const char* createTransactionCommit();
 extern const char* createTransactionRollback();
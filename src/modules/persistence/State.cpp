@@ -6,17 +6,20 @@
 #include "core/Log.h"
 #include "core/Assert.h"
 #include "core/StringUtil.h"
+#include "core/Common.h"
 #include "Connection.h"
 #include "postgres/PQSymbol.h"
+#include <SDL_endian.h>
+#include <string.h>
 
 namespace persistence {
 
-State::State(Connection* connection) :
-		_connection(connection) {
+State::State(Connection* connection, bool binary) :
+		_connection(connection), _resultFormat(binary ? 1 : 0) {
 }
 
 State::State(State&& other) :
-		res(other.res), lastErrorMsg(other.lastErrorMsg), affectedRows(other.affectedRows),
+		_resultFormat(other._resultFormat), res(other.res), lastErrorMsg(other.lastErrorMsg), affectedRows(other.affectedRows),
 		cols(other.cols), currentRow(other.currentRow), result(other.result) {
 	other.res = nullptr;
 	other._connection = nullptr;
@@ -37,7 +40,7 @@ bool State::exec(const char *statement, int parameterCount, const char *const *p
 	core_assert_msg(parameterCount <= 0 || paramValues != nullptr, "Parameters don't match");
 	ConnectionType* c = _connection->connection();
 #ifdef HAVE_POSTGRES
-	if (parameterCount <= 0) {
+	if (parameterCount <= 0 && _resultFormat == 0) {
 		res = PQexec(c, statement);
 	} else {
 		res = PQexecParams(c, statement, parameterCount, nullptr, paramValues, paramLengths, paramFormats, _resultFormat);
@@ -56,9 +59,6 @@ bool State::prepare(const char *name, const char* statement, int parameterCount)
 	if (!result) {
 		return false;
 	}
-	if (name != nullptr && name[0] != '\0') {
-		_connection->registerPreparedStatement(core::String(name));
-	}
 	return true;
 }
 
@@ -71,6 +71,37 @@ bool State::execPrepared(const char *name, int parameterCount, const char *const
 	return result;
 }
 
+bool State::execCached(const core::String& statement, int parameterCount, const char *const *paramValues, const int *paramLengths, const int *paramFormats) {
+	const core::String* name = _connection->preparedStatement(statement);
+	if (name != nullptr) {
+		return execPrepared(name->c_str(), parameterCount, paramValues, paramLengths, paramFormats);
+	}
+	if (_connection->preparedStatements() >= Connection::MaxPreparedStatements) {
+		return exec(statement.c_str(), parameterCount, paramValues, paramLengths, paramFormats);
+	}
+	const core::String& newName = core::string::format("stmt%i", (int)_connection->preparedStatements());
+	if (!prepare(newName.c_str(), statement.c_str(), parameterCount)) {
+		return false;
+	}
+	_connection->registerPreparedStatement(statement, newName);
+#ifdef HAVE_POSTGRES
+	PQclear(res);
+#endif
+	res = nullptr;
+	return execPrepared(newName.c_str(), parameterCount, paramValues, paramLengths, paramFormats);
+}
+
+bool State::assign(ResultType* newRes) {
+	if (res != nullptr) {
+#ifdef HAVE_POSTGRES
+		PQclear(res);
+#endif
+	}
+	res = newRes;
+	checkLastResult(_connection->connection());
+	return result;
+}
+
 bool State::isBool(const char *value) {
 	return *value == '1' || *value == 't' || *value == 'y' || *value == 'o' || *value == 'T';
 }
@@ -80,12 +111,69 @@ bool State::asBool(int colIndex) const {
 	int length;
 	bool isNull;
 	getResult(colIndex, FieldType::BOOLEAN, &value, &length, &isNull);
-	if (length == 0) {
+	return toBool(value, length);
+}
+
+bool State::toBool(const char *value, int length) const {
+	if (length <= 0) {
 		return false;
 	}
+	if (isBinary()) {
+		return value[0] != 0;
+	}
 	return isBool(value);
 }
 
+int64_t State::toLong(const char *value, int length) const {
+	if (!isBinary()) {
+		return core::string::toLong(value);
+	}
+	// integers are transferred in network byte order - the size depends on the column type
+	switch (length) {
+	case 2: {
+		int16_t v;
+		memcpy(&v, value, sizeof(v));
+		return (int16_t)SDL_SwapBE16(v);
+	}
+	case 4: {
+		int32_t v;
+		memcpy(&v, value, sizeof(v));
+		return (int32_t)SDL_SwapBE32(v);
+	}
+	case 8: {
+		int64_t v;
+		memcpy(&v, value, sizeof(v));
+		return (int64_t)SDL_SwapBE64(v);
+	}
+	default:
+		break;
+	}
+	return 0;
+}
+
+double State::toDouble(const char *value, int length) const {
+	if (!isBinary()) {
+		return core::string::toDouble(value);
+	}
+	if (length == 8) {
+		uint64_t v;
+		memcpy(&v, value, sizeof(v));
+		v = SDL_SwapBE64(v);
+		double d;
+		memcpy(&d, &v, sizeof(d));
+		return d;
+	}
+	if (length == 4) {
+		uint32_t v;
+		memcpy(&v, value, sizeof(v));
+		v = SDL_SwapBE32(v);
+		float f;
+		memcpy(&f, &v, sizeof(f));
+		return f;
+	}
+	return 0.0;
+}
+
 const char *State::columnName(int colIndex) const {
 #ifdef HAVE_POSTGRES
 	return PQfname(res, colIndex);
@@ -98,27 +186,44 @@ void State::freeBlob(unsigned char* data) {
 	if (data == nullptr) {
 		return;
 	}
-#ifdef HAVE_POSTGRES
-	//core_assert(_resultFormat == 0);
-	PQfreemem(data);
-#endif
+	core_free(data);
 }
 
 void State::getResult(int colIndex, FieldType type, const char **value, int *length, bool *isNull) const {
 #ifdef HAVE_POSTGRES
 	*isNull = PQgetisnull(res, currentRow, colIndex) == 1;
 	if (type == FieldType::BLOB) {
-		core_assert(_resultFormat == 0);
-		const unsigned char *byteArray = (const unsigned char*)PQgetvalue(res, currentRow, colIndex);
-		size_t byteArraySize = 0u;
-		*value = *isNull ? nullptr : (char*)PQunescapeBytea(byteArray, &byteArraySize);
-		*length = *isNull ? 0 : byteArraySize;
+		*value = nullptr;
+		*length = 0;
+		if (!*isNull) {
+			const unsigned char *byteArray = (const unsigned char*)PQgetvalue(res, currentRow, colIndex);
+			// the blob data is owned by the model - it must outlive the result
+			if (isBinary()) {
+				const int byteArraySize = PQgetlength(res, currentRow, colIndex);
+				uint8_t *copy = (uint8_t*)core_malloc(byteArraySize > 0 ? byteArraySize : 1);
+				memcpy(copy, byteArray, byteArraySize);
+				*value = (const char*)copy;
+				*length = byteArraySize;
+			} else {
+				size_t byteArraySize = 0u;
+				unsigned char *unescaped = PQunescapeBytea(byteArray, &byteArraySize);
+				uint8_t *copy = (uint8_t*)core_malloc(byteArraySize > 0u ? byteArraySize : 1u);
+				memcpy(copy, unescaped, byteArraySize);
+				PQfreemem(unescaped);
+				*value = (const char*)copy;
+				*length = (int)byteArraySize;
+			}
+		}
 	} else {
 		*value = *isNull ? nullptr : PQgetvalue(res, currentRow, colIndex);
 		*length = PQgetlength(res, currentRow, colIndex);
 	}
 	if (*value != nullptr) {
-		Log::trace("value: %s, length: %i", *value, *length);
+		if (type == FieldType::BLOB || isBinary()) {
+			Log::trace("binary value with length: %i", *length);
+		} else {
+			Log::trace("value: %s, length: %i", *value, *length);
+		}
 	} else {
 		Log::trace("value for row %i - col %i is null", currentRow, colIndex);
 	}
@@ -152,11 +257,21 @@ void State::checkLastResult(ConnectionType* connection) {
 		result = true;
 		break;
 	}
+#ifdef LIBPQ_HAS_PIPELINING
+	case PGRES_PIPELINE_ABORTED:
+		Log::error("Pipeline aborted");
+		break;
+#endif
 	case PGRES_BAD_RESPONSE:
 	case PGRES_FATAL_ERROR:
 		lastErrorMsg = PQerrorMessage(connection);
 		Log::error("Fatal error: %s", lastErrorMsg);
 		break;
+	case PGRES_COPY_IN:
+	case PGRES_COPY_OUT:
+		// the data is transferred with the copy functions
+		result = true;
+		break;
 	case PGRES_EMPTY_QUERY:
 	case PGRES_COMMAND_OK:
 	case PGRES_TUPLES_OK:
@@ -20,12 +20,16 @@ private:
 	void checkLastResult(ConnectionType* connection);
 
 	// 1 = binary, 0 = text
-	const int _resultFormat = 0;
+	int _resultFormat = 0;
 public:
 	constexpr State() {
 	}
 
-	State(Connection* connection);
+	/**
+	 * @param[in] binary Request the results in binary format. This only works for statements that are
+	 * executed with parameters or as prepared statement.
+	 */
+	State(Connection* connection, bool binary = false);
 	State(State&& other);
 	~State();
 
@@ -34,6 +38,16 @@ public:
 	bool exec(const char* statement, int parameterCount = 0, const char *const *paramValues = nullptr, const int *paramLengths = nullptr, const int *paramFormats = nullptr);
 	bool prepare(const char *name, const char* statement, int parameterCount);
 	bool execPrepared(const char *name, int parameterCount, const char *const *paramValues = nullptr, const int *paramLengths = nullptr, const int *paramFormats = nullptr);
+	/**
+	 * @brief Executes the statement as prepared statement of the connection. The statement is prepared
+	 * on the first execution and reused for every following execution of the same statement text.
+	 * @note Falls back to a normal execution if the connection reached its prepared statement limit
+	 */
+	bool execCached(const core::String& statement, int parameterCount, const char *const *paramValues = nullptr, const int *paramLengths = nullptr, const int *paramFormats = nullptr);
+	/**
+	 * @brief Takes the ownership of a result that was fetched from the connection - e.g. in pipeline mode
+	 */
+	bool assign(ResultType* result);
 
 	/**
 	 * @param[in] colIndex The column index of the current row. Starting at index 0 for the first column
@@ -46,15 +60,31 @@ public:
 	 * @param[out] value The value of the current row and given colIndex as string
 	 * @param[out] length The length of the value string
 	 * @param[out] isNull @c true if the result was null
+	 * @note The value is in binary format if the results were requested in binary format - use the
+	 * conversion functions to get the values. Blobs are always returned as a copy of the raw data that
+	 * must be freed with @c freeBlob()
 	 * @sa freeBlob
 	 */
 	void getResult(int colIndex, FieldType type, const char **value, int *length, bool *isNull) const;
 	/**
-	 * @brief Free data from a string-to-binary conversion of a blob
+	 * @brief Free the blob data that was returned by @c getResult()
 	 * @sa getResult
 	 */
 	static void freeBlob(unsigned char* data);
 
+	/**
+	 * @brief Converts a value of @c getResult() for integer or timestamp columns
+	 */
+	int64_t toLong(const char *value, int length) const;
+	/**
+	 * @brief Converts a value of @c getResult() for floating point columns
+	 */
+	double toDouble(const char *value, int length) const;
+	/**
+	 * @brief Converts a value of @c getResult() for boolean columns
+	 */
+	bool toBool(const char *value, int length) const;
+
 	/**
 	 * @param[in] colIndex The column index of the current row. Starting at index 0 for the first column
 	 */
@@ -0,0 +1,217 @@
+/**
+ * @file
+ *
+ * Needs a local PostgreSQL - see @c AbstractDatabaseTest for the connection settings. The first argument
+ * of every benchmark toggles the prepared statements and binary results (1) against the plain text
+ * statements (0).
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/Var.h"
+#include "core/GameConfig.h"
+#include "core/StringUtil.h"
+#include "persistence/DBHandler.h"
+#include "BackendModels.h"
+#include <vector>
+
+class PersistenceBenchmark : public core::AbstractBenchmark {
+private:
+	using Super = core::AbstractBenchmark;
+protected:
+	persistence::DBHandler _dbHandler;
+	bool _initialized = false;
+	std::vector<uint8_t> _chunkData;
+
+	static constexpr int Users = 16;
+	static constexpr int Chunks = 64;
+
+	bool insertChunk(int x) {
+		backend::db::ChunkModel model;
+		model.setX(x);
+		model.setY(0);
+		model.setZ(0);
+		model.setMapid(1);
+		model.setSeed(1);
+		model.setVersion(1);
+		model.setData(persistence::Blob(_chunkData.data(), _chunkData.size()));
+		return _dbHandler.insert(model);
+	}
+
+public:
+	void SetUp(benchmark::State& state) override {
+		Super::SetUp(state);
+		core::Var::get(cfg::DatabaseMinConnections, "1");
+		core::Var::get(cfg::DatabaseMaxConnections, "2");
+		core::Var::get(cfg::DatabaseName, "enginetest");
+		core::Var::get(cfg::DatabaseHost, "localhost");
+		core::Var::get(cfg::DatabaseUser, "vengi");
+		core::Var::get(cfg::DatabasePassword, "engine");
+		core::Var::get(cfg::DatabasePreparedStatements, "true")->setVal(state.range(0) != 0);
+		_chunkData.resize(8192);
+		for (size_t i = 0u; i < _chunkData.size(); ++i) {
+			_chunkData[i] = (uint8_t)(i * 31u);
+		}
+		_initialized = _dbHandler.init();
+		if (!_initialized) {
+			return;
+		}
+		_dbHandler.dropTable(backend::db::ChunkModel());
+		_dbHandler.dropTable(backend::db::UserModel());
+		if (!_dbHandler.createTable(backend::db::UserModel()) || !_dbHandler.createTable(backend::db::ChunkModel())) {
+			_initialized = false;
+			return;
+		}
+		for (int i = 0; i < Users; ++i) {
+			backend::db::UserModel model;
+			model.setEmail(core::string::format("user%i@localhost", i));
+			model.setName(core::string::format("user%i", i));
+			model.setPassword("password");
+			_initialized &= _dbHandler.insert(model);
+		}
+		for (int i = 0; i < Chunks; ++i) {
+			_initialized &= insertChunk(i);
+		}
+	}
+
+	void TearDown(benchmark::State& state) override {
+		_dbHandler.shutdown();
+		Super::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(PersistenceBenchmark, chunkInsert) (benchmark::State& state) {
+	int x = 0;
+	for (auto _ : state) {
+		if (!_initialized) {
+			state.SkipWithError("No database connection");
+			break;
+		}
+		if (!insertChunk(x++ % Chunks)) {
+			state.SkipWithError("Failed to insert the chunk");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(PersistenceBenchmark, chunkSelect) (benchmark::State& state) {
+	int x = 0;
+	for (auto _ : state) {
+		if (!_initialized) {
+			state.SkipWithError("No database connection");
+			break;
+		}
+		backend::db::ChunkModel model;
+		model.setX(x++ % Chunks);
+		model.setY(0);
+		model.setZ(0);
+		model.setMapid(1);
+		model.setSeed(1);
+		if (!_dbHandler.select(model, persistence::DBConditionOne())) {
+			state.SkipWithError("Failed to select the chunk");
+			break;
+		}
+		persistence::Blob data = model.data();
+		if (data.length != _chunkData.size()) {
+			state.SkipWithError("Unexpected chunk data");
+			break;
+		}
+		_dbHandler.freeBlob(data);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(PersistenceBenchmark, chunkCopyIn) (benchmark::State& state) {
+	// every iteration writes new keys - the copy doesn't handle conflicts
+	int y = 1;
+	std::vector<backend::db::ChunkModel> models(Chunks);
+	for (auto _ : state) {
+		if (!_initialized) {
+			state.SkipWithError("No database connection");
+			break;
+		}
+		for (int i = 0; i < Chunks; ++i) {
+			backend::db::ChunkModel& model = models[i];
+			model.setX(i);
+			model.setY(y);
+			model.setZ(0);
+			model.setMapid(1);
+			model.setSeed(1);
+			model.setVersion(1);
+			model.setData(persistence::Blob(_chunkData.data(), _chunkData.size()));
+		}
+		++y;
+		if (!_dbHandler.copyIn(models)) {
+			state.SkipWithError("Failed to copy the chunks");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * Chunks);
+}
+
+BENCHMARK_DEFINE_F(PersistenceBenchmark, chunkCopyOut) (benchmark::State& state) {
+	for (auto _ : state) {
+		if (!_initialized) {
+			state.SkipWithError("No database connection");
+			break;
+		}
+		backend::db::ChunkModel model;
+		model.setMapid(1);
+		model.setSeed(1);
+		int chunks = 0;
+		const bool success = _dbHandler.copyOut(model, [&] (backend::db::ChunkModel&& chunk) {
+			persistence::Blob data = chunk.data();
+			_dbHandler.freeBlob(data);
+			++chunks;
+		});
+		if (!success || chunks != Chunks) {
+			state.SkipWithError("Failed to copy the chunks");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * Chunks);
+}
+
+BENCHMARK_DEFINE_F(PersistenceBenchmark, userSelect) (benchmark::State& state) {
+	int i = 0;
+	for (auto _ : state) {
+		if (!_initialized) {
+			state.SkipWithError("No database connection");
+			break;
+		}
+		const backend::db::DBConditionUserModelEmail condition(core::string::format("user%i@localhost", i++ % Users));
+		backend::db::UserModel model;
+		if (!_dbHandler.select(model, condition) || model.id() == 0) {
+			state.SkipWithError("Failed to select the user");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(PersistenceBenchmark, userUpdate) (benchmark::State& state) {
+	int i = 0;
+	for (auto _ : state) {
+		if (!_initialized) {
+			state.SkipWithError("No database connection");
+			break;
+		}
+		const backend::db::DBConditionUserModelEmail condition(core::string::format("user%i@localhost", i % Users));
+		backend::db::UserModel model;
+		model.setMapid(1 + i++ % 4);
+		if (!_dbHandler.update(model, condition)) {
+			state.SkipWithError("Failed to update the user");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(PersistenceBenchmark, chunkInsert)->Arg(0)->Arg(1);
+BENCHMARK_REGISTER_F(PersistenceBenchmark, chunkSelect)->Arg(0)->Arg(1);
+BENCHMARK_REGISTER_F(PersistenceBenchmark, chunkCopyIn)->Arg(0);
+BENCHMARK_REGISTER_F(PersistenceBenchmark, chunkCopyOut)->Arg(0);
+BENCHMARK_REGISTER_F(PersistenceBenchmark, userSelect)->Arg(0)->Arg(1);
+BENCHMARK_REGISTER_F(PersistenceBenchmark, userUpdate)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -57,6 +57,16 @@ void postgresShutdown() {
 	PQsetNoticeProcessor = nullptr;
 	PQflush = nullptr;
 	PQfname = nullptr;
+	PQsendQueryParams = nullptr;
+	PQgetResult = nullptr;
+	PQputCopyData = nullptr;
+	PQputCopyEnd = nullptr;
+	PQgetCopyData = nullptr;
+#ifdef LIBPQ_HAS_PIPELINING
+	PQenterPipelineMode = nullptr;
+	PQexitPipelineMode = nullptr;
+	PQpipelineSync = nullptr;
+#endif
 #endif
 }
 
@@ -123,6 +133,17 @@ bool postgresInit() {
 	DYNLOAD(obj, PQsetNoticeProcessor);
 	DYNLOAD(obj, PQflush);
 	DYNLOAD(obj, PQfname);
+	DYNLOAD(obj, PQsendQueryParams);
+	DYNLOAD(obj, PQgetResult);
+	DYNLOAD(obj, PQputCopyData);
+	DYNLOAD(obj, PQputCopyEnd);
+	DYNLOAD(obj, PQgetCopyData);
+#ifdef LIBPQ_HAS_PIPELINING
+	// optional - only available since libpq 14
+	DYNLOAD(obj, PQenterPipelineMode);
+	DYNLOAD(obj, PQexitPipelineMode);
+	DYNLOAD(obj, PQpipelineSync);
+#endif
 
 	if (PQescapeStringConn == nullptr || PQexec == nullptr
 			|| PQinitSSL == nullptr || PQsetdbLogin == nullptr
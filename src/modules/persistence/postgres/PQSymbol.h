@@ -60,6 +60,16 @@ DYNDEFINE(PQsslInUse);
 DYNDEFINE(PQsetNoticeProcessor);
 DYNDEFINE(PQflush);
 DYNDEFINE(PQfname);
+DYNDEFINE(PQsendQueryParams);
+DYNDEFINE(PQgetResult);
+DYNDEFINE(PQputCopyData);
+DYNDEFINE(PQputCopyEnd);
+DYNDEFINE(PQgetCopyData);
+#ifdef LIBPQ_HAS_PIPELINING
+DYNDEFINE(PQenterPipelineMode);
+DYNDEFINE(PQexitPipelineMode);
+DYNDEFINE(PQpipelineSync);
+#endif
 #undef DYNDEFINE
 #endif
 }
@@ -0,0 +1,104 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "persistence/BinaryCopy.h"
+#include "persistence/SQLGenerator.h"
+#include "persistence/State.h"
+#include "TestModels.h"
+
+namespace persistence {
+
+class BinaryCopyTest : public core::AbstractTest {
+protected:
+	db::TestModel create(int64_t id) const {
+		db::TestModel model;
+		model.setId(id);
+		model.setName(core::string::format("name%i", (int)id));
+		model.setEmail(core::string::format("mail%i", (int)id));
+		model.setPoints((int32_t)id * 10);
+		model.setSomeboolean(id % 2 == 0);
+		model.setSomedouble((double)id + 0.5);
+		model.setSomeshort((int16_t)-id);
+		model.setSometext(nullptr);
+		return model;
+	}
+};
+
+TEST_F(BinaryCopyTest, testRoundTrip) {
+	const int amount = 5;
+	std::vector<const Field*> columns;
+	const db::TestModel first = create(1);
+	createCopyInStatement(first, &columns);
+	ASSERT_EQ(8u, columns.size());
+
+	BinaryCopyWriter writer;
+	for (int i = 1; i <= amount; ++i) {
+		ASSERT_TRUE(writer.addRow(create(i), columns));
+	}
+	writer.finish();
+
+	// feed the reader in small pieces - rows are only returned once they are complete
+	BinaryCopyReader reader;
+	const State state(nullptr, true);
+	std::vector<CopyValue> row;
+	int rows = 0;
+	bool finished = false;
+	for (size_t offset = 0u; offset < writer.size() && !finished; offset += 7u) {
+		reader.append(writer.data() + offset, core_min((size_t)7u, writer.size() - offset));
+		for (;;) {
+			const BinaryCopyReader::Result result = reader.readRow(row);
+			ASSERT_NE(BinaryCopyReader::Result::Error, result);
+			if (result == BinaryCopyReader::Result::Finished) {
+				finished = true;
+				break;
+			}
+			if (result == BinaryCopyReader::Result::NeedData) {
+				break;
+			}
+			ASSERT_EQ(columns.size(), row.size());
+			db::TestModel model;
+			for (size_t i = 0u; i < columns.size(); ++i) {
+				model.fillModelValue(state, *columns[i], row[i].value, row[i].length, row[i].isNull);
+			}
+			++rows;
+			const db::TestModel expected = create(rows);
+			EXPECT_EQ(expected.id(), model.id());
+			EXPECT_EQ(expected.name(), model.name());
+			EXPECT_EQ(expected.email(), model.email());
+			ASSERT_NE(nullptr, model.points());
+			EXPECT_EQ(*expected.points(), *model.points());
+			ASSERT_NE(nullptr, model.someboolean());
+			EXPECT_EQ(*expected.someboolean(), *model.someboolean());
+			ASSERT_NE(nullptr, model.somedouble());
+			EXPECT_DOUBLE_EQ(*expected.somedouble(), *model.somedouble());
+			ASSERT_NE(nullptr, model.someshort());
+			EXPECT_EQ(*expected.someshort(), *model.someshort());
+			EXPECT_EQ(nullptr, model.sometext());
+		}
+	}
+	EXPECT_TRUE(finished);
+	EXPECT_EQ(amount, rows);
+}
+
+TEST_F(BinaryCopyTest, testPasswordIsRejected) {
+	db::TestModel model;
+	model.setPassword("secret");
+	std::vector<const Field*> columns;
+	createCopyInStatement(model, &columns);
+	BinaryCopyWriter writer;
+	const size_t headerSize = writer.size();
+	EXPECT_FALSE(writer.addRow(model, columns));
+	EXPECT_EQ(headerSize, writer.size()) << "The incomplete row must be removed";
+}
+
+TEST_F(BinaryCopyTest, testInvalidSignature) {
+	const uint8_t data[32] = { 'P', 'G', 'C', 'O', 'P', 'Z' };
+	BinaryCopyReader reader;
+	reader.append(data, sizeof(data));
+	std::vector<CopyValue> row;
+	EXPECT_EQ(BinaryCopyReader::Result::Error, reader.readRow(row));
+}
+
+}
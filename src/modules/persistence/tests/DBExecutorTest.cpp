@@ -0,0 +1,107 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "persistence/DBExecutor.h"
+#include "persistence/Blob.h"
+#include "TestModels.h"
+
+namespace persistence {
+
+class DBExecutorTest : public core::AbstractTest {
+protected:
+	uint8_t _chunkData[4] { 1, 2, 3, 4 };
+
+	// the test chunk table has the composite primary key of the chunk table of the backend
+	db::TestChunkModel chunk(int x) {
+		db::TestChunkModel model;
+		model.setX(x);
+		model.setY(0);
+		model.setZ(0);
+		model.setMapid(1);
+		model.setSeed(1);
+		model.setData(Blob(_chunkData, sizeof(_chunkData)));
+		return model;
+	}
+
+	/**
+	 * @return The amount of queries the inserts of the given models are coalesced into
+	 */
+	int coalescedInserts(const std::vector<const Model*>& models) {
+		std::vector<DBExecutor::Statement> statements;
+		for (const Model* model : models) {
+			statements.emplace_back(DBExecutor::createInsert(*model));
+		}
+		std::vector<DBExecutor::Query> queries;
+		DBExecutor::coalesce(statements, queries);
+		return (int)queries.size();
+	}
+};
+
+TEST_F(DBExecutorTest, testCoalesceChunks) {
+	// the rows share the map id and the seed - but the primary key is made up of all the columns
+	const db::TestChunkModel chunk1 = chunk(0);
+	const db::TestChunkModel chunk2 = chunk(1);
+	EXPECT_EQ(1, coalescedInserts({&chunk1, &chunk2}));
+}
+
+TEST_F(DBExecutorTest, testSameChunkIsNotCoalesced) {
+	const db::TestChunkModel chunk1 = chunk(0);
+	const db::TestChunkModel chunk2 = chunk(1);
+	EXPECT_EQ(2, coalescedInserts({&chunk1, &chunk2, &chunk1}));
+	// the keys of the rows after a repeated key are still known
+	EXPECT_EQ(3, coalescedInserts({&chunk1, &chunk1, &chunk1}));
+}
+
+TEST_F(DBExecutorTest, testSameUniqueKeyIsNotCoalesced) {
+	db::TestModel model1;
+	model1.setEmail("a@b.c");
+	model1.setName("a");
+	model1.setPassword("secret");
+	db::TestModel model2;
+	model2.setEmail("b@b.c");
+	model2.setName("b");
+	model2.setPassword("secret");
+	EXPECT_EQ(1, coalescedInserts({&model1, &model2}));
+	model2.setEmail("a@b.c");
+	EXPECT_EQ(2, coalescedInserts({&model1, &model2}));
+}
+
+TEST_F(DBExecutorTest, testSubmitAfterShutdown) {
+	DBExecutor executor(nullptr);
+	ASSERT_TRUE(executor.init(2));
+	executor.shutdown();
+	const db::TestChunkModel chunk1 = chunk(0);
+	std::future<bool> future = executor.insert(chunk1);
+	ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(0))) << "The promise must be fulfilled";
+	EXPECT_FALSE(future.get());
+}
+
+TEST_F(DBExecutorTest, testCompletionAfterShutdown) {
+	DBExecutor executor(nullptr);
+	ASSERT_TRUE(executor.init(2));
+	executor.shutdown();
+	const db::TestChunkModel chunk1 = chunk(0);
+	int completions = 0;
+	bool result = true;
+	std::future<bool> future = executor.insert(chunk1, [&] (bool success) {
+		++completions;
+		result = success;
+	});
+	ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(0))) << "The promise must be fulfilled";
+	EXPECT_FALSE(future.get());
+	EXPECT_EQ(1, completions) << "The completion callback must be called exactly once";
+	EXPECT_FALSE(result);
+}
+
+TEST_F(DBExecutorTest, testTruncateAfterShutdown) {
+	DBExecutor executor(nullptr);
+	ASSERT_TRUE(executor.init(2));
+	executor.shutdown();
+	std::future<bool> future = executor.truncate(chunk(0));
+	ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(0))) << "The promise must be fulfilled";
+	EXPECT_FALSE(future.get());
+}
+
+}
@@ -139,6 +139,39 @@ TEST_F(DatabaseModelTest, testBlob) {
 	_dbHandler.freeBlob(dataSelect);
 }
 
+TEST_F(DatabaseModelTest, testCopyInUpsert) {
+	if (!_supported) {
+		return;
+	}
+	uint8_t data[] = { 0x01, 0x02, 0x03, 0x04 };
+	uint8_t updatedData[] = { 0x05, 0x06 };
+	std::vector<db::BlobtestModel> models(2);
+	models[0].setId(1);
+	models[0].setData(Blob(data, sizeof(data)));
+	models[1].setId(2);
+	models[1].setData(Blob(data, sizeof(data)));
+	ASSERT_TRUE(_dbHandler.copyIn(models));
+	EXPECT_FALSE(_dbHandler.copyIn(models)) << "A plain copy doesn't handle existing keys";
+
+	models[0].setData(Blob(updatedData, sizeof(updatedData)));
+	models[1].setId(3);
+	EXPECT_TRUE(_dbHandler.copyIn(models, true));
+
+	db::BlobtestModel modelSelect;
+	modelSelect.setId(1);
+	EXPECT_TRUE(_dbHandler.select(modelSelect, persistence::DBConditionOne()));
+	Blob dataSelect = modelSelect.data();
+	EXPECT_EQ(dataSelect.length, sizeof(updatedData));
+	_dbHandler.freeBlob(dataSelect);
+	int count = 0;
+	_dbHandler.select(db::BlobtestModel(), persistence::DBConditionOne(), [&] (db::BlobtestModel&& model) {
+		++count;
+		Blob blob = model.data();
+		_dbHandler.freeBlob(blob);
+	});
+	EXPECT_EQ(3, count);
+}
+
 TEST_F(DatabaseModelTest, testCreateModels) {
 	if (!_supported) {
 		return;
@@ -279,6 +312,54 @@ TEST_F(DatabaseModelTest, test10Insert) {
 	massInsert(10);
 }
 
+TEST_F(DatabaseModelTest, testExecutorInsert) {
+	if (!_supported) {
+		return;
+	}
+	const int amount = 100;
+	std::vector<db::TestModel> models(amount);
+	std::vector<const Model*> modelPtrs(amount);
+	for (int i = 0; i < amount; ++i) {
+		models[i] = m(core::string::format("executor%i", i), "secret");
+		modelPtrs[i] = &models[i];
+	}
+	std::future<bool> future = _dbHandler.executor().insert(modelPtrs);
+	// the models are copied on submission
+	models.clear();
+	// the same unique key twice must not end up in the same statement
+	db::TestModel duplicate = m("executor0", "secret");
+	duplicate.setName("updated");
+	std::future<bool> duplicateFuture = _dbHandler.executor().insert(duplicate);
+	EXPECT_TRUE(future.get());
+	EXPECT_TRUE(duplicateFuture.get());
+	int count = 0;
+	_dbHandler.select(db::TestModel(), persistence::DBConditionOne(), [&] (db::TestModel&& model) {
+		++count;
+	});
+	EXPECT_EQ(count, amount);
+	core::String name;
+	EXPECT_TRUE(_dbHandler.select(db::TestModel(), db::DBConditionTestModelEmail("executor0"), [&] (db::TestModel&& model) {
+		name = model.name();
+	}));
+	EXPECT_EQ("updated", name);
+}
+
+TEST_F(DatabaseModelTest, testExecutorSelect) {
+	if (!_supported) {
+		return;
+	}
+	int64_t id = -1L;
+	createModel("testExecutorSelect@b.c.d", "secret", id);
+	db::TestModel key;
+	key.setId(id);
+	core::String email;
+	std::future<bool> future = _dbHandler.executor().select(key, [&] (db::TestModel&& model) {
+		email = model.email();
+	});
+	EXPECT_TRUE(future.get());
+	EXPECT_EQ("testexecutorselect@b.c.d", email);
+}
+
 TEST_F(DatabaseModelTest, testUpdate) {
 	if (!_supported) {
 		return;
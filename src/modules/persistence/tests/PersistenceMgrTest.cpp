@@ -50,7 +50,7 @@ public:
 		EXPECT_TRUE(mgr.init());
 		EXPECT_TRUE(mgr.registerSavable(FourCC('F','O','O','O'), this));
 		_dirtyModels.push_back(&in);
-		mgr.update(0l);
+		EXPECT_TRUE(mgr.update(0l));
 		EXPECT_TRUE(_dirtyModels.empty());
 		EXPECT_TRUE(mgr.unregisterSavable(FourCC('F','O','O','O'), this));
 		mgr.shutdown();
@@ -105,4 +105,45 @@ TEST_F(SQLGeneratorTest, testInsertMultiple) {
 	ASSERT_EQ(amount * 3, p.position);
 }
 
+TEST_F(SQLGeneratorTest, testCopyIn) {
+	db::TestModel model;
+	model.setId(1);
+	model.setName("testname");
+	std::vector<const Field*> columns;
+	ASSERT_EQ(R"(COPY "public"."test" ("id", "name") FROM STDIN (FORMAT binary))", createCopyInStatement(model, &columns));
+	ASSERT_EQ(2u, columns.size());
+	EXPECT_EQ("id", columns[0]->name);
+	EXPECT_EQ("name", columns[1]->name);
+}
+
+TEST_F(SQLGeneratorTest, testCopyInStaging) {
+	db::TestModel model;
+	model.setId(1);
+	model.setName("testname");
+	std::vector<const Field*> columns;
+	ASSERT_EQ(R"(CREATE TEMPORARY TABLE "test_staging" ON COMMIT DROP AS SELECT "id", "name" FROM "public"."test" WITH NO DATA;)",
+			createCreateStagingTableStatement(model));
+	ASSERT_EQ(R"(COPY "test_staging" ("id", "name") FROM STDIN (FORMAT binary))", createCopyInStagingStatement(model, &columns));
+	ASSERT_EQ(2u, columns.size());
+	ASSERT_EQ(R"(INSERT INTO "public"."test" ("id", "name") SELECT "id", "name" FROM "test_staging" ON CONFLICT ("id") DO UPDATE SET "name" = EXCLUDED."name";)",
+			createInsertFromStagingStatement(model));
+}
+
+TEST_F(SQLGeneratorTest, testCopyOut) {
+	db::TestModel model;
+	model.setId(42);
+	model.setSomeboolean(true);
+	std::vector<const Field*> columns;
+	const core::String& stmt = createCopyOutStatement(model, &columns);
+	EXPECT_TRUE(SDL_strstr(stmt.c_str(), R"( FROM "public"."test" WHERE "id" = 42 AND "someboolean" = TRUE) TO STDOUT (FORMAT binary))") != nullptr) << stmt;
+	// the password is not part of the result
+	EXPECT_EQ(model.fields().size() - 1u, columns.size());
+}
+
+TEST_F(SQLGeneratorTest, testCopyOutInvalidCondition) {
+	db::TestModel model;
+	model.setName("testname");
+	EXPECT_EQ("", createCopyOutStatement(model));
+}
+
 }
@@ -0,0 +1,45 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "persistence/State.h"
+
+namespace persistence {
+
+class StateTest : public core::AbstractTest {
+};
+
+TEST_F(StateTest, testTextValues) {
+	const State state(nullptr, false);
+	EXPECT_FALSE(state.isBinary());
+	EXPECT_EQ(-42, state.toLong("-42", 3));
+	EXPECT_EQ(4294967296l, state.toLong("4294967296", 10));
+	EXPECT_DOUBLE_EQ(1.5, state.toDouble("1.5", 3));
+	EXPECT_TRUE(state.toBool("t", 1));
+	EXPECT_FALSE(state.toBool("f", 1));
+	EXPECT_FALSE(state.toBool("", 0));
+}
+
+TEST_F(StateTest, testBinaryValues) {
+	const State state(nullptr, true);
+	EXPECT_TRUE(state.isBinary());
+	// network byte order
+	const char int2[] = { (char)0xff, (char)0xd6 };
+	EXPECT_EQ(-42, state.toLong(int2, sizeof(int2)));
+	const char int4[] = { 0x00, 0x01, 0x00, 0x02 };
+	EXPECT_EQ(65538, state.toLong(int4, sizeof(int4)));
+	const char int8[] = { 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00 };
+	EXPECT_EQ(4294967296l, state.toLong(int8, sizeof(int8)));
+	const char float8[] = { 0x3f, (char)0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	EXPECT_DOUBLE_EQ(1.5, state.toDouble(float8, sizeof(float8)));
+	const char float4[] = { 0x3f, (char)0xc0, 0x00, 0x00 };
+	EXPECT_DOUBLE_EQ(1.5, state.toDouble(float4, sizeof(float4)));
+	const char boolTrue[] = { 0x01 };
+	const char boolFalse[] = { 0x00 };
+	EXPECT_TRUE(state.toBool(boolTrue, sizeof(boolTrue)));
+	EXPECT_FALSE(state.toBool(boolFalse, sizeof(boolFalse)));
+	EXPECT_EQ(0, state.toLong("", 0)) << "Null values must be converted to 0";
+}
+
+}
@@ -196,6 +196,22 @@ bool Buffer::update(int32_t idx, const void* data, size_t size) {
 	return true;
 }
 
+bool Buffer::updateSubData(int32_t idx, size_t offset, const void* data, size_t size) {
+	if (!isValid(idx)) {
+		return false;
+	}
+	if (offset + size > _size[idx]) {
+		Log::error("Buffer sub data update exceeds the buffer size (%i vs %i)", (int)(offset + size), (int)_size[idx]);
+		return false;
+	}
+	core_assert(video::boundVertexArray() == InvalidId);
+#if VIDEO_BUFFER_HASH_COMPARE
+	_hash[idx] = 0u;
+#endif
+	video::bufferSubData(_handles[idx], _targets[idx], (intptr_t)offset, data, size);
+	return true;
+}
+
 int32_t Buffer::create(const void* data, size_t size, BufferType target) {
 	if (_handleIdx >= MAX_HANDLES) {
 		return -1;
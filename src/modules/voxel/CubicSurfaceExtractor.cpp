@@ -4,6 +4,8 @@
 
 #include "CubicSurfaceExtractor.h"
 #include <SDL.h>
+#include <algorithm>
+#include <limits>
 
 namespace voxel {
 
@@ -86,17 +88,6 @@ static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent) {
 	return didMerge;
 }
 
-/**
- * @brief We are checking the voxels above us. There are four possible ambient occlusion values
- * for a vertex.
- */
-SDL_FORCE_INLINE uint8_t vertexAmbientOcclusion(bool side1, bool side2, bool corner) {
-	if (side1 && side2) {
-		return 0;
-	}
-	return 3 - (side1 + side2 + corner);
-}
-
 void meshify(Mesh* result, bool mergeQuads, QuadListVector& vecListQuads) {
 	core_trace_scoped(GenerateMeshify);
 	for (QuadList& listQuads : vecListQuads) {
@@ -132,10 +123,7 @@ void meshify(Mesh* result, bool mergeQuads, QuadListVector& vecListQuads) {
 IndexType addVertex(bool reuseVertices, uint32_t uX, uint32_t uY, uint32_t uZ, const Voxel& materialIn, Array& existingVertices,
 		Mesh* meshCurrent, const VoxelType face1, const VoxelType face2, const VoxelType corner, const glm::ivec3& offset) {
 	core_trace_scoped(AddVertex);
-	const uint8_t ambientOcclusion = vertexAmbientOcclusion(
-		!isAir(face1) && !isWater(face1),
-		!isAir(face2) && !isWater(face2),
-		!isAir(corner) && !isWater(corner));
+	const uint8_t ambientOcclusion = vertexAmbientOcclusion(isOccluding(face1), isOccluding(face2), isOccluding(corner));
 
 	for (uint32_t ct = 0; ct < MaxVerticesPerPosition; ++ct) {
 		VertexData& entry = existingVertices(uX, uY, ct);
@@ -167,4 +155,145 @@ IndexType addVertex(bool reuseVertices, uint32_t uX, uint32_t uY, uint32_t uZ, c
 	return 0; //Should never happen.
 }
 
+GreedyMeshArena::GreedyMeshArena(const glm::ivec3& regionSize, int tasks) :
+		_size(regionSize + 2), _tasks(tasks) {
+	_maskCells = core_max(core_max(regionSize.y * regionSize.z, regionSize.x * regionSize.z), regionSize.x * regionSize.y);
+	const size_t voxelBytes = (size_t)_size.x * _size.y * _size.z * sizeof(Voxel);
+	// keep the masks aligned to their element size
+	const size_t maskOffset = (voxelBytes + sizeof(GreedyMaskCell) - 1) / sizeof(GreedyMaskCell) * sizeof(GreedyMaskCell);
+	const size_t maskBytes = (size_t)_tasks * 2 * _maskCells * sizeof(GreedyMaskCell);
+	_buffer = (uint8_t*)core_malloc(maskOffset + maskBytes);
+	_masks = (GreedyMaskCell*)(_buffer + maskOffset);
+}
+
+GreedyMeshArena::~GreedyMeshArena() {
+	core_free(_buffer);
+}
+
+GreedyMaskCell* GreedyMeshArena::masks(int task) const {
+	core_assert_msg(task >= 0 && task < _tasks, "Invalid greedy mesh task %i", task);
+	return _masks + (size_t)task * 2 * _maskCells;
+}
+
+/**
+ * @brief Adds the quad for the merged mask cells in the corner order and orientation of the non-greedy extractor
+ */
+static void addGreedyQuad(GreedyMaskCell cell, FaceNames face, const glm::ivec3& sliceOrigin, int uAxis, int vAxis,
+		int u, int v, int width, int height, GreedyMeshBuffer& buffer) {
+	// the mask cell corners are stored counter clockwise in the u/v plane
+	static const int cornerU[] = {0, 1, 1, 0};
+	static const int cornerV[] = {0, 0, 1, 1};
+	static const int forwardCorners[] = {0, 1, 2, 3};
+	static const int reversedCorners[] = {0, 3, 2, 1};
+	const bool reversed = face == PositiveX || face == PositiveY || face == NegativeZ;
+	const int* corners = reversed ? reversedCorners : forwardCorners;
+
+	VoxelVertex vertex;
+	vertex.colorIndex = (uint8_t)(cell >> 8);
+	vertex.material = (VoxelType)((cell >> 16) & 0xff);
+	vertex.padding = 0u;
+	const IndexType base = (IndexType)buffer.vertices.size();
+	for (int i = 0; i < 4; ++i) {
+		const int corner = corners[i];
+		vertex.position = sliceOrigin;
+		vertex.position[uAxis] += u + cornerU[corner] * width;
+		vertex.position[vAxis] += v + cornerV[corner] * height;
+		vertex.ambientOcclusion = (uint8_t)((cell >> (corner * 2)) & 3u);
+		buffer.vertices.push_back(vertex);
+	}
+
+	const VoxelVertex* quad = &buffer.vertices[base];
+	if (isQuadFlipped(quad[3], quad[0], quad[2], quad[1])) {
+		buffer.indices.insert(buffer.indices.end(), {base + 1, base + 2, base + 3, base + 1, base + 3, base + 0});
+	} else {
+		buffer.indices.insert(buffer.indices.end(), {base + 0, base + 1, base + 2, base + 0, base + 2, base + 3});
+	}
+}
+
+SDL_FORCE_INLINE uint32_t greedyVertexHash(const VoxelVertex& vertex) {
+	uint32_t hash = (uint32_t)vertex.position.x * 73856093u;
+	hash ^= (uint32_t)vertex.position.y * 19349663u;
+	hash ^= (uint32_t)vertex.position.z * 83492791u;
+	hash ^= ((uint32_t)vertex.ambientOcclusion | ((uint32_t)vertex.colorIndex << 8) | ((uint32_t)vertex.material << 16)) * 2654435761u;
+	return hash ^ (hash >> 16);
+}
+
+SDL_FORCE_INLINE bool isSameGreedyVertex(const VoxelVertex& v1, const VoxelVertex& v2) {
+	return v1.position == v2.position && v1.ambientOcclusion == v2.ambientOcclusion
+			&& v1.colorIndex == v2.colorIndex && v1.material == v2.material;
+}
+
+void greedyMergeBuffers(const std::vector<GreedyMeshBuffer>& buffers, Mesh* result) {
+	core_trace_scoped(GenerateMesh);
+	size_t vertices = 0u;
+	size_t indices = 0u;
+	for (const GreedyMeshBuffer& buffer : buffers) {
+		vertices += buffer.vertices.size();
+		indices += buffer.indices.size();
+	}
+	VertexArray& vertexArray = result->getVertexVector();
+	IndexArray& indexArray = result->getIndexVector();
+	vertexArray.reserve(vertices);
+	indexArray.reserve(indices);
+
+	// open addressing table of the mesh vertex indices - kept at a load factor of at most 0.5
+	size_t tableSize = 16u;
+	while (tableSize < vertices * 2u) {
+		tableSize <<= 1;
+	}
+	const size_t tableMask = tableSize - 1u;
+	const IndexType empty = (std::numeric_limits<IndexType>::max)();
+	std::vector<IndexType> table(tableSize, empty);
+	std::vector<IndexType> remap;
+	for (const GreedyMeshBuffer& buffer : buffers) {
+		remap.resize(buffer.vertices.size());
+		for (size_t i = 0; i < buffer.vertices.size(); ++i) {
+			const VoxelVertex& vertex = buffer.vertices[i];
+			size_t slot = greedyVertexHash(vertex) & tableMask;
+			while (table[slot] != empty && !isSameGreedyVertex(vertexArray[table[slot]], vertex)) {
+				slot = (slot + 1u) & tableMask;
+			}
+			if (table[slot] == empty) {
+				table[slot] = (IndexType)vertexArray.size();
+				vertexArray.push_back(vertex);
+			}
+			remap[i] = table[slot];
+		}
+		for (IndexType index : buffer.indices) {
+			indexArray.push_back(remap[index]);
+		}
+	}
+}
+
+void greedyMeshSlice(GreedyMaskCell* mask, int width, int height, FaceNames face, const glm::ivec3& sliceOrigin,
+		int uAxis, int vAxis, GreedyMeshBuffer& buffer) {
+	core_trace_scoped(GreedyMeshSlice);
+	for (int v = 0; v < height; ++v) {
+		GreedyMaskCell* row = mask + v * width;
+		for (int u = 0; u < width;) {
+			const GreedyMaskCell cell = row[u];
+			if (cell == 0u) {
+				++u;
+				continue;
+			}
+			int quadWidth = 1;
+			while (u + quadWidth < width && row[u + quadWidth] == cell) {
+				++quadWidth;
+			}
+			int quadHeight = 1;
+			for (; v + quadHeight < height; ++quadHeight) {
+				const GreedyMaskCell* nextRow = mask + (v + quadHeight) * width + u;
+				if (std::find_if(nextRow, nextRow + quadWidth, [cell] (GreedyMaskCell c) { return c != cell; }) != nextRow + quadWidth) {
+					break;
+				}
+			}
+			for (int i = 1; i < quadHeight; ++i) {
+				std::fill_n(mask + (v + i) * width + u, quadWidth, 0u);
+			}
+			addGreedyQuad(cell, face, sliceOrigin, uAxis, vAxis, u, v, quadWidth, quadHeight, buffer);
+			u += quadWidth;
+		}
+	}
+}
+
 }
@@ -16,6 +16,7 @@
 #include <glm/vec3.hpp>
 #include <list>
 #include "core/Trace.h"
+#include "core/concurrent/ThreadPool.h"
 #include "Face.h"
 
 namespace voxel {
@@ -110,6 +111,21 @@ SDL_FORCE_INLINE bool isQuadFlipped(const VoxelVertex& v00, const VoxelVertex& v
 
 extern void meshify(Mesh* result, bool mergeQuads, QuadListVector& vecListQuads);
 
+SDL_FORCE_INLINE bool isOccluding(VoxelType material) {
+	return !isAir(material) && !isWater(material);
+}
+
+/**
+ * @brief We are checking the voxels above us. There are four possible ambient occlusion values
+ * for a vertex.
+ */
+SDL_FORCE_INLINE uint8_t vertexAmbientOcclusion(bool side1, bool side2, bool corner) {
+	if (side1 && side2) {
+		return 0;
+	}
+	return 3 - (side1 + side2 + corner);
+}
+
 /**
  * The CubicSurfaceExtractor creates a mesh in which each voxel appears to be rendered as a cube
  * Introduction
@@ -453,6 +469,221 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 	result->removeUnusedVertices();
 }
 
+/**
+ * @section Greedy surface extraction
+ */
+
+/**
+ * @brief A cell of the per slice face mask of the greedy mesher. A value of @c 0 means that no quad is needed
+ * for the cell. Otherwise the voxel and the ambient occlusion values of the four quad corners are packed into
+ * the cell - and two cells can only get merged into one quad if their values are equal.
+ */
+typedef uint32_t GreedyMaskCell;
+
+/**
+ * @brief Dense copy of the extraction region (including a one voxel border for the neighbour lookups) and the
+ * face masks of every slice task. Everything is carved out of a single allocation per extraction.
+ */
+class GreedyMeshArena : public core::NonCopyable {
+private:
+	uint8_t* _buffer;
+	GreedyMaskCell* _masks;
+	glm::ivec3 _size;
+	int _maskCells;
+	int _tasks;
+public:
+	GreedyMeshArena(const glm::ivec3& regionSize, int tasks);
+	~GreedyMeshArena();
+
+	inline Voxel* voxels() const {
+		return (Voxel*)_buffer;
+	}
+
+	/**
+	 * @return The voxel index distance of two neighbouring voxels along the given axis
+	 */
+	inline int stride(int axis) const {
+		if (axis == 0) {
+			return 1;
+		}
+		if (axis == 1) {
+			return _size.x;
+		}
+		return _size.x * _size.y;
+	}
+
+	/**
+	 * @return The face masks of the given task - one for the negative and one for the positive face
+	 * direction, each of them big enough for the largest slice of the region.
+	 */
+	GreedyMaskCell* masks(int task) const;
+
+	inline const glm::ivec3& size() const {
+		return _size;
+	}
+};
+
+/**
+ * @brief The vertices and indices a greedy slice task produced. They are appended to the resulting
+ * mesh in task order, which makes the output independent of the amount of threads.
+ * @sa greedyMergeBuffers()
+ */
+struct GreedyMeshBuffer {
+	VertexArray vertices;
+	IndexArray indices;
+};
+
+SDL_FORCE_INLINE GreedyMaskCell greedyMaskCell(const Voxel* voxels, const Voxel& voxel, int outside, int strideU, int strideV) {
+	const bool u0 = isOccluding(voxels[outside - strideU].getMaterial());
+	const bool u1 = isOccluding(voxels[outside + strideU].getMaterial());
+	const bool v0 = isOccluding(voxels[outside - strideV].getMaterial());
+	const bool v1 = isOccluding(voxels[outside + strideV].getMaterial());
+	const uint32_t ao0 = vertexAmbientOcclusion(u0, v0, isOccluding(voxels[outside - strideU - strideV].getMaterial()));
+	const uint32_t ao1 = vertexAmbientOcclusion(u1, v0, isOccluding(voxels[outside + strideU - strideV].getMaterial()));
+	const uint32_t ao2 = vertexAmbientOcclusion(u1, v1, isOccluding(voxels[outside + strideU + strideV].getMaterial()));
+	const uint32_t ao3 = vertexAmbientOcclusion(u0, v1, isOccluding(voxels[outside - strideU + strideV].getMaterial()));
+	return (1u << 24) | ((uint32_t)voxel.getMaterial() << 16) | ((uint32_t)voxel.getColor() << 8)
+			| ao0 | (ao1 << 2) | (ao2 << 4) | (ao3 << 6);
+}
+
+/**
+ * @brief Merges the cells of the given face mask into as few rectangles as possible and adds a quad for each of them.
+ * @param[in,out] mask The face mask of the slice - it's cleared while the cells are consumed.
+ * @param sliceOrigin The world position of the lower corner of the first mask cell.
+ * @param uAxis The axis the mask rows are extending along.
+ * @param vAxis The axis the mask columns are extending along.
+ */
+extern void greedyMeshSlice(GreedyMaskCell* mask, int width, int height, FaceNames face, const glm::ivec3& sliceOrigin,
+		int uAxis, int vAxis, GreedyMeshBuffer& buffer);
+
+/**
+ * @brief Appends the task buffers to the mesh. Like @c addVertex() does for the non-greedy extractor, vertices
+ * with the same position, voxel and ambient occlusion value are only added once and are shared between the quads
+ * of all tasks.
+ */
+extern void greedyMergeBuffers(const std::vector<GreedyMeshBuffer>& buffers, Mesh* result);
+
+/**
+ * @brief Builds the face masks for the slices [sliceStart, sliceEnd] (in arena coordinates) along the given axis and
+ * hands them over to @c greedyMeshSlice()
+ */
+template<typename IsQuadNeeded>
+void extractGreedySlices(const GreedyMeshArena& arena, const glm::ivec3& offset, int axis, int sliceStart, int sliceEnd,
+		GreedyMaskCell* masks, IsQuadNeeded& isQuadNeeded, GreedyMeshBuffer& buffer) {
+	core_trace_scoped(ExtractGreedySlices);
+	// the quad corner order of the non-greedy extractor is kept: the rows of the x slices are extending along z
+	const int uAxis = axis == 0 ? 2 : 0;
+	const int vAxis = axis == 1 ? 2 : 1;
+	const FaceNames negativeFace = (FaceNames)(NegativeX + axis);
+	const FaceNames positiveFace = (FaceNames)(PositiveX + axis);
+	const glm::ivec3& size = arena.size();
+	const int width = size[uAxis] - 2;
+	const int height = size[vAxis] - 2;
+	const int strideD = arena.stride(axis);
+	const int strideU = arena.stride(uAxis);
+	const int strideV = arena.stride(vAxis);
+	const Voxel* voxels = arena.voxels();
+	GreedyMaskCell* negativeMask = masks;
+	GreedyMaskCell* positiveMask = masks + width * height;
+
+	for (int slice = sliceStart; slice <= sliceEnd; ++slice) {
+		GreedyMaskCell* negativeCell = negativeMask;
+		GreedyMaskCell* positiveCell = positiveMask;
+		for (int v = 1; v <= height; ++v) {
+			int index = slice * strideD + v * strideV + strideU;
+			for (int u = 1; u <= width; ++u, index += strideU) {
+				const Voxel& current = voxels[index];
+				const Voxel& previous = voxels[index - strideD];
+				const VoxelType currentMaterial = current.getMaterial();
+				const VoxelType previousMaterial = previous.getMaterial();
+				*negativeCell++ = isQuadNeeded(currentMaterial, previousMaterial, negativeFace)
+						? greedyMaskCell(voxels, current, index - strideD, strideU, strideV) : 0u;
+				*positiveCell++ = isQuadNeeded(previousMaterial, currentMaterial, positiveFace)
+						? greedyMaskCell(voxels, previous, index, strideU, strideV) : 0u;
+			}
+		}
+		glm::ivec3 sliceOrigin = offset;
+		sliceOrigin[axis] += slice - 1;
+		greedyMeshSlice(negativeMask, width, height, negativeFace, sliceOrigin, uAxis, vAxis, buffer);
+		greedyMeshSlice(positiveMask, width, height, positiveFace, sliceOrigin, uAxis, vAxis, buffer);
+	}
+}
+
+/**
+ * @brief Greedy meshing variant of @c extractCubicMesh()
+ *
+ * The voxels of the region are copied into a flat array first. Every slice of the region is then turned into a
+ * face mask per face direction, and the mask cells are merged into the biggest possible rectangles. Cells are only
+ * merged if they share the same voxel and the same ambient occlusion values at all four corners, which keeps the
+ * quad orientation that @c isQuadFlipped() picks for the single voxel faces. The quads share their vertices.
+ *
+ * @param threadPool If given, the slices of each axis are split into one range per pool thread and extracted in
+ * parallel. The resulting mesh is the same as without a pool.
+ * @note Don't hand in the pool of the thread that is calling this - waiting for the slice tasks would dead lock.
+ */
+template<typename VolumeType, typename IsQuadNeeded>
+void extractGreedyCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, core::ThreadPool* threadPool = nullptr) {
+	core_trace_scoped(ExtractGreedyCubicMesh);
+
+	result->clear();
+	const glm::ivec3& offset = region.getLowerCorner();
+	const glm::ivec3& regionSize = region.getDimensionsInVoxels();
+	result->setOffset(offset);
+
+	const int tasksPerAxis = threadPool == nullptr ? 1 : core_max(1, (int)threadPool->size());
+	const int tasks = 3 * tasksPerAxis;
+	GreedyMeshArena arena(regionSize, tasks);
+
+	{
+		core_trace_scoped(GreedyVoxelCopy);
+		typename VolumeType::Sampler volumeSampler(volData);
+		const glm::ivec3& size = arena.size();
+		Voxel* voxels = arena.voxels();
+		for (int z = 0; z < size.z; ++z) {
+			for (int y = 0; y < size.y; ++y) {
+				volumeSampler.setPosition(offset.x - 1, offset.y - 1 + y, offset.z - 1 + z);
+				for (int x = 0; x < size.x; ++x) {
+					*voxels++ = volumeSampler.voxel();
+					if (core_likely(x != size.x - 1)) {
+						volumeSampler.movePositiveX();
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<GreedyMeshBuffer> buffers(tasks);
+	auto extractTask = [&arena, &offset, &regionSize, &buffers, tasksPerAxis, isQuadNeeded] (int task) {
+		IsQuadNeeded quadNeeded = isQuadNeeded;
+		const int axis = task / tasksPerAxis;
+		const int part = task % tasksPerAxis;
+		const int slices = regionSize[axis];
+		const int sliceStart = 1 + slices * part / tasksPerAxis;
+		const int sliceEnd = slices * (part + 1) / tasksPerAxis;
+		extractGreedySlices(arena, offset, axis, sliceStart, sliceEnd, arena.masks(task), quadNeeded, buffers[task]);
+	};
+
+	if (threadPool == nullptr) {
+		for (int task = 0; task < tasks; ++task) {
+			extractTask(task);
+		}
+	} else {
+		std::vector<std::future<void>> futures;
+		futures.reserve(tasks);
+		for (int task = 0; task < tasks; ++task) {
+			futures.emplace_back(threadPool->enqueue(extractTask, task));
+		}
+		for (std::future<void>& future : futures) {
+			future.wait();
+		}
+	}
+
+	greedyMergeBuffers(buffers, result);
+
+	// there are no unused vertices - but this updates the mesh bounds
+	result->removeUnusedVertices();
+}
+
 }
 
 #undef BUFFERED_SAMPLER
@@ -22,6 +22,7 @@ namespace voxel {
 class MaterialColor {
 private:
 	MaterialColorArray _materialColors;
+	MaterialColorHSBArray _materialColorsHSB;
 	core::Map<VoxelType, MaterialColorIndices, 8, EnumClassHash> _colorMapping;
 	bool _initialized = false;
 	bool _dirty = false;
@@ -46,9 +47,14 @@ public:
 			return false;
 		}
 		_materialColors.reserve(colors);
+		_materialColorsHSB.reserve(colors);
 		const uint32_t* paletteData = (const uint32_t*)paletteBuffer;
 		for (int i = 0; i < colors; ++i) {
-			_materialColors.emplace_back(core::Color::fromRGBA(*paletteData));
+			const glm::vec4& color = core::Color::fromRGBA(*paletteData);
+			_materialColors.emplace_back(color);
+			glm::vec3 hsb;
+			core::Color::getHSB(color, hsb.x, hsb.y, hsb.z);
+			_materialColorsHSB.emplace_back(hsb);
 			++paletteData;
 		}
 		Log::info("Set up %i material colors", (int)_materialColors.size());
@@ -145,6 +151,7 @@ public:
 
 	void shutdown() {
 		_materialColors.clear();
+		_materialColorsHSB.clear();
 		_colorMapping.clear();
 		_initialized = false;
 		_dirty = false;
@@ -164,6 +171,11 @@ public:
 		return _materialColors;
 	}
 
+	inline const MaterialColorHSBArray& getColorsHSB() const {
+		core_assert_msg(_initialized, "Material colors are not yet initialized");
+		return _materialColorsHSB;
+	}
+
 	inline const MaterialColorIndices& getColorIndices(VoxelType type) const {
 		auto i = _colorMapping.find(type);
 		if (i == _colorMapping.end()) {
@@ -306,6 +318,10 @@ const MaterialColorArray& getMaterialColors() {
 	return getInstance().getColors();
 }
 
+const MaterialColorHSBArray& getMaterialColorsHSB() {
+	return getInstance().getColorsHSB();
+}
+
 const glm::vec4& getMaterialColor(const Voxel& voxel) {
 	return getMaterialColors()[voxel.getColor()];
 }
@@ -8,6 +8,7 @@
 #include "core/io/File.h"
 #include "image/Image.h"
 
+#include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <vector>
 #include "core/String.h"
@@ -21,6 +22,8 @@ namespace voxel {
 // this size must match the color uniform size in the shader
 typedef std::vector<glm::vec4> MaterialColorArray;
 typedef std::vector<uint8_t> MaterialColorIndices;
+// hue, saturation and brightness of the material colors
+typedef std::vector<glm::vec3> MaterialColorHSBArray;
 
 extern const char* getDefaultPaletteName();
 extern core::String extractPaletteName(const core::String& file);
@@ -34,6 +37,11 @@ extern void shutdownMaterialColors();
 extern void materialColorMarkClean();
 extern bool materialColorChanged();
 extern const MaterialColorArray& getMaterialColors();
+/**
+ * @brief The material colors converted to hue, saturation and brightness - computed once when the colors are initialized
+ * @sa core::Color::getClosestMatchHSB()
+ */
+extern const MaterialColorHSBArray& getMaterialColorsHSB();
 extern const glm::vec4& getMaterialColor(const Voxel& voxel);
 
 extern bool createPalette(const image::ImagePtr& image, uint32_t *colorsBuffer, int colors);
@@ -7,6 +7,7 @@
 #include "core/Common.h"
 #include "core/Trace.h"
 #include "core/Assert.h"
+#include "core/Log.h"
 #include <glm/vector_relational.hpp>
 #include <glm/common.hpp>
 
@@ -152,4 +153,85 @@ bool Mesh::operator<(const Mesh& rhs) const {
 	return glm::all(glm::lessThan(getOffset(), rhs.getOffset()));
 }
 
+bool Mesh::pack(PackedMesh& packed) const {
+	core_trace_scoped(MeshPack);
+	constexpr uint32_t maxRangeVertices = (std::numeric_limits<PackedIndexType>::max)();
+	const size_t vertices = _vecVertices.size();
+	const size_t indices = _vecIndices.size();
+	packed.offset = _offset;
+	packed.mins = glm::ivec3((std::numeric_limits<int>::max)());
+	packed.maxs = glm::ivec3((std::numeric_limits<int>::min)());
+	packed.vertices.resize(vertices);
+	packed.indices.resize(indices);
+	packed.ranges.clear();
+
+	for (size_t i = 0u; i < vertices; ++i) {
+		const VoxelVertex& v = _vecVertices[i];
+		const glm::ivec3 position = v.position - _offset;
+		if (glm::any(glm::lessThan(position, glm::ivec3(0))) || glm::any(glm::greaterThan(position, glm::ivec3(MaxPackedVertexPosition)))) {
+			Log::debug("Vertex position %i:%i:%i exceeds the packed vertex range", position.x, position.y, position.z);
+			return false;
+		}
+		VoxelVertexPacked& p = packed.vertices[i];
+		p.position = glm::u8vec3(position);
+		p.padding0 = 0u;
+		p.ambientOcclusion = v.ambientOcclusion;
+		p.colorIndex = v.colorIndex;
+		p.material = v.material;
+		p.padding1 = 0u;
+		packed.mins = (glm::min)(packed.mins, v.position);
+		packed.maxs = (glm::max)(packed.maxs, v.position);
+	}
+
+	if (vertices == 0u) {
+		packed.mins = packed.maxs = glm::ivec3(0);
+	}
+
+	// start a new range whenever a triangle refers to vertices that are out of reach of the current base vertex
+	PackedRange range { 0u, 0u, 0u };
+	for (size_t i = 0u; i < indices; i += 3) {
+		const IndexType i0 = _vecIndices[i + 0];
+		const IndexType i1 = _vecIndices[i + 1];
+		const IndexType i2 = _vecIndices[i + 2];
+		const IndexType lowest = core_min(i0, core_min(i1, i2));
+		const IndexType highest = core_max(i0, core_max(i1, i2));
+		if (highest - lowest > maxRangeVertices) {
+			Log::debug("Triangle spans more vertices than the packed indices can address");
+			return false;
+		}
+		if (range.numIndices == 0u) {
+			range.baseVertex = lowest;
+		} else if (lowest < range.baseVertex || highest - range.baseVertex > maxRangeVertices) {
+			packed.ranges.push_back(range);
+			range.baseIndex += range.numIndices;
+			range.numIndices = 0u;
+			range.baseVertex = lowest;
+		}
+		packed.indices[i + 0] = (PackedIndexType)(i0 - range.baseVertex);
+		packed.indices[i + 1] = (PackedIndexType)(i1 - range.baseVertex);
+		packed.indices[i + 2] = (PackedIndexType)(i2 - range.baseVertex);
+		range.numIndices += 3u;
+	}
+	if (range.numIndices > 0u) {
+		packed.ranges.push_back(range);
+	}
+	return true;
+}
+
+size_t PackedMesh::size() const {
+	constexpr size_t classSize = sizeof(*this);
+	const size_t indicesSize = indices.size() * sizeof(PackedIndexType);
+	const size_t verticesSize = vertices.size() * sizeof(VoxelVertexPacked);
+	const size_t rangesSize = ranges.size() * sizeof(PackedRange);
+	return classSize + indicesSize + verticesSize + rangesSize;
+}
+
+bool PackedMesh::isEmpty() const {
+	return vertices.empty() || indices.empty();
+}
+
+bool PackedMesh::operator<(const PackedMesh& rhs) const {
+	return glm::all(glm::lessThan(offset, rhs.offset));
+}
+
 }
@@ -11,6 +11,38 @@ namespace voxel {
 
 using VertexArray = std::vector<voxel::VoxelVertex>;
 using IndexArray = std::vector<voxel::IndexType>;
+using PackedVertexArray = std::vector<voxel::VoxelVertexPacked>;
+using PackedIndexArray = std::vector<voxel::PackedIndexType>;
+
+/**
+ * @brief A range of packed indices that are relative to the given base vertex
+ */
+struct PackedRange {
+	uint32_t baseIndex;
+	uint32_t numIndices;
+	uint32_t baseVertex;
+};
+
+/**
+ * @brief A mesh in the packed vertex layout with 16 bit indices. The vertex positions are relative
+ * to the offset - the vertices of each range must be drawn with their base vertex.
+ * @sa Mesh::pack()
+ */
+struct PackedMesh {
+	PackedVertexArray vertices;
+	PackedIndexArray indices;
+	std::vector<PackedRange> ranges;
+	glm::ivec3 offset { 0 };
+	glm::ivec3 mins { 0 };
+	glm::ivec3 maxs { 0 };
+
+	/**
+	 * @brief Calculate the memory amount this mesh is using
+	 */
+	size_t size() const;
+	bool isEmpty() const;
+	bool operator<(const PackedMesh& rhs) const;
+};
 
 /**
  * @brief A simple and general-purpose mesh class to represent the data returned by the surface extraction functions.
@@ -48,6 +80,13 @@ public:
 	bool isEmpty() const;
 	void removeUnusedVertices();
 
+	/**
+	 * @brief Converts the mesh into the packed vertex layout with 16 bit indices
+	 * @return @c false if the mesh extent doesn't fit into the 8 bit vertex positions or a triangle
+	 * spans more vertices than a 16 bit index can address.
+	 */
+	bool pack(PackedMesh& packed) const;
+
 	const glm::ivec3& mins() const;
 	const glm::ivec3& maxs() const;
 
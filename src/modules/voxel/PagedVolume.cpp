@@ -9,9 +9,17 @@
 #include "core/Common.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/round.hpp>
+#include <glm/gtx/norm.hpp>
+#include <SDL_timer.h>
+#include <algorithm>
+#include <vector>
 
 namespace voxel {
 
+static inline uint64_t microsSince(uint64_t start) {
+	return (SDL_GetPerformanceCounter() - start) * 1000000u / SDL_GetPerformanceFrequency();
+}
+
 /**
  * This constructor creates a volume with a fixed size which is specified as a parameter. By default this constructor will not enable paging
  * but you can override this if desired. If you do wish to enable
@@ -20,8 +28,10 @@ namespace voxel {
  * @param targetMemoryUsageInBytes The upper limit to how much memory this PagedVolume should aim to use.
  * @param chunkSideLength The size of the chunks making up the volume. Small chunks will compress/decompress faster, but there will also be
  * more of them meaning voxel access could be slower.
+ * @param compressedMemoryFraction The part of the memory limit that is used to keep evicted chunks in compressed form. Set to @c 0 to
+ * hand evicted chunks back to the pager immediately.
  */
-PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength) :
+PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength, float compressedMemoryFraction) :
 		_chunkSideLength(chunkSideLength), _pager(pager), _region(0, 0, 0, -1, -1, -1) {
 	// Validation of parameters
 	core_assert_msg(_pager, "You must provide a valid pager when constructing a PagedVolume");
@@ -29,27 +39,47 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
 	core_assert_msg(_chunkSideLength != 0, "Chunk side length cannot be zero.");
 	core_assert_msg(_chunkSideLength <= 256, "Chunk size is too large to be practical.");
 	core_assert_msg(glm::isPowerOfTwo(_chunkSideLength), "Chunk side length must be a power of two.");
+	core_assert_msg(compressedMemoryFraction >= 0.0f && compressedMemoryFraction < 1.0f, "Compressed memory fraction must be in [0, 1).");
 
 	// Used to perform multiplications and divisions by bit shifting.
 	_chunkSideLengthPower = logBase2(_chunkSideLength);
 	// Use to perform modulo by bit operations
 	_chunkMask = _chunkSideLength - 1;
 
-	// Calculate the number of chunks based on the memory limit and the size of each chunk.
-	uint32_t chunkSizeInBytes = PagedVolume::Chunk::calculateSizeInBytes(_chunkSideLength);
-	_chunkCountLimit = targetMemoryUsageInBytes / chunkSizeInBytes;
+	// Split the memory limit between the uncompressed and the compressed chunks
+	compressedMemoryFraction = glm::clamp(compressedMemoryFraction, 0.0f, 1.0f);
+	_compressedMemoryLimit = (uint32_t)((double)targetMemoryUsageInBytes * compressedMemoryFraction);
+	const uint32_t uncompressedMemoryLimit = targetMemoryUsageInBytes - _compressedMemoryLimit;
 
-	// Enforce sensible limits on the number of chunks.
-	const uint32_t minPracticalNoOfChunks = 32; // Enough to make sure a chunks and it's neighbours can be loaded, with a few to spare.
-	if (_chunkCountLimit < minPracticalNoOfChunks) {
-		Log::warn("Requested memory usage limit of %uMb is too low and cannot be adhered to. Chunk limit is at %i, Chunk size: %uKb",
-				targetMemoryUsageInBytes / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+	// The chunks are evicted by the memory they actually use - uniform and palette chunks are a lot smaller than the
+	// raw voxels. The amount of chunks is only limited by the smallest chunk that fits into the memory limit.
+	_chunkMemoryLimit = uncompressedMemoryLimit;
+	const uint32_t chunkSizeInBytes = PagedVolume::Chunk::calculateSizeInBytes(_chunkSideLength);
+	if (uncompressedMemoryLimit / chunkSizeInBytes < MinChunks) {
+		Log::warn("Requested memory usage limit of %uMb might be exceeded by %u raw chunks of %uKb",
+				uncompressedMemoryLimit / (1024 * 1024), MinChunks, chunkSizeInBytes / 1024);
 	}
-	_chunkCountLimit = core_max(_chunkCountLimit, minPracticalNoOfChunks);
+	_chunkCountLimit = uncompressedMemoryLimit / PagedVolume::Chunk::calculateMinSizeInBytes();
+	_chunkCountLimit = core_max(_chunkCountLimit, MinChunks);
+	// The pool allocator of the chunk map can't address more entries
+	const uint32_t maxPracticalNoOfChunks = 65534u;
+	_chunkCountLimit = core_min(_chunkCountLimit, maxPracticalNoOfChunks);
+
+	// Each shard gets its part of the chunk limit plus some headroom for an uneven distribution of the chunks
+	// (+1 for the chunk that is inserted before the eviction kicks in). The shard maps can't grow - if a shard is
+	// full anyway, one of its own chunks is evicted before the new one is inserted.
+	const uint32_t chunksPerShard = _chunkCountLimit / ChunkShards;
+	for (uint32_t i = 0u; i < ChunkShards; ++i) {
+		_shards[i] = new ChunkShard((int)(chunksPerShard + chunksPerShard / 2u + 1u));
+	}
+	// The compressed chunks are mostly limited by memory - but the map needs an upper bound for the entries, too.
+	const uint32_t compressedChunkCountLimit = core_min(_chunkCountLimit * 4u, maxPracticalNoOfChunks);
+	_compressedChunks = new CompressedChunkMap((int)compressedChunkCountLimit);
 
 	// Inform the user about the chosen memory configuration.
-	Log::info("Memory usage limit for volume now set to %uMb (%u chunks of %uKb each).",
-			(_chunkCountLimit * chunkSizeInBytes) / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+	Log::info("Memory usage limit for volume now set to %uMb (at most %u chunks, %uKb per raw chunk) and %uMb for compressed chunks.",
+			uncompressedMemoryLimit / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024,
+			_compressedMemoryLimit / (1024 * 1024));
 }
 
 /**
@@ -58,6 +88,12 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
  */
 PagedVolume::~PagedVolume() {
 	flushAll();
+	for (uint32_t i = 0u; i < ChunkShards; ++i) {
+		delete _shards[i];
+		_shards[i] = nullptr;
+	}
+	delete _compressedChunks;
+	_compressedChunks = nullptr;
 }
 
 /**
@@ -68,7 +104,7 @@ PagedVolume::~PagedVolume() {
  * @param uZPos The @c z position of the voxel
  * @return The voxel value
  */
-const Voxel& PagedVolume::voxel(int32_t uXPos, int32_t uYPos, int32_t uZPos) const {
+Voxel PagedVolume::voxel(int32_t uXPos, int32_t uYPos, int32_t uZPos) const {
 	return voxel(glm::ivec3(uXPos, uYPos, uZPos));
 }
 
@@ -83,9 +119,9 @@ PagedVolume::ChunkPtr PagedVolume::chunk(const glm::ivec3& pos) const {
  * This version of the function is provided so that the wrap mode does not need
  * to be specified as a template parameter, as it may be confusing to some users.
  * @param v3dPos The 3D position of the voxel
- * @return The voxel value
+ * @return The voxel value - a copy, as the storage of the chunk might be replaced after the chunk reference was given up
  */
-const Voxel& PagedVolume::voxel(const glm::ivec3& v3dPos) const {
+Voxel PagedVolume::voxel(const glm::ivec3& v3dPos) const {
 	const uint16_t xOffset = static_cast<uint16_t>(v3dPos.x & _chunkMask);
 	const uint16_t yOffset = static_cast<uint16_t>(v3dPos.y & _chunkMask);
 	const uint16_t zOffset = static_cast<uint16_t>(v3dPos.z & _chunkMask);
@@ -111,7 +147,11 @@ void PagedVolume::setVoxel(int32_t uXPos, int32_t uYPos, int32_t uZPos, const Vo
 	const uint16_t yOffset = static_cast<uint16_t>(uYPos - (chunkY << _chunkSideLengthPower));
 	const uint16_t zOffset = static_cast<uint16_t>(uZPos - (chunkZ << _chunkSideLengthPower));
 
-	chunk(chunkX, chunkY, chunkZ)->setVoxel(xOffset, yOffset, zOffset, tValue);
+	const ChunkPtr& chunkPtr = chunk(chunkX, chunkY, chunkZ);
+	chunkPtr->setVoxel(xOffset, yOffset, zOffset, tValue);
+	if (chunkPtr->hasRetiredStorage()) {
+		releaseRetiredStorage(chunkPtr);
+	}
 }
 
 /**
@@ -156,6 +196,9 @@ void PagedVolume::setVoxels(int32_t uXPos, int32_t uYPos, int32_t uZPos, int nx,
 				const int32_t n = core_min(left, int32_t(chunkPtr->_sideLength));
 
 				chunkPtr->setVoxels(xOffset, yOffset, zOffset, array, n);
+				if (chunkPtr->hasRetiredStorage()) {
+					releaseRetiredStorage(chunkPtr);
+				}
 				left -= n;
 				array += ptrdiff_t(n);
 				y += n;
@@ -166,33 +209,309 @@ void PagedVolume::setVoxels(int32_t uXPos, int32_t uYPos, int32_t uZPos, int nx,
 
 /**
  * Removes all voxels from memory by removing all chunks. The application has the chance to persist the data via @c Pager::pageOut
+ * @note The compressed chunks are discarded, too - they were already persisted when they were evicted.
+ * @note Queued asynchronous paging tasks are discarded, running ones are finished before the chunks are removed.
+ * The pager must not call this.
  */
 void PagedVolume::flushAll() {
-	core::ScopedWriteLock writeLock(_volumeLock);
-	_chunks.clear();
+	stopPaging();
+	std::vector<ChunkPtr> chunks;
+	{
+		core::ScopedLock lruLock(_lruLock);
+		chunks.reserve(_chunkCount);
+		for (uint32_t i = 0u; i < ChunkShards; ++i) {
+			ChunkShard& s = *_shards[i];
+			core::ScopedWriteLock writeLock(s.lock);
+			for (const auto& e : s.chunks) {
+				chunks.push_back(e->value);
+			}
+			s.chunks.clear();
+		}
+		_lruHead = nullptr;
+		_lruTail = nullptr;
+		_chunkCount = 0u;
+		_chunkMemory = 0u;
+	}
+	{
+		core::ScopedLock pagerLock(_pagerLock);
+		for (const ChunkPtr& chunk : chunks) {
+			_pager->pageEvicted(chunk.get());
+		}
+	}
+	// the chunks are destroyed here - outside of the locks, as this might call Pager::pageOut()
+	chunks.clear();
+	flushCompressedChunks();
+}
+
+/**
+ * Discards the queued asynchronous paging tasks and waits for the running one. The futures of the discarded
+ * requests are resolved with an empty @c ChunkPtr.
+ * @note Must not be called concurrently to @c chunkAsync() or @c prefetch() - they might initialize the pool again
+ */
+void PagedVolume::stopPaging() {
+	bool threadPoolInitialized;
+	{
+		core::ScopedLock loadingLock(_loadingLock);
+		threadPoolInitialized = _threadPoolInitialized;
+		_threadPoolInitialized = false;
+	}
+	// not under the loading lock - the running task needs it to resolve its promise
+	if (threadPoolInitialized) {
+		_threadPool.shutdown();
+	}
+	std::vector<std::shared_ptr<std::promise<ChunkPtr>>> promises;
+	{
+		core::ScopedLock loadingLock(_loadingLock);
+		promises.reserve(_loading.size());
+		for (auto i = _loading.begin(); i != _loading.end(); ++i) {
+			promises.push_back(i->value.promise);
+		}
+		_loading.clear();
+	}
+	// destroying the promises without a value would let the waiting callers fail with a broken promise
+	for (const auto& promise : promises) {
+		promise->set_value(ChunkPtr());
+	}
+}
+
+void PagedVolume::flushCompressedChunks() const {
+	core::ScopedLock compressedLock(_compressedLock);
+	CompressedChunk* chunk = _compressedHead;
+	while (chunk != nullptr) {
+		CompressedChunk* next = chunk->_lruNext;
+		delete chunk;
+		chunk = next;
+	}
+	_compressedChunks->clear();
+	_compressedHead = nullptr;
+	_compressedTail = nullptr;
+	_compressedMemory = 0u;
+}
+
+PagedVolume::Statistics PagedVolume::statistics() const {
+	Statistics stats;
+	{
+		core::ScopedLock compressedLock(_compressedLock);
+		stats = _statistics;
+		stats.warmChunks = (uint32_t)_compressedChunks->size();
+		stats.warmMemory = _compressedMemory;
+	}
+	{
+		core::ScopedLock lruLock(_lruLock);
+		stats.hotChunks = _chunkCount;
+		for (const Chunk* chunk = _lruHead; chunk != nullptr; chunk = chunk->_lruNext) {
+			stats.hotMemory += chunk->sizeInBytes();
+		}
+	}
+	for (uint32_t i = 0u; i < ChunkShards; ++i) {
+		stats.hotHits += _shards[i]->hits;
+	}
+	return stats;
+}
+
+void PagedVolume::linkCompressedChunk(CompressedChunk* chunk) const {
+	chunk->_lruPrev = nullptr;
+	chunk->_lruNext = _compressedHead;
+	if (_compressedHead != nullptr) {
+		_compressedHead->_lruPrev = chunk;
+	} else {
+		_compressedTail = chunk;
+	}
+	_compressedHead = chunk;
+	_compressedMemory += chunk->sizeInBytes();
+	_compressedChunks->put(chunk->_chunkSpacePosition, chunk);
+}
+
+void PagedVolume::unlinkCompressedChunk(CompressedChunk* chunk) const {
+	if (chunk->_lruPrev != nullptr) {
+		chunk->_lruPrev->_lruNext = chunk->_lruNext;
+	} else {
+		_compressedHead = chunk->_lruNext;
+	}
+	if (chunk->_lruNext != nullptr) {
+		chunk->_lruNext->_lruPrev = chunk->_lruPrev;
+	} else {
+		_compressedTail = chunk->_lruPrev;
+	}
+	chunk->_lruPrev = nullptr;
+	chunk->_lruNext = nullptr;
+	_compressedMemory -= chunk->sizeInBytes();
+	_compressedChunks->remove(chunk->_chunkSpacePosition);
+}
+
+/**
+ * Frees the storage blocks that the chunk retired when it changed its representation. Readers only access the
+ * storage while they hold a reference to the chunk (@c PagedVolume::voxel() and the samplers return copies of the
+ * voxels) - so it's safe to free them once the chunk map and the caller hold the only references. The shard write
+ * lock makes sure that no other thread can pick up a new reference while the count is checked. If the storage is
+ * still in use, this is tried again with the next write.
+ * The resident memory of the chunk is updated, too.
+ */
+void PagedVolume::releaseRetiredStorage(const ChunkPtr& chunk) const {
+	const glm::ivec3& pos = chunk->chunkPos();
+	core::ScopedLock lruLock(_lruLock);
+	ChunkShard& s = shard(pos);
+	core::ScopedWriteLock writeLock(s.lock);
+	auto i = s.chunks.find(pos);
+	if (i == s.chunks.end() || i->second != chunk) {
+		// not resident (anymore) - the retired storage is released when the chunk is paged in again or destroyed
+		return;
+	}
+	if (*chunk.refCnt() == 2) {
+		chunk->releaseRetiredStorage();
+	}
+	_chunkMemory -= chunk->_residentSizeInBytes;
+	chunk->_residentSizeInBytes = chunk->sizeInBytes();
+	_chunkMemory += chunk->_residentSizeInBytes;
+}
+
+/**
+ * Keeps a compressed copy of an evicted chunk. The oldest compressed chunks are dropped if the memory
+ * limit for the compressed chunks is exceeded.
+ * @note The chunk is only compressed if the given pointer is the last reference - otherwise the chunk might
+ * still get modified and the compressed copy would be outdated.
+ */
+void PagedVolume::compressChunk(const ChunkPtr& chunk) const {
+	if (_compressedMemoryLimit == 0u || *chunk.refCnt() != 1) {
+		return;
+	}
+	const uint64_t start = SDL_GetPerformanceCounter();
+	CompressedChunk* compressed = new CompressedChunk(chunk.get());
+	const uint64_t micros = microsSince(start);
+	const uint32_t size = compressed->sizeInBytes();
+
+	core::ScopedLock compressedLock(_compressedLock);
+	_statistics.compressMicros += micros;
+	if (size > _compressedMemoryLimit) {
+		delete compressed;
+		return;
+	}
+	while (_compressedTail != nullptr && (_compressedMemory + size > _compressedMemoryLimit
+			|| _compressedChunks->size() >= _compressedChunks->capacity())) {
+		CompressedChunk* oldest = _compressedTail;
+		unlinkCompressedChunk(oldest);
+		delete oldest;
+	}
+	linkCompressedChunk(compressed);
 }
 
 /**
- * As we have added a chunk we may have exceeded our target chunk limit. Search through the array to
- * determine how many chunks we have, as well as finding the oldest timestamp. Note that this is potentially
- * wasteful and we may instead wish to track how many chunks we have and/or delete a chunk at random (or
- * just check e.g. 10 and delete the oldest of those) but we'll see if this is a bottleneck first. Paging
- * the data in is probably more expensive.
+ * @return A new chunk that was filled by the compressed copy of the chunk at the given position, or an
+ * empty pointer if no compressed copy is available. The compressed copy is removed.
  */
-void PagedVolume::deleteOldestChunkIfNeeded() const {
-	ChunkMap::iterator oldestChunk = _chunks.end();
-	uint32_t oldestChunkTimestamp = _timestamper;
-	for (ChunkMap::iterator i = _chunks.begin(); i != _chunks.end(); ++i) {
-		const ChunkPtr& chunk = i->second;
-		if (chunk->_chunkLastAccessed < oldestChunkTimestamp) {
-			oldestChunkTimestamp = chunk->_chunkLastAccessed;
-			oldestChunk = i;
+PagedVolume::ChunkPtr PagedVolume::restoreChunk(const glm::ivec3& pos) const {
+	CompressedChunk* compressed = nullptr;
+	{
+		core::ScopedLock compressedLock(_compressedLock);
+		++_statistics.hotMisses;
+		if (!_compressedChunks->get(pos, compressed)) {
+			++_statistics.warmMisses;
+			return ChunkPtr();
 		}
+		++_statistics.warmHits;
+		unlinkCompressedChunk(compressed);
 	}
-	if (oldestChunk != _chunks.end()) {
-		Log::info("delete oldest chunk - reached %u", _chunkCountLimit);
-		_chunks.erase(oldestChunk);
+	Log::debug("restore compressed chunk at %i:%i:%i", pos.x, pos.y, pos.z);
+	const uint64_t start = SDL_GetPerformanceCounter();
+	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
+	compressed->decompress(chunk.get());
+	const uint64_t micros = microsSince(start);
+	delete compressed;
+
+	core::ScopedLock compressedLock(_compressedLock);
+	_statistics.decompressMicros += micros;
+	return chunk;
+}
+
+void PagedVolume::linkChunk(Chunk* chunk) const {
+	chunk->_lruPrev = nullptr;
+	chunk->_lruNext = _lruHead;
+	if (_lruHead != nullptr) {
+		_lruHead->_lruPrev = chunk;
+	} else {
+		_lruTail = chunk;
 	}
+	_lruHead = chunk;
+	++_chunkCount;
+	chunk->_residentSizeInBytes = chunk->sizeInBytes();
+	_chunkMemory += chunk->_residentSizeInBytes;
+}
+
+void PagedVolume::unlinkChunk(Chunk* chunk) const {
+	if (chunk->_lruPrev != nullptr) {
+		chunk->_lruPrev->_lruNext = chunk->_lruNext;
+	} else {
+		_lruHead = chunk->_lruNext;
+	}
+	if (chunk->_lruNext != nullptr) {
+		chunk->_lruNext->_lruPrev = chunk->_lruPrev;
+	} else {
+		_lruTail = chunk->_lruPrev;
+	}
+	chunk->_lruPrev = nullptr;
+	chunk->_lruNext = nullptr;
+	--_chunkCount;
+	_chunkMemory -= chunk->_residentSizeInBytes;
+	chunk->_residentSizeInBytes = 0u;
+}
+
+/**
+ * As we have added a chunk we may have exceeded our target memory or chunk limit. The chunks are kept in an intrusive list
+ * ordered by insertion, lookups only flag a chunk as referenced. The eviction walks from the tail and moves every
+ * referenced chunk back to the head (second chance) - so a lookup never has to modify the list and thus never has
+ * to take the list lock.
+ * @note The caller must hold the @c _lruLock
+ * @return The removed chunk - the caller should release it after giving up the locks as the destruction might
+ * trigger a @c Pager::pageOut() call.
+ */
+PagedVolume::ChunkPtr PagedVolume::deleteOldestChunkIfNeeded() const {
+	if (_chunkCount <= MinChunks || (_chunkCount <= _chunkCountLimit && _chunkMemory <= _chunkMemoryLimit)) {
+		return ChunkPtr();
+	}
+	for (uint32_t i = 0u; i < _chunkCount; ++i) {
+		Chunk* candidate = _lruTail;
+		if (!candidate->_referenced.exchange(false)) {
+			break;
+		}
+		unlinkChunk(candidate);
+		linkChunk(candidate);
+	}
+	Chunk* oldestChunk = _lruTail;
+	unlinkChunk(oldestChunk);
+	const glm::ivec3 pos = oldestChunk->_chunkSpacePosition;
+	Log::debug("delete oldest chunk %i:%i:%i - reached %u chunks with %ukb", pos.x, pos.y, pos.z, _chunkCount,
+			(uint32_t)(_chunkMemory / 1024u));
+	ChunkShard& s = shard(pos);
+	core::ScopedWriteLock writeLock(s.lock);
+	ChunkPtr chunk;
+	s.chunks.get(pos, chunk);
+	s.chunks.remove(pos);
+	return chunk;
+}
+
+/**
+ * The chunks are not evenly distributed over the shards - if the map of a shard is full, the least recently
+ * inserted chunk of that shard is evicted. The referenced flag is ignored here, as there is no room left anyway.
+ * @note The caller must hold the @c _lruLock
+ * @return The removed chunk - the caller should release it after giving up the locks as the destruction might
+ * trigger a @c Pager::pageOut() call.
+ */
+PagedVolume::ChunkPtr PagedVolume::deleteOldestChunkOfShard(ChunkShard& s) const {
+	Chunk* oldestChunk = _lruTail;
+	while (oldestChunk != nullptr && &shard(oldestChunk->_chunkSpacePosition) != &s) {
+		oldestChunk = oldestChunk->_lruPrev;
+	}
+	if (oldestChunk == nullptr) {
+		return ChunkPtr();
+	}
+	unlinkChunk(oldestChunk);
+	const glm::ivec3 pos = oldestChunk->_chunkSpacePosition;
+	Log::debug("delete oldest chunk %i:%i:%i - shard is full", pos.x, pos.y, pos.z);
+	core::ScopedWriteLock writeLock(s.lock);
+	ChunkPtr chunk;
+	s.chunks.get(pos, chunk);
+	s.chunks.remove(pos);
+	return chunk;
 }
 
 PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
@@ -200,7 +519,6 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 	glm::ivec3 pos(chunkX, chunkY, chunkZ);
 	Log::debug("create new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
 	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
-	chunk->_chunkLastAccessed = ++_timestamper; // Important, as we may soon delete the oldest chunk
 
 	// Pass the chunk to the Pager to give it a chance to initialise it with any data
 	// From the coordinates of the chunk we deduce the coordinates of the contained voxels.
@@ -218,22 +536,224 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 	return chunk;
 }
 
+PagedVolume::ChunkPtr PagedVolume::findChunk(const glm::ivec3& pos) const {
+	const ChunkShard& s = shard(pos);
+	core::ScopedReadLock readLock(s.lock);
+	auto i = s.chunks.find(pos);
+	if (i == s.chunks.end()) {
+		return ChunkPtr();
+	}
+	const ChunkPtr& chunk = i->second;
+	// avoid the write (and thus the cache line invalidation for the other threads) if already flagged
+	if (!chunk->_referenced) {
+		chunk->_referenced = true;
+	}
+	return chunk;
+}
+
+PagedVolume::ChunkPtr PagedVolume::pageInChunk(const glm::ivec3& pos) const {
+	// declared before the lock - the evicted chunk is released after the pager lock was given up, as the
+	// destruction might call Pager::pageOut()
+	ChunkPtr oldestChunk;
+	core::ScopedLock pagerLock(_pagerLock);
+	// another thread might have paged in the chunk while we were waiting for the lock
+	ChunkPtr chunk = findChunk(pos);
+	bool ownsLoadingChunk = false;
+	if (!chunk) {
+		{
+			core::ScopedLock loadingLock(_loadingLock);
+			auto i = _loading.find(pos);
+			// if the entry is already started, we are called recursively by the pager for the chunk that is
+			// currently paged in - the outer call fulfills the promise then.
+			if (i != _loading.end() && !i->value.started) {
+				i->value.started = true;
+				ownsLoadingChunk = true;
+			}
+		}
+		chunk = restoreChunk(pos);
+		if (chunk) {
+			PagerContext pctx;
+			const glm::ivec3& mins = pos * static_cast<int32_t>(_chunkSideLength);
+			pctx.region = Region(mins, mins + glm::ivec3(_chunkSideLength - 1));
+			pctx.chunk = chunk;
+			_pager->pageRestored(pctx);
+		} else {
+			const uint64_t start = SDL_GetPerformanceCounter();
+			chunk = createNewChunk(pos.x, pos.y, pos.z);
+			const uint64_t micros = microsSince(start);
+			core::ScopedLock compressedLock(_compressedLock);
+			_statistics.pageInMicros += micros;
+		}
+		// nobody else has access to the chunk yet
+		chunk->releaseRetiredStorage();
+		// the chunk is about to be used - without the flag it would be the first candidate for the eviction
+		// if all the other chunks are referenced
+		chunk->_referenced = true;
+		{
+			core::ScopedLock lruLock(_lruLock);
+			ChunkShard& s = shard(pos);
+			// all modifications of the shard maps are done with the lru lock held - so the size is stable here
+			if (s.chunks.size() >= s.chunks.capacity()) {
+				oldestChunk = deleteOldestChunkOfShard(s);
+			}
+			{
+				core::ScopedWriteLock writeLock(s.lock);
+				s.chunks.put(pos, chunk);
+			}
+			linkChunk(chunk.get());
+			if (!oldestChunk) {
+				oldestChunk = deleteOldestChunkIfNeeded();
+			}
+		}
+		if (oldestChunk) {
+			_pager->pageEvicted(oldestChunk.get());
+			compressChunk(oldestChunk);
+		}
+	}
+	// resolve the asynchronous request - this is either our own entry, or one that was scheduled
+	// while we were paging in the chunk
+	std::shared_ptr<std::promise<ChunkPtr>> promise;
+	{
+		core::ScopedLock loadingLock(_loadingLock);
+		auto i = _loading.find(pos);
+		if (i != _loading.end() && (ownsLoadingChunk || !i->value.started)) {
+			promise = i->value.promise;
+			_loading.remove(pos);
+		}
+	}
+	if (promise) {
+		promise->set_value(chunk);
+	}
+	return chunk;
+}
+
 PagedVolume::ChunkPtr PagedVolume::chunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
-	core::ScopedWriteLock chunkWriteLock(_volumeLock);
 	const glm::ivec3 pos(chunkX, chunkY, chunkZ);
-	auto i = _chunks.find(pos);
-	if (i == _chunks.end()) {
-		const ChunkPtr& chunk = createNewChunk(chunkX, chunkY, chunkZ);
-		_chunks.put(pos, chunk);
-		const std::size_t chunkCount = _chunks.size();
-		if (chunkCount >= _chunkCountLimit) {
-			deleteOldestChunkIfNeeded();
-		}
+	const ChunkPtr& chunk = findChunk(pos);
+	if (chunk) {
+		++shard(pos).hits;
 		return chunk;
 	}
-	const ChunkPtr& chunk = i->second;
-	chunk->_chunkLastAccessed = ++_timestamper;
-	return chunk;
+	return pageInChunk(pos);
+}
+
+bool PagedVolume::isResident(const glm::ivec3& pos) const {
+	return hasChunk(chunkPos(pos));
+}
+
+/**
+ * @brief Unlike @c findChunk() this doesn't mark the chunk as referenced for the eviction
+ */
+bool PagedVolume::hasChunk(const glm::ivec3& pos) const {
+	const ChunkShard& s = shard(pos);
+	core::ScopedReadLock readLock(s.lock);
+	return s.chunks.find(pos) != s.chunks.end();
+}
+
+/**
+ * @note The caller must hold the @c _loadingLock
+ * @param[out] scheduled @c true if a new paging task was created for the chunk
+ */
+PagedVolume::ChunkFuture PagedVolume::scheduleChunk(const glm::ivec3& pos, bool& scheduled) const {
+	scheduled = false;
+	auto i = _loading.find(pos);
+	if (i != _loading.end()) {
+		return i->value.future;
+	}
+	std::shared_ptr<std::promise<ChunkPtr>> promise = std::make_shared<std::promise<ChunkPtr>>();
+	LoadingChunk loadingChunk;
+	loadingChunk.future = promise->get_future().share();
+	// the chunk might have been inserted after the caller checked it
+	const ChunkPtr& chunk = findChunk(pos);
+	if (chunk) {
+		promise->set_value(chunk);
+		return loadingChunk.future;
+	}
+	if (_loading.size() >= _loading.capacity()) {
+		Log::warn("Too many chunks are scheduled for paging");
+		return ChunkFuture();
+	}
+	if (!_threadPoolInitialized) {
+		_threadPool.init();
+		_threadPoolInitialized = true;
+	}
+	loadingChunk.promise = promise;
+	_loading.put(pos, loadingChunk);
+	_threadPool.enqueue([this, pos] () {
+		pageInChunk(pos);
+	});
+	scheduled = true;
+	return loadingChunk.future;
+}
+
+PagedVolume::ChunkFuture PagedVolume::chunkAsync(const glm::ivec3& pos) const {
+	const glm::ivec3& p = chunkPos(pos);
+	const ChunkPtr& chunk = findChunk(p);
+	if (chunk) {
+		std::promise<ChunkPtr> promise;
+		promise.set_value(chunk);
+		return promise.get_future().share();
+	}
+	core::ScopedLock loadingLock(_loadingLock);
+	bool scheduled;
+	return scheduleChunk(p, scheduled);
+}
+
+int PagedVolume::prefetch(const glm::ivec3& pos, int radius) const {
+	return prefetch(Region(pos - radius, pos + radius));
+}
+
+int PagedVolume::prefetch(const Region& region) const {
+	const glm::ivec3& mins = chunkPos(region.getLowerCorner());
+	const glm::ivec3& maxs = chunkPos(region.getUpperCorner());
+	const glm::ivec3& center = chunkPos(region.getCenter());
+	std::vector<glm::ivec3> positions;
+	for (int32_t x = mins.x; x <= maxs.x; ++x) {
+		for (int32_t y = mins.y; y <= maxs.y; ++y) {
+			for (int32_t z = mins.z; z <= maxs.z; ++z) {
+				const glm::ivec3 pos(x, y, z);
+				if (hasChunk(pos)) {
+					continue;
+				}
+				positions.push_back(pos);
+			}
+		}
+	}
+	if (positions.empty()) {
+		return 0;
+	}
+	std::sort(positions.begin(), positions.end(), [&center] (const glm::ivec3& lhs, const glm::ivec3& rhs) {
+		return glm::length2(glm::vec3(lhs - center)) < glm::length2(glm::vec3(rhs - center));
+	});
+
+	core::ScopedLock loadingLock(_loadingLock);
+	uint32_t chunkCount;
+	uint64_t chunkMemory;
+	{
+		core::ScopedLock lruLock(_lruLock);
+		chunkCount = _chunkCount;
+		chunkMemory = _chunkMemory;
+	}
+	// don't schedule more chunks than we can hold - otherwise we would evict chunks that we've just prefetched. The
+	// size of the new chunks is estimated by the resident ones - without any, the raw chunk size is assumed.
+	const uint64_t chunkSize = chunkCount > 0u ? chunkMemory / chunkCount : Chunk::calculateSizeInBytes(_chunkSideLength);
+	const uint64_t freeMemory = chunkMemory < _chunkMemoryLimit ? _chunkMemoryLimit - chunkMemory : 0u;
+	const int memoryBudget = (int)core_min(freeMemory / core_max(chunkSize, (uint64_t)1u), (uint64_t)_chunkCountLimit);
+	const int countBudget = core_min((int)_chunkCountLimit - (int)chunkCount, core_max(memoryBudget, (int)MinChunks - (int)chunkCount));
+	int budget = countBudget - (int)_loading.size();
+	int scheduledChunks = 0;
+	for (const glm::ivec3& pos : positions) {
+		if (budget <= 0) {
+			break;
+		}
+		bool scheduled;
+		scheduleChunk(pos, scheduled);
+		if (scheduled) {
+			++scheduledChunks;
+			--budget;
+		}
+	}
+	return scheduledChunks;
 }
 
 }
@@ -9,12 +9,16 @@
 #include "core/NonCopyable.h"
 #include "core/Assert.h"
 #include "core/concurrent/ReadWriteLock.h"
+#include "core/concurrent/Lock.h"
 #include "core/concurrent/Atomic.h"
 #include "core/collection/Array.h"
 #include "core/collection/Map.h"
 #include "core/SharedPtr.h"
+#include "core/concurrent/ThreadPool.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
+#include <future>
+#include <atomic>
 
 namespace voxel {
 
@@ -38,20 +42,54 @@ public:
 	class Chunk;
 	/// The Pager class is responsible for the loading and unloading of Chunks, and can be subclassed by the user.
 	class Pager;
+	/// Evicted chunks are kept as CompressedChunk instances until the memory of the compressed tier is exhausted.
+	class CompressedChunk;
 
 	class Chunk {
 		friend class PagedVolume;
 		friend class PagedVolumeWrapper;
 
 	public:
+		/**
+		 * @brief The voxels of a chunk are stored in the smallest of these representations that is able to hold them.
+		 * A chunk starts as Uniform and is promoted on the first voxel that differs.
+		 */
+		enum class Representation : uint8_t {
+			// A single voxel for the whole chunk - no per voxel storage at all
+			Uniform,
+			// Palette with 2, 4, 16 or 256 entries and 1, 2, 4 or 8 bit indices per voxel
+			Palette,
+			// The plain voxels
+			Raw
+		};
+
 		Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pager);
 		~Chunk();
 
+		/**
+		 * @param[in] voxels The voxels of the whole chunk in morton order
+		 */
 		bool setData(const Voxel* voxels, size_t sizeInBytes);
-		Voxel* data() const;
+		/**
+		 * @brief Copies the voxels of the whole chunk in morton order - the counterpart of @c setData()
+		 * @param[out] voxels Must be able to hold @c dataSizeInBytes() bytes
+		 */
+		bool data(Voxel* voxels, size_t sizeInBytes) const;
+		/**
+		 * @return The size of the voxels if they were stored uncompressed
+		 */
 		uint32_t dataSizeInBytes() const;
+		/**
+		 * @return The memory that is currently allocated to store the voxels
+		 */
+		uint32_t sizeInBytes() const;
 		uint32_t voxels() const;
+		Representation representation() const;
 
+		/**
+		 * @note The returned reference points into the storage of the chunk. It's only valid as long as the
+		 * caller holds a reference to the chunk - see @c PagedVolume::releaseRetiredStorage()
+		 */
 		const Voxel& voxel(uint32_t x, uint32_t y, uint32_t z) const;
 		const Voxel& voxel(const glm::i16vec3& pos) const;
 
@@ -64,12 +102,66 @@ public:
 		int16_t sideLength() const;
 
 	private:
-		// This is updated by the PagedVolume and used to discard the least recently used chunks.
-		uint32_t _chunkLastAccessed = 0u;
+		/**
+		 * Every change of the representation allocates a new storage block. Other threads might still read from the
+		 * previous block - it's retired and freed at a safe point: when the chunk is paged in, when the volume
+		 * writes to the chunk and nobody else holds a reference to it, or when the chunk is destroyed.
+		 * The block is allocated in one piece: the header, followed by the palette and the indices or voxels.
+		 */
+		struct Storage {
+			Storage* retired;
+			// the voxels in morton order for the raw representation
+			Voxel* data;
+			// bit packed palette indices in morton order for the palette representation
+			uint8_t* indices;
+			Voxel* palette;
+			uint32_t sizeInBytes;
+			uint16_t paletteSize;
+			uint16_t paletteCapacity;
+			// 0 for the uniform representation, 16 for the raw representation
+			uint8_t bitsPerIndex;
+			// the last palette index that was looked up
+			uint8_t paletteHint;
+		};
+
+		static constexpr uint8_t RawBitsPerIndex = 16u;
+
+		static uint32_t paletteIndexAt(const Storage* storage, uint32_t index);
+		static void setPaletteIndexAt(Storage* storage, uint32_t index, uint32_t paletteIndex);
+		bool findPaletteIndex(Storage* storage, const Voxel& value, uint32_t& paletteIndex) const;
+		Storage* createStorage(uint8_t bitsPerIndex) const;
+		Storage* promoteStorage(Storage* storage);
+		void publishStorage(Storage* storage);
+		/**
+		 * @brief Frees the storage blocks of previous representations. Only safe as long as no other thread
+		 * can access the chunk.
+		 * @sa PagedVolume::releaseRetiredStorage()
+		 */
+		void releaseRetiredStorage();
+		bool hasRetiredStorage() const;
+
+		const Voxel& voxelAt(uint32_t index) const;
+		void setVoxelsAt(uint32_t index, uint32_t amount, const Voxel& value);
+		const Voxel* rawData() const;
+
+		// published with release semantics - readers must load it with acquire semantics
+		std::atomic<Storage*> _storage { nullptr };
+
+		// This is set by the PagedVolume on every access and cleared again by the eviction. A chunk that was
+		// accessed since the last eviction pass gets a second chance before it is discarded.
+		core::AtomicBool _referenced { false };
+		// Intrusive least recently used list of all resident chunks - maintained by the PagedVolume.
+		Chunk* _lruPrev = nullptr;
+		Chunk* _lruNext = nullptr;
+		// The memory of the chunk that is part of the resident chunk memory of the PagedVolume - guarded by its lru lock
+		uint32_t _residentSizeInBytes = 0u;
 
 		static uint32_t calculateSizeInBytes(uint32_t sideLength);
+		/**
+		 * @return The memory of a chunk in the uniform representation - this is the smallest a chunk can get
+		 */
+		static uint32_t calculateMinSizeInBytes();
 
-		Voxel* _data = nullptr;
 		uint16_t _sideLength = 0u;
 
 		// This is so we can tell whether a uncompressed chunk has to be recompressed and whether
@@ -83,6 +175,66 @@ public:
 		glm::ivec3 _chunkSpacePosition;
 	};
 	typedef core::SharedPtr<Chunk> ChunkPtr;
+	typedef std::shared_future<ChunkPtr> ChunkFuture;
+
+	/**
+	 * @brief Run length encoded copy of the voxels of a chunk. The runs follow the morton order of the chunk data - so
+	 * spatially close voxels end up in the same run. Chunks that are mostly air or a single material only need a few
+	 * runs.
+	 */
+	class CompressedChunk {
+		friend class PagedVolume;
+	public:
+		CompressedChunk(const Chunk* chunk);
+		~CompressedChunk();
+
+		/**
+		 * @brief Writes the voxels back into the given chunk
+		 * @return @c false if the side length of the given chunk doesn't match
+		 */
+		bool decompress(Chunk* chunk) const;
+
+		uint32_t sizeInBytes() const;
+		uint32_t runs() const;
+		const glm::ivec3& chunkPos() const;
+
+	private:
+		struct Run {
+			Voxel voxel;
+			uint16_t length;
+		};
+
+		// Intrusive least recently used list of the compressed chunks - maintained by the PagedVolume.
+		CompressedChunk* _lruPrev = nullptr;
+		CompressedChunk* _lruNext = nullptr;
+
+		Run* _runs = nullptr;
+		uint32_t _runCount = 0u;
+		uint16_t _sideLength = 0u;
+		glm::ivec3 _chunkSpacePosition;
+	};
+
+	/**
+	 * @brief Counters for the residency tiers of the volume. Hot chunks are uncompressed, warm chunks are kept compressed
+	 * in memory and cold chunks must be paged in by the Pager.
+	 */
+	struct Statistics {
+		// chunk lookups that found an uncompressed chunk
+		int hotHits = 0;
+		// chunk lookups that had to restore or page in the chunk
+		int hotMisses = 0;
+		// hot misses that could be restored from a compressed chunk
+		int warmHits = 0;
+		// hot misses that had to be paged in by the pager
+		int warmMisses = 0;
+		uint32_t hotChunks = 0u;
+		uint64_t hotMemory = 0u;
+		uint32_t warmChunks = 0u;
+		uint32_t warmMemory = 0u;
+		uint64_t compressMicros = 0u;
+		uint64_t decompressMicros = 0u;
+		uint64_t pageInMicros = 0u;
+	};
 
 	struct PagerContext {
 		Region region;
@@ -108,7 +260,22 @@ public:
 		 * @return @c true if the chunk was modified (created), @c false if it was just loaded
 		 */
 		virtual bool pageIn(PagerContext& ctx) = 0;
+		/**
+		 * @brief Called for modified chunks when they are destroyed - the data should be persisted here
+		 */
 		virtual void pageOut(Chunk* chunk) = 0;
+		/**
+		 * @brief Called instead of @c pageIn() if the chunk was restored from the compressed tier
+		 * @note Called while the pager lock is held - just like @c pageIn()
+		 */
+		virtual void pageRestored(PagerContext& ctx) {
+		}
+		/**
+		 * @brief Called for every chunk that is removed from the volume - independent of whether it was modified
+		 * or is kept in the compressed tier. @c pageOut() is called later when the chunk is destroyed.
+		 */
+		virtual void pageEvicted(Chunk* chunk) {
+		}
 	};
 
 	typedef core::SharedPtr<Pager> PagerPtr;
@@ -119,7 +286,7 @@ public:
 		Sampler(const PagedVolume& volume);
 		virtual ~Sampler();
 
-		const Voxel& voxel() const;
+		Voxel voxel() const;
 
 		inline bool currentPositionValid() const {
 			return true;
@@ -138,35 +305,35 @@ public:
 		void moveNegativeY();
 		void moveNegativeZ();
 
-		const Voxel& peekVoxel1nx1ny1nz() const;
-		const Voxel& peekVoxel1nx1ny0pz() const;
-		const Voxel& peekVoxel1nx1ny1pz() const;
-		const Voxel& peekVoxel1nx0py1nz() const;
-		const Voxel& peekVoxel1nx0py0pz() const;
-		const Voxel& peekVoxel1nx0py1pz() const;
-		const Voxel& peekVoxel1nx1py1nz() const;
-		const Voxel& peekVoxel1nx1py0pz() const;
-		const Voxel& peekVoxel1nx1py1pz() const;
-
-		const Voxel& peekVoxel0px1ny1nz() const;
-		const Voxel& peekVoxel0px1ny0pz() const;
-		const Voxel& peekVoxel0px1ny1pz() const;
-		const Voxel& peekVoxel0px0py1nz() const;
-		const Voxel& peekVoxel0px0py0pz() const;
-		const Voxel& peekVoxel0px0py1pz() const;
-		const Voxel& peekVoxel0px1py1nz() const;
-		const Voxel& peekVoxel0px1py0pz() const;
-		const Voxel& peekVoxel0px1py1pz() const;
-
-		const Voxel& peekVoxel1px1ny1nz() const;
-		const Voxel& peekVoxel1px1ny0pz() const;
-		const Voxel& peekVoxel1px1ny1pz() const;
-		const Voxel& peekVoxel1px0py1nz() const;
-		const Voxel& peekVoxel1px0py0pz() const;
-		const Voxel& peekVoxel1px0py1pz() const;
-		const Voxel& peekVoxel1px1py1nz() const;
-		const Voxel& peekVoxel1px1py0pz() const;
-		const Voxel& peekVoxel1px1py1pz() const;
+		Voxel peekVoxel1nx1ny1nz() const;
+		Voxel peekVoxel1nx1ny0pz() const;
+		Voxel peekVoxel1nx1ny1pz() const;
+		Voxel peekVoxel1nx0py1nz() const;
+		Voxel peekVoxel1nx0py0pz() const;
+		Voxel peekVoxel1nx0py1pz() const;
+		Voxel peekVoxel1nx1py1nz() const;
+		Voxel peekVoxel1nx1py0pz() const;
+		Voxel peekVoxel1nx1py1pz() const;
+
+		Voxel peekVoxel0px1ny1nz() const;
+		Voxel peekVoxel0px1ny0pz() const;
+		Voxel peekVoxel0px1ny1pz() const;
+		Voxel peekVoxel0px0py1nz() const;
+		Voxel peekVoxel0px0py0pz() const;
+		Voxel peekVoxel0px0py1pz() const;
+		Voxel peekVoxel0px1py1nz() const;
+		Voxel peekVoxel0px1py0pz() const;
+		Voxel peekVoxel0px1py1pz() const;
+
+		Voxel peekVoxel1px1ny1nz() const;
+		Voxel peekVoxel1px1ny0pz() const;
+		Voxel peekVoxel1px1ny1pz() const;
+		Voxel peekVoxel1px0py1nz() const;
+		Voxel peekVoxel1px0py0pz() const;
+		Voxel peekVoxel1px0py1pz() const;
+		Voxel peekVoxel1px1py1nz() const;
+		Voxel peekVoxel1px1py0pz() const;
+		Voxel peekVoxel1px1py1pz() const;
 
 	protected:
 		const PagedVolume* _volume;
@@ -176,8 +343,15 @@ public:
 		int32_t _yPosInVolume;
 		int32_t _zPosInVolume;
 
+		const Voxel& peekVoxel(int32_t delta) const;
+
 		//Other current position information
-		Voxel* _currentVoxel = nullptr;
+		// morton index of the current position in the current chunk
+		uint32_t _voxelIndex = 0u;
+		// only set for chunks in the raw representation. If the voxels of the chunk are replaced (Chunk::setData()),
+		// this points to the retired storage until the sampler moves to another chunk - the retired storage isn't
+		// freed while the sampler holds a reference to the chunk.
+		const Voxel* _currentData = nullptr;
 		ChunkPtr _currentChunk	;
 
 		uint16_t _xPosInChunk = 0u;
@@ -192,14 +366,14 @@ public:
 
 public:
 	/// Constructor for creating a fixed size volume.
-	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32);
+	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32, float compressedMemoryFraction = 0.25f);
 	/// Destructor
 	~PagedVolume();
 
 	/// Gets a voxel at the position given by <tt>x,y,z</tt> coordinates
-	const Voxel& voxel(int32_t x, int32_t y, int32_t z) const;
+	Voxel voxel(int32_t x, int32_t y, int32_t z) const;
 	/// Gets a voxel at the position given by a 3D vector
-	const Voxel& voxel(const glm::ivec3& v3dPos) const;
+	Voxel voxel(const glm::ivec3& v3dPos) const;
 
 	const Region& region() const;
 
@@ -214,8 +388,50 @@ public:
 	/// Removes all voxels from memory
 	void flushAll();
 
+	/**
+	 * @brief Snapshot of the residency counters of the volume
+	 */
+	Statistics statistics() const;
+
+	/**
+	 * @brief Returns the chunk that contains the given voxel position. If the chunk isn't resident yet, it is
+	 * paged in synchronously.
+	 */
 	ChunkPtr chunk(const glm::ivec3& pos) const;
 
+	/**
+	 * @brief Non-blocking check whether the chunk that contains the given voxel position is already paged in.
+	 * @note This doesn't count as an access for the eviction of chunks.
+	 */
+	bool isResident(const glm::ivec3& pos) const;
+
+	/**
+	 * @brief Returns a future for the chunk that contains the given voxel position. If the chunk isn't resident
+	 * yet, it is paged in by the paging thread of the volume and doesn't block the caller.
+	 * @note If the chunk is already resident, the returned future is ready.
+	 * @note This moves the paging off the calling thread - it doesn't page in several chunks in parallel. All
+	 * page-ins (synchronous and asynchronous) are serialized, because the pager fills the neighbouring chunks,
+	 * too (e.g. trees), and isn't required to be thread safe. A synchronous @c chunk() call for a missing chunk
+	 * thus waits for a running asynchronous page-in.
+	 * @note If the request is discarded by @c flushAll() (or the destruction of the volume) before the chunk was
+	 * paged in, the future resolves to an empty @c ChunkPtr. If too many chunks are already scheduled, the
+	 * returned future is not valid.
+	 */
+	ChunkFuture chunkAsync(const glm::ivec3& pos) const;
+
+	/**
+	 * @brief Schedules all chunks that intersect the given region for asynchronous paging. The chunks that are
+	 * closest to the center of the region are scheduled first.
+	 * @note This never schedules more chunks than the volume is able to hold without evicting other chunks.
+	 * @return The amount of chunks that were scheduled for paging.
+	 */
+	int prefetch(const Region& region) const;
+	/**
+	 * @brief Prefetch all chunks in the given radius around the given voxel position.
+	 * @sa prefetch(const Region&)
+	 */
+	int prefetch(const glm::ivec3& pos, int radius) const;
+
 	glm::ivec3 chunkPos(int x, int y, int z) const;
 
 	inline glm::ivec3 chunkPos(const glm::ivec3& worldPos) const {
@@ -234,16 +450,100 @@ protected:
 	PagedVolume& operator=(const PagedVolume& rhs);
 
 private:
-	ChunkPtr chunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
-	ChunkPtr createNewChunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
-	void deleteOldestChunkIfNeeded() const;
+	/**
+	 * The amount of stripes the chunk map is split into. Every stripe has its own lock, so concurrent
+	 * lookups of chunks only contend if they hash into the same stripe. Must be a power of two.
+	 */
+	static constexpr uint32_t ChunkShards = 16u;
 
-	mutable int32_t _timestamper = 0;
+	typedef core::Map<glm::ivec3, ChunkPtr, 64, std::hash<glm::ivec3>> ChunkMap;
 
-	uint32_t _chunkCountLimit = 0u;
+	struct ChunkShard {
+		ChunkShard(int maxSize) : chunks(maxSize) {
+		}
+		core::ReadWriteLock lock {"pagedvolume-shard"};
+		ChunkMap chunks;
+		core::AtomicInt hits { 0 };
+	};
 
-	typedef core::Map<glm::ivec3, ChunkPtr, 64, std::hash<glm::ivec3>> ChunkMap;
-	mutable ChunkMap _chunks;
+	typedef core::Map<glm::ivec3, CompressedChunk*, 64, std::hash<glm::ivec3>> CompressedChunkMap;
+
+	/**
+	 * A chunk that was requested asynchronously but isn't yet resident. The entry is removed again after the chunk
+	 * was inserted into the chunk map.
+	 */
+	struct LoadingChunk {
+		std::shared_ptr<std::promise<ChunkPtr>> promise;
+		ChunkFuture future;
+		// set if the pager is already working on the chunk
+		bool started = false;
+	};
+	typedef core::Map<glm::ivec3, LoadingChunk, 64, std::hash<glm::ivec3>> LoadingMap;
+
+	ChunkPtr chunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
+	ChunkPtr findChunk(const glm::ivec3& pos) const;
+	bool hasChunk(const glm::ivec3& pos) const;
+	ChunkPtr pageInChunk(const glm::ivec3& pos) const;
+	ChunkFuture scheduleChunk(const glm::ivec3& pos, bool& scheduled) const;
+	ChunkPtr createNewChunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
+	ChunkPtr deleteOldestChunkIfNeeded() const;
+	ChunkPtr deleteOldestChunkOfShard(ChunkShard& s) const;
+	ChunkShard& shard(const glm::ivec3& pos) const;
+	void linkChunk(Chunk* chunk) const;
+	void unlinkChunk(Chunk* chunk) const;
+	ChunkPtr restoreChunk(const glm::ivec3& pos) const;
+	void compressChunk(const ChunkPtr& chunk) const;
+	void linkCompressedChunk(CompressedChunk* chunk) const;
+	void unlinkCompressedChunk(CompressedChunk* chunk) const;
+	void flushCompressedChunks() const;
+	void stopPaging();
+	void releaseRetiredStorage(const ChunkPtr& chunk) const;
+
+	// The eviction never goes below this amount of chunks - enough to make sure a chunk and its neighbours can be
+	// loaded, with a few to spare.
+	static constexpr uint32_t MinChunks = 32u;
+
+	// The upper bound for the amount of resident chunks - this is the amount of the smallest possible chunks that
+	// fit into the memory limit. The chunk maps are sized for this.
+	uint32_t _chunkCountLimit = 0u;
+	// The chunks are evicted if their memory exceeds this limit
+	uint64_t _chunkMemoryLimit = 0u;
+
+	ChunkShard* _shards[ChunkShards];
+
+	// Protects the least recently used list and the chunk count. Lock order is _lruLock before any shard lock.
+	mutable core::Lock _lruLock;
+	// Most recently inserted chunk
+	mutable Chunk* _lruHead = nullptr;
+	// Eviction candidate
+	mutable Chunk* _lruTail = nullptr;
+	mutable uint32_t _chunkCount = 0u;
+	// The memory of all resident chunks
+	mutable uint64_t _chunkMemory = 0u;
+
+	// Only one thread is paging in new chunks at a time. The lock is recursive, as the pager is allowed to
+	// access (and thus page in) other chunks of this volume while it is filling a chunk. Per chunk locks would
+	// deadlock if two threads page in neighbouring chunks that reach into each other.
+	mutable core::Lock _pagerLock;
+
+	// Protects the chunks that are scheduled for asynchronous paging. Lock order is _loadingLock before any shard lock.
+	mutable core::Lock _loadingLock;
+	mutable LoadingMap _loading;
+	// The pager calls are serialized by the _pagerLock - so there is no need for more than one thread here.
+	mutable core::ThreadPool _threadPool {1, "PagedVolume"};
+	// Guarded by the _loadingLock
+	mutable bool _threadPoolInitialized = false;
+
+	// Protects the compressed chunks and the statistics. No other lock is acquired while holding this one.
+	mutable core::Lock _compressedLock;
+	CompressedChunkMap* _compressedChunks = nullptr;
+	// Most recently compressed chunk
+	mutable CompressedChunk* _compressedHead = nullptr;
+	// Eviction candidate
+	mutable CompressedChunk* _compressedTail = nullptr;
+	mutable uint32_t _compressedMemory = 0u;
+	uint32_t _compressedMemoryLimit = 0u;
+	mutable Statistics _statistics;
 
 	// The size of the chunks
 	uint16_t _chunkSideLength;
@@ -253,12 +553,40 @@ private:
 	Pager* _pager = nullptr;
 
 	Region _region;
-
-	mutable core::ReadWriteLock _volumeLock{"pagedvolume"};
 };
 
-inline const Voxel& PagedVolume::Sampler::voxel() const {
-	return *_currentVoxel;
+inline const Voxel& PagedVolume::Chunk::voxelAt(uint32_t index) const {
+	const Storage* storage = _storage.load(std::memory_order_acquire);
+	if (storage->data != nullptr) {
+		return storage->data[index];
+	}
+	const uint32_t bits = storage->bitsPerIndex;
+	if (bits == 0u) {
+		return storage->palette[0];
+	}
+	return storage->palette[paletteIndexAt(storage, index)];
+}
+
+inline uint32_t PagedVolume::Chunk::paletteIndexAt(const Storage* storage, uint32_t index) {
+	// the bits per index are a power of two - so an index never crosses a byte boundary
+	const uint32_t bits = storage->bitsPerIndex;
+	const uint32_t bitIndex = index * bits;
+	return (storage->indices[bitIndex >> 3] >> (bitIndex & 7u)) & ((1u << bits) - 1u);
+}
+
+inline const Voxel* PagedVolume::Chunk::rawData() const {
+	return _storage.load(std::memory_order_acquire)->data;
+}
+
+inline const Voxel& PagedVolume::Sampler::peekVoxel(int32_t delta) const {
+	if (_currentData != nullptr) {
+		return _currentData[_voxelIndex + delta];
+	}
+	return _currentChunk->voxelAt(_voxelIndex + delta);
+}
+
+inline Voxel PagedVolume::Sampler::voxel() const {
+	return peekVoxel(0);
 }
 
 inline void PagedVolume::Sampler::setPosition(const glm::ivec3& v3dNewPos) {
@@ -305,188 +633,188 @@ static const core::Array<int32_t, 256> deltaZ = {{ 4, 28, 4, 220, 4, 28, 4, 1756
 #define NEG_Z_DELTA (-(deltaZ[this->_zPosInChunk-1]))
 #define POS_Z_DELTA (deltaZ[this->_zPosInChunk])
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1ny1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx1ny1nz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
+		return peekVoxel(NEG_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume - 1, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1ny0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx1ny0pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Y_DELTA);
+		return peekVoxel(NEG_X_DELTA + NEG_Y_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume - 1, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1ny1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx1ny1pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
+		return peekVoxel(NEG_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume - 1, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx0py1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx0py1nz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Z_DELTA);
+		return peekVoxel(NEG_X_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx0py0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx0py0pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA);
+		return peekVoxel(NEG_X_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx0py1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx0py1pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Z_DELTA);
+		return peekVoxel(NEG_X_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1py1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx1py1nz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
+		return peekVoxel(NEG_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume + 1, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1py0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx1py0pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Y_DELTA);
+		return peekVoxel(NEG_X_DELTA + POS_Y_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume + 1, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1py1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1nx1py1pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
+		return peekVoxel(NEG_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume - 1, this->_yPosInVolume + 1, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px1ny1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px1ny1nz() const {
 	if (CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_Y_DELTA + NEG_Z_DELTA);
+		return peekVoxel(NEG_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume - 1, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px1ny0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px1ny0pz() const {
 	if (CAN_GO_NEG_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + NEG_Y_DELTA);
+		return peekVoxel(NEG_Y_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume - 1, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px1ny1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px1ny1pz() const {
 	if (CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_Y_DELTA + POS_Z_DELTA);
+		return peekVoxel(NEG_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume - 1, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px0py1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px0py1nz() const {
 	if (CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_Z_DELTA);
+		return peekVoxel(NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px0py0pz() const {
-	return *_currentVoxel;
+inline Voxel PagedVolume::Sampler::peekVoxel0px0py0pz() const {
+	return peekVoxel(0);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px0py1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px0py1pz() const {
 	if (CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_Z_DELTA);
+		return peekVoxel(POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px1py1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px1py1nz() const {
 	if (CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_Y_DELTA + NEG_Z_DELTA);
+		return peekVoxel(POS_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume + 1, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px1py0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px1py0pz() const {
 	if (CAN_GO_POS_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + POS_Y_DELTA);
+		return peekVoxel(POS_Y_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume + 1, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel0px1py1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel0px1py1pz() const {
 	if (CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_Y_DELTA + POS_Z_DELTA);
+		return peekVoxel(POS_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume, this->_yPosInVolume + 1, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px1ny1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px1ny1nz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
+		return peekVoxel(POS_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume - 1, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px1ny0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px1ny0pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Y_DELTA);
+		return peekVoxel(POS_X_DELTA + NEG_Y_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume - 1, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px1ny1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px1ny1pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
+		return peekVoxel(POS_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume - 1, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px0py1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px0py1nz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Z_DELTA);
+		return peekVoxel(POS_X_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px0py0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px0py0pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA);
+		return peekVoxel(POS_X_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px0py1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px0py1pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Z_DELTA);
+		return peekVoxel(POS_X_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume, this->_zPosInVolume + 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px1py1nz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px1py1nz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
+		return peekVoxel(POS_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume + 1, this->_zPosInVolume - 1);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px1py0pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px1py0pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Y_DELTA);
+		return peekVoxel(POS_X_DELTA + POS_Y_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume + 1, this->_zPosInVolume);
 }
 
-inline const Voxel& PagedVolume::Sampler::peekVoxel1px1py1pz() const {
+inline Voxel PagedVolume::Sampler::peekVoxel1px1py1pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
+		return peekVoxel(POS_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->_volume->voxel(this->_xPosInVolume + 1, this->_yPosInVolume + 1, this->_zPosInVolume + 1);
 }
@@ -509,4 +837,9 @@ inline const Region& PagedVolume::region() const {
 	return _region;
 }
 
+inline PagedVolume::ChunkShard& PagedVolume::shard(const glm::ivec3& pos) const {
+	const uint32_t hash = (uint32_t)pos.x * 73856093u ^ (uint32_t)pos.y * 19349663u ^ (uint32_t)pos.z * 83492791u;
+	return *_shards[hash & (ChunkShards - 1u)];
+}
+
 }
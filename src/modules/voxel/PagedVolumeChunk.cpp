@@ -6,6 +6,7 @@
 #include "Morton.h"
 #include "Utility.h"
 #include "core/Common.h"
+#include <algorithm>
 
 namespace voxel {
 
@@ -18,10 +19,8 @@ PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pag
 	_sideLength = sideLength;
 	_sideLengthPower = logBase2(sideLength);
 
-	// Allocate the data
-	const uint32_t uNoOfVoxels = _sideLength * _sideLength * _sideLength;
-	_data = (Voxel*)core_malloc(uNoOfVoxels * sizeof(Voxel));
-	core_memset(_data, 0, uNoOfVoxels * sizeof(Voxel));
+	// A new chunk is uniformly filled with air - no per voxel memory is needed until the first voxel differs
+	_storage.store(createStorage(0u), std::memory_order_relaxed);
 }
 
 PagedVolume::Chunk::~Chunk() {
@@ -29,8 +28,146 @@ PagedVolume::Chunk::~Chunk() {
 		_pager->pageOut(this);
 	}
 
-	core_free(_data);
-	_data = nullptr;
+	releaseRetiredStorage();
+	core_free(_storage.load(std::memory_order_relaxed));
+	_storage.store(nullptr, std::memory_order_relaxed);
+}
+
+PagedVolume::Chunk::Storage* PagedVolume::Chunk::createStorage(uint8_t bitsPerIndex) const {
+	const uint32_t voxelCount = voxels();
+	uint32_t paletteCapacity = 0u;
+	uint32_t payloadSize;
+	if (bitsPerIndex == RawBitsPerIndex) {
+		payloadSize = voxelCount * sizeof(Voxel);
+	} else {
+		paletteCapacity = 1u << bitsPerIndex;
+		payloadSize = (voxelCount * bitsPerIndex + 7u) / 8u;
+	}
+	const uint32_t headerSize = sizeof(Storage) + paletteCapacity * sizeof(Voxel);
+	const uint32_t sizeInBytes = headerSize + payloadSize;
+	uint8_t* buf = (uint8_t*)core_malloc(sizeInBytes);
+	// the raw voxels are always filled by the caller - but the palette indices must start at 0
+	core_memset(buf, 0, bitsPerIndex == RawBitsPerIndex ? headerSize : sizeInBytes);
+
+	Storage* storage = (Storage*)buf;
+	storage->palette = (Voxel*)(buf + sizeof(Storage));
+	if (bitsPerIndex == RawBitsPerIndex) {
+		storage->data = (Voxel*)(buf + headerSize);
+	} else if (bitsPerIndex > 0u) {
+		storage->indices = buf + headerSize;
+	} else {
+		// the uniform voxel - this is air after the memset
+		storage->paletteSize = 1u;
+	}
+	storage->sizeInBytes = sizeInBytes;
+	storage->paletteCapacity = (uint16_t)paletteCapacity;
+	storage->bitsPerIndex = bitsPerIndex;
+	return storage;
+}
+
+/**
+ * Other threads might still read from the current storage - so it's only replaced and retired, but not freed.
+ * @sa PagedVolume::releaseRetiredStorage()
+ */
+void PagedVolume::Chunk::publishStorage(Storage* storage) {
+	storage->retired = _storage.load(std::memory_order_relaxed);
+	// the new storage must be completely visible before other threads can pick it up
+	_storage.store(storage, std::memory_order_release);
+}
+
+void PagedVolume::Chunk::releaseRetiredStorage() {
+	Storage* storage = _storage.load(std::memory_order_relaxed);
+	Storage* retired = storage->retired;
+	while (retired != nullptr) {
+		Storage* next = retired->retired;
+		core_free(retired);
+		retired = next;
+	}
+	storage->retired = nullptr;
+}
+
+bool PagedVolume::Chunk::hasRetiredStorage() const {
+	return _storage.load(std::memory_order_acquire)->retired != nullptr;
+}
+
+/**
+ * Uniform chunks are promoted to 1 bit palette indices, the palette indices are doubled in size until they
+ * reach 8 bits. If 256 palette entries are not enough, the chunk is converted to the raw representation.
+ */
+PagedVolume::Chunk::Storage* PagedVolume::Chunk::promoteStorage(Storage* storage) {
+	const uint32_t bits = storage->bitsPerIndex == 0u ? 1u : storage->bitsPerIndex * 2u;
+	Storage* promoted = createStorage(bits > 8u ? RawBitsPerIndex : (uint8_t)bits);
+	const uint32_t voxelCount = voxels();
+	if (promoted->data != nullptr) {
+		for (uint32_t i = 0u; i < voxelCount; ++i) {
+			promoted->data[i] = voxelAt(i);
+		}
+	} else {
+		core_memcpy(promoted->palette, storage->palette, storage->paletteSize * sizeof(Voxel));
+		promoted->paletteSize = storage->paletteSize;
+		promoted->paletteHint = storage->paletteHint;
+		// the indices of a uniform chunk are all 0 - which is what the new storage starts with
+		if (storage->bitsPerIndex > 0u) {
+			for (uint32_t i = 0u; i < voxelCount; ++i) {
+				setPaletteIndexAt(promoted, i, paletteIndexAt(storage, i));
+			}
+		}
+	}
+	publishStorage(promoted);
+	return promoted;
+}
+
+void PagedVolume::Chunk::setPaletteIndexAt(Storage* storage, uint32_t index, uint32_t paletteIndex) {
+	const uint32_t bits = storage->bitsPerIndex;
+	const uint32_t bitIndex = index * bits;
+	const uint32_t shift = bitIndex & 7u;
+	const uint32_t mask = ((1u << bits) - 1u) << shift;
+	uint8_t& byte = storage->indices[bitIndex >> 3];
+	byte = (uint8_t)((byte & ~mask) | (paletteIndex << shift));
+}
+
+bool PagedVolume::Chunk::findPaletteIndex(Storage* storage, const Voxel& value, uint32_t& paletteIndex) const {
+	// most writes are done in runs of the same voxel
+	if (storage->palette[storage->paletteHint].isSame(value)) {
+		paletteIndex = storage->paletteHint;
+		return true;
+	}
+	for (uint32_t i = 0u; i < storage->paletteSize; ++i) {
+		if (storage->palette[i].isSame(value)) {
+			storage->paletteHint = (uint8_t)i;
+			paletteIndex = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void PagedVolume::Chunk::setVoxelsAt(uint32_t index, uint32_t amount, const Voxel& value) {
+	Storage* storage = _storage.load(std::memory_order_relaxed);
+	uint32_t paletteIndex = 0u;
+	if (storage->data == nullptr && !findPaletteIndex(storage, value, paletteIndex)) {
+		if (storage->paletteSize == storage->paletteCapacity) {
+			storage = promoteStorage(storage);
+		}
+		if (storage->data == nullptr) {
+			paletteIndex = storage->paletteSize;
+			storage->palette[paletteIndex] = value;
+			storage->paletteHint = (uint8_t)paletteIndex;
+			// readers never access the entry before an index refers to it
+			++storage->paletteSize;
+		}
+	}
+	if (storage->data != nullptr) {
+		std::fill_n(storage->data + index, amount, value);
+		return;
+	}
+	if (storage->bitsPerIndex == 0u) {
+		// the value is the uniform voxel of the chunk
+		return;
+	}
+	for (uint32_t i = index; i < index + amount; ++i) {
+		setPaletteIndexAt(storage, i, paletteIndex);
+	}
 }
 
 bool PagedVolume::Chunk::setData(const Voxel* voxels, size_t sizeInBytes) {
@@ -38,32 +175,77 @@ bool PagedVolume::Chunk::setData(const Voxel* voxels, size_t sizeInBytes) {
 		return false;
 	}
 	_dataModified = true;
-	core_memcpy((uint8_t*)_data, (const uint8_t*)voxels, sizeInBytes);
+	// start over with a uniform chunk and let it grow to the representation that is needed for the given voxels
+	Storage* storage = createStorage(0u);
+	storage->palette[0] = voxels[0];
+	publishStorage(storage);
+	const uint32_t voxelCount = this->voxels();
+	uint32_t start = 0u;
+	while (start < voxelCount) {
+		uint32_t end = start + 1u;
+		while (end < voxelCount && voxels[end].isSame(voxels[start])) {
+			++end;
+		}
+		setVoxelsAt(start, end - start, voxels[start]);
+		start = end;
+	}
 	return true;
 }
 
-Voxel* PagedVolume::Chunk::data() const {
-	return _data;
+bool PagedVolume::Chunk::data(Voxel* voxels, size_t sizeInBytes) const {
+	if (sizeInBytes != dataSizeInBytes()) {
+		return false;
+	}
+	const Storage* storage = _storage.load(std::memory_order_acquire);
+	const uint32_t voxelCount = this->voxels();
+	if (storage->data != nullptr) {
+		core_memcpy(voxels, storage->data, sizeInBytes);
+	} else if (storage->bitsPerIndex == 0u) {
+		std::fill_n(voxels, voxelCount, storage->palette[0]);
+	} else {
+		for (uint32_t i = 0u; i < voxelCount; ++i) {
+			voxels[i] = storage->palette[paletteIndexAt(storage, i)];
+		}
+	}
+	return true;
 }
 
 uint32_t PagedVolume::Chunk::dataSizeInBytes() const {
 	return voxels() * sizeof(Voxel);
 }
 
+uint32_t PagedVolume::Chunk::sizeInBytes() const {
+	uint32_t size = sizeof(*this);
+	for (const Storage* storage = _storage.load(std::memory_order_acquire); storage != nullptr; storage = storage->retired) {
+		size += storage->sizeInBytes;
+	}
+	return size;
+}
+
 uint32_t PagedVolume::Chunk::voxels() const {
 	return _sideLength * _sideLength * _sideLength;
 }
 
+PagedVolume::Chunk::Representation PagedVolume::Chunk::representation() const {
+	const Storage* storage = _storage.load(std::memory_order_acquire);
+	if (storage->data != nullptr) {
+		return Representation::Raw;
+	}
+	if (storage->bitsPerIndex == 0u) {
+		return Representation::Uniform;
+	}
+	return Representation::Palette;
+}
+
 const Voxel& PagedVolume::Chunk::voxel(uint32_t x, uint32_t y, uint32_t z) const {
 	// This code is not usually expected to be called by the user, with the exception of when implementing paging
 	// of uncompressed data. It's a performance critical code path
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", x, _sideLength);
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", y, _sideLength);
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", z, _sideLength);
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
 	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
-	return _data[index];
+	return voxelAt(index);
 }
 
 const Voxel& PagedVolume::Chunk::voxel(const glm::i16vec3& pos) const {
@@ -76,10 +258,9 @@ void PagedVolume::Chunk::setVoxel(uint32_t x, uint32_t y, uint32_t z, const Voxe
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
 	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
-	_data[index] = value;
+	setVoxelsAt(index, 1u, value);
 	_dataModified = true;
 }
 
@@ -94,11 +275,10 @@ void PagedVolume::Chunk::setVoxels(uint32_t x, uint32_t y, uint32_t z, const Vox
 	core_assert_msg(x < _sideLength, "Supplied x position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied y position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied z position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
 	for (int i = y; i < amount; ++i) {
 		const uint32_t index = morton256_x[x] | morton256_y[i] | morton256_z[z];
-		_data[index] = values[i];
+		setVoxelsAt(index, 1u, values[i]);
 	}
 	_dataModified = true;
 }
@@ -118,8 +298,14 @@ void PagedVolume::Chunk::setVoxel(const glm::i16vec3& pos, const Voxel& value) {
 uint32_t PagedVolume::Chunk::calculateSizeInBytes(uint32_t sideLength) {
 	// Note: We disregard the size of the other class members as they are likely to be very small compared to the size of the
 	// allocated voxel data. This also keeps the reported size as a power of two, which makes other memory calculations easier.
+	// This is the upper limit - chunks in the uniform or palette representation need less memory.
 	const uint32_t sizeInBytes = sideLength * sideLength * sideLength * sizeof(Voxel);
 	return sizeInBytes;
 }
 
+uint32_t PagedVolume::Chunk::calculateMinSizeInBytes() {
+	// see createStorage() - the uniform storage only holds the palette entry
+	return sizeof(Chunk) + sizeof(Storage) + sizeof(Voxel);
+}
+
 }
@@ -0,0 +1,83 @@
+/**
+ * @file
+ */
+
+#include "PagedVolume.h"
+#include "core/Common.h"
+
+namespace voxel {
+
+/**
+ * @brief Calls the given functor for every run of equal voxels. A run is limited to the max value of
+ * the 16 bit run length.
+ */
+template<class ACCESSOR, class FUNC>
+static void visitRuns(ACCESSOR&& voxelAt, uint32_t voxels, FUNC&& func) {
+	uint32_t start = 0u;
+	while (start < voxels) {
+		const Voxel& voxel = voxelAt(start);
+		const uint32_t maxEnd = core_min(voxels, start + (uint32_t)UINT16_MAX);
+		uint32_t end = start + 1u;
+		while (end < maxEnd && voxelAt(end).isSame(voxel)) {
+			++end;
+		}
+		func(voxel, (uint16_t)(end - start));
+		start = end;
+	}
+}
+
+PagedVolume::CompressedChunk::CompressedChunk(const Chunk* chunk) :
+		_sideLength(chunk->_sideLength), _chunkSpacePosition(chunk->_chunkSpacePosition) {
+	const uint32_t voxels = chunk->voxels();
+	const Voxel* data = chunk->rawData();
+	const auto voxelAt = [chunk, data] (uint32_t index) -> const Voxel& {
+		if (data != nullptr) {
+			return data[index];
+		}
+		return chunk->voxelAt(index);
+	};
+	// count the runs first to allocate the exact amount of memory
+	visitRuns(voxelAt, voxels, [this] (const Voxel&, uint16_t) {
+		++_runCount;
+	});
+	_runs = (Run*)core_malloc(_runCount * sizeof(Run));
+	Run* run = _runs;
+	visitRuns(voxelAt, voxels, [&run] (const Voxel& voxel, uint16_t length) {
+		run->voxel = voxel;
+		run->length = length;
+		++run;
+	});
+}
+
+PagedVolume::CompressedChunk::~CompressedChunk() {
+	core_free(_runs);
+	_runs = nullptr;
+}
+
+bool PagedVolume::CompressedChunk::decompress(Chunk* chunk) const {
+	if (chunk->_sideLength != _sideLength) {
+		return false;
+	}
+	uint32_t index = 0u;
+	for (uint32_t i = 0u; i < _runCount; ++i) {
+		const Run& run = _runs[i];
+		chunk->setVoxelsAt(index, run.length, run.voxel);
+		index += run.length;
+	}
+	core_assert(index == chunk->voxels());
+	return true;
+}
+
+uint32_t PagedVolume::CompressedChunk::sizeInBytes() const {
+	return sizeof(*this) + _runCount * sizeof(Run);
+}
+
+uint32_t PagedVolume::CompressedChunk::runs() const {
+	return _runCount;
+}
+
+const glm::ivec3& PagedVolume::CompressedChunk::chunkPos() const {
+	return _chunkSpacePosition;
+}
+
+}
@@ -51,16 +51,20 @@ void PagedVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos)
 	const uint32_t voxelIndexInChunk = morton256_x[_xPosInChunk] | morton256_y[_yPosInChunk] | morton256_z[_zPosInChunk];
 
 	_currentChunk = _volume->chunk(xChunk, yChunk, zChunk);
-	_currentVoxel = _currentChunk->_data + voxelIndexInChunk;
+	_currentData = _currentChunk->rawData();
+	_voxelIndex = voxelIndexInChunk;
 }
 
 bool PagedVolume::Sampler::setVoxel(const Voxel& tValue) {
-	if (_currentVoxel == nullptr) {
+	if (!_currentChunk) {
 		return false;
 	}
 	//Need to think what effect this has on any existing iterators.
 	//core_assert_msg(false, "This function cannot be used on PagedVolume samplers.");
-	*_currentVoxel = tValue;
+	_currentChunk->setVoxelsAt(_voxelIndex, 1u, tValue);
+	_currentChunk->_dataModified = true;
+	// the chunk might have been promoted to the raw representation
+	_currentData = _currentChunk->rawData();
 	return true;
 }
 
@@ -70,7 +74,7 @@ void PagedVolume::Sampler::movePositiveX() {
 	// Then we update the voxel pointer
 	if (CAN_GO_POS_X(_xPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += POS_X_DELTA;
+		_voxelIndex += POS_X_DELTA;
 		_xPosInChunk++;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -84,7 +88,7 @@ void PagedVolume::Sampler::movePositiveY() {
 	// Then we update the voxel pointer
 	if (CAN_GO_POS_Y(_yPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += POS_Y_DELTA;
+		_voxelIndex += POS_Y_DELTA;
 		_yPosInChunk++;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -98,7 +102,7 @@ void PagedVolume::Sampler::movePositiveZ() {
 	// Then we update the voxel pointer
 	if (CAN_GO_POS_Z(_zPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += POS_Z_DELTA;
+		_voxelIndex += POS_Z_DELTA;
 		_zPosInChunk++;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -112,7 +116,7 @@ void PagedVolume::Sampler::moveNegativeX() {
 	// Then we update the voxel pointer
 	if (CAN_GO_NEG_X(_xPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += NEG_X_DELTA;
+		_voxelIndex += NEG_X_DELTA;
 		_xPosInChunk--;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -126,7 +130,7 @@ void PagedVolume::Sampler::moveNegativeY() {
 	// Then we update the voxel pointer
 	if (CAN_GO_NEG_Y(_yPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += NEG_Y_DELTA;
+		_voxelIndex += NEG_Y_DELTA;
 		_yPosInChunk--;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -140,7 +144,7 @@ void PagedVolume::Sampler::moveNegativeZ() {
 	// Then we update the voxel pointer
 	if (CAN_GO_NEG_Z(_zPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += NEG_Z_DELTA;
+		_voxelIndex += NEG_Z_DELTA;
 		_zPosInChunk--;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
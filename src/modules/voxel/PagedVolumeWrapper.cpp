@@ -39,7 +39,8 @@ void PagedVolumeWrapper::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_
 		_currentChunk = _volume->chunk(xChunk, yChunk, zChunk);
 	}
 
-	_currentVoxel = _currentChunk->_data + voxelIndexInChunk;
+	_currentData = _currentChunk->rawData();
+	_voxelIndex = voxelIndexInChunk;
 }
 
 PagedVolumeWrapper::PagedVolumeWrapper(PagedVolume* voxelStorage, const PagedVolume::ChunkPtr& chunk, const Region& region) :
@@ -52,7 +53,7 @@ PagedVolumeWrapper::PagedVolumeWrapper(PagedVolume* voxelStorage, const PagedVol
 	}
 }
 
-const Voxel& PagedVolumeWrapper::voxel(int x, int y, int z) const {
+Voxel PagedVolumeWrapper::voxel(int x, int y, int z) const {
 	if (_validRegion.containsPoint(x, y, z)) {
 		core_assert(_chunk != nullptr);
 		const int relX = x - _validRegion.getLowerX();
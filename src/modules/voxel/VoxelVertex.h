@@ -6,6 +6,7 @@
 
 #include "Voxel.h"
 #include <glm/vec3.hpp>
+#include <glm/ext/vector_uint3_sized.hpp>
 
 namespace voxel {
 
@@ -24,7 +25,33 @@ struct VoxelVertex {
 };
 static_assert(sizeof(VoxelVertex) == 16, "Unexpected size of the vertex struct");
 
-// TODO: maybe reduce to uint16_t and use glDrawElementsBaseVertex
 typedef uint32_t IndexType;
 
+/**
+ * @brief Packed variant of the @c VoxelVertex for meshes with a small extent - like the world mesh columns.
+ * The position is relative to the offset of the mesh.
+ * @sa Mesh::pack()
+ */
+struct VoxelVertexPacked {
+	glm::u8vec3 position;
+	uint8_t padding0;
+	/** 0 is the darkest, 3 is no occlusion at all */
+	uint8_t ambientOcclusion;
+	uint8_t colorIndex;
+	VoxelType material;
+	uint8_t padding1;
+};
+static_assert(sizeof(VoxelVertexPacked) == 8, "Unexpected size of the packed vertex struct");
+
+/**
+ * @brief The highest vertex position relative to the mesh offset that fits into the packed vertex
+ */
+constexpr int MaxPackedVertexPosition = 255;
+
+/**
+ * @brief Indices of packed meshes are relative to the base vertex of their draw range
+ * @sa PackedRange
+ */
+typedef uint16_t PackedIndexType;
+
 }
@@ -0,0 +1,164 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "core/concurrent/ThreadPool.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/RawVolume.h"
+#include <glm/geometric.hpp>
+
+namespace voxel {
+
+class CubicSurfaceExtractorTest: public core::AbstractTest {
+protected:
+	/**
+	 * @brief Fills the volume with a pattern that contains a lot of different surfaces, colors and ambient occlusion values
+	 */
+	void fillPattern(RawVolume& volume) const {
+		const Region& region = volume.region();
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					if ((x * 7 + y * 13 + z * 5) % 5 < 2 || y < 2) {
+						volume.setVoxel(x, y, z, createVoxel(VoxelType::Grass, (x + z) % 3));
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * @return The area that is covered by the triangles of the mesh
+	 */
+	float surfaceArea(const Mesh& mesh) const {
+		float area = 0.0f;
+		for (size_t i = 0; i < mesh.getNoOfIndices(); i += 3) {
+			const glm::vec3 p0(mesh.getVertex(mesh.getIndex(i + 0)).position);
+			const glm::vec3 p1(mesh.getVertex(mesh.getIndex(i + 1)).position);
+			const glm::vec3 p2(mesh.getVertex(mesh.getIndex(i + 2)).position);
+			area += glm::length(glm::cross(p1 - p0, p2 - p0)) * 0.5f;
+		}
+		return area;
+	}
+
+	/**
+	 * @return The amount of vertices that are equal to a vertex with a lower index
+	 */
+	int duplicatedVertices(const Mesh& mesh) const {
+		int duplicates = 0;
+		for (size_t i = 0; i < mesh.getNoOfVertices(); ++i) {
+			const VoxelVertex& v1 = mesh.getVertex(i);
+			for (size_t j = 0; j < i; ++j) {
+				const VoxelVertex& v2 = mesh.getVertex(j);
+				if (v1.position == v2.position && v1.ambientOcclusion == v2.ambientOcclusion
+						&& v1.colorIndex == v2.colorIndex && v1.material == v2.material) {
+					++duplicates;
+					break;
+				}
+			}
+		}
+		return duplicates;
+	}
+};
+
+TEST_F(CubicSurfaceExtractorTest, testGreedyBox) {
+	RawVolume volume(Region(0, 7));
+	for (int32_t z = 1; z <= 4; ++z) {
+		for (int32_t y = 1; y <= 4; ++y) {
+			for (int32_t x = 1; x <= 4; ++x) {
+				volume.setVoxel(x, y, z, createVoxel(VoxelType::Grass, 1));
+			}
+		}
+	}
+	Mesh mesh(0, 0, true);
+	extractGreedyCubicMesh(&volume, volume.region(), &mesh, IsQuadNeeded());
+	// one quad per side of the box - the quads share the corners
+	EXPECT_EQ(8u, mesh.getNoOfVertices());
+	EXPECT_EQ(36u, mesh.getNoOfIndices());
+	EXPECT_EQ(glm::ivec3(1), mesh.mins());
+	EXPECT_EQ(glm::ivec3(5), mesh.maxs());
+	EXPECT_FLOAT_EQ(6.0f * 4.0f * 4.0f, surfaceArea(mesh));
+	for (size_t i = 0; i < mesh.getNoOfVertices(); ++i) {
+		const VoxelVertex& v = mesh.getVertex(i);
+		EXPECT_EQ(3, v.ambientOcclusion);
+		EXPECT_EQ(1, v.colorIndex);
+		EXPECT_EQ(VoxelType::Grass, v.material);
+	}
+}
+
+TEST_F(CubicSurfaceExtractorTest, testGreedyAmbientOcclusion) {
+	RawVolume volume(Region(0, 3));
+	for (int32_t z = 0; z <= 2; ++z) {
+		for (int32_t x = 0; x <= 2; ++x) {
+			volume.setVoxel(x, 0, z, createVoxel(VoxelType::Grass, 0));
+			volume.setVoxel(x, 1, z, createVoxel(VoxelType::Grass, 0));
+		}
+	}
+	volume.setVoxel(1, 2, 1, createVoxel(VoxelType::Grass, 0));
+	Mesh mesh(0, 0, true);
+	extractGreedyCubicMesh(&volume, volume.region(), &mesh, IsQuadNeeded());
+	const int noAO = 3;
+	int floorVertices = 0;
+	for (size_t i = 0; i < mesh.getNoOfVertices(); ++i) {
+		const VoxelVertex& v = mesh.getVertex(i);
+		if (v.position.y != 2 || v.position.x == 0 || v.position.x == 3 || v.position.z == 0 || v.position.z == 3) {
+			continue;
+		}
+		if (v.ambientOcclusion != noAO) {
+			++floorVertices;
+		}
+	}
+	// the inner floor corners next to the block must not be merged away
+	EXPECT_GT(floorVertices, 0);
+	EXPECT_GT(mesh.getNoOfIndices(), 6u * 6u);
+}
+
+TEST_F(CubicSurfaceExtractorTest, testGreedyCoversSameSurface) {
+	RawVolume volume(Region(0, 15));
+	fillPattern(volume);
+	const Region region(glm::ivec3(1), glm::ivec3(14));
+
+	Mesh singleQuads(0, 0, true);
+	extractCubicMesh(&volume, region, &singleQuads, IsQuadNeeded(), false, false);
+	Mesh mergedQuads(0, 0, true);
+	extractCubicMesh(&volume, region, &mergedQuads, IsQuadNeeded());
+	Mesh greedy(0, 0, true);
+	extractGreedyCubicMesh(&volume, region, &greedy, IsQuadNeeded());
+
+	ASSERT_GT(singleQuads.getNoOfIndices(), 0u);
+	EXPECT_FLOAT_EQ(surfaceArea(singleQuads), surfaceArea(greedy));
+	EXPECT_LE(greedy.getNoOfIndices(), mergedQuads.getNoOfIndices());
+	EXPECT_LE(greedy.getNoOfVertices(), mergedQuads.getNoOfVertices());
+	EXPECT_EQ(0, duplicatedVertices(greedy));
+	EXPECT_EQ(singleQuads.mins(), greedy.mins());
+	EXPECT_EQ(singleQuads.maxs(), greedy.maxs());
+}
+
+TEST_F(CubicSurfaceExtractorTest, testGreedyThreadPool) {
+	RawVolume volume(Region(0, 31));
+	fillPattern(volume);
+	const Region region(glm::ivec3(1), glm::ivec3(30));
+
+	Mesh mesh(0, 0, true);
+	extractGreedyCubicMesh(&volume, region, &mesh, IsQuadNeeded());
+
+	core::ThreadPool threadPool(3, "GreedyMesh");
+	threadPool.init();
+	Mesh parallelMesh(0, 0, true);
+	extractGreedyCubicMesh(&volume, region, &parallelMesh, IsQuadNeeded(), &threadPool);
+	threadPool.shutdown(true);
+
+	ASSERT_EQ(mesh.getNoOfVertices(), parallelMesh.getNoOfVertices());
+	ASSERT_EQ(mesh.getIndexVector(), parallelMesh.getIndexVector());
+	for (size_t i = 0; i < mesh.getNoOfVertices(); ++i) {
+		const VoxelVertex& v1 = mesh.getVertex(i);
+		const VoxelVertex& v2 = parallelMesh.getVertex(i);
+		ASSERT_EQ(v1.position, v2.position) << "vertex " << i;
+		ASSERT_EQ(v1.ambientOcclusion, v2.ambientOcclusion) << "vertex " << i;
+		ASSERT_EQ(v1.colorIndex, v2.colorIndex) << "vertex " << i;
+	}
+}
+
+}
@@ -0,0 +1,97 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/Mesh.h"
+#include "voxel/RawVolume.h"
+
+namespace voxel {
+
+class MeshTest: public core::AbstractTest {
+protected:
+	VoxelVertex vertex(const glm::ivec3& position) const {
+		VoxelVertex v;
+		v.position = position;
+		v.ambientOcclusion = 3;
+		v.colorIndex = 1;
+		v.material = VoxelType::Grass;
+		return v;
+	}
+};
+
+TEST_F(MeshTest, testPack) {
+	const glm::ivec3 offset(32, 0, -64);
+	RawVolume volume(Region(offset, offset + 15));
+	for (int32_t z = 1; z <= 4; ++z) {
+		for (int32_t x = 1; x <= 4; ++x) {
+			volume.setVoxel(offset.x + x, 0, offset.z + z, createVoxel(VoxelType::Grass, 1));
+		}
+	}
+	Mesh mesh(0, 0, true);
+	extractGreedyCubicMesh(&volume, volume.region(), &mesh, IsQuadNeeded());
+	mesh.setOffset(offset);
+	ASSERT_FALSE(mesh.isEmpty());
+
+	PackedMesh packed;
+	ASSERT_TRUE(mesh.pack(packed));
+	EXPECT_EQ(offset, packed.offset);
+	EXPECT_EQ(mesh.mins(), packed.mins);
+	EXPECT_EQ(mesh.maxs(), packed.maxs);
+	ASSERT_EQ(1u, packed.ranges.size());
+	EXPECT_EQ(0u, packed.ranges[0].baseIndex);
+	EXPECT_EQ(0u, packed.ranges[0].baseVertex);
+	EXPECT_EQ(mesh.getNoOfIndices(), packed.ranges[0].numIndices);
+	ASSERT_EQ(mesh.getNoOfVertices(), packed.vertices.size());
+	for (size_t i = 0; i < mesh.getNoOfIndices(); ++i) {
+		EXPECT_EQ(mesh.getIndex(i), packed.indices[i]);
+	}
+	for (size_t i = 0; i < mesh.getNoOfVertices(); ++i) {
+		const VoxelVertex& v = mesh.getVertex(i);
+		const VoxelVertexPacked& p = packed.vertices[i];
+		EXPECT_EQ(v.position, glm::ivec3(p.position) + offset);
+		EXPECT_EQ(v.ambientOcclusion, p.ambientOcclusion);
+		EXPECT_EQ(v.colorIndex, p.colorIndex);
+		EXPECT_EQ(v.material, p.material);
+	}
+}
+
+TEST_F(MeshTest, testPackSplitsRanges) {
+	const int quads = 20000;
+	Mesh mesh(quads * 4, quads * 6, true);
+	for (int i = 0; i < quads; ++i) {
+		const glm::ivec3 pos(i % 200, i / 200 % 100, 0);
+		const IndexType i0 = mesh.addVertex(vertex(pos));
+		const IndexType i1 = mesh.addVertex(vertex(pos + glm::ivec3(1, 0, 0)));
+		const IndexType i2 = mesh.addVertex(vertex(pos + glm::ivec3(1, 1, 0)));
+		const IndexType i3 = mesh.addVertex(vertex(pos + glm::ivec3(0, 1, 0)));
+		mesh.addTriangle(i0, i1, i2);
+		mesh.addTriangle(i0, i2, i3);
+	}
+	PackedMesh packed;
+	ASSERT_TRUE(mesh.pack(packed));
+	ASSERT_EQ(2u, packed.ranges.size()) << "80000 vertices don't fit into one 16 bit index range";
+	uint32_t numIndices = 0u;
+	for (const PackedRange& range : packed.ranges) {
+		EXPECT_EQ(numIndices, range.baseIndex);
+		for (uint32_t i = range.baseIndex; i < range.baseIndex + range.numIndices; ++i) {
+			ASSERT_EQ(mesh.getIndex(i), packed.indices[i] + range.baseVertex) << "index " << i;
+		}
+		numIndices += range.numIndices;
+	}
+	EXPECT_EQ(mesh.getNoOfIndices(), numIndices);
+}
+
+TEST_F(MeshTest, testPackOutOfRange) {
+	Mesh mesh(4, 6, true);
+	const IndexType i0 = mesh.addVertex(vertex(glm::ivec3(0)));
+	const IndexType i1 = mesh.addVertex(vertex(glm::ivec3(256, 0, 0)));
+	const IndexType i2 = mesh.addVertex(vertex(glm::ivec3(256, 1, 0)));
+	mesh.addTriangle(i0, i1, i2);
+	PackedMesh packed;
+	EXPECT_FALSE(mesh.pack(packed)) << "The vertex positions exceed the 8 bit range";
+}
+
+}
@@ -0,0 +1,458 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "core/concurrent/Atomic.h"
+#include <SDL_timer.h>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace voxel {
+
+class PagedVolumeTest: public core::AbstractTest {
+protected:
+	class CountingPager: public PagedVolume::Pager {
+	public:
+		core::AtomicInt pageIns { 0 };
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			++pageIns;
+			const Voxel voxel = createVoxel(VoxelType::Grass, 0);
+			const int32_t sideLength = ctx.chunk->sideLength();
+			for (int32_t i = 0; i < sideLength; ++i) {
+				ctx.chunk->setVoxel(i, 0, 0, voxel);
+			}
+			return true;
+		}
+
+		void pageOut(PagedVolume::Chunk* chunk) override {
+		}
+
+		core::AtomicInt restores { 0 };
+		void pageRestored(PagedVolume::PagerContext& ctx) override {
+			++restores;
+		}
+
+		core::AtomicInt evictions { 0 };
+		void pageEvicted(PagedVolume::Chunk* chunk) override {
+			++evictions;
+		}
+	};
+
+	/**
+	 * @brief Fills the chunks with more different voxels than the palette can hold - the chunks need the memory
+	 * of the raw representation. The grass voxels of the @c CountingPager are set, too.
+	 */
+	class RawPager: public CountingPager {
+	public:
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			std::vector<Voxel> voxels(ctx.chunk->voxels());
+			for (size_t i = 0; i < voxels.size(); ++i) {
+				voxels[i] = createVoxel(i % 2 ? VoxelType::Dirt : VoxelType::Rock, (uint8_t)(i / 2));
+			}
+			ctx.chunk->setData(voxels.data(), ctx.chunk->dataSizeInBytes());
+			return CountingPager::pageIn(ctx);
+		}
+	};
+
+	/**
+	 * @brief Keeps the chunks in the uniform representation
+	 */
+	class UniformPager: public CountingPager {
+	public:
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			++pageIns;
+			return false;
+		}
+	};
+
+	class BlockingPager: public CountingPager {
+	public:
+		core::AtomicBool started { false };
+		core::AtomicBool release { false };
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			started = true;
+			while (!release) {
+				SDL_Delay(1);
+			}
+			return CountingPager::pageIn(ctx);
+		}
+	};
+
+	static constexpr uint16_t ChunkSideLength = 32;
+	// the memory of 16 raw chunks - the eviction keeps at least 32 chunks
+	static constexpr uint32_t MemoryLimit = 1 * 1024 * 1024;
+	static constexpr int ChunkLimit = 32;
+};
+
+TEST_F(PagedVolumeTest, testEvictOldestChunk) {
+	RawPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, 0.0f);
+	for (int i = 0; i <= ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns);
+	volume.chunk(glm::ivec3(ChunkLimit * ChunkSideLength, 0, 0));
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns) << "Chunk should still be resident";
+	volume.chunk(glm::ivec3(0));
+	EXPECT_EQ(ChunkLimit + 2, (int)pager.pageIns) << "The oldest chunk should have been evicted";
+}
+
+TEST_F(PagedVolumeTest, testReferencedChunkSurvivesEviction) {
+	RawPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, 0.0f);
+	for (int i = 0; i <= ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	// the eviction of the first chunk cleared the referenced flags of all other chunks
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns);
+	// touch the oldest chunk - this should give it a second chance
+	volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	volume.chunk(glm::ivec3((ChunkLimit + 1) * ChunkSideLength, 0, 0));
+	EXPECT_EQ(ChunkLimit + 2, (int)pager.pageIns);
+	volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	EXPECT_EQ(ChunkLimit + 2, (int)pager.pageIns) << "The referenced chunk should not have been evicted";
+	volume.chunk(glm::ivec3(2 * ChunkSideLength, 0, 0));
+	EXPECT_EQ(ChunkLimit + 3, (int)pager.pageIns) << "The second oldest chunk should have been evicted";
+}
+
+TEST_F(PagedVolumeTest, testNewChunkSurvivesEviction) {
+	RawPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, 0.0f);
+	for (int i = 0; i < ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	// reference all chunks of the volume that is at its limit
+	for (int i = 0; i < ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(ChunkLimit, (int)pager.pageIns);
+	const glm::ivec3 pos(ChunkLimit * ChunkSideLength, 0, 0);
+	volume.chunk(pos);
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns);
+	volume.chunk(pos);
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns) << "The paged in chunk must not be the evicted one";
+}
+
+TEST_F(PagedVolumeTest, testFullShardEvictsOwnChunk) {
+	UniformPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, 0.0f);
+	// all of these chunks end up in the same shard - which only holds a part of the chunk limit. The uniform chunks
+	// don't reach the memory limit before.
+	int chunks = 0;
+	while (pager.evictions == 0 && chunks < 65536) {
+		volume.chunk(glm::ivec3(chunks * 16 * ChunkSideLength, 0, 0));
+		++chunks;
+	}
+	EXPECT_EQ(chunks, (int)pager.pageIns);
+	EXPECT_GT((int)pager.evictions, 0) << "The full shard should have evicted its oldest chunks";
+	EXPECT_TRUE(volume.isResident(glm::ivec3((chunks - 1) * 16 * ChunkSideLength, 0, 0)));
+	EXPECT_FALSE(volume.isResident(glm::ivec3(0))) << "The oldest chunk of the shard should have been evicted";
+	EXPECT_GT(volume.statistics().hotChunks, (uint32_t)ChunkLimit);
+}
+
+TEST_F(PagedVolumeTest, testEvictionByChunkMemory) {
+	UniformPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, 0.0f);
+	// a lot more uniform chunks than raw chunks fit into the memory limit
+	const int chunks = ChunkLimit * 8;
+	for (int i = 0; i < chunks; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(0, (int)pager.evictions);
+	EXPECT_EQ((uint32_t)chunks, volume.statistics().hotChunks);
+	EXPECT_LE(volume.statistics().hotMemory, (uint64_t)MemoryLimit);
+
+	RawPager rawPager;
+	PagedVolume rawVolume(&rawPager, MemoryLimit, ChunkSideLength, 0.0f);
+	for (int i = 0; i < chunks; ++i) {
+		rawVolume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(chunks - ChunkLimit, (int)rawPager.evictions);
+	EXPECT_EQ((uint32_t)ChunkLimit, rawVolume.statistics().hotChunks);
+}
+
+TEST_F(PagedVolumeTest, testFlushAll) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	volume.chunk(glm::ivec3(0));
+	volume.flushAll();
+	volume.chunk(glm::ivec3(0));
+	EXPECT_EQ(2, (int)pager.pageIns);
+}
+
+TEST_F(PagedVolumeTest, testCompressedChunk) {
+	CountingPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), ChunkSideLength, &pager);
+	const Voxel dirt = createVoxel(VoxelType::Dirt, 1);
+	for (int32_t x = 0; x < ChunkSideLength; ++x) {
+		for (int32_t z = 0; z < ChunkSideLength; ++z) {
+			chunk.setVoxel(x, 0, z, dirt);
+		}
+	}
+	chunk.setVoxel(3, 7, 5, createVoxel(VoxelType::Grass, 2));
+	const PagedVolume::CompressedChunk compressed(&chunk);
+	EXPECT_LT(compressed.sizeInBytes(), chunk.dataSizeInBytes());
+
+	PagedVolume::Chunk restored(glm::ivec3(0), ChunkSideLength, &pager);
+	ASSERT_TRUE(compressed.decompress(&restored));
+	for (int32_t x = 0; x < ChunkSideLength; ++x) {
+		for (int32_t y = 0; y < ChunkSideLength; ++y) {
+			for (int32_t z = 0; z < ChunkSideLength; ++z) {
+				ASSERT_TRUE(chunk.voxel(x, y, z).isSame(restored.voxel(x, y, z))) << x << ":" << y << ":" << z;
+			}
+		}
+	}
+
+	PagedVolume::Chunk wrongSize(glm::ivec3(0), ChunkSideLength / 2, &pager);
+	EXPECT_FALSE(compressed.decompress(&wrongSize));
+}
+
+TEST_F(PagedVolumeTest, testRestoreCompressedChunk) {
+	RawPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	for (int i = 0; i <= ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	PagedVolume::Statistics stats = volume.statistics();
+	EXPECT_EQ(ChunkLimit, (int)stats.hotChunks);
+	EXPECT_EQ(1, (int)stats.warmChunks);
+	EXPECT_GT(stats.warmMemory, 0u);
+	EXPECT_EQ(0, stats.warmHits);
+	EXPECT_EQ(ChunkLimit + 1, stats.warmMisses);
+
+	EXPECT_EQ(VoxelType::Grass, volume.voxel(1, 0, 0).getMaterial());
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns) << "The evicted chunk should have been restored from the compressed tier";
+	EXPECT_EQ(1, (int)pager.restores);
+	EXPECT_EQ(2, (int)pager.evictions);
+	EXPECT_EQ(VoxelType::Grass, volume.voxel(2, 0, 0).getMaterial());
+	stats = volume.statistics();
+	EXPECT_EQ(1, stats.warmHits);
+	EXPECT_EQ(ChunkLimit + 2, stats.hotMisses);
+	EXPECT_EQ(1, (int)stats.warmChunks) << "The restored chunk should have evicted another chunk into the compressed tier";
+	EXPECT_GT(stats.hotHits, 0);
+
+	volume.flushAll();
+	EXPECT_EQ(ChunkLimit + 2, (int)pager.evictions) << "Every resident chunk should have been evicted by the flush";
+	stats = volume.statistics();
+	EXPECT_EQ(0, (int)stats.hotChunks);
+	EXPECT_EQ(0, (int)stats.warmChunks);
+	EXPECT_EQ(0u, stats.warmMemory);
+}
+
+TEST_F(PagedVolumeTest, testChunkRepresentation) {
+	CountingPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), ChunkSideLength, &pager);
+	EXPECT_EQ(PagedVolume::Chunk::Representation::Uniform, chunk.representation());
+	const uint32_t uniformSize = chunk.sizeInBytes();
+	EXPECT_LT(uniformSize, chunk.dataSizeInBytes());
+	chunk.setVoxel(1, 2, 3, createVoxel(VoxelType::Air, 0));
+	EXPECT_EQ(PagedVolume::Chunk::Representation::Uniform, chunk.representation());
+
+	chunk.setVoxel(1, 2, 3, createVoxel(VoxelType::Dirt, 0));
+	EXPECT_EQ(PagedVolume::Chunk::Representation::Palette, chunk.representation());
+	EXPECT_EQ(VoxelType::Dirt, chunk.voxel(1, 2, 3).getMaterial());
+	EXPECT_EQ(VoxelType::Air, chunk.voxel(1, 2, 4).getMaterial());
+
+	// two materials with all colors - 256 palette entries are not enough for this
+	for (int32_t y = 0; y < ChunkSideLength; ++y) {
+		for (int32_t x = 0; x < ChunkSideLength; ++x) {
+			const uint8_t color = (uint8_t)(x + y * ChunkSideLength);
+			chunk.setVoxel(x, y, 0, createVoxel(VoxelType::Rock, color));
+			chunk.setVoxel(x, y, 1, createVoxel(VoxelType::Sand, color));
+		}
+	}
+	EXPECT_EQ(PagedVolume::Chunk::Representation::Raw, chunk.representation());
+	EXPECT_TRUE(chunk.voxel(1, 2, 3).isSame(createVoxel(VoxelType::Dirt, 0)));
+	EXPECT_TRUE(chunk.voxel(5, 7, 0).isSame(createVoxel(VoxelType::Rock, 229)));
+	EXPECT_TRUE(chunk.voxel(5, 7, 1).isSame(createVoxel(VoxelType::Sand, 229)));
+	EXPECT_TRUE(chunk.voxel(5, 7, 2).isSame(createVoxel(VoxelType::Air, 0)));
+}
+
+TEST_F(PagedVolumeTest, testChunkSetData) {
+	CountingPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), ChunkSideLength, &pager);
+	std::vector<Voxel> voxels(chunk.voxels(), createVoxel(VoxelType::Rock, 1));
+	ASSERT_TRUE(chunk.setData(voxels.data(), voxels.size() * sizeof(Voxel)));
+	EXPECT_EQ(PagedVolume::Chunk::Representation::Uniform, chunk.representation());
+	EXPECT_TRUE(chunk.voxel(4, 5, 6).isSame(voxels[0]));
+
+	for (size_t i = 0; i < voxels.size(); i += 3) {
+		voxels[i] = createVoxel(VoxelType::Grass, (uint8_t)(i % 3u));
+	}
+	ASSERT_TRUE(chunk.setData(voxels.data(), voxels.size() * sizeof(Voxel)));
+	EXPECT_EQ(PagedVolume::Chunk::Representation::Palette, chunk.representation());
+	EXPECT_LT(chunk.sizeInBytes(), chunk.dataSizeInBytes());
+	EXPECT_FALSE(chunk.setData(voxels.data(), 1));
+}
+
+TEST_F(PagedVolumeTest, testRetiredStorageIsReleased) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const glm::ivec3 pos(0);
+	// the palette of air and grass is full - nobody else holds the chunk, so the promotion frees the retired storage
+	volume.setVoxel(1, 1, 1, createVoxel(VoxelType::Dirt, 0));
+	const uint32_t size = volume.chunk(pos)->sizeInBytes();
+	EXPECT_EQ(VoxelType::Dirt, volume.voxel(1, 1, 1).getMaterial());
+	std::vector<Voxel> voxels(volume.chunk(pos)->voxels());
+	ASSERT_TRUE(volume.chunk(pos)->data(voxels.data(), volume.chunk(pos)->dataSizeInBytes()));
+
+	// another reference might still read from the retired storage
+	PagedVolume::ChunkPtr chunk = volume.chunk(pos);
+	const Voxel& air = chunk->voxel(1, 2, 1);
+	ASSERT_TRUE(chunk->setData(voxels.data(), chunk->dataSizeInBytes()));
+	volume.setVoxel(1, 2, 2, createVoxel(VoxelType::Dirt, 0));
+	EXPECT_GT(chunk->sizeInBytes(), size);
+	EXPECT_TRUE(isAir(air.getMaterial()));
+
+	// the next write is a safe point to free it
+	chunk = PagedVolume::ChunkPtr();
+	volume.setVoxel(1, 2, 3, createVoxel(VoxelType::Dirt, 0));
+	EXPECT_EQ(size, volume.chunk(pos)->sizeInBytes());
+	EXPECT_EQ((uint64_t)size, volume.statistics().hotMemory);
+}
+
+TEST_F(PagedVolumeTest, testSamplerPaletteChunk) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	PagedVolume::Sampler sampler(volume);
+	sampler.setPosition(0, 1, 0);
+	EXPECT_EQ(VoxelType::Air, sampler.voxel().getMaterial());
+	EXPECT_EQ(VoxelType::Grass, sampler.peekVoxel0px1ny0pz().getMaterial());
+	sampler.moveNegativeY();
+	EXPECT_EQ(VoxelType::Grass, sampler.voxel().getMaterial());
+	EXPECT_EQ(VoxelType::Grass, sampler.peekVoxel1px0py0pz().getMaterial());
+	EXPECT_EQ(VoxelType::Air, sampler.peekVoxel0px1py0pz().getMaterial());
+	EXPECT_EQ(PagedVolume::Chunk::Representation::Palette, volume.chunk(glm::ivec3(0))->representation());
+	ASSERT_TRUE(sampler.setVoxel(createVoxel(VoxelType::Rock, 0)));
+	EXPECT_EQ(VoxelType::Rock, sampler.voxel().getMaterial());
+	EXPECT_EQ(VoxelType::Rock, volume.voxel(0, 0, 0).getMaterial());
+}
+
+TEST_F(PagedVolumeTest, testConcurrentAccess) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const int chunksPerAxis = 4;
+	const int threads = 4;
+	std::vector<std::future<int>> futures;
+	for (int t = 0; t < threads; ++t) {
+		futures.emplace_back(std::async(std::launch::async, [&] () {
+			int grass = 0;
+			for (int n = 0; n < 10; ++n) {
+				for (int x = 0; x < chunksPerAxis; ++x) {
+					for (int z = 0; z < chunksPerAxis; ++z) {
+						const Voxel& voxel = volume.voxel(x * ChunkSideLength + 1, 0, z * ChunkSideLength);
+						if (voxel.getMaterial() == VoxelType::Grass) {
+							++grass;
+						}
+					}
+				}
+			}
+			return grass;
+		}));
+	}
+	for (std::future<int>& f : futures) {
+		EXPECT_EQ(10 * chunksPerAxis * chunksPerAxis, f.get());
+	}
+	EXPECT_EQ(chunksPerAxis * chunksPerAxis, (int)pager.pageIns) << "Every chunk should only be paged in once";
+}
+
+TEST_F(PagedVolumeTest, testChunkAsync) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const glm::ivec3 pos(1, 0, 0);
+	EXPECT_FALSE(volume.isResident(pos));
+	PagedVolume::ChunkFuture future = volume.chunkAsync(pos);
+	ASSERT_TRUE(future.valid());
+	const PagedVolume::ChunkPtr& chunk = future.get();
+	ASSERT_TRUE(chunk);
+	EXPECT_TRUE(volume.isResident(pos));
+	EXPECT_EQ(chunk, volume.chunk(pos));
+	EXPECT_EQ(VoxelType::Grass, volume.voxel(pos).getMaterial());
+	EXPECT_EQ(1, (int)pager.pageIns);
+}
+
+TEST_F(PagedVolumeTest, testFlushAllStopsPaging) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const Region region(0, 0, 0, ChunkSideLength * 4 - 1, ChunkSideLength - 1, ChunkSideLength * 4 - 1);
+	EXPECT_GT(volume.prefetch(region), 0);
+	volume.flushAll();
+	const int pageIns = pager.pageIns;
+	EXPECT_FALSE(volume.isResident(glm::ivec3(0))) << "No chunk must be paged in after the flush";
+	EXPECT_EQ(pageIns, (int)pager.pageIns);
+	// the asynchronous paging works again after the flush
+	PagedVolume::ChunkFuture future = volume.chunkAsync(glm::ivec3(0));
+	ASSERT_TRUE(future.valid());
+	EXPECT_TRUE(future.get());
+	EXPECT_EQ(pageIns + 1, (int)pager.pageIns);
+}
+
+TEST_F(PagedVolumeTest, testFlushAllResolvesDiscardedRequests) {
+	BlockingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	PagedVolume::ChunkFuture running = volume.chunkAsync(glm::ivec3(0));
+	PagedVolume::ChunkFuture queued = volume.chunkAsync(glm::ivec3(ChunkSideLength, 0, 0));
+	ASSERT_TRUE(running.valid());
+	ASSERT_TRUE(queued.valid());
+	while (!pager.started) {
+		SDL_Delay(1);
+	}
+	// release the running page-in while the paging is already stopped
+	std::thread releaser([&pager] () {
+		SDL_Delay(50);
+		pager.release = true;
+	});
+	volume.flushAll();
+	releaser.join();
+	EXPECT_TRUE(running.get()) << "The running page-in should have been finished";
+	PagedVolume::ChunkPtr chunk;
+	ASSERT_NO_THROW(chunk = queued.get());
+	EXPECT_FALSE(chunk) << "The discarded request should resolve to an empty chunk";
+	EXPECT_EQ(1, (int)pager.pageIns);
+}
+
+TEST_F(PagedVolumeTest, testPrefetch) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const Region region(0, 0, 0, ChunkSideLength * 2 - 1, ChunkSideLength - 1, ChunkSideLength * 2 - 1);
+	EXPECT_EQ(4, volume.prefetch(region));
+	for (int x = 0; x < 2; ++x) {
+		for (int z = 0; z < 2; ++z) {
+			const glm::ivec3 pos(x * ChunkSideLength, 0, z * ChunkSideLength);
+			PagedVolume::ChunkFuture future = volume.chunkAsync(pos);
+			ASSERT_TRUE(future.valid());
+			EXPECT_TRUE(future.get());
+			EXPECT_TRUE(volume.isResident(pos));
+		}
+	}
+	EXPECT_EQ(0, volume.prefetch(region)) << "All chunks should already be resident";
+	EXPECT_EQ(4, (int)pager.pageIns);
+}
+
+TEST_F(PagedVolumeTest, testPrefetchDoesNotReferenceChunks) {
+	RawPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, 0.0f);
+	for (int i = 0; i <= ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	// the eviction of the first chunk cleared the referenced flags of all other chunks
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns);
+	const Region region(ChunkSideLength, 0, 0, ChunkSideLength * 2 - 1, ChunkSideLength - 1, ChunkSideLength - 1);
+	EXPECT_EQ(0, volume.prefetch(region));
+	volume.chunk(glm::ivec3((ChunkLimit + 1) * ChunkSideLength, 0, 0));
+	EXPECT_EQ(ChunkLimit + 2, (int)pager.pageIns);
+	EXPECT_FALSE(volume.isResident(glm::ivec3(ChunkSideLength, 0, 0))) << "The probe of the prefetch must not give the chunk a second chance";
+}
+
+TEST_F(PagedVolumeTest, testPrefetchRespectsChunkLimit) {
+	CountingPager pager;
+	PagedVolume volume(&pager, MemoryLimit, ChunkSideLength);
+	const Region region(0, 0, 0, ChunkSideLength * 8 - 1, ChunkSideLength - 1, ChunkSideLength * 8 - 1);
+	EXPECT_EQ(ChunkLimit, volume.prefetch(region));
+}
+
+}
@@ -7,6 +7,8 @@
 #include "core/StringUtil.h"
 #include "core/Log.h"
 #include "core/Color.h"
+#include "core/Common.h"
+#include <vector>
 
 namespace voxel {
 
@@ -28,26 +30,38 @@ bool CubFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 	wrap(stream.readInt(depth))
 	wrap(stream.readInt(height))
 
+	if (width == 0u || depth == 0u || height == 0u) {
+		Log::error("Could not load cub file: Invalid dimensions %u:%u:%u", width, depth, height);
+		return false;
+	}
+	const size_t rowSize = (size_t)width * 3;
+	// the dimensions must be covered by the stream before anything is allocated for them
+	const size_t left = (size_t)core_max(stream.remaining(), (int64_t)0);
+	if (rowSize > left || (uint64_t)depth * height > left / rowSize) {
+		Log::error("Could not load cub file: %u:%u:%u voxels exceed the stream", width, depth, height);
+		return false;
+	}
+
 	RawVolume *volume = new RawVolume(voxel::Region(0, 0, 0, width - 1, height - 1, depth - 1));
 	volumes.push_back(VoxelVolume{volume, file->fileName(), true});
 
 	// TODO: support loading own palette
 
-	const MaterialColorArray& materialColors = getMaterialColors();
-
+	_paletteLookup.clear();
+	std::vector<uint8_t> row(rowSize);
 	for (uint32_t h = 0u; h < height; ++h) {
 		for (uint32_t d = 0u; d < depth; ++d) {
+			wrap(stream.readBuf(row.data(), row.size()))
 			for (uint32_t w = 0u; w < width; ++w) {
-				uint8_t r, g, b;
-				wrap(stream.readByte(r))
-				wrap(stream.readByte(g))
-				wrap(stream.readByte(b))
+				const uint8_t r = row[w * 3 + 0];
+				const uint8_t g = row[w * 3 + 1];
+				const uint8_t b = row[w * 3 + 2];
 				if (r == 0u && g == 0u && b == 0u) {
 					// empty voxel
 					continue;
 				}
 				const glm::vec4& color = core::Color::fromRGBA(r, g, b, 255);
-				int index = core::Color::getClosestMatch(color, materialColors);
+				const uint8_t index = findClosestIndex(color);
 				voxel::VoxelType voxelType = voxel::VoxelType::Generic;
 				const voxel::Voxel& voxel = voxel::createVoxel(voxelType, index);
 				// we have to flip depth with height for our own coordinate system
@@ -0,0 +1,33 @@
+/**
+ * @file
+ */
+
+#include "PaletteLookup.h"
+#include "voxel/MaterialColor.h"
+#include "core/Color.h"
+#include <glm/common.hpp>
+
+namespace voxel {
+
+uint32_t PaletteLookup::key(const glm::vec4& color) {
+	// round instead of truncate - the imported colors are 8 bit values and must get distinct keys
+	const glm::u8vec4 c(glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f));
+	return (uint32_t)c.r | ((uint32_t)c.g << 8) | ((uint32_t)c.b << 16) | ((uint32_t)c.a << 24);
+}
+
+uint8_t PaletteLookup::findClosestIndex(const glm::vec4& color) {
+	const uint32_t k = key(color);
+	auto i = _cache.find(k);
+	if (i != _cache.end()) {
+		return i->second;
+	}
+	const uint8_t index = (uint8_t)core::Color::getClosestMatchHSB(color, getMaterialColorsHSB());
+	_cache.emplace(k, index);
+	return index;
+}
+
+uint8_t PaletteLookup::findClosestIndex(uint32_t rgba) {
+	return findClosestIndex(core::Color::fromRGBA(rgba));
+}
+
+}
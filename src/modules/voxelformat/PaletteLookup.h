@@ -0,0 +1,53 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <glm/vec4.hpp>
+#include <stdint.h>
+#include <unordered_map>
+
+namespace voxel {
+
+/**
+ * @brief Maps the colors of an imported model to the closest match of the material colors
+ *
+ * The matches are cached by the 8 bit rgba value of the color. A lookup is meant to live as long as
+ * one file with its palette is imported - call @c clear() before the next file is loaded, because
+ * the material colors might have changed in the meantime.
+ *
+ * @sa core::Color::getClosestMatchHSB()
+ */
+class PaletteLookup {
+private:
+	std::unordered_map<uint32_t, uint8_t> _cache;
+
+	static uint32_t key(const glm::vec4& color);
+public:
+	/**
+	 * @return The material color index of the closest match
+	 */
+	uint8_t findClosestIndex(const glm::vec4& color);
+	/**
+	 * @param[in] rgba The color in the format of @c core::Color::fromRGBA()
+	 */
+	uint8_t findClosestIndex(uint32_t rgba);
+
+	void clear();
+
+	/**
+	 * @return The amount of different colors that were resolved since the last @c clear()
+	 */
+	size_t size() const;
+};
+
+inline void PaletteLookup::clear() {
+	_cache.clear();
+}
+
+inline size_t PaletteLookup::size() const {
+	return _cache.size();
+}
+
+}
@@ -313,6 +313,7 @@ bool QBFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 		return false;
 	}
 	io::FileStream stream(file.get());
+	_paletteLookup.clear();
 	if (!loadFromStream(stream, volumes)) {
 		return false;
 	}
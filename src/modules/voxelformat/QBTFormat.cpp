@@ -407,7 +407,7 @@ bool QBTFormat::loadColorMap(io::FileStream& stream) {
 		return false;
 	}
 	_paletteSize = 0;
-	_palette.reserve(colorCount);
+	_palette.resize(colorCount);
 	for (uint32_t i = 0; i < colorCount; ++i) {
 		uint8_t colorByteR;
 		uint8_t colorByteG;
@@ -505,6 +505,7 @@ bool QBTFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 		return false;
 	}
 	io::FileStream stream(file.get());
+	_paletteLookup.clear();
 	if (!loadFromStream(stream, volumes)) {
 		return false;
 	}
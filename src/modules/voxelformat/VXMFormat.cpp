@@ -34,6 +34,7 @@ bool VXMFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 		return false;
 	}
 	io::FileStream stream(file.get());
+	_paletteLookup.clear();
 
 	uint32_t header;
 	wrap(stream.readInt(header))
@@ -23,16 +23,18 @@ uint8_t VoxFileFormat::convertPaletteIndex(uint32_t paletteIndex) const {
 	return _palette[paletteIndex];
 }
 
-glm::vec4 VoxFileFormat::findClosestMatch(const glm::vec4& color) const {
+glm::vec4 VoxFileFormat::findClosestMatch(const glm::vec4& color) {
 	const int index = findClosestIndex(color);
-	voxel::MaterialColorArray materialColors = voxel::getMaterialColors();
+	const voxel::MaterialColorArray& materialColors = voxel::getMaterialColors();
 	return materialColors[index];
 }
 
-uint8_t VoxFileFormat::findClosestIndex(const glm::vec4& color) const {
-	const voxel::MaterialColorArray& materialColors = voxel::getMaterialColors();
-	//materialColors.erase(materialColors.begin());
-	return core::Color::getClosestMatch(color, materialColors);
+uint8_t VoxFileFormat::findClosestIndex(const glm::vec4& color) {
+	return _paletteLookup.findClosestIndex(color);
+}
+
+uint8_t VoxFileFormat::findClosestIndex(uint32_t rgba) {
+	return _paletteLookup.findClosestIndex(rgba);
 }
 
 RawVolume* VoxFileFormat::merge(const VoxelVolumes& volumes) const {
@@ -7,6 +7,7 @@
 #include "voxel/RawVolume.h"
 #include "core/io/File.h"
 #include "VoxelVolumes.h"
+#include "PaletteLookup.h"
 #include <glm/fwd.hpp>
 #include <vector>
 
@@ -16,10 +17,15 @@ class VoxFileFormat {
 protected:
 	std::vector<uint8_t> _palette;
 	size_t _paletteSize = 0;
+	/**
+	 * @brief Caches the closest matches of the colors of the file that is loaded - cleared with every @c loadGroups()
+	 */
+	PaletteLookup _paletteLookup;
 
 	const glm::vec4& getColor(const Voxel& voxel) const;
-	glm::vec4 findClosestMatch(const glm::vec4& color) const;
-	uint8_t findClosestIndex(const glm::vec4& color) const;
+	glm::vec4 findClosestMatch(const glm::vec4& color);
+	uint8_t findClosestIndex(const glm::vec4& color);
+	uint8_t findClosestIndex(uint32_t rgba);
 	/**
 	 * @brief Maps a custum palette index to our own 256 color palette by a closest match
 	 */
@@ -11,6 +11,7 @@
 #include "core/StringUtil.h"
 #include "core/UTF8.h"
 #include "voxel/MaterialColor.h"
+#include <vector>
 
 namespace voxel {
 
@@ -390,14 +391,9 @@ bool VoxFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 	const int paletteSize = lengthof(palette);
 	_palette.resize(paletteSize);
 	_paletteSize = paletteSize;
-	// convert to our palette
+	_paletteLookup.clear();
 	const MaterialColorArray& materialColors = getMaterialColors();
-	for (int i = 0; i < paletteSize; ++i) {
-		const uint32_t p = palette[i];
-		const glm::vec4& color = core::Color::fromRGBA(p);
-		const int index = core::Color::getClosestMatch(color, materialColors);
-		_palette[i] = index;
-	}
+	bool foundPalette = false;
 
 	std::vector<Region> regions;
 
@@ -424,15 +420,17 @@ bool VoxFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 			//                       |     palette[i + 1] = ReadRGBA();
 			//                       | }
 			// -------------------------------------------------------------------------------
+			uint32_t rgbaPalette[255];
+			wrap(stream.readInts(rgbaPalette, lengthof(rgbaPalette)))
 			for (int i = 0; i <= 254; i++) {
-				uint32_t rgba;
-				wrap(stream.readInt(rgba))
+				const uint32_t rgba = rgbaPalette[i];
 				const glm::vec4& color = core::Color::fromRGBA(rgba);
-				const int index = core::Color::getClosestMatch(color, materialColors);
+				const int index = findClosestIndex(color);
 				Log::trace("rgba %x, r: %f, g: %f, b: %f, a: %f, index: %i, r2: %f, g2: %f, b2: %f, a2: %f",
 						rgba, color.r, color.g, color.b, color.a, index, materialColors[index].r, materialColors[index].g, materialColors[index].b, materialColors[index].a);
 				_palette[i + 1] = (uint8_t)index;
 			}
+			foundPalette = true;
 			break;
 		} else if (chunkId == FourCC('S','I','Z','E')) {
 			Log::debug("Found size chunk with %u bytes and %u child bytes (currentPos: %i, nextPos: %i)", numBytesChunk, numBytesChildrenChunks, (int)currentChunkPos, (int)nextChunkPos);
@@ -458,6 +456,12 @@ bool VoxFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 		wrap(stream.seek(nextChunkPos));
 	} while (stream.remaining() > 0);
 
+	// convert the default palette to our palette - the first entry is also used if the file has its own palette
+	const int defaultPaletteSize = foundPalette ? 1 : paletteSize;
+	for (int i = 0; i < defaultPaletteSize; ++i) {
+		_palette[i] = findClosestIndex(palette[i]);
+	}
+
 	stream.seek(resetPos);
 
 	std::vector<VoxModel> models;
@@ -490,15 +494,21 @@ bool VoxFormat::loadGroups(const io::FilePtr& file, VoxelVolumes& volumes) {
 				Log::error("Invalid XYZI chunk without previous SIZE chunk");
 				return false;
 			}
+			if ((int64_t)numVoxels * 4 > stream.remaining()) {
+				Log::error("Could not load vox file: XYZI chunk with %u voxels exceeds the stream", numVoxels);
+				return false;
+			}
+			std::vector<uint8_t> voxelData(numVoxels * 4);
+			wrap(stream.readBuf(voxelData.data(), voxelData.size()))
 			RawVolume *volume = new RawVolume(regions[volumeIdx]);
 			int volumeVoxelSet = 0;
 			for (uint32_t i = 0; i < numVoxels; ++i) {
 				// we have to flip the axis here
-				uint8_t x, y, z, colorIndex;
-				wrap(stream.readByte(x))
-				wrap(stream.readByte(z))
-				wrap(stream.readByte(y))
-				wrap(stream.readByte(colorIndex))
+				const uint8_t *v = &voxelData[i * 4];
+				const uint8_t x = v[0];
+				const uint8_t z = v[1];
+				const uint8_t y = v[2];
+				const uint8_t colorIndex = v[3];
 				const uint8_t index = convertPaletteIndex(colorIndex);
 				voxel::VoxelType voxelType = voxel::VoxelType::Generic;
 				const voxel::Voxel& voxel = voxel::createVoxel(voxelType, index);
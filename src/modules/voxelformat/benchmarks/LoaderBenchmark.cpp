@@ -0,0 +1,99 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/ArrayLength.h"
+#include "core/io/FileStream.h"
+#include "voxelformat/Loader.h"
+#include "voxelformat/VoxelVolumes.h"
+#include "voxelformat/PaletteLookup.h"
+#include "core/Color.h"
+#include "voxel/MaterialColor.h"
+#include <vector>
+
+namespace {
+
+const char *Models[] = {
+	"models/glider.vox",
+	"models/trees/deciduous/3.vox",
+	"models/chr_knight.qb",
+	"models/chr_knight.qbt",
+	"cw.cub",
+	"test.vxm"
+};
+
+}
+
+class LoaderBenchmark: public core::AbstractBenchmark {
+public:
+	bool onInitApp() override {
+		return voxel::initDefaultMaterialColors();
+	}
+};
+
+BENCHMARK_DEFINE_F(LoaderBenchmark, loadVolumeFormat) (benchmark::State& state) {
+	const char *model = Models[state.range(0)];
+	const io::FilePtr& file = io::filesystem()->open(model);
+	state.SetLabel(model);
+	for (auto _ : state) {
+		voxel::VoxelVolumes volumes;
+		if (!voxelformat::loadVolumeFormat(file, volumes)) {
+			state.SkipWithError("Failed to load the model");
+			break;
+		}
+		benchmark::DoNotOptimize(volumes.size());
+	}
+	state.SetBytesProcessed(state.iterations() * file->length());
+}
+
+BENCHMARK_DEFINE_F(LoaderBenchmark, readInt) (benchmark::State& state) {
+	const io::FilePtr& file = io::filesystem()->open(Models[1]);
+	const bool bulk = state.range(0) != 0;
+	std::vector<uint32_t> values;
+	for (auto _ : state) {
+		io::FileStream stream(file);
+		const size_t amount = (size_t)stream.size() / sizeof(uint32_t);
+		values.resize(amount);
+		if (bulk) {
+			stream.readInts(values.data(), amount);
+		} else {
+			for (size_t i = 0; i < amount; ++i) {
+				stream.readInt(values[i]);
+			}
+		}
+		benchmark::DoNotOptimize(values.data());
+	}
+	state.SetLabel(bulk ? "readInts" : "readInt");
+	state.SetBytesProcessed(state.iterations() * values.size() * sizeof(uint32_t));
+}
+
+BENCHMARK_DEFINE_F(LoaderBenchmark, findClosestIndex) (benchmark::State& state) {
+	const voxel::MaterialColorArray& materialColors = voxel::getMaterialColors();
+	const bool lookup = state.range(0) != 0;
+	// a model with 64 different colors - resolved once per voxel like the cub and qb importers do
+	std::vector<glm::vec4> colors;
+	for (uint32_t i = 0u; i < 4096u; ++i) {
+		colors.push_back(core::Color::fromRGBA(0xff000000u | ((i % 64u) * 0x030507u)));
+	}
+	for (auto _ : state) {
+		voxel::PaletteLookup paletteLookup;
+		int sum = 0;
+		for (const glm::vec4& color : colors) {
+			if (lookup) {
+				sum += paletteLookup.findClosestIndex(color);
+			} else {
+				sum += core::Color::getClosestMatch(color, materialColors);
+			}
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetLabel(lookup ? "PaletteLookup" : "getClosestMatch");
+	state.SetItemsProcessed(state.iterations() * colors.size());
+}
+
+BENCHMARK_REGISTER_F(LoaderBenchmark, loadVolumeFormat)->DenseRange(0, lengthof(Models) - 1);
+BENCHMARK_REGISTER_F(LoaderBenchmark, readInt)->Arg(0)->Arg(1);
+BENCHMARK_REGISTER_F(LoaderBenchmark, findClosestIndex)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -15,4 +15,14 @@ TEST_F(CubFormatTest, testLoad) {
 	std::unique_ptr<RawVolume> volume(load("cw.cub", f));
 }
 
+TEST_F(CubFormatTest, testLoadDimensionsExceedStream) {
+	// width, depth and height - followed by a single row of voxels
+	const uint8_t data[] = { 0x56, 0x55, 0x55, 0x55, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 255, 0, 0 };
+	ASSERT_TRUE(io::filesystem()->write("cub-exceedstreamtest.cub", data, sizeof(data)));
+	CubFormat f;
+	VoxelVolumes volumes;
+	EXPECT_FALSE(f.loadGroups(open("cub-exceedstreamtest.cub"), volumes));
+	EXPECT_TRUE(volumes.empty());
+}
+
 }
@@ -0,0 +1,39 @@
+/**
+ * @file
+ */
+
+#include "voxel/tests/AbstractVoxelTest.h"
+#include "voxelformat/PaletteLookup.h"
+#include "voxel/MaterialColor.h"
+#include "core/Color.h"
+
+namespace voxel {
+
+class PaletteLookupTest: public AbstractVoxelTest {
+};
+
+TEST_F(PaletteLookupTest, testClosestMatch) {
+	const MaterialColorArray& materialColors = getMaterialColors();
+	ASSERT_EQ(materialColors.size(), getMaterialColorsHSB().size());
+	PaletteLookup lookup;
+	for (uint32_t rgba = 0u; rgba <= 0xffffffu; rgba += 0x070503u) {
+		const glm::vec4& color = core::Color::fromRGBA(rgba | 0xff000000u);
+		const int expected = core::Color::getClosestMatch(color, materialColors);
+		EXPECT_EQ(expected, lookup.findClosestIndex(color));
+		EXPECT_EQ(expected, lookup.findClosestIndex(rgba | 0xff000000u)) << "The cached match differs";
+	}
+}
+
+TEST_F(PaletteLookupTest, testMaterialColors) {
+	const MaterialColorArray& materialColors = getMaterialColors();
+	PaletteLookup lookup;
+	for (size_t i = 0; i < materialColors.size(); ++i) {
+		const uint8_t index = lookup.findClosestIndex(materialColors[i]);
+		EXPECT_EQ(core::Color::getRGBA(materialColors[i]), core::Color::getRGBA(materialColors[index]));
+	}
+	EXPECT_LE(lookup.size(), materialColors.size());
+	lookup.clear();
+	EXPECT_EQ(0u, lookup.size());
+}
+
+}
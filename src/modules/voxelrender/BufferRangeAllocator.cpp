@@ -0,0 +1,75 @@
+/**
+ * @file
+ */
+
+#include "BufferRangeAllocator.h"
+#include "core/Assert.h"
+#include <algorithm>
+
+namespace voxelrender {
+
+void BufferRangeAllocator::init(uint32_t capacity) {
+	_free.clear();
+	_capacity = capacity;
+	_used = 0u;
+	if (capacity > 0u) {
+		_free.push_back({0u, capacity});
+	}
+}
+
+void BufferRangeAllocator::grow(uint32_t capacity) {
+	if (capacity <= _capacity) {
+		return;
+	}
+	if (!_free.empty() && _free.back().offset + _free.back().size == _capacity) {
+		_free.back().size += capacity - _capacity;
+	} else {
+		_free.push_back({_capacity, capacity - _capacity});
+	}
+	_capacity = capacity;
+}
+
+bool BufferRangeAllocator::alloc(uint32_t size, uint32_t& offset) {
+	core_assert(size > 0u);
+	for (auto i = _free.begin(); i != _free.end(); ++i) {
+		if (i->size < size) {
+			continue;
+		}
+		offset = i->offset;
+		if (i->size == size) {
+			_free.erase(i);
+		} else {
+			i->offset += size;
+			i->size -= size;
+		}
+		_used += size;
+		return true;
+	}
+	return false;
+}
+
+void BufferRangeAllocator::free(uint32_t offset, uint32_t size) {
+	core_assert(size > 0u);
+	core_assert(offset + size <= _capacity);
+	core_assert(_used >= size);
+	_used -= size;
+	auto next = std::lower_bound(_free.begin(), _free.end(), offset, [] (const Range& range, uint32_t offset) {
+		return range.offset < offset;
+	});
+	core_assert_msg(next == _free.end() || offset + size <= next->offset, "The range overlaps a free range");
+	const bool mergePrev = next != _free.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+	const bool mergeNext = next != _free.end() && offset + size == next->offset;
+	if (mergePrev && mergeNext) {
+		std::prev(next)->size += size + next->size;
+		_free.erase(next);
+	} else if (mergePrev) {
+		std::prev(next)->size += size;
+	} else if (mergeNext) {
+		next->offset = offset;
+		next->size += size;
+	} else {
+		_free.insert(next, {offset, size});
+	}
+}
+
+}
@@ -0,0 +1,65 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace voxelrender {
+
+/**
+ * @brief First fit allocator for ranges of a buffer with a fixed capacity - used to give each chunk
+ * mesh its own slot in the world vertex and index buffers.
+ * @note This is only the bookkeeping - there is no memory behind the ranges. Offsets and sizes are
+ * given in elements, not in bytes.
+ */
+class BufferRangeAllocator {
+private:
+	struct Range {
+		uint32_t offset;
+		uint32_t size;
+	};
+	/**
+	 * The free ranges sorted by their offset. Adjacent ranges are always merged.
+	 */
+	std::vector<Range> _free;
+	uint32_t _capacity = 0u;
+	uint32_t _used = 0u;
+public:
+	void init(uint32_t capacity);
+
+	/**
+	 * @brief Extends the capacity of the buffer - already allocated ranges stay valid.
+	 */
+	void grow(uint32_t capacity);
+
+	/**
+	 * @param[out] offset The start of the allocated range
+	 * @return @c false if there is no free range that is big enough
+	 */
+	bool alloc(uint32_t size, uint32_t& offset);
+	void free(uint32_t offset, uint32_t size);
+
+	uint32_t capacity() const;
+	uint32_t used() const;
+	/**
+	 * @return The amount of free ranges
+	 */
+	uint32_t fragments() const;
+};
+
+inline uint32_t BufferRangeAllocator::capacity() const {
+	return _capacity;
+}
+
+inline uint32_t BufferRangeAllocator::used() const {
+	return _used;
+}
+
+inline uint32_t BufferRangeAllocator::fragments() const {
+	return (uint32_t)_free.size();
+}
+
+}
@@ -45,6 +45,39 @@ inline video::Attribute getInfoVertexAttribute(uint32_t bufferIndex, uint32_t at
 	return attrib;
 }
 
+/**
+ * @brief The packed vertex positions are relative to the mesh offset and converted to float
+ * @sa voxel::VoxelVertexPacked
+ */
+inline video::Attribute getPackedPositionVertexAttribute(uint32_t bufferIndex, uint32_t attributeLocation, int components) {
+	static_assert(voxel::MAX_MESH_CHUNK_HEIGHT <= 256, "Max mesh chunk height exceeds the packed voxel positions");
+	video::Attribute attrib;
+	attrib.bufferIndex = bufferIndex;
+	attrib.location = attributeLocation;
+	attrib.stride = sizeof(voxel::VoxelVertexPacked);
+	attrib.size = components;
+	attrib.type = video::mapType<decltype(voxel::VoxelVertexPacked::position)::value_type>();
+	attrib.offset = offsetof(voxel::VoxelVertexPacked, position);
+	return attrib;
+}
+
+/**
+ * @note we are uploading multiple bytes at once here
+ */
+inline video::Attribute getPackedInfoVertexAttribute(uint32_t bufferIndex, uint32_t attributeLocation, int components) {
+	static_assert(offsetof(voxel::VoxelVertexPacked, ambientOcclusion) < offsetof(voxel::VoxelVertexPacked, colorIndex), "Layout change of VoxelVertexPacked without change in upload");
+	static_assert(offsetof(voxel::VoxelVertexPacked, colorIndex) < offsetof(voxel::VoxelVertexPacked, material), "Layout change of VoxelVertexPacked without change in upload");
+	video::Attribute attrib;
+	attrib.bufferIndex = bufferIndex;
+	attrib.location = attributeLocation;
+	attrib.stride = sizeof(voxel::VoxelVertexPacked);
+	attrib.size = components;
+	attrib.type = video::mapType<decltype(voxel::VoxelVertexPacked::ambientOcclusion)>();
+	attrib.typeIsInt = true;
+	attrib.offset = offsetof(voxel::VoxelVertexPacked, ambientOcclusion);
+	return attrib;
+}
+
 inline video::Attribute getOffsetVertexAttribute(uint32_t bufferIndex, uint32_t attributeLocation, int components) {
 	video::Attribute voxelAttributeOffsets;
 	voxelAttributeOffsets.bufferIndex = bufferIndex;
@@ -7,6 +7,7 @@
 #include "video/Buffer.h"
 #include "video/Types.h"
 #include "voxel/VoxelVertex.h"
+#include "core/Common.h"
 #include "core/Log.h"
 #include "core/Trace.h"
 #include "video/Renderer.h"
@@ -14,15 +15,17 @@
 
 namespace voxelrender {
 
-bool WorldBuffers::renderTerrain() {
+int WorldBuffers::renderTerrain(const ChunkDrawRanges& ranges, const std::function<void(const glm::ivec3&)>& setOffset) {
 	core_trace_gl_scoped(WorldBuffersRenderTerrain);
-	const uint32_t numIndices = _buffer.elements(_ibo, 1, sizeof(voxel::IndexType));
-	if (numIndices == 0u) {
-		return false;
+	if (ranges.empty()) {
+		return 0;
 	}
 	video::ScopedBuffer scopedBuf(_buffer);
-	video::drawElements<voxel::IndexType>(video::Primitive::Triangles, numIndices);
-	return true;
+	for (const ChunkDrawRange& range : ranges) {
+		setOffset(range.offset);
+		video::drawElementsBaseVertex<voxel::PackedIndexType>(video::Primitive::Triangles, range.numIndices, (int)range.baseIndex, (int)range.baseVertex);
+	}
+	return (int)ranges.size();
 }
 
 bool WorldBuffers::renderWater() {
@@ -39,22 +42,22 @@ bool WorldBuffers::initTerrainBuffer(shader::WorldShader& worldShader) {
 		Log::error("Failed to create vertex buffer");
 		return false;
 	}
-	_buffer.setMode(_vbo, video::BufferMode::Stream);
+	_buffer.setMode(_vbo, video::BufferMode::Dynamic);
 	_ibo = _buffer.create(nullptr, 0, video::BufferType::IndexBuffer);
 	if (_ibo == -1) {
 		Log::error("Failed to create index buffer");
 		return false;
 	}
-	_buffer.setMode(_ibo, video::BufferMode::Stream);
+	_buffer.setMode(_ibo, video::BufferMode::Dynamic);
 
 	const int locationPos = worldShader.getLocationPos();
-	const video::Attribute& posAttrib = getPositionVertexAttribute(_vbo, locationPos, worldShader.getAttributeComponents(locationPos));
+	const video::Attribute& posAttrib = getPackedPositionVertexAttribute(_vbo, locationPos, worldShader.getAttributeComponents(locationPos));
 	if (!_buffer.addAttribute(posAttrib)) {
 		Log::warn("Failed to add position attribute");
 	}
 
 	const int locationInfo = worldShader.getLocationInfo();
-	const video::Attribute& infoAttrib = getInfoVertexAttribute(_vbo, locationInfo, worldShader.getAttributeComponents(locationInfo));
+	const video::Attribute& infoAttrib = getPackedInfoVertexAttribute(_vbo, locationInfo, worldShader.getAttributeComponents(locationInfo));
 	if (!_buffer.addAttribute(infoAttrib)) {
 		Log::warn("Failed to add info attribute");
 	}
@@ -99,14 +102,34 @@ bool WorldBuffers::init(shader::WorldShader& worldShader, shader::WaterShader& w
 	return initWaterBuffer(waterShader) && initTerrainBuffer(worldShader);
 }
 
-void WorldBuffers::update(const voxel::VertexArray& vertices, const voxel::IndexArray& indices) {
-	core_trace_gl_scoped(WorldBuffersUpdate);
-	_buffer.update(_vbo, vertices);
-	_buffer.update(_ibo, indices);
+bool WorldBuffers::reserve(uint32_t vertices, uint32_t indices) {
+	if (vertices <= _vertexCapacity && indices <= _indexCapacity) {
+		return false;
+	}
+	core_trace_gl_scoped(WorldBuffersReserve);
+	_vertexCapacity = core_max(vertices, _vertexCapacity);
+	_indexCapacity = core_max(indices, _indexCapacity);
+	Log::debug("Reallocate the terrain buffers for %u vertices and %u indices", _vertexCapacity, _indexCapacity);
+	_buffer.update(_vbo, nullptr, _vertexCapacity * sizeof(voxel::VoxelVertexPacked));
+	_buffer.update(_ibo, nullptr, _indexCapacity * sizeof(voxel::PackedIndexType));
+	return true;
+}
+
+bool WorldBuffers::upload(const voxel::PackedMesh& mesh, uint32_t baseVertex, uint32_t baseIndex) {
+	core_trace_gl_scoped(WorldBuffersUpload);
+	if (mesh.isEmpty()) {
+		return true;
+	}
+	if (!_buffer.updateSubData(_vbo, baseVertex * sizeof(voxel::VoxelVertexPacked), mesh.vertices.data(), mesh.vertices.size() * sizeof(voxel::VoxelVertexPacked))) {
+		return false;
+	}
+	return _buffer.updateSubData(_ibo, baseIndex * sizeof(voxel::PackedIndexType), mesh.indices.data(), mesh.indices.size() * sizeof(voxel::PackedIndexType));
 }
 
 void WorldBuffers::shutdown() {
 	_buffer.shutdown();
+	_vertexCapacity = 0u;
+	_indexCapacity = 0u;
 	_waterBuffer.shutdown();
 }
 
@@ -8,9 +8,22 @@
 #include "WorldShader.h"
 #include "WaterShader.h"
 #include "voxel/Mesh.h"
+#include <functional>
+#include <vector>
 
 namespace voxelrender {
 
+/**
+ * @brief The packed indices of a chunk that are drawn with the given base vertex and mesh offset
+ */
+struct ChunkDrawRange {
+	glm::ivec3 offset;
+	uint32_t baseIndex;
+	uint32_t numIndices;
+	uint32_t baseVertex;
+};
+typedef std::vector<ChunkDrawRange> ChunkDrawRanges;
+
 class WorldBuffers {
 private:
 	bool initTerrainBuffer(shader::WorldShader& worldShader);
@@ -21,11 +34,30 @@ private:
 	int32_t _vbo = -1;
 	video::Buffer _waterBuffer;
 	int32_t _waterVbo = -1;
+	uint32_t _vertexCapacity = 0u;
+	uint32_t _indexCapacity = 0u;
 public:
-	bool renderTerrain();
+	/**
+	 * @brief Renders the given ranges of the terrain buffer
+	 * @param setOffset Called before each range to put the mesh offset into the model matrix of the active shader
+	 * @return The amount of draw calls
+	 */
+	int renderTerrain(const ChunkDrawRanges& ranges, const std::function<void(const glm::ivec3&)>& setOffset);
 	bool renderWater();
 
-	void update(const voxel::VertexArray& vertices, const voxel::IndexArray& indices);
+	/**
+	 * @brief Ensures that the terrain buffers can hold the given amount of vertices and indices
+	 * @return @c true if the buffers were reallocated - their content is lost in this case and all chunks
+	 * have to get uploaded again
+	 */
+	bool reserve(uint32_t vertices, uint32_t indices);
+	/**
+	 * @brief Uploads the mesh into its slot of the terrain buffers
+	 * @param baseVertex The first vertex of the slot
+	 * @param baseIndex The first index of the slot
+	 * @sa reserve()
+	 */
+	bool upload(const voxel::PackedMesh& mesh, uint32_t baseVertex, uint32_t baseIndex);
 
 	bool init(shader::WorldShader& worldShader, shader::WaterShader& waterShader);
 	void shutdown();
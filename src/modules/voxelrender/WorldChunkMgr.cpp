@@ -9,6 +9,8 @@
 namespace voxelrender {
 
 WorldChunkMgr::WorldChunkMgr() : _octree({}, 30) {
+	_vertexSlots.init(INITIAL_VERTEX_SLOTS);
+	_indexSlots.init(INITIAL_INDEX_SLOTS);
 }
 
 void WorldChunkMgr::updateViewDistance(float viewDistance) {
@@ -18,24 +20,76 @@ void WorldChunkMgr::updateViewDistance(float viewDistance) {
 }
 
 bool WorldChunkMgr::init(voxel::PagedVolume* volume) {
+	_volume = volume;
 	return _meshExtractor.init(volume);
 }
 
 void WorldChunkMgr::shutdown() {
 	_meshExtractor.shutdown();
+	_volume = nullptr;
 }
 
 void WorldChunkMgr::reset() {
 	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
 		chunkBuffer.inuse = false;
+		chunkBuffer.dirty = false;
+		chunkBuffer.vertexSlotSize = 0u;
+		chunkBuffer.indexSlotSize = 0u;
 	}
 	_meshExtractor.reset();
+	_cancelDistance = -1;
 	_octree.clear();
 	_activeChunkBuffers = 0;
+	_pendingUploads.clear();
+	_drawRanges.clear();
+	// keep the capacity - the world buffers are not shrinking
+	_vertexSlots.init(_vertexSlots.capacity());
+	_indexSlots.init(_indexSlots.capacity());
+}
+
+/**
+ * @brief Allocates a slot of the size of the chunk mesh. The world buffers are growing if there is
+ * no free slot left.
+ */
+void WorldChunkMgr::allocateSlot(ChunkBuffer& chunkBuffer) {
+	core_assert(chunkBuffer.vertexSlotSize == 0u && chunkBuffer.indexSlotSize == 0u);
+	const voxel::PackedMesh& mesh = chunkBuffer.mesh;
+	if (mesh.isEmpty()) {
+		return;
+	}
+	const uint32_t vertices = (uint32_t)mesh.vertices.size();
+	const uint32_t indices = (uint32_t)mesh.indices.size();
+	while (!_vertexSlots.alloc(vertices, chunkBuffer.baseVertex)) {
+		_vertexSlots.grow(core_max(_vertexSlots.capacity() * 2u, vertices));
+	}
+	chunkBuffer.vertexSlotSize = vertices;
+	while (!_indexSlots.alloc(indices, chunkBuffer.baseIndex)) {
+		_indexSlots.grow(core_max(_indexSlots.capacity() * 2u, indices));
+	}
+	chunkBuffer.indexSlotSize = indices;
+}
+
+void WorldChunkMgr::freeSlot(ChunkBuffer& chunkBuffer) {
+	if (chunkBuffer.vertexSlotSize > 0u) {
+		_vertexSlots.free(chunkBuffer.baseVertex, chunkBuffer.vertexSlotSize);
+		chunkBuffer.vertexSlotSize = 0u;
+	}
+	if (chunkBuffer.indexSlotSize > 0u) {
+		_indexSlots.free(chunkBuffer.baseIndex, chunkBuffer.indexSlotSize);
+		chunkBuffer.indexSlotSize = 0u;
+	}
+}
+
+void WorldChunkMgr::removeChunkBuffer(ChunkBuffer& chunkBuffer) {
+	freeSlot(chunkBuffer);
+	chunkBuffer.inuse = false;
+	chunkBuffer.dirty = false;
+	--_activeChunkBuffers;
+	_octree.remove(&chunkBuffer);
 }
 
 void WorldChunkMgr::handleMeshQueue() {
-	voxel::Mesh mesh;
+	voxel::PackedMesh mesh;
 	if (!_meshExtractor.pop(mesh)) {
 		return;
 	}
@@ -48,7 +102,7 @@ void WorldChunkMgr::handleMeshQueue() {
 			freeChunkBuffer = &chunkBuffer;
 		}
 		// check whether we update an existing one
-		if (chunkBuffer.translation() == mesh.getOffset()) {
+		if (chunkBuffer.translation() == mesh.offset) {
 			freeChunkBuffer = &chunkBuffer;
 			break;
 		}
@@ -59,8 +113,14 @@ void WorldChunkMgr::handleMeshQueue() {
 		return;
 	}
 
+	freeSlot(*freeChunkBuffer);
 	freeChunkBuffer->mesh = std::move(mesh);
-	freeChunkBuffer->_aabb = {freeChunkBuffer->mesh.mins(), freeChunkBuffer->mesh.maxs()};
+	freeChunkBuffer->_aabb = {freeChunkBuffer->mesh.mins, freeChunkBuffer->mesh.maxs};
+	allocateSlot(*freeChunkBuffer);
+	if (!freeChunkBuffer->dirty) {
+		freeChunkBuffer->dirty = true;
+		_pendingUploads.push_back(freeChunkBuffer);
+	}
 	if (!_octree.insert(freeChunkBuffer)) {
 		Log::warn("Failed to insert into octree");
 	}
@@ -70,33 +130,48 @@ void WorldChunkMgr::handleMeshQueue() {
 	}
 }
 
-static inline size_t transform(size_t indexOffset, const voxel::Mesh& mesh, voxel::VertexArray& verts, voxel::IndexArray& idxs) {
-	const voxel::IndexArray& indices = mesh.getIndexVector();
-	const size_t start = idxs.size();
-	idxs.insert(idxs.end(), indices.begin(), indices.end());
-	const size_t end = idxs.size();
-	for (size_t i = start; i < end; ++i) {
-		idxs[i] += indexOffset;
-	}
-	const voxel::VertexArray& vertices = mesh.getVertexVector();
-	verts.insert(verts.end(), vertices.begin(), vertices.end());
-	return vertices.size();
+void WorldChunkMgr::uploadChunks(WorldBuffers& buffers) {
+	core_trace_scoped(WorldChunkMgrUploadChunks);
+	if (buffers.reserve(_vertexSlots.capacity(), _indexSlots.capacity())) {
+		// the buffers were reallocated - all the meshes must get uploaded again
+		_pendingUploads.clear();
+		for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
+			if (!chunkBuffer.inuse) {
+				continue;
+			}
+			chunkBuffer.dirty = true;
+			_pendingUploads.push_back(&chunkBuffer);
+		}
+	}
+	for (ChunkBuffer* chunkBuffer : _pendingUploads) {
+		if (!chunkBuffer->dirty) {
+			// removed in the meantime
+			continue;
+		}
+		chunkBuffer->dirty = false;
+		if (!buffers.upload(chunkBuffer->mesh, chunkBuffer->baseVertex, chunkBuffer->baseIndex)) {
+			Log::warn("Failed to upload the mesh at %i:%i", chunkBuffer->translation().x, chunkBuffer->translation().z);
+		}
+	}
+	_pendingUploads.clear();
 }
 
 void WorldChunkMgr::cull(const video::Camera& camera) {
 	core_trace_scoped(WorldRendererCull);
-	_indices.clear();
-	_vertices.clear();
-	size_t indexOffset = 0;
+	_drawRanges.clear();
 
 	Tree::Contents contents;
 	math::AABB<float> aabb = camera.frustum().aabb();
 	aabb.shift(camera.forward() * -10.0f);
 	_octree.query(math::AABB<int>(aabb.mins(), aabb.maxs()), contents);
 
-	for (ChunkBuffer* chunkBuffer : contents) {
-		core_trace_scoped(WorldRendererCullChunk);
-		indexOffset += transform(indexOffset, chunkBuffer->mesh, _vertices, _indices);
+	// the meshes are already living in the world buffers - only the draw ranges are collected here
+	for (const ChunkBuffer* chunkBuffer : contents) {
+		const voxel::PackedMesh& mesh = chunkBuffer->mesh;
+		for (const voxel::PackedRange& range : mesh.ranges) {
+			_drawRanges.push_back({mesh.offset, chunkBuffer->baseIndex + range.baseIndex, range.numIndices,
+					chunkBuffer->baseVertex + range.baseVertex});
+		}
 	}
 }
 
@@ -108,6 +183,18 @@ int WorldChunkMgr::getDistanceSquare(const glm::ivec3& pos, const glm::ivec3& po
 
 void WorldChunkMgr::update(const glm::vec3& focusPos) {
 	_meshExtractor.updateExtractionOrder(focusPos);
+	if (_maxAllowedDistance > 0) {
+		// the meshes would get removed right after their extraction anyway - but the pending positions are only
+		// checked again if the camera moved by a mesh tile, as this needs the lock that the workers need, too
+		const glm::ivec3 pos(focusPos);
+		const glm::ivec3& d = glm::abs(_cancelPosition - pos);
+		const glm::ivec3& meshSize = _meshExtractor.meshSize();
+		if (_cancelDistance != _maxAllowedDistance || d.x >= meshSize.x || d.z >= meshSize.z) {
+			_cancelPosition = pos;
+			_cancelDistance = _maxAllowedDistance;
+			_meshExtractor.cancelExtractions(pos, _maxAllowedDistance);
+		}
+	}
 
 	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
 		if (!chunkBuffer.inuse) {
@@ -118,9 +205,7 @@ void WorldChunkMgr::update(const glm::vec3& focusPos) {
 			continue;
 		}
 		core_assert_always(_meshExtractor.allowReExtraction(chunkBuffer.translation()));
-		chunkBuffer.inuse = false;
-		--_activeChunkBuffers;
-		_octree.remove(&chunkBuffer);
+		removeChunkBuffer(chunkBuffer);
 		Log::trace("Remove mesh from %i:%i", chunkBuffer.translation().x, chunkBuffer.translation().z);
 	}
 }
@@ -140,6 +225,9 @@ void WorldChunkMgr::extractMeshes(const video::Camera& camera) {
 	maxs.y = voxel::MAX_HEIGHT;
 	maxs.z += farplane;
 
+	// warm the chunks in the view range - the mesh extraction would otherwise have to wait for the pager
+	_volume->prefetch(voxel::Region(glm::ivec3(mins), glm::ivec3(maxs.x, voxel::MAX_HEIGHT - 1, maxs.z)));
+
 	_octree.visit(mins, maxs, [&] (const glm::ivec3& mins, const glm::ivec3& maxs) {
 		return !_meshExtractor.scheduleMeshExtraction(mins);
 	}, glm::vec3(_meshExtractor.meshSize()));
@@ -6,6 +6,8 @@
 
 #include "math/Octree.h"
 #include "WorldMeshExtractor.h"
+#include "WorldBuffers.h"
+#include "BufferRangeAllocator.h"
 #include "video/Camera.h"
 #include "voxel/VoxelVertex.h"
 
@@ -15,15 +17,26 @@ class WorldChunkMgr {
 protected:
 	struct ChunkBuffer {
 		bool inuse = false;
+		/**
+		 * The mesh must get uploaded into its slot of the world buffers
+		 */
+		bool dirty = false;
 		math::AABB<int> _aabb = {glm::zero<glm::ivec3>(), glm::zero<glm::ivec3>()};
-		voxel::Mesh mesh;
+		voxel::PackedMesh mesh;
+		/**
+		 * The slot in the world buffers - given in vertices and indices
+		 */
+		uint32_t baseVertex = 0u;
+		uint32_t baseIndex = 0u;
+		uint32_t vertexSlotSize = 0u;
+		uint32_t indexSlotSize = 0u;
 
 		/**
 		 * This is the world position. Not the render positions. There is no scale
 		 * applied here.
 		 */
 		inline const glm::ivec3 &translation() const {
-			return mesh.getOffset();
+			return mesh.offset;
 		}
 
 		/**
@@ -41,22 +54,48 @@ protected:
 	ChunkBuffer _chunkBuffers[MAX_CHUNKBUFFERS];
 	int _activeChunkBuffers = 0;
 	int _maxAllowedDistance = -1;
+	// the position and the distance of the last cancellation of the pending extractions
+	glm::ivec3 _cancelPosition { 0 };
+	int _cancelDistance = -1;
 
 	WorldMeshExtractor _meshExtractor;
+	voxel::PagedVolume* _volume = nullptr;
+
+	/**
+	 * The chunk meshes stay in their slots of the world buffers until they are removed - only the
+	 * newly extracted meshes are uploaded.
+	 */
+	static constexpr uint32_t INITIAL_VERTEX_SLOTS = 1024u * 1024u;
+	static constexpr uint32_t INITIAL_INDEX_SLOTS = 1536u * 1024u;
+	BufferRangeAllocator _vertexSlots;
+	BufferRangeAllocator _indexSlots;
+	std::vector<ChunkBuffer*> _pendingUploads;
 
 	int getDistanceSquare(const glm::ivec3 &pos, const glm::ivec3 &pos2) const;
+	void allocateSlot(ChunkBuffer& chunkBuffer);
+	void freeSlot(ChunkBuffer& chunkBuffer);
+	void removeChunkBuffer(ChunkBuffer& chunkBuffer);
 
 public:
 	WorldChunkMgr();
 
-	voxel::VertexArray _vertices;
-	voxel::IndexArray _indices;
+	/**
+	 * The draw ranges of the visible chunks
+	 * @sa cull()
+	 */
+	ChunkDrawRanges _drawRanges;
+
+	const WorldMeshExtractor& meshExtractor() const;
 
 	void extractMesh(const glm::ivec3 &pos);
 	void extractMeshes(const video::Camera &camera);
 
 	void cull(const video::Camera &camera);
 	void handleMeshQueue();
+	/**
+	 * @brief Uploads the meshes that were added since the last call into their slots of the world buffers
+	 */
+	void uploadChunks(WorldBuffers& buffers);
 
 	void updateViewDistance(float viewDistance);
 	bool init(voxel::PagedVolume* volume);
@@ -65,4 +104,8 @@ public:
 	void reset();
 };
 
+inline const WorldMeshExtractor& WorldChunkMgr::meshExtractor() const {
+	return _meshExtractor;
+}
+
 }
\ No newline at end of file
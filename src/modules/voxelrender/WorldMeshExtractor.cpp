@@ -7,20 +7,40 @@
 #include "voxel/CubicSurfaceExtractor.h"
 #include "voxel/IsQuadNeeded.h"
 #include "voxel/Constants.h"
+#include <SDL_timer.h>
+#include <glm/common.hpp>
 
 namespace voxelrender {
 
-WorldMeshExtractor::WorldMeshExtractor() :
-		_threadPool(1, "MeshExtract") {
+static_assert(voxel::MAX_MESH_CHUNK_HEIGHT <= voxel::MaxPackedVertexPosition, "The mesh height exceeds the packed vertex range");
+
+static inline uint64_t microsSince(uint64_t start) {
+	return (SDL_GetPerformanceCounter() - start) * 1000000u / SDL_GetPerformanceFrequency();
+}
+
+WorldMeshExtractor::WorldMeshExtractor() {
 }
 
 bool WorldMeshExtractor::init(voxel::PagedVolume *volume) {
 	_volume = volume;
-	_threadPool.init();
-	_meshSize = core::Var::getSafe(cfg::VoxelMeshSize);
-	for (size_t i = 0u; i < _threadPool.size(); ++i) {
-		_threadPool.enqueue([this] () {extractScheduledMesh();});
+	// the vertices of the far faces are placed at the mesh size - they must fit into the packed vertex
+	const int meshSize = core::Var::getSafe(cfg::VoxelMeshSize)->intVal();
+	_meshSize = glm::clamp(meshSize, 1, voxel::MaxPackedVertexPosition);
+	if (_meshSize != meshSize) {
+		Log::warn("%s %i is out of the packed vertex range - use %i", cfg::VoxelMeshSize, meshSize, _meshSize);
 	}
+	_threads = core::Var::get(cfg::VoxelMeshExtractorThreads, (int)core::halfcpus());
+	const int threads = core_max(1, _threads->intVal());
+	_cancelThreads = false;
+	_pendingExtraction.reset();
+	_extracted.reset();
+	resetStatistics();
+	_threadPool = std::make_unique<core::ThreadPool>(threads, "MeshExtract");
+	_threadPool->init();
+	for (size_t i = 0u; i < _threadPool->size(); ++i) {
+		_threadPool->enqueue([this] () {extractScheduledMesh();});
+	}
+	Log::debug("Mesh extraction with %i threads", threads);
 	return true;
 }
 
@@ -30,9 +50,16 @@ void WorldMeshExtractor::shutdown() {
 	_pendingExtraction.abortWait();
 	_extracted.clear();
 	_extracted.abortWait();
-	_threadPool.shutdown();
+	if (_threadPool) {
+		_threadPool->shutdown();
+		_threadPool.reset();
+	}
 	_positionsExtracted.clear();
 	_extracted.clear();
+	{
+		core::ScopedLock lock(_pendingLock);
+		_pendingPositions.clear();
+	}
 	_volume = nullptr;
 }
 
@@ -43,9 +70,34 @@ void WorldMeshExtractor::reset() {
 	_extracted.clear();
 	_positionsExtracted.clear();
 	_pendingExtraction.clear();
+	{
+		core::ScopedLock lock(_pendingLock);
+		_pendingPositions.clear();
+	}
+	resetStatistics();
+}
+
+void WorldMeshExtractor::resetStatistics() {
+	core::ScopedLock lock(_pendingLock);
+	// the in flight extractions are still running and are still counted
+	const uint32_t inFlight = _statistics.inFlight;
+	_statistics = Statistics();
+	_statistics.inFlight = inFlight;
+	_latencySumMicros = 0u;
+	_resetTime = SDL_GetPerformanceCounter();
+}
+
+WorldMeshExtractor::Statistics WorldMeshExtractor::statistics() const {
+	core::ScopedLock lock(_pendingLock);
+	Statistics statistics = _statistics;
+	statistics.pending = (uint32_t)_pendingPositions.size();
+	if (statistics.extracted > 0u) {
+		statistics.averageLatencyMicros = _latencySumMicros / statistics.extracted;
+	}
+	return statistics;
 }
 
-bool WorldMeshExtractor::pop(voxel::Mesh& item) {
+bool WorldMeshExtractor::pop(voxel::PackedMesh& item) {
 	return _extracted.pop(item);
 }
 
@@ -58,13 +110,12 @@ glm::ivec3 WorldMeshExtractor::meshPos(const glm::ivec3& pos) const {
 }
 
 glm::ivec3 WorldMeshExtractor::meshSize() const {
-	const int s = _meshSize->intVal();
-	return glm::ivec3(s, voxel::MAX_MESH_CHUNK_HEIGHT, s);
+	return glm::ivec3(_meshSize, voxel::MAX_MESH_CHUNK_HEIGHT, _meshSize);
 }
 
 void WorldMeshExtractor::updateExtractionOrder(const glm::ivec3& sortPos) {
 	const glm::ivec3& d = glm::abs(_pendingExtractionSortPosition - sortPos);
-	const int allowedDelta = 3 * _meshSize->intVal();
+	const int allowedDelta = 3 * _meshSize;
 	if (d.x < allowedDelta && d.z < allowedDelta) {
 		return;
 	}
@@ -89,18 +140,61 @@ bool WorldMeshExtractor::scheduleMeshExtraction(const glm::ivec3& p) {
 	if (!i.second) {
 		return false;
 	}
+	{
+		core::ScopedLock lock(_pendingLock);
+		// a re-extraction of a position that no worker picked up yet - the pending extraction will see the current voxels
+		if (!_pendingPositions.emplace(pos, SDL_GetPerformanceCounter()).second) {
+			++_statistics.deduplicated;
+			return true;
+		}
+		++_statistics.scheduled;
+	}
 	Log::trace("mesh extraction for %i:%i:%i (%i:%i:%i)",
 			p.x, p.y, p.z, pos.x, pos.y, pos.z);
 	_pendingExtraction.push(pos);
 	return true;
 }
 
+int WorldMeshExtractor::cancelExtractions(const glm::ivec3& pos, int maxDistanceSquare) {
+	const CloseToPoint distance(pos);
+	std::vector<glm::ivec3> cancelled;
+	{
+		core::ScopedLock lock(_pendingLock);
+		for (auto i = _pendingPositions.begin(); i != _pendingPositions.end();) {
+			if (distance.distanceToSortPos(i->first) <= maxDistanceSquare) {
+				++i;
+				continue;
+			}
+			cancelled.push_back(i->first);
+			i = _pendingPositions.erase(i);
+		}
+		_statistics.cancelled += cancelled.size();
+	}
+	// the workers skip the cancelled positions that are still in the queue
+	for (const glm::ivec3& cancelledPos : cancelled) {
+		_positionsExtracted.erase(cancelledPos);
+	}
+	return (int)cancelled.size();
+}
+
 void WorldMeshExtractor::extractScheduledMesh() {
 	while (!_cancelThreads) {
 		decltype(_pendingExtraction)::Key pos;
 		if (!_pendingExtraction.waitAndPop(pos)) {
 			break;
 		}
+		uint64_t scheduleTime;
+		{
+			core::ScopedLock lock(_pendingLock);
+			auto i = _pendingPositions.find(pos);
+			if (i == _pendingPositions.end()) {
+				// cancelled or already extracted by another worker
+				continue;
+			}
+			scheduleTime = i->second;
+			_pendingPositions.erase(i);
+			++_statistics.inFlight;
+		}
 		core_trace_scoped(MeshExtraction);
 		const glm::ivec3& size = meshSize();
 		const glm::ivec3 mins(pos);
@@ -111,11 +205,26 @@ void WorldMeshExtractor::extractScheduledMesh() {
 		const int factor = 64;
 		const int vertices = region.getWidthInVoxels() * region.getDepthInVoxels() * factor;
 		voxel::Mesh mesh(vertices, vertices);
-		voxel::extractCubicMesh(_volume, region, &mesh, voxel::IsQuadNeeded());
+		voxel::extractGreedyCubicMesh(_volume, region, &mesh, voxel::IsQuadNeeded());
 		if (!mesh.isEmpty()) {
-			_extracted.push(std::move(mesh));
+			voxel::PackedMesh packed;
+			// the mesh size is clamped to the packed vertex range in init()
+			const bool success = mesh.pack(packed);
+			core_assert_msg(success, "Failed to pack the mesh at %i:%i:%i", pos.x, pos.y, pos.z);
+			if (success) {
+				_extracted.push(std::move(packed));
+			}
+		}
+		core::ScopedLock lock(_pendingLock);
+		--_statistics.inFlight;
+		++_statistics.extracted;
+		const uint64_t latency = microsSince(scheduleTime);
+		_latencySumMicros += latency;
+		_statistics.maxLatencyMicros = core_max(_statistics.maxLatencyMicros, latency);
+		if (_statistics.timeToFirstMeshMicros == 0u && scheduleTime >= _resetTime) {
+			_statistics.timeToFirstMeshMicros = core_max((uint64_t)1u, microsSince(_resetTime));
 		}
 	}
 }
 
-}
\ No newline at end of file
+}
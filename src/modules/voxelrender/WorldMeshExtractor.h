@@ -10,7 +10,10 @@
 #include "core/collection/ConcurrentQueue.h"
 #include "voxel/PagedVolume.h"
 #include "core/concurrent/Atomic.h"
+#include "core/concurrent/Lock.h"
 
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <glm/vec3.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
@@ -21,9 +24,29 @@ namespace voxelrender {
 typedef std::unordered_set<glm::ivec3, std::hash<glm::ivec3> > PositionSet;
 
 class WorldMeshExtractor {
+public:
+	/**
+	 * @brief Queue and latency metrics of the mesh extraction. The latency is measured from scheduling a
+	 * position until its mesh is ready to get popped.
+	 */
+	struct Statistics {
+		// scheduled extractions that are not yet picked up by a worker
+		uint32_t pending = 0u;
+		uint32_t inFlight = 0u;
+		uint64_t scheduled = 0u;
+		uint64_t extracted = 0u;
+		// extraction requests for positions that were still pending
+		uint64_t deduplicated = 0u;
+		uint64_t cancelled = 0u;
+		uint64_t averageLatencyMicros = 0u;
+		uint64_t maxLatencyMicros = 0u;
+		// time from the last reset (e.g. a teleport) until the first mesh was ready - 0 if there is none yet
+		uint64_t timeToFirstMeshMicros = 0u;
+	};
+
 private:
-	core::ThreadPool _threadPool;
-	core::ConcurrentQueue<voxel::Mesh> _extracted;
+	std::unique_ptr<core::ThreadPool> _threadPool;
+	core::ConcurrentQueue<voxel::PackedMesh> _extracted;
 	glm::ivec3 _pendingExtractionSortPosition { 0, 0, 0 };
 	struct CloseToPoint {
 		glm::ivec3 _refPoint;
@@ -41,19 +64,33 @@ private:
 	core::ConcurrentQueue<glm::ivec3, CloseToPoint> _pendingExtraction { CloseToPoint(_pendingExtractionSortPosition) };
 	// fast lookup for positions that are already extracted
 	PositionSet _positionsExtracted;
-	core::VarPtr _meshSize;
+	/**
+	 * The positions that are waiting for a worker mapped to the performance counter value of their scheduling. A position
+	 * that is still in @c _pendingExtraction but not in here anymore was cancelled and is skipped by the workers.
+	 * Guarded by @c _pendingLock - just like the statistics.
+	 */
+	std::unordered_map<glm::ivec3, uint64_t, std::hash<glm::ivec3> > _pendingPositions;
+	mutable core_trace_mutex(core::Lock, _pendingLock);
+	Statistics _statistics;
+	uint64_t _latencySumMicros = 0u;
+	uint64_t _resetTime = 0u;
+	// the side length of the meshes - clamped to the range of the packed vertices
+	int _meshSize = 0;
+	core::VarPtr _threads;
 	core::AtomicBool _cancelThreads { false };
 	voxel::PagedVolume *_volume = nullptr;
 	void extractScheduledMesh();
+	void resetStatistics();
 
 public:
 	WorldMeshExtractor();
 
 	/**
 	 * @brief We need to pop the mesh extractor queue to find out if there are new and ready to use meshes for us
+	 * @note The meshes are delivered in the packed vertex layout
 	 * @return @c false if this isn't the case, @c true if the given reference was filled with valid data.
 	 */
-	bool pop(voxel::Mesh& item);
+	bool pop(voxel::PackedMesh& item);
 
 	/**
 	 * @brief If you don't need an extracted mesh anymore, make sure to allow the reextraction at a later time.
@@ -75,6 +112,17 @@ public:
 	 */
 	bool scheduleMeshExtraction(const glm::ivec3& pos);
 
+	/**
+	 * @brief Cancels all scheduled extractions that are farther away from the given position than the given
+	 * distance. Extractions that are already running are not affected.
+	 *
+	 * @note The cancelled positions are allowed to get scheduled again.
+	 * @return The amount of cancelled extractions
+	 */
+	int cancelExtractions(const glm::ivec3& pos, int maxDistanceSquare);
+
+	Statistics statistics() const;
+
 	void reset();
 
 	/**
@@ -26,7 +26,6 @@
 
 namespace voxelrender {
 
-// TODO: respect max vertex/index size of the one-big-vbo/ibo
 WorldRenderer::WorldRenderer() :
 		_shadowMapShader(shader::ShadowmapShader::getInstance()) {
 	setViewDistance(240.0f);
@@ -158,10 +157,11 @@ int WorldRenderer::renderToShadowMap(const video::Camera& camera) {
 
 	// render the terrain
 	_shadowMapShader.activate();
-	_shadowMapShader.setModel(glm::mat4(1.0f));
 	_shadow.render([this] (int i, const glm::mat4& lightViewProjection) {
 		_shadowMapShader.setLightviewprojection(lightViewProjection);
-		_worldBuffers.renderTerrain();
+		_worldBuffers.renderTerrain(_worldChunkMgr._drawRanges, [this] (const glm::ivec3& offset) {
+			_shadowMapShader.setModel(glm::translate(glm::vec3(offset)));
+		});
 		return true;
 	}, false);
 	_shadowMapShader.deactivate();
@@ -170,8 +170,8 @@ int WorldRenderer::renderToShadowMap(const video::Camera& camera) {
 
 int WorldRenderer::renderToFrameBuffer(const video::Camera& camera) {
 	core_trace_scoped(WorldRendererRenderToFrameBuffer);
-	// update the vertex buffers
-	_worldBuffers.update(_worldChunkMgr._vertices, _worldChunkMgr._indices);
+	// upload the new chunk meshes
+	_worldChunkMgr.uploadChunks(_worldBuffers);
 
 	// ensure we are in the expected states
 	video::enable(video::State::DepthTest);
@@ -222,9 +222,9 @@ int WorldRenderer::renderTerrain(const glm::mat4& viewProjectionMatrix, const gl
 		_worldShader.setCascades(_shadow.cascades());
 		_worldShader.setDistances(_shadow.distances());
 	}
-	if (_worldBuffers.renderTerrain()) {
-		++drawCallsWorld;
-	}
+	drawCallsWorld += _worldBuffers.renderTerrain(_worldChunkMgr._drawRanges, [this] (const glm::ivec3& offset) {
+		_worldShader.setModel(glm::translate(glm::vec3(offset)));
+	});
 	return drawCallsWorld;
 }
 
@@ -0,0 +1,63 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "voxelrender/BufferRangeAllocator.h"
+
+namespace voxelrender {
+
+class BufferRangeAllocatorTest: public core::AbstractTest {
+};
+
+TEST_F(BufferRangeAllocatorTest, testAllocFree) {
+	BufferRangeAllocator allocator;
+	allocator.init(100u);
+	uint32_t a, b, c;
+	ASSERT_TRUE(allocator.alloc(30u, a));
+	ASSERT_TRUE(allocator.alloc(30u, b));
+	ASSERT_TRUE(allocator.alloc(40u, c));
+	EXPECT_EQ(0u, a);
+	EXPECT_EQ(30u, b);
+	EXPECT_EQ(60u, c);
+	EXPECT_EQ(100u, allocator.used());
+	EXPECT_EQ(0u, allocator.fragments());
+	uint32_t d;
+	EXPECT_FALSE(allocator.alloc(1u, d));
+
+	allocator.free(b, 30u);
+	EXPECT_EQ(1u, allocator.fragments());
+	ASSERT_TRUE(allocator.alloc(20u, d));
+	EXPECT_EQ(b, d) << "The first fitting range should get reused";
+	allocator.free(d, 20u);
+
+	// the free ranges must get merged with their neighbours
+	allocator.free(a, 30u);
+	EXPECT_EQ(1u, allocator.fragments());
+	allocator.free(c, 40u);
+	EXPECT_EQ(1u, allocator.fragments());
+	EXPECT_EQ(0u, allocator.used());
+	ASSERT_TRUE(allocator.alloc(100u, d));
+	EXPECT_EQ(0u, d);
+}
+
+TEST_F(BufferRangeAllocatorTest, testGrow) {
+	BufferRangeAllocator allocator;
+	allocator.init(10u);
+	uint32_t a, b;
+	ASSERT_TRUE(allocator.alloc(6u, a));
+	EXPECT_FALSE(allocator.alloc(6u, b));
+	allocator.grow(20u);
+	EXPECT_EQ(20u, allocator.capacity());
+	ASSERT_TRUE(allocator.alloc(6u, b));
+	EXPECT_EQ(6u, b) << "The free range at the end should get extended";
+	EXPECT_EQ(1u, allocator.fragments());
+
+	allocator.grow(30u);
+	ASSERT_TRUE(allocator.alloc(18u, b));
+	EXPECT_EQ(12u, b);
+	EXPECT_EQ(0u, allocator.fragments());
+	EXPECT_EQ(30u, allocator.used());
+}
+
+}
@@ -0,0 +1,125 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "core/GameConfig.h"
+#include "core/concurrent/Atomic.h"
+#include "voxelrender/WorldMeshExtractor.h"
+#include "voxel/MaterialColor.h"
+#include <SDL_timer.h>
+
+namespace voxelrender {
+
+class WorldMeshExtractorTest: public core::AbstractTest {
+protected:
+	/**
+	 * @brief Pager that blocks the first extraction until it gets released - this keeps the single
+	 * worker busy and all other scheduled positions pending.
+	 */
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		core::AtomicBool released { false };
+
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			while (!released) {
+				SDL_Delay(1);
+			}
+			const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Grass, 0);
+			const int32_t sideLength = ctx.chunk->sideLength();
+			for (int32_t x = 0; x < sideLength; ++x) {
+				for (int32_t z = 0; z < sideLength; ++z) {
+					ctx.chunk->setVoxel(x, 0, z, voxel);
+				}
+			}
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	void SetUp() override {
+		core::AbstractTest::SetUp();
+		core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY);
+		core::Var::get(cfg::VoxelMeshExtractorThreads, "1");
+		voxel::initDefaultMaterialColors();
+	}
+
+	template<class FUNC>
+	bool waitFor(FUNC&& func) const {
+		for (int i = 0; i < 10000; ++i) {
+			if (func()) {
+				return true;
+			}
+			SDL_Delay(1);
+		}
+		return false;
+	}
+};
+
+TEST_F(WorldMeshExtractorTest, testExtract) {
+	Pager pager;
+	pager.released = true;
+	voxel::PagedVolume volume(&pager, 64 * 1024 * 1024, 32);
+	WorldMeshExtractor extractor;
+	ASSERT_TRUE(extractor.init(&volume));
+	EXPECT_TRUE(extractor.scheduleMeshExtraction(glm::ivec3(0)));
+	EXPECT_TRUE(extractor.scheduleMeshExtraction(glm::ivec3(16, 0, 0)));
+	EXPECT_FALSE(extractor.scheduleMeshExtraction(glm::ivec3(1, 0, 1))) << "The mesh position was already scheduled";
+	int meshes = 0;
+	EXPECT_TRUE(waitFor([&] () {
+		voxel::PackedMesh mesh;
+		while (extractor.pop(mesh)) {
+			EXPECT_FALSE(mesh.ranges.empty());
+			++meshes;
+		}
+		return meshes == 2;
+	}));
+	const WorldMeshExtractor::Statistics& stats = extractor.statistics();
+	EXPECT_EQ(2u, stats.scheduled);
+	EXPECT_EQ(2u, stats.extracted);
+	EXPECT_EQ(0u, stats.pending);
+	EXPECT_EQ(0u, stats.inFlight);
+	EXPECT_GT(stats.timeToFirstMeshMicros, 0u);
+	EXPECT_GE(stats.maxLatencyMicros, stats.averageLatencyMicros);
+	extractor.shutdown();
+}
+
+TEST_F(WorldMeshExtractorTest, testDeduplicateAndCancel) {
+	Pager pager;
+	voxel::PagedVolume volume(&pager, 64 * 1024 * 1024, 32);
+	WorldMeshExtractor extractor;
+	ASSERT_TRUE(extractor.init(&volume));
+
+	// the only worker is blocked by the pager while extracting this one
+	ASSERT_TRUE(extractor.scheduleMeshExtraction(glm::ivec3(0)));
+	ASSERT_TRUE(waitFor([&] () { return extractor.statistics().inFlight == 1u; }));
+
+	const glm::ivec3 near(16, 0, 0);
+	const glm::ivec3 far(1600, 0, 0);
+	EXPECT_TRUE(extractor.scheduleMeshExtraction(near));
+	EXPECT_TRUE(extractor.scheduleMeshExtraction(far));
+	EXPECT_EQ(2u, extractor.statistics().pending);
+
+	// the position is still pending - no second extraction is needed
+	EXPECT_TRUE(extractor.allowReExtraction(near));
+	EXPECT_TRUE(extractor.scheduleMeshExtraction(near));
+	EXPECT_EQ(1u, extractor.statistics().deduplicated);
+	EXPECT_EQ(2u, extractor.statistics().pending);
+
+	EXPECT_EQ(1, extractor.cancelExtractions(glm::ivec3(0), 32 * 32));
+	EXPECT_EQ(1u, extractor.statistics().pending);
+	EXPECT_EQ(1u, extractor.statistics().cancelled);
+	EXPECT_FALSE(extractor.allowReExtraction(far)) << "Cancelled positions should be allowed to get scheduled again";
+
+	pager.released = true;
+	ASSERT_TRUE(waitFor([&] () {
+		const WorldMeshExtractor::Statistics& stats = extractor.statistics();
+		return stats.extracted == 2u && stats.inFlight == 0u;
+	}));
+	EXPECT_EQ(0u, extractor.statistics().pending);
+	extractor.shutdown();
+}
+
+}
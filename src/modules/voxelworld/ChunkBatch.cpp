@@ -0,0 +1,83 @@
+/**
+ * @file
+ */
+
+#include "ChunkBatch.h"
+#include "core/Log.h"
+#include <SDL_endian.h>
+#include <string.h>
+
+namespace voxelworld {
+
+namespace {
+
+// x, y, z and the length of the data
+constexpr size_t EntryHeaderSize = 4u * sizeof(uint32_t);
+
+inline void writeUInt32(uint8_t *buf, uint32_t value) {
+	const uint32_t v = SDL_SwapLE32(value);
+	memcpy(buf, &v, sizeof(v));
+}
+
+inline uint32_t readUInt32(const uint8_t *buf) {
+	uint32_t v;
+	memcpy(&v, buf, sizeof(v));
+	return SDL_SwapLE32(v);
+}
+
+}
+
+size_t chunkBatchSize(const std::vector<ChunkBatchEntry>& entries) {
+	size_t size = 0u;
+	for (const ChunkBatchEntry& entry : entries) {
+		size += EntryHeaderSize + entry.length;
+	}
+	return size;
+}
+
+size_t writeChunkBatch(const std::vector<ChunkBatchEntry>& entries, uint8_t *buf, size_t bufSize) {
+	size_t pos = 0u;
+	for (const ChunkBatchEntry& entry : entries) {
+		if (bufSize - pos < EntryHeaderSize + entry.length) {
+			Log::error("Chunk batch buffer is too small");
+			return pos;
+		}
+		writeUInt32(buf + pos, (uint32_t)entry.chunkPos.x);
+		writeUInt32(buf + pos + 4u, (uint32_t)entry.chunkPos.y);
+		writeUInt32(buf + pos + 8u, (uint32_t)entry.chunkPos.z);
+		writeUInt32(buf + pos + 12u, entry.length);
+		pos += EntryHeaderSize;
+		if (entry.length > 0u) {
+			memcpy(buf + pos, entry.data, entry.length);
+			pos += entry.length;
+		}
+	}
+	return pos;
+}
+
+bool readChunkBatch(const uint8_t *buf, size_t bufSize, std::vector<ChunkBatchEntry>& entries) {
+	size_t pos = 0u;
+	while (pos < bufSize) {
+		if (bufSize - pos < EntryHeaderSize) {
+			Log::error("Truncated chunk batch entry header");
+			return false;
+		}
+		ChunkBatchEntry entry;
+		entry.chunkPos.x = (int32_t)readUInt32(buf + pos);
+		entry.chunkPos.y = (int32_t)readUInt32(buf + pos + 4u);
+		entry.chunkPos.z = (int32_t)readUInt32(buf + pos + 8u);
+		entry.length = readUInt32(buf + pos + 12u);
+		pos += EntryHeaderSize;
+		if (bufSize - pos < entry.length) {
+			Log::error("Truncated chunk batch entry data for %i:%i:%i",
+					entry.chunkPos.x, entry.chunkPos.y, entry.chunkPos.z);
+			return false;
+		}
+		entry.data = buf + pos;
+		pos += entry.length;
+		entries.push_back(entry);
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,48 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace voxelworld {
+
+/**
+ * @brief The max amount of chunks that are transferred with one batch
+ */
+constexpr size_t MaxChunkBatchSize = 64u;
+
+/**
+ * @brief One compressed chunk of a batch - the data is the output of @c ChunkPersister::saveCompressed()
+ */
+struct ChunkBatchEntry {
+	glm::ivec3 chunkPos { 0 };
+	const uint8_t *data = nullptr;
+	uint32_t length = 0u;
+};
+
+/**
+ * @brief The size of the buffer that is needed to write the given entries
+ *
+ * A batch is a length prefixed stream of compressed chunks. Every entry starts with the chunk position
+ * and the length of the data as little endian 32 bit values, followed by the data.
+ */
+extern size_t chunkBatchSize(const std::vector<ChunkBatchEntry>& entries);
+
+/**
+ * @param[out] buf Must be able to hold @c chunkBatchSize() bytes
+ * @return The amount of bytes that were written
+ */
+extern size_t writeChunkBatch(const std::vector<ChunkBatchEntry>& entries, uint8_t *buf, size_t bufSize);
+
+/**
+ * @param[out] entries The data of the entries points into the given buffer
+ * @return @c false if the buffer is truncated or malformed
+ */
+extern bool readChunkBatch(const uint8_t *buf, size_t bufSize, std::vector<ChunkBatchEntry>& entries);
+
+}
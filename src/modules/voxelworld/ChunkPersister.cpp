@@ -6,100 +6,419 @@
 #include "core/ByteStream.h"
 #include "core/Zip.h"
 #include "core/Assert.h"
+#include "core/Common.h"
 #include "core/Enum.h"
 #include "core/Log.h"
+#include "core/StringUtil.h"
+#include "core/Trace.h"
+#include "voxel/Morton.h"
+#include <SDL_endian.h>
+#include <algorithm>
+#include <vector>
 
 namespace voxelworld {
 
-#define WORLD_FILE_VERSION 1
+namespace {
+
+/**
+ * @brief The layout of the voxels in the uncompressed body of a chunk
+ */
+enum class Encoding : uint8_t {
+	// one voxel for the whole chunk
+	Uniform,
+	// up to 256 voxels and the packed palette indices with 1, 2, 4 or 8 bits per voxel
+	Palette,
+	// all materials followed by all colors
+	Planes
+};
+
+enum class Codec : uint8_t {
+	Stored,
+	Deflate
+};
+
+// int32 size of the uncompressed body and the byte for the format version
+constexpr size_t HeaderSize = 5u;
+// the generator version and the codec follow the header since format version 3 - version 2 only has the codec
+constexpr size_t GeneratorOffset = HeaderSize;
+constexpr size_t CodecOffset = HeaderSize + 1u;
+constexpr size_t CodecOffsetVersion2 = HeaderSize;
+// all chunks of the formats before version 3 were created by the first world generator
+constexpr int FirstGeneratorVersion = 1;
+constexpr int VersionWithoutGenerator = 2;
+constexpr int FirstVersionWithGenerator = 3;
+constexpr int MaxPaletteSize = 256;
+constexpr int SizeLimitMB = 1024;
+
+// the buffers of a 64^3 chunk in any encoding fit into this
+constexpr size_t MaxRetainedBytes = 1024u * 1024u;
+
+/**
+ * @brief The chunks are paged in and out by several threads - each of them reuses its own buffers
+ */
+struct Scratch {
+	std::vector<voxel::Voxel> voxels;
+	std::vector<uint8_t> indices;
+	std::vector<uint8_t> body;
+	std::vector<uint8_t> compressed;
+};
+
+template<class T>
+inline void releaseIfLarge(std::vector<T>& buffer) {
+	if (buffer.capacity() * sizeof(T) > MaxRetainedBytes) {
+		std::vector<T>().swap(buffer);
+	}
+}
+
+/**
+ * @brief Gives access to the buffers of the current thread. The buffers of bigger chunks are freed again when
+ * the scope is left - otherwise every thread that ever paged a 256^3 chunk would keep about 100 MB alive.
+ */
+class ScopedScratch {
+private:
+	Scratch& _buffers;
+
+	static Scratch& threadBuffers() {
+		thread_local Scratch buffers;
+		return buffers;
+	}
+public:
+	ScopedScratch() : _buffers(threadBuffers()) {
+	}
+
+	~ScopedScratch() {
+		releaseIfLarge(_buffers.voxels);
+		releaseIfLarge(_buffers.indices);
+		releaseIfLarge(_buffers.body);
+		releaseIfLarge(_buffers.compressed);
+	}
+
+	inline Scratch* operator->() const {
+		return &_buffers;
+	}
+};
+
+inline uint8_t bitsPerIndex(int paletteSize) {
+	if (paletteSize <= 2) {
+		return 1u;
+	}
+	if (paletteSize <= 4) {
+		return 2u;
+	}
+	if (paletteSize <= 16) {
+		return 4u;
+	}
+	return 8u;
+}
+
+inline uint8_t* writeUInt16(uint8_t* out, uint16_t value) {
+	out[0] = (uint8_t)(value & 0xFFu);
+	out[1] = (uint8_t)(value >> 8);
+	return out + 2;
+}
+
+inline uint16_t readUInt16(const uint8_t* in) {
+	return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+}
+
+static_assert(ChunkPersister::ETagHeaderSize == GeneratorOffset + 1u, "The entity tag needs the generator version");
+
+core::String ChunkPersister::etag(unsigned int seed) {
+	return core::string::format("\"%u-%i-%i\"", seed, Version, GeneratorVersion);
+}
+
+core::String ChunkPersister::etag(unsigned int seed, const uint8_t *fileBuf, size_t fileLen) {
+	const int generator = generatorVersion(fileBuf, fileLen);
+	if (generator < 0) {
+		return core::String();
+	}
+	return core::string::format("\"%u-%i-%i\"", seed, (int)fileBuf[4], generator);
+}
+
+int ChunkPersister::generatorVersion(const uint8_t *fileBuf, size_t fileLen) {
+	if (fileBuf == nullptr || fileLen < HeaderSize) {
+		return -1;
+	}
+	if (fileBuf[4] < FirstVersionWithGenerator) {
+		return FirstGeneratorVersion;
+	}
+	if (fileLen <= GeneratorOffset) {
+		return -1;
+	}
+	return fileBuf[GeneratorOffset];
+}
+
+void ChunkPersister::setCompressionLevel(int level) {
+	_compressionLevel = level;
+}
 
 bool ChunkPersister::saveCompressed(voxel::PagedVolume::Chunk* chunk, core::ByteStream& outStream) const {
-	core::ByteStream voxelStream;
-	const int width = chunk->sideLength();
-	const int height = chunk->sideLength();
-	const int depth = chunk->sideLength();
-
-	for (int z = 0; z < depth; ++z) {
-		for (int y = 0; y < height; ++y) {
-			for (int x = 0; x < width; ++x) {
-				const voxel::Voxel& voxel = chunk->voxel(x, y, z);
-				static_assert(sizeof(voxel::VoxelType) == sizeof(uint8_t), "Voxel type size changed");
-				voxelStream.addByte(core::enumVal(voxel.getMaterial()));
-				voxelStream.addByte(voxel.getColor());
+	core_trace_scoped(ChunkPersisterSave);
+	const ScopedScratch buffers;
+	const uint32_t voxelCount = chunk->voxels();
+	buffers->voxels.resize(voxelCount);
+	if (!chunk->data(buffers->voxels.data(), voxelCount * sizeof(voxel::Voxel))) {
+		Log::error("Failed to get the voxel data of the chunk");
+		return false;
+	}
+	const voxel::Voxel* voxels = buffers->voxels.data();
+
+	// palette pre-pass - most chunks only consist of a few different voxels that come in runs
+	voxel::Voxel palette[MaxPaletteSize];
+	int paletteSize = 0;
+	int hint = 0;
+	bool planes = false;
+	buffers->indices.resize(voxelCount);
+	for (uint32_t i = 0u; i < voxelCount; ++i) {
+		const voxel::Voxel& voxel = voxels[i];
+		if (paletteSize == 0 || !palette[hint].isSame(voxel)) {
+			int p = 0;
+			while (p < paletteSize && !palette[p].isSame(voxel)) {
+				++p;
+			}
+			if (p == paletteSize) {
+				if (paletteSize == MaxPaletteSize) {
+					planes = true;
+					break;
+				}
+				palette[paletteSize++] = voxel;
 			}
+			hint = p;
 		}
+		buffers->indices[i] = (uint8_t)hint;
 	}
 
-	// save the stuff
-	const uint8_t* voxelBuf = voxelStream.getBuffer();
-	const int voxelSize = voxelStream.getSize();
-	uint32_t neededVoxelBufLen = core::zip::compressBound(voxelSize);
-	uint8_t* compressedVoxelBuf = new uint8_t[neededVoxelBufLen];
-	size_t finalBufferSize;
-	const bool success = core::zip::compress(voxelBuf, voxelSize, compressedVoxelBuf, neededVoxelBufLen, &finalBufferSize);
-	std::unique_ptr<uint8_t[]> smartBuf(compressedVoxelBuf);
-	if (!success) {
-		Log::error("Failed to compress the voxel data");
-		return false;
+	static_assert(sizeof(voxel::VoxelType) == sizeof(uint8_t), "Voxel type size changed");
+	Encoding encoding;
+	uint8_t bits = 0u;
+	size_t bodySize = 3u;
+	if (planes) {
+		encoding = Encoding::Planes;
+		bodySize += 2u * voxelCount;
+	} else if (paletteSize == 1) {
+		encoding = Encoding::Uniform;
+		bodySize += 2u;
+	} else {
+		encoding = Encoding::Palette;
+		bits = bitsPerIndex(paletteSize);
+		bodySize += 3u + 2u * paletteSize + (voxelCount * bits + 7u) / 8u;
+	}
+
+	buffers->body.resize(bodySize);
+	uint8_t* body = buffers->body.data();
+	uint8_t* out = writeUInt16(body, (uint16_t)chunk->sideLength());
+	*out++ = core::enumVal(encoding);
+	if (encoding == Encoding::Uniform) {
+		*out++ = core::enumVal(palette[0].getMaterial());
+		*out++ = palette[0].getColor();
+	} else if (encoding == Encoding::Palette) {
+		out = writeUInt16(out, (uint16_t)paletteSize);
+		*out++ = bits;
+		for (int i = 0; i < paletteSize; ++i) {
+			out[i] = core::enumVal(palette[i].getMaterial());
+			out[paletteSize + i] = palette[i].getColor();
+		}
+		out += 2 * paletteSize;
+		if (bits == 8u) {
+			core_memcpy(out, buffers->indices.data(), voxelCount);
+		} else {
+			const uint8_t* indices = buffers->indices.data();
+			const uint32_t perByte = 8u / bits;
+			const uint32_t packedSize = (voxelCount * bits + 7u) / 8u;
+			for (uint32_t b = 0u; b < packedSize; ++b) {
+				const uint32_t first = b * perByte;
+				const uint32_t last = core_min(first + perByte, voxelCount);
+				uint8_t packed = 0u;
+				for (uint32_t i = first; i < last; ++i) {
+					packed |= (uint8_t)(indices[i] << ((i - first) * bits));
+				}
+				out[b] = packed;
+			}
+		}
+	} else {
+		for (uint32_t i = 0u; i < voxelCount; ++i) {
+			out[i] = core::enumVal(voxels[i].getMaterial());
+			out[voxelCount + i] = voxels[i].getColor();
+		}
+	}
+
+	const uint8_t* payload = body;
+	size_t payloadSize = bodySize;
+	Codec codec = Codec::Stored;
+	if (_compressionLevel > 0) {
+		buffers->compressed.resize(core::zip::compressBound((uint32_t)bodySize));
+		size_t compressedSize = 0u;
+		if (!core::zip::compress(body, bodySize, buffers->compressed.data(), buffers->compressed.size(), &compressedSize, _compressionLevel)) {
+			Log::error("Failed to compress the voxel data");
+			return false;
+		}
+		// tiny uniform chunks don't get smaller
+		if (compressedSize < bodySize) {
+			payload = buffers->compressed.data();
+			payloadSize = compressedSize;
+			codec = Codec::Deflate;
+		}
 	}
-	outStream.addFormat("ib", voxelSize, WORLD_FILE_VERSION);
-	outStream.append(compressedVoxelBuf, finalBufferSize);
+	outStream.addFormat("ib", (int)bodySize, Version);
+	outStream.addByte((uint8_t)GeneratorVersion);
+	outStream.addByte(core::enumVal(codec));
+	outStream.append(payload, payloadSize);
 	return true;
 }
 
-bool ChunkPersister::loadCompressed(voxel::PagedVolume::Chunk* chunk, const uint8_t *fileBuf, size_t fileLen) const {
-	if (!fileBuf || fileLen <= 0) {
+bool ChunkPersister::loadVersion1(voxel::PagedVolume::Chunk* chunk, const uint8_t *buf, size_t bufLen, int len) const {
+	const uint32_t sideLength = chunk->sideLength();
+	const uint32_t voxelCount = chunk->voxels();
+	if ((uint32_t)len != voxelCount * 2u) {
+		Log::error("chunk data size %i doesn't match the chunk side length %u", len, sideLength);
+		return false;
+	}
+	const ScopedScratch buffers;
+	buffers->body.resize(len);
+	if (!core::zip::uncompress(buf, bufLen, buffers->body.data(), len)) {
+		Log::error("Failed to uncompress the world data with len %i", len);
 		return false;
 	}
-	core::ByteStream bs(fileLen);
-	bs.append(fileBuf, fileLen);
-	int len;
-	int version;
-	bs.readFormat("ib", &len, &version);
 
-	if (version != WORLD_FILE_VERSION) {
-		Log::error("chunk has a wrong version number %i (expected %i)",
-				version, WORLD_FILE_VERSION);
+	// the voxels were stored in x, y, z order - the chunk needs them in morton order
+	buffers->voxels.resize(voxelCount);
+	voxel::Voxel* voxels = buffers->voxels.data();
+	const uint8_t* in = buffers->body.data();
+	for (uint32_t z = 0u; z < sideLength; ++z) {
+		for (uint32_t y = 0u; y < sideLength; ++y) {
+			const uint32_t yz = voxel::morton256_y[y] | voxel::morton256_z[z];
+			for (uint32_t x = 0u; x < sideLength; ++x) {
+				voxels[voxel::morton256_x[x] | yz] = voxel::createVoxel((voxel::VoxelType)in[0], in[1]);
+				in += 2;
+			}
+		}
+	}
+	return chunk->setData(voxels, voxelCount * sizeof(voxel::Voxel));
+}
+
+bool ChunkPersister::loadCompressed(voxel::PagedVolume::Chunk* chunk, const uint8_t *fileBuf, size_t fileLen) const {
+	core_trace_scoped(ChunkPersisterLoad);
+	if (fileBuf == nullptr || fileLen < HeaderSize) {
 		return false;
 	}
-	const int sizeLimit = 1024;
-	if (len > 1000l * 1000l * sizeLimit) {
-		Log::error("extracted memory would be more than %i MB",
-				sizeLimit);
+	uint32_t rawLen;
+	core_memcpy(&rawLen, fileBuf, sizeof(rawLen));
+	const int len = (int)SDL_SwapLE32(rawLen);
+	const int version = fileBuf[4];
+	if (len <= 0 || len > 1000l * 1000l * SizeLimitMB) {
+		Log::error("extracted memory would be more than %i MB", SizeLimitMB);
+		return false;
+	}
+	const int generator = generatorVersion(fileBuf, fileLen);
+	if (generator != GeneratorVersion) {
+		// the chunk doesn't match the chunks that are generated now for the same seed - it's regenerated
+		Log::debug("chunk was created by the world generator %i (expected %i)", generator, GeneratorVersion);
+		return false;
+	}
+	if (version == VersionPlain) {
+		return loadVersion1(chunk, fileBuf + HeaderSize, fileLen - HeaderSize, len);
+	}
+	size_t codecOffset;
+	if (version == Version) {
+		codecOffset = CodecOffset;
+	} else if (version == VersionWithoutGenerator) {
+		codecOffset = CodecOffsetVersion2;
+	} else {
+		Log::error("chunk has a wrong version number %i (expected %i)", version, Version);
+		return false;
+	}
+	if (fileLen <= codecOffset) {
+		Log::error("chunk without codec");
 		return false;
 	}
 
-	uint8_t *targetBuf = new uint8_t[len];
-	std::unique_ptr<uint8_t[]> smartTargetBuf(targetBuf);
+	const ScopedScratch buffers;
+	const Codec codec = (Codec)fileBuf[codecOffset];
+	const uint8_t* payload = fileBuf + codecOffset + 1u;
+	const size_t payloadSize = fileLen - codecOffset - 1u;
+	const uint8_t* body;
+	if (codec == Codec::Stored) {
+		if (payloadSize != (size_t)len) {
+			Log::error("stored chunk data has the wrong size %i (expected %i)", (int)payloadSize, len);
+			return false;
+		}
+		body = payload;
+	} else if (codec == Codec::Deflate) {
+		buffers->body.resize(len);
+		size_t finalSize = 0u;
+		if (!core::zip::uncompress(payload, payloadSize, buffers->body.data(), len, &finalSize) || finalSize != (size_t)len) {
+			Log::error("Failed to uncompress the world data with len %i", len);
+			return false;
+		}
+		body = buffers->body.data();
+	} else {
+		Log::error("chunk has an unknown codec %i", (int)codec);
+		return false;
+	}
 
-	if (!core::zip::uncompress(bs.getBuffer(), bs.getSize(), targetBuf, len)) {
-		Log::error("Failed to uncompress the world data with len %i", len);
+	if (len < 3) {
+		Log::error("chunk data is too small");
 		return false;
 	}
+	const uint16_t sideLength = readUInt16(body);
+	if (sideLength != chunk->sideLength()) {
+		Log::error("chunk side length %i doesn't match %i", (int)sideLength, (int)chunk->sideLength());
+		return false;
+	}
+	const Encoding encoding = (Encoding)body[2];
+	const uint8_t* in = body + 3;
+	const size_t remaining = (size_t)len - 3u;
+	const uint32_t voxelCount = chunk->voxels();
+	buffers->voxels.resize(voxelCount);
+	voxel::Voxel* voxels = buffers->voxels.data();
 
-	core::ByteStream voxelBuf(len);
-	voxelBuf.append(targetBuf, len);
-
-	const int width = chunk->sideLength();
-	const int height = chunk->sideLength();
-	const int depth = chunk->sideLength();
-
-	for (int z = 0; z < depth; ++z) {
-		for (int y = 0; y < height; ++y) {
-			for (int x = 0; x < width; ++x) {
-				core_assert_msg(voxelBuf.getSize() >= 1,
-						"Failed to load from buffer (x: %i, y: %i, z: %i)",
-						x, y, z);
-				static_assert(sizeof(voxel::VoxelType) == sizeof(uint8_t), "Voxel type size changed");
-				const voxel::VoxelType material =
-						(voxel::VoxelType) voxelBuf.readByte();
-				const uint8_t colorIndex = voxelBuf.readByte();
-				const voxel::Voxel &voxel = createVoxel(material, colorIndex);
-				chunk->setVoxel(x, y, z, voxel);
-			}
+	if (encoding == Encoding::Uniform) {
+		if (remaining != 2u) {
+			Log::error("invalid uniform chunk data");
+			return false;
+		}
+		std::fill_n(voxels, voxelCount, voxel::createVoxel((voxel::VoxelType)in[0], in[1]));
+	} else if (encoding == Encoding::Palette) {
+		if (remaining < 3u) {
+			Log::error("invalid palette chunk data");
+			return false;
+		}
+		const int paletteSize = readUInt16(in);
+		const uint32_t bits = in[2];
+		in += 3;
+		const uint32_t packedSize = (voxelCount * bits + 7u) / 8u;
+		if (paletteSize < 1 || paletteSize > MaxPaletteSize || bits != bitsPerIndex(paletteSize)
+				|| remaining != 3u + 2u * paletteSize + packedSize) {
+			Log::error("invalid palette chunk data (palette: %i, bits: %u)", paletteSize, bits);
+			return false;
+		}
+		// the unused entries are mapped to the first voxel - only a corrupted chunk would refer to them
+		voxel::Voxel palette[MaxPaletteSize];
+		for (int i = 0; i < MaxPaletteSize; ++i) {
+			const int p = i < paletteSize ? i : 0;
+			palette[i] = voxel::createVoxel((voxel::VoxelType)in[p], in[paletteSize + p]);
 		}
+		in += 2 * paletteSize;
+		const uint32_t mask = (1u << bits) - 1u;
+		for (uint32_t i = 0u; i < voxelCount; ++i) {
+			const uint32_t bitIndex = i * bits;
+			voxels[i] = palette[(in[bitIndex >> 3] >> (bitIndex & 7u)) & mask];
+		}
+	} else if (encoding == Encoding::Planes) {
+		if (remaining != 2u * voxelCount) {
+			Log::error("invalid chunk plane data");
+			return false;
+		}
+		for (uint32_t i = 0u; i < voxelCount; ++i) {
+			voxels[i] = voxel::createVoxel((voxel::VoxelType)in[i], in[voxelCount + i]);
+		}
+	} else {
+		Log::error("chunk has an unknown encoding %i", (int)encoding);
+		return false;
 	}
-	return true;
+	return chunk->setData(voxels, voxelCount * sizeof(voxel::Voxel));
 }
 
 }
@@ -9,14 +9,67 @@
 #include "voxel/Region.h"
 #include "core/Zip.h"
 #include "core/ByteStream.h"
+#include "core/String.h"
 #include <memory>
 
 namespace voxelworld {
 
+/**
+ * @brief Serializes the chunks into a compressed and versioned format that is used for the disk, the database and the network
+ *
+ * The chunk voxels are taken in their morton order from the chunk storage. The voxels are stored as one uniform
+ * voxel, as palette with packed indices or as separated material and color planes - whatever is the smallest.
+ */
 class ChunkPersister : public core::IComponent {
+private:
+	int _compressionLevel = core::zip::FastCompressionLevel;
+
+	bool loadVersion1(voxel::PagedVolume::Chunk* chunk, const uint8_t *buf, size_t bufLen, int len) const;
 public:
+	/**
+	 * @brief The version of the compressed chunk format - chunks with an unknown version are not loaded
+	 */
+	static constexpr int Version = 3;
+	/**
+	 * @brief The byte-per-voxel format in x, y, z order that is still supported for loading
+	 */
+	static constexpr int VersionPlain = 1;
+	/**
+	 * @brief The version of the world generation. This must be increased whenever the same seed generates other
+	 * voxels. Stored chunks of other generator versions are not loaded and thus generated again, otherwise they
+	 * wouldn't fit to the new chunks. The formats before version 3 don't store it - they are from generator 1.
+	 * @note The batched noise of @c noise::Noise::fBmRow() gives the same values as the scalar noise - switching
+	 * to it didn't change the generated voxels.
+	 */
+	static constexpr int GeneratorVersion = 1;
+
 	virtual ~ChunkPersister() {}
 
+	/**
+	 * @param[in] level The compression level from 0 (stored) to 9 (best) - see @c core::zip::compress()
+	 */
+	void setCompressionLevel(int level);
+
+	/**
+	 * @brief The entity tag for the compressed chunks that are created now - the chunks only depend on the seed,
+	 * the format version and the generator version
+	 */
+	static core::String etag(unsigned int seed);
+	/**
+	 * @brief The entity tag of an already compressed chunk - derived from the versions in its header
+	 * @param[in] fileLen At least @c ETagHeaderSize bytes are needed for the current format
+	 * @return An empty string if the data is invalid
+	 */
+	static core::String etag(unsigned int seed, const uint8_t *fileBuf, size_t fileLen);
+	/**
+	 * @brief The amount of bytes at the beginning of a compressed chunk that contain the versions
+	 */
+	static constexpr size_t ETagHeaderSize = 6u;
+	/**
+	 * @return The generator version of the given compressed chunk or @c -1 if the data is invalid
+	 */
+	static int generatorVersion(const uint8_t *fileBuf, size_t fileLen);
+
 	virtual bool init() override { return true; };
 	virtual void shutdown() override { };
 
@@ -16,17 +16,49 @@
 
 namespace voxelworld {
 
-static core::String getWorldName(const glm::ivec3& chunkPos, unsigned int seed) {
+core::String FilePersister::chunkFilename(const glm::ivec3& chunkPos, unsigned int seed) {
 	return core::string::format("world_%u_%i_%i_%i.wld", seed, chunkPos.x, chunkPos.y, chunkPos.z);
 }
 
+bool FilePersister::exists(const glm::ivec3& chunkPos, unsigned int seed) const {
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	return filesystem->exists(chunkFilename(chunkPos, seed));
+}
+
+core::String FilePersister::storedETag(const glm::ivec3& chunkPos, unsigned int seed) const {
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	const io::FilePtr& f = filesystem->open(chunkFilename(chunkPos, seed));
+	if (!f->exists()) {
+		return core::String();
+	}
+	// only the header with the versions is read
+	uint8_t header[ETagHeaderSize];
+	const int len = f->read(header, (int)sizeof(header));
+	if (len <= 0) {
+		return core::String();
+	}
+	return etag(seed, header, (size_t)len);
+}
+
+bool FilePersister::write(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t *data, size_t length) {
+	core_trace_scoped(WorldPersisterWrite);
+	const core::String& filename = chunkFilename(chunkPos, seed);
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	if (!filesystem->write(filename, data, length)) {
+		Log::error("Failed to write file %s", filename.c_str());
+		return false;
+	}
+	Log::debug("Wrote file %s (%i)", filename.c_str(), (int)length);
+	return true;
+}
+
 void FilePersister::erase(const voxel::Region& region, unsigned int seed) {
 	core_trace_scoped(WorldPersisterErase);
 #if 0
 	voxel::PagedVolume::ChunkPtr chunk = ctx.getChunk();
 	const io::FilesystemPtr& filesystem = io::filesystem();
 	const voxel::Region& region = ctx.region;
-	const core::String& filename = getWorldName(region, seed);
+	const core::String& filename = chunkFilename(region, seed);
 	// TODO: filesystem->remove(filename);
 #endif
 }
@@ -34,7 +66,7 @@ void FilePersister::erase(const voxel::Region& region, unsigned int seed) {
 bool FilePersister::load(voxel::PagedVolume::Chunk* chunk, unsigned int seed) {
 	core_trace_scoped(WorldPersisterLoad);
 	const io::FilesystemPtr& filesystem = io::filesystem();
-	const core::String& filename = getWorldName(chunk->chunkPos(), seed);
+	const core::String& filename = chunkFilename(chunk->chunkPos(), seed);
 	const io::FilePtr& f = filesystem->open(filename);
 	if (!f->exists()) {
 		return false;
@@ -53,15 +85,7 @@ bool FilePersister::save(voxel::PagedVolume::Chunk* chunk, unsigned int seed) {
 	if (!saveCompressed(chunk, final)) {
 		return false;
 	}
-	const core::String& filename = getWorldName(chunk->chunkPos(), seed);
-	const io::FilesystemPtr& filesystem = io::filesystem();
-
-	if (!filesystem->write(filename, final.getBuffer(), final.getSize())) {
-		Log::error("Failed to write file %s", filename.c_str());
-		return false;
-	}
-	Log::debug("Wrote file %s (%i)", filename.c_str(), (int)final.getSize());
-	return true;
+	return write(chunk->chunkPos(), seed, final.getBuffer(), final.getSize());
 }
 
 }
@@ -16,6 +16,25 @@ class FilePersister : public ChunkPersister {
 public:
 	virtual ~FilePersister() {}
 
+	/**
+	 * @brief The name of the file that the chunk at the given chunk position is stored in
+	 */
+	static core::String chunkFilename(const glm::ivec3& chunkPos, unsigned int seed);
+
+	/**
+	 * @return @c true if the chunk at the given chunk position is stored
+	 */
+	bool exists(const glm::ivec3& chunkPos, unsigned int seed) const;
+	/**
+	 * @brief The entity tag of the stored chunk at the given chunk position - see @c ChunkPersister::etag()
+	 * @return An empty string if the chunk isn't stored
+	 */
+	core::String storedETag(const glm::ivec3& chunkPos, unsigned int seed) const;
+	/**
+	 * @brief Stores the already compressed chunk data - see @c saveCompressed()
+	 */
+	bool write(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t *data, size_t length);
+
 	bool load(voxel::PagedVolume::Chunk* chunk, unsigned int seed) override;
 	bool save(voxel::PagedVolume::Chunk* chunk, unsigned int seed) override;
 	void erase(const voxel::Region& region, unsigned int seed) override;
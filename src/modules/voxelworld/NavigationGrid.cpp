@@ -0,0 +1,660 @@
+/**
+ * @file
+ */
+
+#include "NavigationGrid.h"
+#include "core/Common.h"
+#include "core/Trace.h"
+#include "voxel/Constants.h"
+#include "voxel/Voxel.h"
+#include <algorithm>
+
+namespace voxelworld {
+
+namespace {
+
+constexpr float Sqrt2 = 1.41421356f;
+constexpr int TileSize = NavigationGrid::TileSize;
+constexpr int TileCells = TileSize * TileSize;
+// entrances of runs with at least this length are placed at both ends of the run
+constexpr int LongEntrance = 8;
+
+// -x, +x, -z, +z - the opposite direction is direction ^ 1
+const glm::ivec2 Directions[4] = { glm::ivec2(-1, 0), glm::ivec2(1, 0), glm::ivec2(0, -1), glm::ivec2(0, 1) };
+
+struct HeapEntry {
+	float f;
+	int index;
+
+	inline bool operator<(const HeapEntry& other) const {
+		// std::push_heap builds a max heap
+		return f > other.f;
+	}
+};
+
+inline float octile(int dx, int dz) {
+	dx = glm::abs(dx);
+	dz = glm::abs(dz);
+	const int diagonal = dx < dz ? dx : dz;
+	return (float)(dx + dz) + (Sqrt2 - 2.0f) * (float)diagonal;
+}
+
+/**
+ * @brief The state of the searches of one thread - the generation counters avoid clearing the flat arrays for every search
+ */
+struct SearchState {
+	std::vector<float> g;
+	std::vector<int> parent;
+	std::vector<uint32_t> open;
+	std::vector<uint32_t> closed;
+	std::vector<HeapEntry> heap;
+	uint32_t generation = 0u;
+
+	void begin(size_t size) {
+		if (g.size() < size) {
+			g.resize(size);
+			parent.resize(size);
+			open.resize(size, 0u);
+			closed.resize(size, 0u);
+		}
+		if (++generation == 0u) {
+			std::fill(open.begin(), open.end(), 0u);
+			std::fill(closed.begin(), closed.end(), 0u);
+			generation = 1u;
+		}
+		heap.clear();
+	}
+
+	inline void push(int index, float cost, float f, int from) {
+		g[index] = cost;
+		parent[index] = from;
+		open[index] = generation;
+		heap.push_back(HeapEntry { f, index });
+		std::push_heap(heap.begin(), heap.end());
+	}
+
+	/**
+	 * @return -1 if the open list is empty
+	 */
+	inline int pop() {
+		while (!heap.empty()) {
+			std::pop_heap(heap.begin(), heap.end());
+			const int index = heap.back().index;
+			heap.pop_back();
+			// entries of nodes that were reached on a cheaper path in the meantime are just skipped
+			if (closed[index] != generation) {
+				closed[index] = generation;
+				return index;
+			}
+		}
+		return -1;
+	}
+
+	inline bool isOpen(int index) const {
+		return open[index] == generation;
+	}
+
+	inline bool isClosed(int index) const {
+		return closed[index] == generation;
+	}
+};
+
+SearchState& tileSearch() {
+	thread_local SearchState state;
+	return state;
+}
+
+SearchState& graphSearch() {
+	thread_local SearchState state;
+	return state;
+}
+
+inline bool passable(const int16_t* heights, const bool* walkable, int from, int to) {
+	return walkable[to] && glm::abs(heights[to] - heights[from]) <= NavigationGrid::MaxStepHeight;
+}
+
+/**
+ * @brief Searches inside of one tile with 8 neighbours - diagonal moves are only allowed if both
+ * orthogonal moves are possible, too.
+ * @param[in] to The target cell index or @c -1 to reach all cells (Dijkstra)
+ * @return @c true if the target was reached - the state is left in @c tileSearch()
+ */
+bool search(const int16_t* heights, const bool* walkable, int from, int to) {
+	SearchState& state = tileSearch();
+	state.begin(TileCells);
+	const int toX = to & (TileSize - 1);
+	const int toZ = to >> NavigationGrid::TileShift;
+	state.push(from, 0.0f, 0.0f, -1);
+	for (;;) {
+		const int index = state.pop();
+		if (index == -1) {
+			return false;
+		}
+		if (index == to) {
+			return true;
+		}
+		const int x = index & (TileSize - 1);
+		const int z = index >> NavigationGrid::TileShift;
+		for (int dz = -1; dz <= 1; ++dz) {
+			const int nz = z + dz;
+			if (nz < 0 || nz >= TileSize) {
+				continue;
+			}
+			for (int dx = -1; dx <= 1; ++dx) {
+				const int nx = x + dx;
+				if ((dx == 0 && dz == 0) || nx < 0 || nx >= TileSize) {
+					continue;
+				}
+				const int n = nz * TileSize + nx;
+				if (state.isClosed(n) || !passable(heights, walkable, index, n)) {
+					continue;
+				}
+				const bool diagonal = dx != 0 && dz != 0;
+				if (diagonal && (!passable(heights, walkable, index, z * TileSize + nx) || !passable(heights, walkable, index, nz * TileSize + x))) {
+					continue;
+				}
+				const float cost = state.g[index] + (diagonal ? Sqrt2 : 1.0f);
+				if (state.isOpen(n) && cost >= state.g[n]) {
+					continue;
+				}
+				const float h = to == -1 ? 0.0f : octile(toX - nx, toZ - nz);
+				state.push(n, cost, cost + h, index);
+			}
+		}
+	}
+}
+
+}
+
+NavigationGrid::NavigationGrid() :
+		_lock("NavigationGrid") {
+}
+
+NavigationGrid::Tile* NavigationGrid::tile(int tileX, int tileZ) const {
+	auto i = _tiles.find(tileKey(tileX, tileZ));
+	if (i == _tiles.end()) {
+		return nullptr;
+	}
+	return i->second.get();
+}
+
+NavigationGrid::Tile* NavigationGrid::tileForCell(int x, int z) const {
+	return tile(x >> TileShift, z >> TileShift);
+}
+
+NavigationGrid::Tile* NavigationGrid::neighbour(const Tile& t, int direction) const {
+	const glm::ivec2 pos = t.pos + Directions[direction];
+	return tile(pos.x, pos.y);
+}
+
+glm::ivec3 NavigationGrid::worldPos(const Tile& t, const glm::ivec2& cell) const {
+	const int index = (cell.y & (TileSize - 1)) * TileSize + (cell.x & (TileSize - 1));
+	return glm::ivec3(cell.x, t.heights[index], cell.y);
+}
+
+int NavigationGrid::allocNode(const glm::ivec2& cell, Tile* t) {
+	int id;
+	if (_freeNodes.empty()) {
+		id = (int)_nodes.size();
+		_nodes.emplace_back();
+	} else {
+		id = _freeNodes.back();
+		_freeNodes.pop_back();
+	}
+	Node& node = _nodes[id];
+	node.cell = cell;
+	node.tile = t;
+	node.partner = -1;
+	node.edges.clear();
+	return id;
+}
+
+void NavigationGrid::freeNodes(std::vector<int>& nodes) {
+	for (int id : nodes) {
+		Node& node = _nodes[id];
+		node.tile = nullptr;
+		node.partner = -1;
+		node.edges.clear();
+		_freeNodes.push_back(id);
+	}
+	nodes.clear();
+}
+
+void NavigationGrid::update(const voxel::PagedVolume::Chunk& chunk, const glm::ivec3& mins) {
+	core_trace_scoped(NavigationGridUpdate);
+	const int sideLength = chunk.sideLength();
+	thread_local std::vector<int16_t> heights;
+	thread_local std::vector<uint8_t> walkable;
+
+	// the floors of the chunk columns are computed outside of the lock - directly from the chunk storage, a copy
+	// of the voxels would need the memory of a raw chunk per paging thread
+	heights.resize(sideLength * sideLength);
+	walkable.resize(sideLength * sideLength);
+	const bool uniform = chunk.representation() == voxel::PagedVolume::Chunk::Representation::Uniform;
+	for (int z = 0; z < sideLength; ++z) {
+		for (int x = 0; x < sideLength; ++x) {
+			if (uniform && (x | z) != 0) {
+				// all columns of a uniform chunk share the floor of the first one
+				heights[z * sideLength + x] = heights[0];
+				walkable[z * sideLength + x] = walkable[0];
+				continue;
+			}
+			int16_t height = Unknown;
+			bool floor = false;
+			for (int y = sideLength - 1; y >= 0; --y) {
+				const voxel::VoxelType material = chunk.voxel(x, y, z).getMaterial();
+				if (!voxel::isEnterable(material)) {
+					height = (int16_t)(mins.y + y + 1);
+					floor = voxel::isFloor(material);
+					break;
+				}
+			}
+			heights[z * sideLength + x] = height;
+			walkable[z * sideLength + x] = floor;
+		}
+	}
+
+	core::ScopedWriteLock lock(_lock);
+	for (int z = 0; z < sideLength; ++z) {
+		for (int x = 0; x < sideLength; ++x) {
+			const int16_t height = heights[z * sideLength + x];
+			if (height == Unknown) {
+				continue;
+			}
+			const int worldX = mins.x + x;
+			const int worldZ = mins.z + z;
+			const int tileX = worldX >> TileShift;
+			const int tileZ = worldZ >> TileShift;
+			std::unique_ptr<Tile>& entry = _tiles[tileKey(tileX, tileZ)];
+			if (!entry) {
+				entry.reset(new Tile());
+				entry->pos = glm::ivec2(tileX, tileZ);
+				std::fill_n(entry->heights, TileCells, Unknown);
+				std::fill_n(entry->walkable, TileCells, false);
+			}
+			Tile& t = *entry;
+			// the chunks of one column are paged in in any order - the topmost floor wins
+			const int index = (worldZ & (TileSize - 1)) * TileSize + (worldX & (TileSize - 1));
+			if (height <= t.heights[index]) {
+				continue;
+			}
+			t.heights[index] = height;
+			t.walkable[index] = walkable[z * sideLength + x] != 0u;
+			markDirty(t);
+		}
+	}
+}
+
+void NavigationGrid::markDirty(Tile& t) {
+	if (t.dirty) {
+		return;
+	}
+	t.dirty = true;
+	_dirtyTiles.push_back(&t);
+}
+
+void NavigationGrid::eraseTile(Tile& t) {
+	for (int direction = 0; direction < 4; ++direction) {
+		freeNodes(t.nodes[direction]);
+		Tile* other = neighbour(t, direction);
+		if (other == nullptr) {
+			continue;
+		}
+		// the partners of these entrances are gone
+		freeNodes(other->nodes[direction ^ 1]);
+		markDirty(*other);
+	}
+	if (t.dirty) {
+		_dirtyTiles.erase(std::find(_dirtyTiles.begin(), _dirtyTiles.end(), &t));
+	}
+	_tiles.erase(tileKey(t.pos.x, t.pos.y));
+}
+
+void NavigationGrid::remove(const glm::ivec3& mins, int sideLength) {
+	core_trace_scoped(NavigationGridRemove);
+	// the floors that the update of this chunk found - a floor on the top voxel layer is one above the chunk
+	const int minHeight = mins.y + 1;
+	const int maxHeight = mins.y + sideLength;
+	core::ScopedWriteLock lock(_lock);
+	for (int tileZ = mins.z >> TileShift; tileZ <= (mins.z + sideLength - 1) >> TileShift; ++tileZ) {
+		for (int tileX = mins.x >> TileShift; tileX <= (mins.x + sideLength - 1) >> TileShift; ++tileX) {
+			Tile* t = tile(tileX, tileZ);
+			if (t == nullptr) {
+				continue;
+			}
+			const glm::ivec2 base = t->pos * TileSize;
+			const int minX = core_max(mins.x, base.x);
+			const int maxX = core_min(mins.x + sideLength, base.x + TileSize);
+			const int minZ = core_max(mins.z, base.y);
+			const int maxZ = core_min(mins.z + sideLength, base.y + TileSize);
+			for (int z = minZ; z < maxZ; ++z) {
+				for (int x = minX; x < maxX; ++x) {
+					const int index = (z & (TileSize - 1)) * TileSize + (x & (TileSize - 1));
+					const int16_t height = t->heights[index];
+					if (height < minHeight || height > maxHeight) {
+						continue;
+					}
+					// the floors of the chunks below are not known anymore - the column is unknown until the
+					// chunk is paged in again
+					t->heights[index] = Unknown;
+					t->walkable[index] = false;
+					markDirty(*t);
+				}
+			}
+			if (std::find_if(t->heights, t->heights + TileCells, [] (int16_t height) { return height != Unknown; }) == t->heights + TileCells) {
+				eraseTile(*t);
+			}
+		}
+	}
+}
+
+void NavigationGrid::clear() {
+	core::ScopedWriteLock lock(_lock);
+	_tiles.clear();
+	_dirtyTiles.clear();
+	_nodes.clear();
+	_freeNodes.clear();
+}
+
+int NavigationGrid::floor(int x, int z) const {
+	core::ScopedReadLock lock(_lock);
+	const Tile* t = tileForCell(x, z);
+	if (t == nullptr) {
+		return voxel::NO_FLOOR_FOUND;
+	}
+	const int index = (z & (TileSize - 1)) * TileSize + (x & (TileSize - 1));
+	if (!t->walkable[index]) {
+		return voxel::NO_FLOOR_FOUND;
+	}
+	return t->heights[index];
+}
+
+void NavigationGrid::rebuildBorder(Tile& t, int direction) {
+	freeNodes(t.nodes[direction]);
+	Tile* other = neighbour(t, direction);
+	if (other == nullptr) {
+		return;
+	}
+	const int opposite = direction ^ 1;
+	freeNodes(other->nodes[opposite]);
+
+	// the local cell index of the i-th cell on the border in the given direction
+	auto borderCell = [] (int dir, int i) {
+		switch (dir) {
+		case 0:
+			return i * TileSize;
+		case 1:
+			return i * TileSize + TileSize - 1;
+		case 2:
+			return i;
+		default:
+			return (TileSize - 1) * TileSize + i;
+		}
+	};
+	auto addEntrance = [&] (int i) {
+		const int a = borderCell(direction, i);
+		const int b = borderCell(opposite, i);
+		const glm::ivec2 base = t.pos * TileSize;
+		const glm::ivec2 otherBase = other->pos * TileSize;
+		const int na = allocNode(base + glm::ivec2(a & (TileSize - 1), a >> TileShift), &t);
+		const int nb = allocNode(otherBase + glm::ivec2(b & (TileSize - 1), b >> TileShift), other);
+		_nodes[na].partner = nb;
+		_nodes[nb].partner = na;
+		t.nodes[direction].push_back(na);
+		other->nodes[opposite].push_back(nb);
+	};
+
+	int runStart = -1;
+	for (int i = 0; i <= TileSize; ++i) {
+		bool open = false;
+		if (i < TileSize) {
+			const int a = borderCell(direction, i);
+			const int b = borderCell(opposite, i);
+			open = t.walkable[a] && other->walkable[b] && glm::abs(t.heights[a] - other->heights[b]) <= MaxStepHeight;
+		}
+		if (open) {
+			if (runStart == -1) {
+				runStart = i;
+			}
+			continue;
+		}
+		if (runStart == -1) {
+			continue;
+		}
+		const int runEnd = i - 1;
+		if (runEnd - runStart + 1 >= LongEntrance) {
+			addEntrance(runStart);
+			addEntrance(runEnd);
+		} else {
+			addEntrance((runStart + runEnd) / 2);
+		}
+		runStart = -1;
+	}
+}
+
+void NavigationGrid::floodTile(const Tile& t, const glm::ivec2& from, const std::vector<int>& nodes, std::vector<float>& costs) const {
+	costs.clear();
+	const int fromIndex = (from.y & (TileSize - 1)) * TileSize + (from.x & (TileSize - 1));
+	search(t.heights, t.walkable, fromIndex, -1);
+	const SearchState& state = tileSearch();
+	for (int id : nodes) {
+		const glm::ivec2& cell = _nodes[id].cell;
+		const int index = (cell.y & (TileSize - 1)) * TileSize + (cell.x & (TileSize - 1));
+		costs.push_back(state.isClosed(index) ? state.g[index] : -1.0f);
+	}
+}
+
+void NavigationGrid::rebuildEdges(Tile& t) {
+	thread_local std::vector<int> nodes;
+	thread_local std::vector<float> costs;
+	nodes.clear();
+	for (int direction = 0; direction < 4; ++direction) {
+		nodes.insert(nodes.end(), t.nodes[direction].begin(), t.nodes[direction].end());
+	}
+	for (int id : nodes) {
+		_nodes[id].edges.clear();
+	}
+	// one flood fill per entrance instead of one search per pair of entrances
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		floodTile(t, _nodes[nodes[i]].cell, nodes, costs);
+		for (size_t j = 0; j < nodes.size(); ++j) {
+			if (i != j && costs[j] >= 0.0f) {
+				_nodes[nodes[i]].edges.push_back(Edge { nodes[j], costs[j] });
+			}
+		}
+	}
+}
+
+void NavigationGrid::rebuild() {
+	if (_dirtyTiles.empty()) {
+		return;
+	}
+	core_trace_scoped(NavigationGridRebuild);
+	for (Tile* t : _dirtyTiles) {
+		for (int direction = 0; direction < 4; ++direction) {
+			rebuildBorder(*t, direction);
+		}
+	}
+	// the entrances of the neighbours changed, too
+	++_rebuildStamp;
+	std::vector<Tile*> affected;
+	for (Tile* t : _dirtyTiles) {
+		t->dirty = false;
+		if (t->rebuildStamp != _rebuildStamp) {
+			t->rebuildStamp = _rebuildStamp;
+			affected.push_back(t);
+		}
+		for (int direction = 0; direction < 4; ++direction) {
+			Tile* other = neighbour(*t, direction);
+			if (other != nullptr && other->rebuildStamp != _rebuildStamp) {
+				other->rebuildStamp = _rebuildStamp;
+				affected.push_back(other);
+			}
+		}
+	}
+	_dirtyTiles.clear();
+	for (Tile* t : affected) {
+		rebuildEdges(*t);
+	}
+}
+
+float NavigationGrid::searchTile(const Tile& t, const glm::ivec2& from, const glm::ivec2& to, std::vector<glm::ivec3>* path) const {
+	const int fromIndex = (from.y & (TileSize - 1)) * TileSize + (from.x & (TileSize - 1));
+	const int toIndex = (to.y & (TileSize - 1)) * TileSize + (to.x & (TileSize - 1));
+	if (!t.walkable[fromIndex] || !t.walkable[toIndex]) {
+		return -1.0f;
+	}
+	if (fromIndex == toIndex) {
+		return 0.0f;
+	}
+	if (!search(t.heights, t.walkable, fromIndex, toIndex)) {
+		return -1.0f;
+	}
+	const SearchState& state = tileSearch();
+	if (path != nullptr) {
+		const size_t first = path->size();
+		const glm::ivec2 base = t.pos * TileSize;
+		for (int index = toIndex; index != fromIndex; index = state.parent[index]) {
+			const glm::ivec2 cell = base + glm::ivec2(index & (TileSize - 1), index >> TileShift);
+			path->push_back(glm::ivec3(cell.x, t.heights[index], cell.y));
+		}
+		std::reverse(path->begin() + first, path->end());
+	}
+	return state.g[toIndex];
+}
+
+bool NavigationGrid::searchGraph(const Tile& startTile, const glm::ivec2& start, const Tile& endTile, const glm::ivec2& end, std::vector<int>& nodes) const {
+	thread_local std::vector<int> tileNodes;
+	thread_local std::vector<float> startCosts;
+	thread_local std::vector<int> endNodes;
+	thread_local std::vector<float> endCosts;
+	thread_local std::vector<float> endCostByNode;
+
+	const int startId = (int)_nodes.size();
+	const int endId = startId + 1;
+
+	// connect the start and the end to the entrances of their tiles
+	tileNodes.clear();
+	for (int direction = 0; direction < 4; ++direction) {
+		tileNodes.insert(tileNodes.end(), startTile.nodes[direction].begin(), startTile.nodes[direction].end());
+	}
+	floodTile(startTile, start, tileNodes, startCosts);
+	endNodes.clear();
+	for (int direction = 0; direction < 4; ++direction) {
+		endNodes.insert(endNodes.end(), endTile.nodes[direction].begin(), endTile.nodes[direction].end());
+	}
+	floodTile(endTile, end, endNodes, endCosts);
+	endCostByNode.assign(_nodes.size(), -1.0f);
+	for (size_t i = 0; i < endNodes.size(); ++i) {
+		endCostByNode[endNodes[i]] = endCosts[i];
+	}
+
+	SearchState& state = graphSearch();
+	state.begin(_nodes.size() + 2);
+	state.push(startId, 0.0f, octile(end.x - start.x, end.y - start.y), -1);
+	auto relax = [&] (int from, int to, float edgeCost) {
+		if (state.isClosed(to)) {
+			return;
+		}
+		const float cost = state.g[from] + edgeCost;
+		if (state.isOpen(to) && cost >= state.g[to]) {
+			return;
+		}
+		const glm::ivec2& cell = to == endId ? end : _nodes[to].cell;
+		state.push(to, cost, cost + octile(end.x - cell.x, end.y - cell.y), from);
+	};
+	for (;;) {
+		const int id = state.pop();
+		if (id == -1) {
+			return false;
+		}
+		if (id == endId) {
+			break;
+		}
+		if (id == startId) {
+			for (size_t i = 0; i < tileNodes.size(); ++i) {
+				if (startCosts[i] >= 0.0f) {
+					relax(id, tileNodes[i], startCosts[i]);
+				}
+			}
+			continue;
+		}
+		const Node& node = _nodes[id];
+		if (node.partner != -1) {
+			relax(id, node.partner, 1.0f);
+		}
+		for (const Edge& edge : node.edges) {
+			relax(id, edge.node, edge.cost);
+		}
+		if (endCostByNode[id] >= 0.0f) {
+			relax(id, endId, endCostByNode[id]);
+		}
+	}
+
+	nodes.clear();
+	for (int id = endId; id != -1; id = state.parent[id]) {
+		nodes.push_back(id);
+	}
+	std::reverse(nodes.begin(), nodes.end());
+	return true;
+}
+
+bool NavigationGrid::findPath(const glm::ivec3& start, const glm::ivec3& end, std::vector<glm::ivec3>& path) {
+	core_trace_scoped(NavigationGridFindPath);
+	path.clear();
+	{
+		core::ScopedWriteLock lock(_lock);
+		rebuild();
+	}
+	core::ScopedReadLock lock(_lock);
+	const glm::ivec2 from(start.x, start.z);
+	const glm::ivec2 to(end.x, end.z);
+	const Tile* startTile = tileForCell(from.x, from.y);
+	const Tile* endTile = tileForCell(to.x, to.y);
+	if (startTile == nullptr || endTile == nullptr) {
+		return false;
+	}
+	path.push_back(worldPos(*startTile, from));
+	// most queries are short - try to stay inside of the tile before the abstract graph is searched
+	if (startTile == endTile && searchTile(*startTile, from, to, &path) >= 0.0f) {
+		return true;
+	}
+	thread_local std::vector<int> nodes;
+	if (!searchGraph(*startTile, from, *endTile, to, nodes)) {
+		path.clear();
+		return false;
+	}
+
+	// refine the abstract path - the first entry is the start, the last one the end
+	const int endId = (int)_nodes.size() + 1;
+	glm::ivec2 cell = from;
+	const Tile* current = startTile;
+	for (size_t i = 1; i < nodes.size(); ++i) {
+		const bool isEnd = nodes[i] == endId;
+		const glm::ivec2& next = isEnd ? to : _nodes[nodes[i]].cell;
+		const Tile* nextTile = isEnd ? endTile : _nodes[nodes[i]].tile;
+		if (nextTile != current) {
+			// the step over the border to the partner entrance
+			path.push_back(worldPos(*nextTile, next));
+		} else if (searchTile(*current, cell, next, &path) < 0.0f) {
+			path.clear();
+			return false;
+		}
+		cell = next;
+		current = nextTile;
+	}
+	return true;
+}
+
+int NavigationGrid::nodes() {
+	core::ScopedWriteLock lock(_lock);
+	rebuild();
+	return (int)(_nodes.size() - _freeNodes.size());
+}
+
+int NavigationGrid::tiles() const {
+	core::ScopedReadLock lock(_lock);
+	return (int)_tiles.size();
+}
+
+}
@@ -0,0 +1,163 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "voxel/PagedVolume.h"
+#include "core/concurrent/ReadWriteLock.h"
+#include "core/NonCopyable.h"
+#include "core/GLM.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace voxelworld {
+
+/**
+ * @brief Walkable 2.5D heightfield of the paged in chunks with a hierarchical (HPA*) path search on top
+ *
+ * Each column of the world has one floor - the air voxel above the topmost solid voxel. The columns are
+ * grouped into square tiles (the clusters). Neighbouring walkable cells on the border of two tiles are
+ * connected by entrances, and the entrances of one tile are connected by the costs of the path inside
+ * the tile. A path query first searches this abstract graph and afterwards refines it tile by tile.
+ *
+ * The heightfield is updated by the pager when chunks are paged in or out - the path queries never touch the
+ * voxels. The abstract graph of the changed tiles is rebuilt with the next query.
+ *
+ * @note All functions are thread safe.
+ */
+class NavigationGrid : public core::NonCopyable {
+public:
+	static constexpr int TileShift = 5;
+	/**
+	 * @brief The side length of the tiles (clusters) in voxels
+	 */
+	static constexpr int TileSize = 1 << TileShift;
+	/**
+	 * @brief The height difference between two neighbouring columns that can still be walked
+	 */
+	static constexpr int MaxStepHeight = 1;
+
+private:
+	static constexpr int TileCells = TileSize * TileSize;
+	static constexpr int16_t Unknown = -1;
+
+	struct Edge {
+		int node;
+		float cost;
+	};
+
+	struct Tile;
+
+	/**
+	 * @brief An entrance cell on the border of a tile - the partner is the cell on the other side of the border
+	 */
+	struct Node {
+		glm::ivec2 cell { 0 };
+		Tile* tile = nullptr;
+		int partner = -1;
+		// the paths to the other entrances of the same tile
+		std::vector<Edge> edges;
+	};
+
+	struct Tile {
+		glm::ivec2 pos { 0 };
+		int16_t heights[TileCells];
+		bool walkable[TileCells];
+		// the entrance nodes on the border to the -x, +x, -z and +z neighbours
+		std::vector<int> nodes[4];
+		bool dirty = false;
+		uint32_t rebuildStamp = 0u;
+	};
+
+	mutable core::ReadWriteLock _lock;
+	std::unordered_map<int64_t, std::unique_ptr<Tile>> _tiles;
+	std::vector<Tile*> _dirtyTiles;
+	std::vector<Node> _nodes;
+	std::vector<int> _freeNodes;
+	uint32_t _rebuildStamp = 0u;
+
+	static inline int64_t tileKey(int tileX, int tileZ) {
+		return ((int64_t)tileX << 32) | (uint32_t)tileZ;
+	}
+
+	Tile* tile(int tileX, int tileZ) const;
+	Tile* tileForCell(int x, int z) const;
+	Tile* neighbour(const Tile& tile, int direction) const;
+
+	int allocNode(const glm::ivec2& cell, Tile* tile);
+	void freeNodes(std::vector<int>& nodes);
+	void markDirty(Tile& tile);
+	/**
+	 * @brief Removes the tile and its entrances - the entrances of the neighbours are rebuilt with the next query
+	 */
+	void eraseTile(Tile& tile);
+
+	void rebuild();
+	/**
+	 * @brief Creates the entrances to the neighbour tile in the given direction
+	 */
+	void rebuildBorder(Tile& tile, int direction);
+	/**
+	 * @brief Connects all entrances of the given tile by the paths inside the tile
+	 */
+	void rebuildEdges(Tile& tile);
+
+	/**
+	 * @brief A* search that doesn't leave the given tile
+	 * @param[in] from, to World cell coordinates inside the tile
+	 * @param[out] path The floor positions of the path - excluding the start cell. Might be @c nullptr.
+	 * @return The costs of the path or a negative value if there is no path
+	 */
+	float searchTile(const Tile& tile, const glm::ivec2& from, const glm::ivec2& to, std::vector<glm::ivec3>* path) const;
+	/**
+	 * @brief Dijkstra search from the given cell to all reachable cells of the tile
+	 * @param[out] costs The costs to the given entrance nodes - negative values for unreachable nodes
+	 */
+	void floodTile(const Tile& tile, const glm::ivec2& from, const std::vector<int>& nodes, std::vector<float>& costs) const;
+	/**
+	 * @param[out] nodes The entrance nodes of the path - the first and last entry are the start and end pseudo nodes
+	 */
+	bool searchGraph(const Tile& startTile, const glm::ivec2& start, const Tile& endTile, const glm::ivec2& end, std::vector<int>& nodes) const;
+	glm::ivec3 worldPos(const Tile& tile, const glm::ivec2& cell) const;
+
+public:
+	NavigationGrid();
+
+	/**
+	 * @brief Updates the floor heights of all columns of the chunk
+	 * @param[in] mins The world position of the lower corner of the chunk
+	 */
+	void update(const voxel::PagedVolume::Chunk& chunk, const glm::ivec3& mins);
+	/**
+	 * @brief Forgets the floors that were found in the given chunk - tiles without any known column are removed
+	 * @param[in] mins The world position of the lower corner of the chunk
+	 */
+	void remove(const glm::ivec3& mins, int sideLength);
+	void clear();
+
+	/**
+	 * @return The y component of the walkable floor of the column - or @c voxel::NO_FLOOR_FOUND if the column
+	 * isn't paged in or not walkable.
+	 */
+	int floor(int x, int z) const;
+
+	/**
+	 * @brief Searches a path over the walkable floor from the start column to the end column
+	 * @note The y components of @c start and @c end are ignored - the floors of the columns are used.
+	 * @param[out] path The floor positions of the path - including the start and the end position
+	 * @return @c false if no path was found
+	 */
+	bool findPath(const glm::ivec3& start, const glm::ivec3& end, std::vector<glm::ivec3>& path);
+
+	/**
+	 * @return The amount of entrance nodes in the abstract graph - the graph is rebuilt if needed
+	 */
+	int nodes();
+	int tiles() const;
+};
+
+typedef std::shared_ptr<NavigationGrid> NavigationGridPtr;
+
+}
@@ -55,6 +55,12 @@ void WorldMgr::shutdown() {
 	_volumeData = nullptr;
 }
 
+int WorldMgr::prefetch(const glm::ivec3& position, int radius) const {
+	// always page in the full columns - there is nothing below 0 or above the max height
+	const voxel::Region region(position.x - radius, 0, position.z - radius, position.x + radius, voxel::MAX_HEIGHT - 1, position.z + radius);
+	return _volumeData->prefetch(region);
+}
+
 int WorldMgr::findWalkableFloor(const glm::ivec3& position, int maxDistanceY) const {
 	voxel::PagedVolume::Sampler sampler(_volumeData);
 	sampler.setPosition(position);
@@ -48,7 +48,7 @@ public:
 			if (check(sampler.voxel().getMaterial())) {
 				return sampler.position().y;
 			}
-			sampler.movePositiveY();
+			sampler.moveNegativeY();
 		}
 		return voxel::NO_FLOOR_FOUND;
 	}
@@ -58,6 +58,12 @@ public:
 	 */
 	int findWalkableFloor(const glm::ivec3& position, int maxDistanceY = voxel::MAX_HEIGHT) const;
 
+	/**
+	 * @brief Schedules the asynchronous paging of all chunk columns in the given radius around the given position
+	 * @return The amount of chunks that were scheduled for paging
+	 */
+	int prefetch(const glm::ivec3& position, int radius) const;
+
 	bool init(uint32_t volumeMemoryMegaBytes = 512, uint16_t chunkSideLength = 256);
 	void shutdown();
 	void reset();
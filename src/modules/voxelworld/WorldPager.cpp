@@ -2,11 +2,11 @@
  * @file
  */
 #include "WorldPager.h"
+#include "NavigationGrid.h"
 #include "math/Random.h"
 #include "core/ArrayLength.h"
 #include "voxel/PagedVolumeWrapper.h"
 #include "voxelutil/Raycast.h"
-#include "noise/Simplex.h"
 #include "core/Common.h"
 #include "core/StringUtil.h"
 #include "core/collection/Array.h"
@@ -27,6 +27,9 @@ bool WorldPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 		return false;
 	}
 	if (_chunkPersister->load(pctx.chunk.get(), _seed)) {
+		if (_navigationGrid != nullptr) {
+			_navigationGrid->update(*pctx.chunk.get(), pctx.region.getLowerCorner());
+		}
 		return false;
 	}
 	voxel::PagedVolumeWrapper wrapper(_volumeData, pctx.chunk, pctx.region);
@@ -37,6 +40,9 @@ bool WorldPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 	placeTrees(pctx);
 	_chunkPersister->save(pctx.chunk.get(), _seed);
 	//}
+	if (_navigationGrid != nullptr) {
+		_navigationGrid->update(*pctx.chunk.get(), pctx.region.getLowerCorner());
+	}
 	return true;
 }
 
@@ -44,6 +50,23 @@ void WorldPager::pageOut(voxel::PagedVolume::Chunk* chunk) {
 	// currently chunks are not modifiable and are saved directly after creating the chunk
 }
 
+void WorldPager::pageRestored(voxel::PagedVolume::PagerContext& pctx) {
+	if (_navigationGrid != nullptr) {
+		_navigationGrid->update(*pctx.chunk.get(), pctx.region.getLowerCorner());
+	}
+}
+
+void WorldPager::pageEvicted(voxel::PagedVolume::Chunk* chunk) {
+	if (_navigationGrid != nullptr) {
+		const int sideLength = chunk->sideLength();
+		_navigationGrid->remove(chunk->chunkPos() * sideLength, sideLength);
+	}
+}
+
+void WorldPager::setNavigationGrid(NavigationGrid* navigationGrid) {
+	_navigationGrid = navigationGrid;
+}
+
 void WorldPager::setSeed(unsigned int seed) {
 	_seed = seed;
 }
@@ -98,44 +121,72 @@ void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume) const {
 	const int size = 2;
 	core_assert(depth % size == 0);
 	core_assert(width % size == 0);
-	for (int z = lowerZ; z < lowerZ + depth; z += size) {
-		for (int x = lowerX; x < lowerX + width; x += size) {
-			const int ni = fillVoxels(x, minsY, z, voxels);
-			volume.setVoxels(x, minsY, z, size, size, voxels, ni);
+	const int columnsX = width / size;
+	const int columnsZ = depth / size;
+
+	// the terrain noise of all columns of the chunk is generated in one step
+	std::vector<float> heightmap(columnsX * columnsZ);
+	for (int z = 0; z < columnsZ; ++z) {
+		getNoiseValues(lowerX, lowerZ + z * size, columnsX, size, &heightmap[z * columnsX]);
+	}
+	for (int z = 0; z < columnsZ; ++z) {
+		for (int x = 0; x < columnsX; ++x) {
+			const int worldX = lowerX + x * size;
+			const int worldZ = lowerZ + z * size;
+			const int ni = fillVoxels(worldX, minsY, worldZ, heightmap[z * columnsX + x], voxels);
+			volume.setVoxels(worldX, minsY, worldZ, size, size, voxels, ni);
 			core_memset(voxels, 0, ni * sizeof(voxel::Voxel));
 		}
 	}
 }
 
-float WorldPager::getNoiseValue(float x, float z) const {
-	const glm::vec2 noisePos2d(_noiseSeedOffset.x + x, _noiseSeedOffset.y + z);
-	// TODO: move the noise settings into the biome
-	const float landscapeNoise = noise::fBm(noisePos2d * _worldCtx.landscapeNoiseFrequency, _worldCtx.landscapeNoiseOctaves,
-			_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
-	const float noiseNormalized = noise::norm(landscapeNoise);
-	const float mountainNoise = noise::fBm(noisePos2d * _worldCtx.mountainNoiseFrequency, _worldCtx.mountainNoiseOctaves,
-			_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
-	const float mountainNoiseNormalized = noise::norm(mountainNoise);
-	const float mountainMultiplier = mountainNoiseNormalized * (mountainNoiseNormalized + 0.5f);
-	const float n = glm::clamp(noiseNormalized * mountainMultiplier, 0.0f, 1.0f);
-	return n;
+void WorldPager::getNoiseValues(int x, int z, int amount, int step, float* n) const {
+	constexpr int batchSize = 64;
+	float mountainNoise[batchSize];
+	const glm::vec2 delta((float)step, 0.0f);
+	for (int i = 0; i < amount; i += batchSize) {
+		const int columns = core_min(batchSize, amount - i);
+		const glm::vec2 noisePos2d((float)(x + i * step), (float)z);
+		float* landscapeNoise = n + i;
+		// TODO: move the noise settings into the biome
+		_noise.fBmRow(landscapeNoise, columns, _noiseSeedOffset, noisePos2d, delta, _worldCtx.landscapeNoiseFrequency, _worldCtx.landscapeNoiseOctaves,
+				_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
+		_noise.fBmRow(mountainNoise, columns, _noiseSeedOffset, noisePos2d, delta, _worldCtx.mountainNoiseFrequency, _worldCtx.mountainNoiseOctaves,
+				_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
+		for (int c = 0; c < columns; ++c) {
+			const float noiseNormalized = noise::norm(landscapeNoise[c]);
+			const float mountainNoiseNormalized = noise::norm(mountainNoise[c]);
+			const float mountainMultiplier = mountainNoiseNormalized * (mountainNoiseNormalized + 0.5f);
+			landscapeNoise[c] = glm::clamp(noiseNormalized * mountainMultiplier, 0.0f, 1.0f);
+		}
+	}
 }
 
-float WorldPager::getDensity(float x, float y, float z, float n) const {
-	const glm::vec3 noisePos3d(_noiseSeedOffset.x + x, y, _noiseSeedOffset.y + z);
+void WorldPager::getDensity(int x, int minsY, int z, int height, float n, float* density) const {
+	const int amount = height - (minsY + 1);
+	if (amount <= 0) {
+		return;
+	}
+	core_assert(height <= voxel::MAX_TERRAIN_HEIGHT);
+	const glm::vec3 noiseOffset(_noiseSeedOffset.x, 0.0f, _noiseSeedOffset.y);
+	const glm::vec3 noisePos3d((float)x, (float)(minsY + 1), (float)z);
+	float* columnDensity = density + minsY + 1;
 	// TODO: move the noise settings into the biome
-	const float noiseVal = noise::norm(
-			noise::fBm(noisePos3d * _worldCtx.caveNoiseFrequency, _worldCtx.caveNoiseOctaves, _worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain));
-	const float finalDensity = n + noiseVal;
-	return finalDensity;
+	_noise.fBmRow(columnDensity, amount, noiseOffset, noisePos3d, glm::vec3(0.0f, 1.0f, 0.0f), _worldCtx.caveNoiseFrequency, _worldCtx.caveNoiseOctaves,
+			_worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain);
+	for (int i = 0; i < amount; ++i) {
+		columnDensity[i] = n + noise::norm(columnDensity[i]);
+	}
 }
 
 int WorldPager::terrainHeight(int x, int y, int z) const {
-	const float n = getNoiseValue(x, z);
-	return terrainHeight(x, y, z, n);
+	float n;
+	getNoiseValues(x, z, 1, 1, &n);
+	float density[voxel::MAX_TERRAIN_HEIGHT];
+	return terrainHeight(x, y, z, n, density);
 }
 
-int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
+int WorldPager::terrainHeight(int x, int minsY, int z, float n, float* density) const {
 	const int maxHeight = voxel::MAX_TERRAIN_HEIGHT - 1;
 	int centerHeight;
 	// the center of a city should make the terrain more even
@@ -147,9 +198,10 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 	} else {
 		ni = n * maxHeight;
 	}
+	// the whole column is evaluated at once - the voxels are filled with the same density values
+	getDensity(x, minsY, z, ni, n, density);
 	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
-		if (density > _worldCtx.caveDensityThreshold) {
+		if (density[y] > _worldCtx.caveDensityThreshold) {
 			break;
 		}
 		--ni;
@@ -157,9 +209,9 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 	return ni;
 }
 
-int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const {
-	const float n = getNoiseValue(x, z);
-	const int ni = terrainHeight(x, minsY, z, n);
+int WorldPager::fillVoxels(int x, int minsY, int z, float n, voxel::Voxel* voxels) const {
+	float density[voxel::MAX_TERRAIN_HEIGHT];
+	const int ni = terrainHeight(x, minsY, z, n, density);
 	if (ni < minsY) {
 		return 0;
 	}
@@ -171,8 +223,7 @@ int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const
 	voxels[0] = dirt;
 	glm::ivec3 pos(x, 0, z);
 	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
-		if (density > _worldCtx.caveDensityThreshold) {
+		if (density[y] > _worldCtx.caveDensityThreshold) {
 			const bool cave = y < ni - 1;
 			pos.y = y;
 			const voxel::Voxel& voxel = _biomeManager.getVoxel(pos, cave);
@@ -23,6 +23,8 @@ class RawVolume;
 
 namespace voxelworld {
 
+class NavigationGrid;
+
 /**
  * @brief Pager implementation for PagedVolume.
  *
@@ -40,20 +42,30 @@ private:
 	noise::Noise _noise;
 	TreeVolumeCache _volumeCache;
 	ChunkPersisterPtr _chunkPersister;
+	NavigationGrid* _navigationGrid = nullptr;
 
 	void createWorld(voxel::PagedVolumeWrapper& volume) const;
 	void placeTrees(voxel::PagedVolume::PagerContext& pagerCtx);
 	void addVolumeToPosition(voxel::PagedVolumeWrapper& target, const voxelutil::RawVolumeRotateWrapper& source, const glm::ivec3& pos);
 
 	int terrainHeight(int x, int minsY, int z) const;
-	int terrainHeight(int x, int minsY, int z, float n) const;
-	int fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const;
+	/**
+	 * @param[out] density The cave density of the column - indexed by the y coordinate
+	 * @sa getDensity()
+	 */
+	int terrainHeight(int x, int minsY, int z, float n, float* density) const;
+	int fillVoxels(int x, int minsY, int z, float n, voxel::Voxel* voxels) const;
 
 	/**
-	 * @return A float value between [0.0-1.0]
+	 * @brief Evaluates the terrain noise for @c amount columns in a row along the x axis
+	 * @param[out] n A float value between [0.0-1.0] for each column
 	 */
-	float getNoiseValue(float x, float z) const;
-	float getDensity(float x, float y, float z, float n) const;
+	void getNoiseValues(int x, int z, int amount, int step, float* n) const;
+	/**
+	 * @brief Evaluates the cave density for all voxels of the column in the range [minsY + 1, height)
+	 * @param[out] density Indexed by the y coordinate
+	 */
+	void getDensity(int x, int minsY, int z, int height, float n, float* density) const;
 
 public:
 	WorldPager(const voxelformat::VolumeCachePtr& volumeCache, const ChunkPersisterPtr& chunkPersister);
@@ -73,6 +85,12 @@ public:
 
 	const ChunkPersisterPtr& chunkPersister() const;
 
+	/**
+	 * @brief The walkable floors of all chunks that are paged in are added to the given navigation grid
+	 * @note The grid must outlive the pager - might be @c nullptr
+	 */
+	void setNavigationGrid(NavigationGrid* navigationGrid);
+
 	/**
 	 * @brief The ssed that is going to be used for creating the world
 	 */
@@ -86,6 +104,14 @@ public:
 	 */
 	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override;
 	void pageOut(voxel::PagedVolume::Chunk* chunk) override;
+	/**
+	 * @brief Adds the floors of the chunk to the navigation grid again
+	 */
+	void pageRestored(voxel::PagedVolume::PagerContext& ctx) override;
+	/**
+	 * @brief Removes the floors of the chunk from the navigation grid
+	 */
+	void pageEvicted(voxel::PagedVolume::Chunk* chunk) override;
 };
 
 inline const ChunkPersisterPtr& WorldPager::chunkPersister() const {
@@ -5,7 +5,16 @@
 #include "voxelworld/BiomeManager.h"
 #include "voxel/Constants.h"
 #include "voxel/IsQuadNeeded.h"
+#include "voxel/RawVolume.h"
+#include "core/concurrent/ThreadPool.h"
 #include "voxelformat/VolumeCache.h"
+#include "voxelworld/WorldContext.h"
+#include "voxelworld/ChunkPersister.h"
+#include "voxelworld/NavigationGrid.h"
+#include "voxel/Morton.h"
+#include "core/ByteStream.h"
+#include "noise/Noise.h"
+#include "noise/Simplex.h"
 
 class PagedVolumeBenchmark: public core::AbstractBenchmark {
 protected:
@@ -49,4 +58,408 @@ BENCHMARK_DEFINE_F(PagedVolumeBenchmark, pageIn) (benchmark::State& state) {
 
 BENCHMARK_REGISTER_F(PagedVolumeBenchmark, pageIn)->RangeMultiplier(2)->Range(8, 256);
 
+/**
+ * @brief Measures the chunk lookup scaling with the amount of threads that are reading voxels from the same volume.
+ * All chunks are resident - this is about the locking overhead of cache hits.
+ */
+class ConcurrentPagedVolumeBenchmark: public core::AbstractBenchmark {
+private:
+	using Super = core::AbstractBenchmark;
+
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Grass, 0);
+			const int32_t sideLength = ctx.chunk->sideLength();
+			for (int32_t i = 0; i < sideLength; ++i) {
+				ctx.chunk->setVoxel(i, 0, i, voxel);
+			}
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+protected:
+	Pager _pager;
+	voxel::PagedVolume* _volume = nullptr;
+
+public:
+	static constexpr int ChunkSideLength = 32;
+	static constexpr int ChunksPerAxis = 8;
+
+	// the volume is shared between all benchmark threads - only the first thread is setting it up
+	void SetUp(benchmark::State& state) override {
+		if (state.thread_index != 0) {
+			return;
+		}
+		Super::SetUp(state);
+		_volume = new voxel::PagedVolume(&_pager, 128 * 1024 * 1024, ChunkSideLength);
+		for (int x = 0; x < ChunksPerAxis; ++x) {
+			for (int y = 0; y < ChunksPerAxis; ++y) {
+				for (int z = 0; z < ChunksPerAxis; ++z) {
+					_volume->chunk(glm::ivec3(x, y, z) * ChunkSideLength);
+				}
+			}
+		}
+	}
+
+	void TearDown(benchmark::State& state) override {
+		if (state.thread_index != 0) {
+			return;
+		}
+		delete _volume;
+		_volume = nullptr;
+		Super::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(ConcurrentPagedVolumeBenchmark, voxelLookup) (benchmark::State& state) {
+	const int size = ChunkSideLength * ChunksPerAxis;
+	uint32_t seed = 1u + (uint32_t)state.thread_index;
+	int grass = 0;
+	while (state.KeepRunning()) {
+		// cheap lcg to get a spread over all chunks without the overhead of a real random number generator
+		seed = seed * 1664525u + 1013904223u;
+		const int x = (int)((seed >> 8) % size);
+		const int y = (int)((seed >> 4) % size);
+		const int z = (int)((seed >> 16) % size);
+		if (_volume->voxel(x, y, z).getMaterial() == voxel::VoxelType::Grass) {
+			++grass;
+		}
+	}
+	benchmark::DoNotOptimize(grass);
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(ConcurrentPagedVolumeBenchmark, voxelLookup)->ThreadRange(1, 8)->UseRealTime();
+
+/**
+ * @brief Compares the extraction of the existing quad merging with the greedy meshing of a mesh column.
+ * The first argument selects the extractor: 0 is the quad merging, 1 the greedy meshing, 2 the greedy
+ * meshing split over a thread pool.
+ */
+class CubicSurfaceExtractorBenchmark: public core::AbstractBenchmark {
+private:
+	using Super = core::AbstractBenchmark;
+protected:
+	voxel::RawVolume* _volume = nullptr;
+	core::ThreadPool _threadPool {4, "GreedyMesh"};
+
+public:
+	static constexpr int Height = 256;
+	static constexpr int ColumnSize = 16;
+	static constexpr int Columns = 4;
+
+	void SetUp(benchmark::State& state) override {
+		Super::SetUp(state);
+		voxel::initDefaultMaterialColors();
+		_threadPool.init();
+		const int size = ColumnSize * Columns;
+		_volume = new voxel::RawVolume(voxel::Region(glm::ivec3(0), glm::ivec3(size - 1, Height - 1, size - 1)));
+		// rolling hills with some overhangs and different colors
+		for (int z = 0; z < size; ++z) {
+			for (int x = 0; x < size; ++x) {
+				const int height = 64 + (int)(24.0f * glm::sin(x * 0.21f) * glm::cos(z * 0.17f));
+				for (int y = 0; y < height; ++y) {
+					const voxel::VoxelType type = y < height - 4 ? voxel::VoxelType::Rock : voxel::VoxelType::Grass;
+					_volume->setVoxel(x, y, z, voxel::createVoxel(type, (x / 3 + z / 5 + y / 7) % 4));
+				}
+				if ((x * 31 + z * 17) % 23 == 0) {
+					for (int y = height + 3; y < height + 6; ++y) {
+						_volume->setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Leaf, 0));
+					}
+				}
+			}
+		}
+	}
+
+	void TearDown(benchmark::State& state) override {
+		delete _volume;
+		_volume = nullptr;
+		_threadPool.shutdown(true);
+		Super::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, extract) (benchmark::State& state) {
+	const int mode = state.range(0);
+	size_t vertices = 0u;
+	size_t indices = 0u;
+	int column = 0;
+	while (state.KeepRunning()) {
+		const glm::ivec3 mins((column % Columns) * ColumnSize, 0, (column / Columns % Columns) * ColumnSize);
+		const voxel::Region region(mins, mins + glm::ivec3(ColumnSize - 1, Height - 2, ColumnSize - 1));
+		++column;
+		voxel::Mesh mesh(0, 0, true);
+		if (mode == 0) {
+			voxel::extractCubicMesh(_volume, region, &mesh, voxel::IsQuadNeeded());
+		} else {
+			voxel::extractGreedyCubicMesh(_volume, region, &mesh, voxel::IsQuadNeeded(), mode == 2 ? &_threadPool : nullptr);
+		}
+		vertices += mesh.getNoOfVertices();
+		indices += mesh.getNoOfIndices();
+	}
+	const double iterations = (double)core_max((size_t)1u, (size_t)state.iterations());
+	state.counters["vertices"] = (double)vertices / iterations;
+	state.counters["indices"] = (double)indices / iterations;
+}
+
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, extract)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Measures the columns per second of the terrain noise (heightmap and cave density) of the world pager.
+ * The first argument selects the path: 0 is the scalar noise::fBm() per column and voxel, 1 the batched noise
+ * with the scalar kernel and 2 the batched noise with the best kernel the cpu supports.
+ */
+class TerrainNoiseBenchmark: public core::AbstractBenchmark {
+private:
+	using Super = core::AbstractBenchmark;
+protected:
+	voxelworld::WorldContext _worldCtx;
+	noise::Noise _noise;
+
+	inline float normalizedHeight(float landscapeNoise, float mountainNoise) const {
+		const float noiseNormalized = noise::norm(landscapeNoise);
+		const float mountainNoiseNormalized = noise::norm(mountainNoise);
+		return glm::clamp(noiseNormalized * mountainNoiseNormalized * (mountainNoiseNormalized + 0.5f), 0.0f, 1.0f);
+	}
+
+	int scalarColumn(int x, int z) const {
+		const glm::vec2 noisePos2d((float)x, (float)z);
+		const float n = normalizedHeight(
+				noise::fBm(noisePos2d * _worldCtx.landscapeNoiseFrequency, _worldCtx.landscapeNoiseOctaves, _worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain),
+				noise::fBm(noisePos2d * _worldCtx.mountainNoiseFrequency, _worldCtx.mountainNoiseOctaves, _worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain));
+		const int height = (int)(n * (voxel::MAX_TERRAIN_HEIGHT - 1));
+		int solid = 0;
+		for (int y = height - 1; y >= 1; --y) {
+			const glm::vec3 noisePos3d((float)x, (float)y, (float)z);
+			const float density = n + noise::norm(noise::fBm(noisePos3d * _worldCtx.caveNoiseFrequency, _worldCtx.caveNoiseOctaves,
+					_worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain));
+			solid += density > _worldCtx.caveDensityThreshold;
+		}
+		return solid;
+	}
+
+	int batchedRow(int z, int columns, float* landscapeNoise, float* mountainNoise, float* density) const {
+		const glm::vec2 noisePos2d(0.0f, (float)z);
+		const glm::vec2 step(1.0f, 0.0f);
+		_noise.fBmRow(landscapeNoise, columns, glm::vec2(0.0f), noisePos2d, step, _worldCtx.landscapeNoiseFrequency, _worldCtx.landscapeNoiseOctaves,
+				_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
+		_noise.fBmRow(mountainNoise, columns, glm::vec2(0.0f), noisePos2d, step, _worldCtx.mountainNoiseFrequency, _worldCtx.mountainNoiseOctaves,
+				_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
+		int solid = 0;
+		for (int x = 0; x < columns; ++x) {
+			const float n = normalizedHeight(landscapeNoise[x], mountainNoise[x]);
+			const int height = (int)(n * (voxel::MAX_TERRAIN_HEIGHT - 1));
+			if (height <= 1) {
+				continue;
+			}
+			_noise.fBmRow(density, height - 1, glm::vec3(0.0f), glm::vec3((float)x, 1.0f, (float)z), glm::vec3(0.0f, 1.0f, 0.0f), _worldCtx.caveNoiseFrequency,
+					_worldCtx.caveNoiseOctaves, _worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain);
+			for (int y = 0; y < height - 1; ++y) {
+				solid += n + noise::norm(density[y]) > _worldCtx.caveDensityThreshold;
+			}
+		}
+		return solid;
+	}
+
+public:
+	static constexpr int Columns = 64;
+
+	void SetUp(benchmark::State& state) override {
+		Super::SetUp(state);
+		const core::String& luaParameters = io::filesystem()->load("worldparams.lua");
+		_worldCtx.load(luaParameters);
+	}
+};
+
+BENCHMARK_DEFINE_F(TerrainNoiseBenchmark, columns) (benchmark::State& state) {
+	const int mode = state.range(0);
+	if (mode == 1) {
+		_noise.setBatchKernel(noise::BatchKernel::Scalar);
+	} else if (mode == 2) {
+		_noise.setBatchKernel(noise::Noise::bestBatchKernel());
+	}
+	float landscapeNoise[Columns];
+	float mountainNoise[Columns];
+	float density[voxel::MAX_TERRAIN_HEIGHT];
+	int z = 0;
+	int solid = 0;
+	while (state.KeepRunning()) {
+		if (mode == 0) {
+			for (int x = 0; x < Columns; ++x) {
+				solid += scalarColumn(x, z);
+			}
+		} else {
+			solid += batchedRow(z, Columns, landscapeNoise, mountainNoise, density);
+		}
+		++z;
+	}
+	benchmark::DoNotOptimize(solid);
+	state.SetItemsProcessed(state.iterations() * Columns);
+}
+
+BENCHMARK_REGISTER_F(TerrainNoiseBenchmark, columns)->DenseRange(0, 2);
+
+/**
+ * @brief Saves and loads a chunk with the compressed chunk format. The first argument selects the chunk content:
+ * 0 is a terrain chunk with a few materials (palette), 1 is a chunk with more than 256 different voxels (raw).
+ * The second argument is the compression level.
+ */
+class ChunkPersisterBenchmark: public core::AbstractBenchmark {
+private:
+	using Super = core::AbstractBenchmark;
+
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+protected:
+	Pager _pager;
+	voxel::PagedVolume::Chunk* _chunk = nullptr;
+
+public:
+	static constexpr int ChunkSideLength = 64;
+
+	void SetUp(benchmark::State& state) override {
+		Super::SetUp(state);
+		_chunk = new voxel::PagedVolume::Chunk(glm::ivec3(0), ChunkSideLength, &_pager);
+		const bool noisy = state.range(0) != 0;
+		for (int z = 0; z < ChunkSideLength; ++z) {
+			for (int x = 0; x < ChunkSideLength; ++x) {
+				const int height = 32 + (int)(16.0f * glm::sin(x * 0.21f) * glm::cos(z * 0.17f));
+				for (int y = 0; y < height; ++y) {
+					const voxel::VoxelType type = y < height - 4 ? voxel::VoxelType::Rock : voxel::VoxelType::Grass;
+					const uint8_t color = noisy ? (uint8_t)(x * 7 + y * 3 + z) : (uint8_t)((x / 3 + z / 5 + y / 7) % 4);
+					_chunk->setVoxel(x, y, z, voxel::createVoxel(type, color));
+				}
+			}
+		}
+	}
+
+	void TearDown(benchmark::State& state) override {
+		delete _chunk;
+		_chunk = nullptr;
+		Super::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(ChunkPersisterBenchmark, roundTrip) (benchmark::State& state) {
+	voxelworld::ChunkPersister persister;
+	persister.setCompressionLevel((int)state.range(1));
+	voxel::PagedVolume::Chunk loaded(glm::ivec3(0), ChunkSideLength, &_pager);
+	core::ByteStream stream;
+	for (auto _ : state) {
+		stream.resize(0);
+		if (!persister.saveCompressed(_chunk, stream) || !persister.loadCompressed(&loaded, stream.getBuffer(), stream.getSize())) {
+			state.SkipWithError("Failed to save or load the chunk");
+			break;
+		}
+	}
+	const int64_t chunkBytes = _chunk->dataSizeInBytes();
+	state.SetBytesProcessed(state.iterations() * chunkBytes);
+	state.counters["ratio"] = stream.getSize() > 0 ? (double)chunkBytes / (double)stream.getSize() : 0.0;
+}
+
+BENCHMARK_REGISTER_F(ChunkPersisterBenchmark, roundTrip)
+	->Args({0, 0})->Args({0, 1})->Args({0, 6})
+	->Args({1, 0})->Args({1, 1})->Args({1, 6})
+	->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Path queries between random positions of a generated map with rolling hills and walls with small gaps.
+ * The argument is the amount of queries per iteration.
+ */
+class NavigationGridBenchmark: public core::AbstractBenchmark {
+private:
+	using Super = core::AbstractBenchmark;
+
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+protected:
+	Pager _pager;
+	voxelworld::NavigationGrid* _grid = nullptr;
+
+public:
+	static constexpr int ChunkSideLength = 32;
+	static constexpr int Size = 512;
+
+	static int height(int x, int z) {
+		// walls every 64 voxels along the x axis - with one gap per 64 voxels along the z axis
+		if (x % 64 == 32 && z % 64 > 4) {
+			return 24;
+		}
+		return 8 + (int)(6.0f * glm::sin(x * 0.05f) * glm::cos(z * 0.07f));
+	}
+
+	void SetUp(benchmark::State& state) override {
+		Super::SetUp(state);
+		_grid = new voxelworld::NavigationGrid();
+		std::vector<voxel::Voxel> voxels(ChunkSideLength * ChunkSideLength * ChunkSideLength);
+		for (int cz = 0; cz < Size; cz += ChunkSideLength) {
+			for (int cx = 0; cx < Size; cx += ChunkSideLength) {
+				std::fill(voxels.begin(), voxels.end(), voxel::Voxel());
+				for (int z = 0; z < ChunkSideLength; ++z) {
+					for (int x = 0; x < ChunkSideLength; ++x) {
+						const int h = height(cx + x, cz + z);
+						for (int y = 0; y < h; ++y) {
+							voxels[voxel::morton256_x[x] | voxel::morton256_y[y] | voxel::morton256_z[z]] = voxel::createVoxel(voxel::VoxelType::Grass, 0);
+						}
+					}
+				}
+				voxel::PagedVolume::Chunk chunk(glm::ivec3(cx, 0, cz) / ChunkSideLength, ChunkSideLength, &_pager);
+				chunk.setData(voxels.data(), voxels.size() * sizeof(voxel::Voxel));
+				_grid->update(chunk, glm::ivec3(cx, 0, cz));
+			}
+		}
+		// build the abstract graph before the queries are measured
+		_grid->nodes();
+	}
+
+	void TearDown(benchmark::State& state) override {
+		delete _grid;
+		_grid = nullptr;
+		Super::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(NavigationGridBenchmark, findPath) (benchmark::State& state) {
+	const int queries = (int)state.range(0);
+	std::vector<glm::ivec3> path;
+	int found = 0;
+	for (auto _ : state) {
+		uint32_t seed = 1u;
+		for (int i = 0; i < queries; ++i) {
+			// cheap lcg - the same queries for every iteration
+			seed = seed * 1664525u + 1013904223u;
+			const glm::ivec3 start((seed >> 4) % Size, 0, (seed >> 14) % Size);
+			seed = seed * 1664525u + 1013904223u;
+			const glm::ivec3 end((seed >> 4) % Size, 0, (seed >> 14) % Size);
+			if (_grid->findPath(start, end, path)) {
+				++found;
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * queries);
+	state.counters["found"] = state.iterations() > 0 ? (double)found / (double)(state.iterations() * queries) : 0.0;
+}
+
+BENCHMARK_REGISTER_F(NavigationGridBenchmark, findPath)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
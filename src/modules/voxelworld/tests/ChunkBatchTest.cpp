@@ -0,0 +1,56 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "voxelworld/ChunkBatch.h"
+
+namespace voxelworld {
+
+class ChunkBatchTest: public core::AbstractTest {
+};
+
+TEST_F(ChunkBatchTest, testRoundTrip) {
+	const uint8_t first[] = { 1, 2, 3 };
+	const uint8_t second[] = { 4, 5, 6, 7, 8 };
+	std::vector<ChunkBatchEntry> entries(3);
+	entries[0].chunkPos = glm::ivec3(-1, 0, 2);
+	entries[0].data = first;
+	entries[0].length = sizeof(first);
+	entries[1].chunkPos = glm::ivec3(3, 1, -4);
+	entries[2].chunkPos = glm::ivec3(0, 2, 0);
+	entries[2].data = second;
+	entries[2].length = sizeof(second);
+
+	const size_t size = chunkBatchSize(entries);
+	ASSERT_EQ(3u * 16u + sizeof(first) + sizeof(second), size);
+	std::vector<uint8_t> buf(size);
+	ASSERT_EQ(size, writeChunkBatch(entries, buf.data(), buf.size()));
+
+	std::vector<ChunkBatchEntry> read;
+	ASSERT_TRUE(readChunkBatch(buf.data(), buf.size(), read));
+	ASSERT_EQ(entries.size(), read.size());
+	for (size_t i = 0; i < entries.size(); ++i) {
+		EXPECT_EQ(entries[i].chunkPos, read[i].chunkPos);
+		ASSERT_EQ(entries[i].length, read[i].length);
+		if (entries[i].length > 0u) {
+			EXPECT_EQ(0, memcmp(entries[i].data, read[i].data, entries[i].length));
+		}
+	}
+}
+
+TEST_F(ChunkBatchTest, testTruncated) {
+	const uint8_t data[] = { 1, 2, 3, 4 };
+	std::vector<ChunkBatchEntry> entries(1);
+	entries[0].data = data;
+	entries[0].length = sizeof(data);
+	std::vector<uint8_t> buf(chunkBatchSize(entries));
+	ASSERT_EQ(buf.size(), writeChunkBatch(entries, buf.data(), buf.size()));
+
+	std::vector<ChunkBatchEntry> read;
+	EXPECT_FALSE(readChunkBatch(buf.data(), buf.size() - 1u, read));
+	read.clear();
+	EXPECT_FALSE(readChunkBatch(buf.data(), 8u, read));
+}
+
+}
@@ -0,0 +1,167 @@
+/**
+ * @file
+ */
+
+#include "voxelworld/ChunkPersister.h"
+#include "core/Enum.h"
+#include <vector>
+
+#include "AbstractVoxelTest.h"
+
+namespace voxelworld {
+
+class ChunkPersisterTest: public AbstractVoxelTest {
+protected:
+	static constexpr uint16_t SideLength = 32;
+
+	void roundTrip(voxel::PagedVolume::Chunk& chunk, voxel::PagedVolume::Chunk::Representation expected) {
+		ASSERT_EQ(expected, chunk.representation());
+		ChunkPersister persister;
+		core::ByteStream stream;
+		ASSERT_TRUE(persister.saveCompressed(&chunk, stream));
+		voxel::PagedVolume::Chunk loaded(glm::ivec3(0), SideLength, &_pager);
+		ASSERT_TRUE(persister.loadCompressed(&loaded, stream.getBuffer(), stream.getSize()));
+		EXPECT_EQ(expected, loaded.representation());
+		expectSame(chunk, loaded);
+	}
+
+	void expectSame(const voxel::PagedVolume::Chunk& expected, const voxel::PagedVolume::Chunk& chunk) const {
+		for (int z = 0; z < SideLength; ++z) {
+			for (int y = 0; y < SideLength; ++y) {
+				for (int x = 0; x < SideLength; ++x) {
+					ASSERT_TRUE(expected.voxel(x, y, z).isSame(chunk.voxel(x, y, z))) << x << ":" << y << ":" << z;
+				}
+			}
+		}
+	}
+};
+
+TEST_F(ChunkPersisterTest, testUniform) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	roundTrip(chunk, voxel::PagedVolume::Chunk::Representation::Uniform);
+}
+
+TEST_F(ChunkPersisterTest, testPalette) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	for (int z = 0; z < SideLength; ++z) {
+		for (int x = 0; x < SideLength; ++x) {
+			for (int y = 0; y < x / 4; ++y) {
+				chunk.setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Dirt, (uint8_t)y));
+			}
+		}
+	}
+	roundTrip(chunk, voxel::PagedVolume::Chunk::Representation::Palette);
+}
+
+TEST_F(ChunkPersisterTest, testRaw) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	for (int z = 0; z < SideLength; ++z) {
+		for (int y = 0; y < SideLength; ++y) {
+			for (int x = 0; x < SideLength; ++x) {
+				const voxel::VoxelType material = (y & 1) ? voxel::VoxelType::Rock : voxel::VoxelType::Dirt;
+				chunk.setVoxel(x, y, z, voxel::createVoxel(material, (uint8_t)(x * 8 + z)));
+			}
+		}
+	}
+	roundTrip(chunk, voxel::PagedVolume::Chunk::Representation::Raw);
+}
+
+TEST_F(ChunkPersisterTest, testStored) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	chunk.setVoxel(1, 2, 3, voxel::createVoxel(voxel::VoxelType::Grass, 1));
+	ChunkPersister persister;
+	persister.setCompressionLevel(0);
+	core::ByteStream stream;
+	ASSERT_TRUE(persister.saveCompressed(&chunk, stream));
+	voxel::PagedVolume::Chunk loaded(glm::ivec3(0), SideLength, &_pager);
+	ASSERT_TRUE(persister.loadCompressed(&loaded, stream.getBuffer(), stream.getSize()));
+	expectSame(chunk, loaded);
+}
+
+TEST_F(ChunkPersisterTest, testLoadVersion1) {
+	// the first version stored two bytes per voxel in x, y, z order
+	core::ByteStream voxelStream;
+	for (int z = 0; z < SideLength; ++z) {
+		for (int y = 0; y < SideLength; ++y) {
+			for (int x = 0; x < SideLength; ++x) {
+				const bool solid = y < z;
+				voxelStream.addByte(core::enumVal(solid ? voxel::VoxelType::Sand : voxel::VoxelType::Air));
+				voxelStream.addByte(solid ? (uint8_t)x : 0u);
+			}
+		}
+	}
+	const int voxelSize = voxelStream.getSize();
+	std::vector<uint8_t> compressed(core::zip::compressBound(voxelSize));
+	size_t compressedSize = 0u;
+	ASSERT_TRUE(core::zip::compress(voxelStream.getBuffer(), voxelSize, compressed.data(), compressed.size(), &compressedSize));
+	core::ByteStream stream;
+	stream.addFormat("ib", voxelSize, ChunkPersister::VersionPlain);
+	stream.append(compressed.data(), compressedSize);
+	EXPECT_EQ(1, ChunkPersister::generatorVersion(stream.getBuffer(), stream.getSize()));
+
+	ChunkPersister persister;
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	ASSERT_TRUE(persister.loadCompressed(&chunk, stream.getBuffer(), stream.getSize()));
+	EXPECT_EQ(voxel::VoxelType::Sand, chunk.voxel(3, 4, 5).getMaterial());
+	EXPECT_EQ(3, chunk.voxel(3, 4, 5).getColor());
+	EXPECT_EQ(voxel::VoxelType::Air, chunk.voxel(3, 5, 5).getMaterial());
+}
+
+TEST_F(ChunkPersisterTest, testLoadVersion2) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	chunk.setVoxel(1, 2, 3, voxel::createVoxel(voxel::VoxelType::Sand, 1));
+	ChunkPersister persister;
+	core::ByteStream stream;
+	ASSERT_TRUE(persister.saveCompressed(&chunk, stream));
+	// version 2 didn't store the generator version in front of the codec
+	std::vector<uint8_t> data(stream.getBuffer(), stream.getBuffer() + stream.getSize());
+	data.erase(data.begin() + 5);
+	data[4] = 2u;
+	EXPECT_EQ(1, ChunkPersister::generatorVersion(data.data(), data.size()));
+	voxel::PagedVolume::Chunk loaded(glm::ivec3(0), SideLength, &_pager);
+	ASSERT_TRUE(persister.loadCompressed(&loaded, data.data(), data.size()));
+	expectSame(chunk, loaded);
+}
+
+TEST_F(ChunkPersisterTest, testStoredETag) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	ChunkPersister persister;
+	core::ByteStream stream;
+	ASSERT_TRUE(persister.saveCompressed(&chunk, stream));
+	const unsigned int seed = 42u;
+	EXPECT_EQ(ChunkPersister::etag(seed), ChunkPersister::etag(seed, stream.getBuffer(), ChunkPersister::ETagHeaderSize));
+
+	// chunks of an older format are downloaded again
+	std::vector<uint8_t> data(stream.getBuffer(), stream.getBuffer() + stream.getSize());
+	data.erase(data.begin() + 5);
+	data[4] = 2u;
+	EXPECT_NE(ChunkPersister::etag(seed), ChunkPersister::etag(seed, data.data(), data.size()));
+	EXPECT_TRUE(ChunkPersister::etag(seed, data.data(), 3u).empty());
+}
+
+TEST_F(ChunkPersisterTest, testRejectOtherGenerator) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	chunk.setVoxel(1, 2, 3, voxel::createVoxel(voxel::VoxelType::Sand, 1));
+	ChunkPersister persister;
+	core::ByteStream stream;
+	ASSERT_TRUE(persister.saveCompressed(&chunk, stream));
+	std::vector<uint8_t> data(stream.getBuffer(), stream.getBuffer() + stream.getSize());
+	EXPECT_EQ(ChunkPersister::GeneratorVersion, ChunkPersister::generatorVersion(data.data(), data.size()));
+
+	// the byte after the format version is the generator version - such chunks are generated again
+	data[5] = (uint8_t)(ChunkPersister::GeneratorVersion + 1);
+	voxel::PagedVolume::Chunk loaded(glm::ivec3(0), SideLength, &_pager);
+	EXPECT_FALSE(persister.loadCompressed(&loaded, data.data(), data.size()));
+	EXPECT_EQ(-1, ChunkPersister::generatorVersion(data.data(), 3u));
+}
+
+TEST_F(ChunkPersisterTest, testRejectSideLength) {
+	voxel::PagedVolume::Chunk chunk(glm::ivec3(0), SideLength, &_pager);
+	ChunkPersister persister;
+	core::ByteStream stream;
+	ASSERT_TRUE(persister.saveCompressed(&chunk, stream));
+	voxel::PagedVolume::Chunk other(glm::ivec3(0), SideLength / 2, &_pager);
+	EXPECT_FALSE(persister.loadCompressed(&other, stream.getBuffer(), stream.getSize()));
+}
+
+}
@@ -0,0 +1,143 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "voxelworld/NavigationGrid.h"
+#include "voxel/Constants.h"
+#include "voxel/Voxel.h"
+#include <functional>
+
+namespace voxelworld {
+
+class NavigationGridTest: public core::AbstractTest {
+protected:
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	static constexpr int ChunkSideLength = 32;
+	static constexpr int Size = 128;
+	Pager _pager;
+	NavigationGrid _grid;
+
+	/**
+	 * @brief Adds the chunks of a @c Size x @c Size area with the floor heights of the given function
+	 */
+	void fill(const std::function<int(int, int)>& height) {
+		for (int cz = 0; cz < Size; cz += ChunkSideLength) {
+			for (int cx = 0; cx < Size; cx += ChunkSideLength) {
+				voxel::PagedVolume::Chunk chunk(glm::ivec3(cx, 0, cz) / ChunkSideLength, ChunkSideLength, &_pager);
+				for (int z = 0; z < ChunkSideLength; ++z) {
+					for (int x = 0; x < ChunkSideLength; ++x) {
+						const int h = height(cx + x, cz + z);
+						for (int y = 0; y < h; ++y) {
+							chunk.setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Grass, 0));
+						}
+					}
+				}
+				_grid.update(chunk, glm::ivec3(cx, 0, cz));
+			}
+		}
+	}
+
+	void expectConnected(const std::vector<glm::ivec3>& path, const glm::ivec3& start, const glm::ivec3& end) const {
+		ASSERT_FALSE(path.empty());
+		EXPECT_EQ(start.x, path.front().x);
+		EXPECT_EQ(start.z, path.front().z);
+		EXPECT_EQ(end.x, path.back().x);
+		EXPECT_EQ(end.z, path.back().z);
+		for (size_t i = 1; i < path.size(); ++i) {
+			const glm::ivec3 delta = glm::abs(path[i] - path[i - 1]);
+			ASSERT_LE(delta.x, 1) << "step " << i;
+			ASSERT_LE(delta.z, 1) << "step " << i;
+			ASSERT_LE(delta.y, NavigationGrid::MaxStepHeight) << "step " << i;
+		}
+	}
+};
+
+TEST_F(NavigationGridTest, testFloor) {
+	fill([] (int x, int z) { return 4; });
+	EXPECT_EQ(16, _grid.tiles());
+	EXPECT_EQ(4, _grid.floor(10, 10));
+	EXPECT_EQ(voxel::NO_FLOOR_FOUND, _grid.floor(-1, 10));
+}
+
+TEST_F(NavigationGridTest, testPathInsideTile) {
+	fill([] (int x, int z) { return 4; });
+	std::vector<glm::ivec3> path;
+	const glm::ivec3 start(1, 0, 1);
+	const glm::ivec3 end(10, 0, 1);
+	ASSERT_TRUE(_grid.findPath(start, end, path));
+	expectConnected(path, start, end);
+	EXPECT_EQ(10u, path.size());
+}
+
+TEST_F(NavigationGridTest, testPathOverTiles) {
+	fill([] (int x, int z) { return 4 + (x + z) / 40; });
+	EXPECT_GT(_grid.nodes(), 0);
+	std::vector<glm::ivec3> path;
+	const glm::ivec3 start(2, 0, 3);
+	const glm::ivec3 end(120, 0, 100);
+	ASSERT_TRUE(_grid.findPath(start, end, path));
+	expectConnected(path, start, end);
+}
+
+TEST_F(NavigationGridTest, testPathThroughGap) {
+	// a wall at x = 50 with a gap at the z range [100, 102]
+	fill([] (int x, int z) { return x == 50 && (z < 100 || z > 102) ? 10 : 4; });
+	std::vector<glm::ivec3> path;
+	const glm::ivec3 start(10, 0, 10);
+	const glm::ivec3 end(90, 0, 10);
+	ASSERT_TRUE(_grid.findPath(start, end, path));
+	expectConnected(path, start, end);
+	bool gap = false;
+	for (const glm::ivec3& pos : path) {
+		if (pos.x == 50) {
+			EXPECT_GE(pos.z, 100);
+			EXPECT_LE(pos.z, 102);
+			gap = true;
+		}
+	}
+	EXPECT_TRUE(gap);
+}
+
+TEST_F(NavigationGridTest, testBlocked) {
+	fill([] (int x, int z) { return x == 50 ? 10 : 4; });
+	std::vector<glm::ivec3> path;
+	EXPECT_FALSE(_grid.findPath(glm::ivec3(10, 0, 10), glm::ivec3(90, 0, 10), path));
+	EXPECT_TRUE(path.empty());
+	EXPECT_TRUE(_grid.findPath(glm::ivec3(10, 0, 10), glm::ivec3(40, 0, 120), path));
+}
+
+TEST_F(NavigationGridTest, testRemove) {
+	fill([] (int x, int z) { return 4; });
+	_grid.remove(glm::ivec3(32, 0, 0), ChunkSideLength);
+	EXPECT_EQ(15, _grid.tiles());
+	EXPECT_EQ(voxel::NO_FLOOR_FOUND, _grid.floor(40, 10));
+	std::vector<glm::ivec3> path;
+	const glm::ivec3 start(10, 0, 10);
+	const glm::ivec3 end(70, 0, 10);
+	ASSERT_TRUE(_grid.findPath(start, end, path));
+	expectConnected(path, start, end);
+	for (const glm::ivec3& pos : path) {
+		EXPECT_FALSE(pos.x >= 32 && pos.x < 64 && pos.z < 32) << "path leads over the removed chunk";
+	}
+	// the chunk below the floor didn't find any floor - nothing is removed
+	_grid.remove(glm::ivec3(0, -32, 0), ChunkSideLength);
+	EXPECT_EQ(4, _grid.floor(10, 10));
+	for (int z = 32; z < Size; z += ChunkSideLength) {
+		_grid.remove(glm::ivec3(32, 0, z), ChunkSideLength);
+	}
+	EXPECT_EQ(12, _grid.tiles());
+	path.clear();
+	EXPECT_FALSE(_grid.findPath(start, end, path));
+}
+
+}
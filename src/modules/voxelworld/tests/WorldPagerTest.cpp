@@ -0,0 +1,83 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "voxelworld/WorldPager.h"
+#include "voxelworld/NavigationGrid.h"
+#include "voxelformat/VolumeCache.h"
+#include "core/io/Filesystem.h"
+#include "voxel/Constants.h"
+#include "voxel/MaterialColor.h"
+#include "voxel/Voxel.h"
+
+namespace voxelworld {
+
+class WorldPagerTest: public core::AbstractTest {
+protected:
+	/**
+	 * @brief Every chunk of the lowest layer is persisted with a flat floor
+	 */
+	class FlatPersister: public ChunkPersister {
+	public:
+		bool load(voxel::PagedVolume::Chunk* chunk, unsigned int seed) override {
+			if (chunk->chunkPos().y != 0) {
+				return true;
+			}
+			const voxel::Voxel grass = voxel::createVoxel(voxel::VoxelType::Grass, 0);
+			for (int z = 0; z < chunk->sideLength(); ++z) {
+				for (int x = 0; x < chunk->sideLength(); ++x) {
+					for (int y = 0; y < 4; ++y) {
+						chunk->setVoxel(x, y, z, grass);
+					}
+				}
+			}
+			return true;
+		}
+	};
+
+	static constexpr int ChunkSideLength = 32;
+	// this leads to the min practical chunk amount of 32
+	static constexpr uint32_t MemoryLimit = 1 * 1024 * 1024;
+	static constexpr int ChunkLimit = 32;
+
+	void SetUp() override {
+		core::AbstractTest::SetUp();
+		voxel::initDefaultMaterialColors();
+	}
+};
+
+TEST_F(WorldPagerTest, testNavigationGridSurvivesCompressedTier) {
+	NavigationGrid grid;
+	WorldPager pager(std::make_shared<voxelformat::VolumeCache>(), std::make_shared<FlatPersister>());
+	pager.setNavigationGrid(&grid);
+	voxel::PagedVolume volume(&pager, MemoryLimit, ChunkSideLength, 0.25f);
+	const io::FilesystemPtr& filesystem = _testApp->filesystem();
+	ASSERT_TRUE(pager.init(&volume, filesystem->load("worldparams.lua"), filesystem->load("biomes.lua")));
+
+	volume.chunk(glm::ivec3(0));
+	volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	const glm::ivec3 start(5, 0, 5);
+	const glm::ivec3 end(60, 0, 5);
+	std::vector<glm::ivec3> path;
+	ASSERT_TRUE(grid.findPath(start, end, path));
+
+	// evict both chunks into the compressed tier
+	for (int i = 0; i < ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 10 * ChunkSideLength));
+	}
+	EXPECT_EQ(voxel::NO_FLOOR_FOUND, grid.floor(start.x, start.z));
+	EXPECT_EQ(voxel::NO_FLOOR_FOUND, grid.floor(end.x, end.z));
+	EXPECT_FALSE(grid.findPath(start, end, path));
+	EXPECT_EQ(2, (int)volume.statistics().warmChunks);
+
+	volume.chunk(glm::ivec3(0));
+	volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	EXPECT_EQ(2, volume.statistics().warmHits);
+	EXPECT_EQ(4, grid.floor(start.x, start.z));
+	ASSERT_TRUE(grid.findPath(start, end, path)) << "The restored chunks must be added to the grid again";
+
+	pager.shutdown();
+}
+
+}
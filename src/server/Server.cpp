@@ -26,13 +26,14 @@
 #include "stock/StockDataProvider.h"
 #include "voxelformat/VolumeCache.h"
 #include "compute/Compute.h"
+#include "core/concurrent/Concurrency.h"
 #include <stdlib.h>
 #include "engine-config.h"
 
 Server::Server(const metric::MetricPtr& metric, const backend::ServerLoopPtr& serverLoop,
 		const core::TimeProviderPtr& timeProvider, const io::FilesystemPtr& filesystem,
 		const core::EventBusPtr& eventBus, const http::HttpServerPtr& httpServer) :
-		Super(metric, filesystem, eventBus, timeProvider),
+		Super(metric, filesystem, eventBus, timeProvider, core_max(1u, core::cpus())),
 		_serverLoop(serverLoop) {
 	_syslog = true;
 	_coredump = true;
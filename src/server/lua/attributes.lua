@@ -30,5 +30,8 @@ function init()
   player:absolute("ATTACKRANGE", 1.0)
   player:absolute("STRENGTH", 1.0)
   player:absolute("VIEWDISTANCE", 500.0)
+  -- Entity::inFrustum() checks this angle - without a value the player doesn't see anything
+  -- and the replication has nothing to send
+  player:absolute("FIELDOFVIEW", 360.0)
   player:register()
 end
@@ -272,6 +272,12 @@ void MapView::onRenderUI() {
 	}
 
 	if (ImGui::CollapsingHeader("Mesh extraction")) {
+		const voxelrender::WorldMeshExtractor::Statistics& stats = _worldRenderer.chunkMgr().meshExtractor().statistics();
+		ImGui::Text("Pending: %u, in flight: %u", stats.pending, stats.inFlight);
+		ImGui::Text("Scheduled: %u, extracted: %u", (uint32_t)stats.scheduled, (uint32_t)stats.extracted);
+		ImGui::Text("Deduplicated: %u, cancelled: %u", (uint32_t)stats.deduplicated, (uint32_t)stats.cancelled);
+		ImGui::Text("Latency avg: %.2fms, max: %.2fms", stats.averageLatencyMicros / 1000.0f, stats.maxLatencyMicros / 1000.0f);
+		ImGui::Text("Time to first mesh: %.2fms", stats.timeToFirstMeshMicros / 1000.0f);
 		ImGui::Checkbox("Single position", &_singlePosExtraction);
 		if (ImGui::Button("Use current position")) {
 			_singleExtractionPoint = _camera.camera().target();